@@ -3,6 +3,7 @@
 #include "./after_effects.h"
 #include "engine/scene.h"
 #include "engine/misc.h"
+#include "engine/context_objects.h"
 #include "oglwrap/smart_enums.h"
 
 AfterEffects::AfterEffects(GameObject *parent, Skybox* skybox)
@@ -11,7 +12,8 @@ AfterEffects::AfterEffects(GameObject *parent, Skybox* skybox)
     , s_uSunPos_(prog_, "s_uSunPos")
     , uZNear_(prog_, "uZNear")
     , uZFar_(prog_, "uZFar")
-    , skybox_(skybox) {
+    , skybox_(skybox)
+    , memory_(engine::MemoryStats::kGpu, "render targets", "after effects") {
   engine::ShaderFile *vs = scene_->shader_manager()->get("after_effects.vert");
   engine::ShaderFile *fs = scene_->shader_manager()->get("after_effects_dof.frag");
   if (fs->state() != gl::Shader::kCompileSuccessful) {
@@ -41,6 +43,12 @@ AfterEffects::AfterEffects(GameObject *parent, Skybox* skybox)
   depth_tex_.magFilter(gl::kLinear);
   gl::Unbind(depth_tex_);
 
+  setupFramebuffer();
+
+  scene_->set_render_target(&fbo_);
+}
+
+void AfterEffects::setupFramebuffer() {
   gl::Bind(fbo_);
   fbo_.attachTexture(gl::kColorAttachment0, color_tex_);
   fbo_.attachTexture(gl::kDepthAttachment, depth_tex_);
@@ -48,6 +56,18 @@ AfterEffects::AfterEffects(GameObject *parent, Skybox* skybox)
   gl::Unbind(fbo_);
 }
 
+void AfterEffects::contextChanged() {
+  engine::ContextObjects::Recreate(&fbo_);
+  setupFramebuffer();
+  engine::ContextObjects::Recreate(&rect_);
+}
+
+AfterEffects::~AfterEffects() {
+  if (scene_ && scene_->render_target() == &fbo_) {
+    scene_->set_render_target(nullptr);
+  }
+}
+
 void AfterEffects::screenResized(size_t w, size_t h) {
   width_ = w;
   height_ = h;
@@ -62,15 +82,16 @@ void AfterEffects::screenResized(size_t w, size_t h) {
   depth_tex_.upload(gl::kDepthComponent, width_, height_,
                     gl::kDepthComponent, gl::kFloat, nullptr);
   gl::Unbind(depth_tex_);
-}
 
-void AfterEffects::update() {
-  gl::Bind(fbo_);
-  gl::Clear().Color().Depth();
+  // The color texture's mipmaps are generated every frame.
+  memory_.set_bytes(
+      engine::MemoryStats::TextureBytes(w, h, 3 * sizeof(float), true) +
+      engine::MemoryStats::TextureBytes(w, h, sizeof(float)));
 }
 
-void AfterEffects::render() {
+void AfterEffects::render2D() {
   gl::Unbind(gl::kFramebuffer);
+  gl::TemporaryDisable blend{gl::kBlend};
 
   gl::BindToTexUnit(color_tex_, 0);
   color_tex_.generateMipmap();
@@ -12,12 +12,17 @@
 
 #include "engine/game_engine.h"
 #include "engine/shader_manager.h"
+#include "engine/memory_stats.h"
 
 #include "./skybox.h"
 
 class AfterEffects : public engine::GameObject {
  public:
+  // The scene is rendered into fbo(), as the scene's render target. The
+  // effects are applied in render2D, after the queued draws were executed,
+  // so the 2D objects added after this are drawn over the result.
   explicit AfterEffects(GameObject *parent, Skybox* skybox);
+  virtual ~AfterEffects();
 
   gl::Framebuffer* fbo() { return &fbo_; }
 
@@ -34,10 +39,13 @@ class AfterEffects : public engine::GameObject {
   GLuint width_, height_;
 
   Skybox* skybox_;
+  engine::MemoryStats::Allocation memory_;
 
+  void setupFramebuffer();
+
+  virtual void contextChanged() override;
   virtual void screenResized(size_t width, size_t height) override;
-  virtual void update() override;
-  virtual void render() override;
+  virtual void render2D() override;
 };
 
 
@@ -7,21 +7,34 @@
 #include <GLFW/glfw3.h>
 
 #include "engine/scene.h"
+#include "engine/input.h"
 
 using engine::AnimParams;
 
+engine::ShaderFile* Ayumi::loadBonePalette(engine::ShaderManager* manager) {
+  gl::ShaderSource palette_src("engine/bone_palette.vert");
+  palette_src.insertMacroValue("BONE_ATTRIB_NUM", mesh_.getBoneAttribNum());
+  palette_src.insertMacroValue("BONE_ENCODING", int(mesh_.getBoneEncoding()));
+  return manager->publish("engine/bone_palette.vert", palette_src);
+}
+
 engine::ShaderFile* Ayumi::loadVertexShader(engine::ShaderManager* manager) {
+  // It is included by the shadow's vertex shader too.
+  loadBonePalette(manager);
+
   gl::ShaderSource vs_src("ayumi.vert");
-  vs_src.insertMacroValue("BONE_ATTRIB_NUM", mesh_.getBoneAttribNum());
+  int bone_size = engine::BoneEncodingSize(mesh_.getBoneEncoding());
   vs_src.insertMacroValue("BONE_NUM", mesh_.getNumBones());
+  vs_src.insertMacroValue("BONE_SIZE", bone_size);
   return manager->publish("ayumi.vert", vs_src);
 }
 
 engine::ShaderFile* Ayumi::loadShadowVertexShader(
     engine::ShaderManager* manager) {
   gl::ShaderSource shadow_vs_src("ayumi_shadow.vert");
-  shadow_vs_src.insertMacroValue("BONE_ATTRIB_NUM", mesh_.getBoneAttribNum());
+  int bone_size = engine::BoneEncodingSize(mesh_.getBoneEncoding());
   shadow_vs_src.insertMacroValue("BONE_NUM", mesh_.getNumBones());
+  shadow_vs_src.insertMacroValue("BONE_SIZE", bone_size);
   return manager->publish("ayumi_shadow.vert", shadow_vs_src);
 }
 
@@ -34,12 +47,8 @@ Ayumi::Ayumi(engine::GameObject* parent)
             scene_->shader_manager()->get("ayumi.frag"))
     , shadow_prog_(loadShadowVertexShader(scene_->shader_manager()),
                    scene_->shader_manager()->get("shadow.frag"))
-    , uProjectionMatrix_(prog_, "uProjectionMatrix")
-    , uCameraMatrix_(prog_, "uCameraMatrix")
     , uModelMatrix_(prog_, "uModelMatrix")
-    , uBones_(prog_, "uBones")
     , shadow_uMCP_(shadow_prog_, "uMCP")
-    , shadow_uBones_(shadow_prog_, "uBones")
     , attack2_(false)
     , attack3_(false)
     , was_left_click_(false)
@@ -112,10 +121,14 @@ engine::Animation& Ayumi::getAnimation() {
   return anim_;
 }
 
+void Ayumi::contextChanged() {
+  mesh_.recreateVertexArrays();
+}
+
 void Ayumi::update() {
   float time = scene_->game_time().current;
 
-  std::string curr_anim = anim_.getCurrentAnimation();
+  const std::string& curr_anim = anim_.getCurrentAnimation();
 
   using engine::AnimParams;
 
@@ -146,7 +159,8 @@ void Ayumi::update() {
     }
   } else {
     if (charmove_->isWalking()) {
-      if (glfwGetKey(scene_->window(), GLFW_KEY_LEFT_SHIFT) == GLFW_RELEASE) {
+      if (engine::Input::GetKey(scene_->window(), GLFW_KEY_LEFT_SHIFT)
+            == GLFW_RELEASE) {
         anim_.setCurrentAnimation(AnimParams("Run", 0.3f), time);
       } else {
         anim_.setCurrentAnimation(AnimParams("Walk", 0.3f), time);
@@ -160,11 +174,13 @@ void Ayumi::update() {
 }
 
 void Ayumi::shadowRender() {
+  if (!scene_->shadow()->hasFreeSlot()) { return; }
+
   gl::Use(shadow_prog_);
   shadow_uMCP_ =
     scene_->shadow()->modelCamProjMat(bsphere_, transform()->matrix(),
                                      mesh_.worldTransform());
-  mesh_.uploadBoneInfo(shadow_uBones_);
+  mesh_.uploadBoneInfo(anim_);
 
   gl::CullFace(gl::kFront);
   gl::FrontFace(gl::kCcw);
@@ -175,19 +191,14 @@ void Ayumi::shadowRender() {
 
   mesh_.enableTextures();
   gl::CullFace(gl::kBack);
-
-  scene_->shadow()->push();
 }
 
 void Ayumi::render() {
   gl::Use(prog_);
   prog_.update();
-  const auto& cam = *scene_->camera();
-  uCameraMatrix_ = cam.cameraMatrix();
-  uProjectionMatrix_ = cam.projectionMatrix();
   uModelMatrix_ = transform()->matrix() * mesh_.worldTransform();
 
-  mesh_.uploadBoneInfo(uBones_);
+  mesh_.uploadBoneInfo(anim_);
 
   gl::FrontFace(gl::kCcw);
   gl::TemporaryEnable cullface{gl::kCullFace};
@@ -205,13 +216,15 @@ bool Ayumi::canFlip() {
 
 AnimParams Ayumi::animationEndedCallback(const std::string& current_anim) {
   if (current_anim == "Attack") {
-    if (attack2_ || glfwGetMouseButton(scene_->window(), GLFW_MOUSE_BUTTON_LEFT)
+    if (attack2_ || engine::Input::GetMouseButton(scene_->window(),
+                                                  GLFW_MOUSE_BUTTON_LEFT)
           == GLFW_PRESS) {
       return AnimParams("Attack2", 0.1f);
     }
   } else if (current_anim == "Attack2") {
     attack2_ = false;
-    if (attack3_ || glfwGetMouseButton(scene_->window(), GLFW_MOUSE_BUTTON_LEFT)
+    if (attack3_ || engine::Input::GetMouseButton(scene_->window(),
+                                                  GLFW_MOUSE_BUTTON_LEFT)
           == GLFW_PRESS) {
       return AnimParams("Attack3", 0.05f);
     }
@@ -240,7 +253,8 @@ AnimParams Ayumi::animationEndedCallback(const std::string& current_anim) {
     } else {
       params.transition_time = 0.3f;
     }
-    if (glfwGetKey(scene_->window(), GLFW_KEY_LEFT_SHIFT) == GLFW_RELEASE) {
+    if (engine::Input::GetKey(scene_->window(), GLFW_KEY_LEFT_SHIFT)
+          == GLFW_RELEASE) {
       params.name = "Run";
       return params;
     } else {
@@ -31,9 +31,7 @@ class Ayumi : public engine::GameObject {
   engine::Animation anim_;
   engine::ShaderProgram prog_, shadow_prog_;
 
-  gl::LazyUniform<glm::mat4> uProjectionMatrix_, uCameraMatrix_,
-                             uModelMatrix_, uBones_,
-                             shadow_uMCP_, shadow_uBones_;
+  gl::LazyUniform<glm::mat4> uModelMatrix_, shadow_uMCP_;
 
   bool attack2_, attack3_, was_left_click_;
   CharacterMovement *charmove_;
@@ -44,9 +42,11 @@ class Ayumi : public engine::GameObject {
   CharacterMovement::CanDoCallback canFlip;
   engine::Animation::AnimationEndedCallback animationEndedCallback;
 
+  engine::ShaderFile* loadBonePalette(engine::ShaderManager* manager);
   engine::ShaderFile* loadVertexShader(engine::ShaderManager* manager);
   engine::ShaderFile* loadShadowVertexShader(engine::ShaderManager* manager);
 
+  virtual void contextChanged() override;
   virtual void update() override;
   virtual void shadowRender() override;
   virtual void render() override;
@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 #include <algorithm>
 #include "engine/game_engine.h"
+#include "engine/input.h"
 
 CharacterMovement::CharacterMovement(engine::GameObject *parent,
                                      float horizontal_speed,
@@ -55,10 +56,10 @@ void CharacterMovement::update() {
   prevTime = time;
 
   glm::ivec2 moveDir;  // up and right is positive
-  bool w = glfwGetKey(scene_->window(), GLFW_KEY_W) == GLFW_PRESS;
-  bool a = glfwGetKey(scene_->window(), GLFW_KEY_A) == GLFW_PRESS;
-  bool s = glfwGetKey(scene_->window(), GLFW_KEY_S) == GLFW_PRESS;
-  bool d = glfwGetKey(scene_->window(), GLFW_KEY_D) == GLFW_PRESS;
+  bool w = engine::Input::GetKey(scene_->window(), GLFW_KEY_W) == GLFW_PRESS;
+  bool a = engine::Input::GetKey(scene_->window(), GLFW_KEY_A) == GLFW_PRESS;
+  bool s = engine::Input::GetKey(scene_->window(), GLFW_KEY_S) == GLFW_PRESS;
+  bool d = engine::Input::GetKey(scene_->window(), GLFW_KEY_D) == GLFW_PRESS;
 
   if (w && !s) {
     moveDir.y = 1;
@@ -0,0 +1,72 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./allocation_counter.h"
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+
+namespace engine {
+
+namespace {
+
+std::atomic<uint64_t> total_allocations{0};
+thread_local uint64_t thread_allocations = 0;
+
+}  // namespace
+
+uint64_t AllocationCounter::Total() {
+  return total_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::ThreadTotal() {
+  return thread_allocations;
+}
+
+void* AllocationCounter::CountedAllocate(std::size_t size) {
+  total_allocations.fetch_add(1, std::memory_order_relaxed);
+  thread_allocations++;
+  return std::malloc(size ? size : 1);
+}
+
+}  // namespace engine
+
+#if ENGINE_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size) {
+  void* ptr = engine::AllocationCounter::CountedAllocate(size);
+  if (!ptr) { throw std::bad_alloc{}; }
+  return ptr;
+}
+
+void* operator new[](std::size_t size) {
+  void* ptr = engine::AllocationCounter::CountedAllocate(size);
+  if (!ptr) { throw std::bad_alloc{}; }
+  return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return engine::AllocationCounter::CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return engine::AllocationCounter::CountedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+#endif
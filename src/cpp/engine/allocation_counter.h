@@ -0,0 +1,50 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_ALLOCATION_COUNTER_H_
+#define ENGINE_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "./profiler.h"
+
+// If it is 1, the global operator new is replaced, to count the heap
+// allocations. It follows the profiling by default (so it's off in the
+// release build).
+#ifndef ENGINE_COUNT_ALLOCATIONS
+  #define ENGINE_COUNT_ALLOCATIONS ENGINE_PROFILING
+#endif
+
+namespace engine {
+
+// Counts the calls of operator new, to find the hot paths that allocate every
+// frame. The per frame counts are in the profiler's frames.
+class AllocationCounter {
+ public:
+  // If the allocations are counted at all.
+  static bool enabled() { return ENGINE_COUNT_ALLOCATIONS; }
+
+  // The allocations since the start, on every thread.
+  static uint64_t Total();
+
+  // The allocations since the start, on the calling thread.
+  static uint64_t ThreadTotal();
+
+  // Counts the allocations of the calling thread in a scope, i.e. to check
+  // that a code path doesn't allocate once it warmed up.
+  class Scope {
+   public:
+    Scope() : begin_(ThreadTotal()) {}
+    uint64_t count() const { return ThreadTotal() - begin_; }
+
+   private:
+    uint64_t begin_;
+  };
+
+  // Counts an allocation, and allocates it with malloc.
+  static void* CountedAllocate(std::size_t size);
+};
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,217 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./benchmark.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include "./profiler.h"
+#include "./allocation_counter.h"
+#include "./memory_stats.h"
+
+#if ENGINE_BENCHMARK && !(ENGINE_PROFILING && ENGINE_COUNT_ALLOCATIONS)
+  #error "The benchmark needs ENGINE_PROFILING and ENGINE_COUNT_ALLOCATIONS"
+#endif
+
+namespace engine {
+
+bool Benchmark::ParseArgs(int argc, char* argv[], Options* options) {
+  bool benchmark = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    size_t eq = arg.find('=');
+    std::string name = arg.substr(0, eq);
+    std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+    if (name == "--benchmark") {
+      benchmark = true;
+    } else if (name == "--scene") {
+      options->scene = value;
+    } else if (name == "--frames") {
+      options->frames = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (name == "--warmup") {
+      options->warmup_frames = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (name == "--step") {
+      options->time_step = std::strtod(value.c_str(), nullptr);
+    } else if (name == "--size") {
+      std::sscanf(value.c_str(), "%dx%d", &options->width, &options->height);
+    } else if (name == "--output") {
+      options->output = value;
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+    }
+  }
+
+  return benchmark;
+}
+
+std::vector<Benchmark::Segment> Benchmark::DefaultScript() {
+  return std::vector<Segment>{
+    Segment{2.0, {}, glm::dvec2()},
+    Segment{5.0, {GLFW_KEY_W}, glm::dvec2(150, 0)},
+    Segment{5.0, {GLFW_KEY_W, GLFW_KEY_LEFT_SHIFT}, glm::dvec2(-100, 20)},
+    Segment{4.0, {GLFW_KEY_W, GLFW_KEY_A}, glm::dvec2(0, -20)},
+    Segment{4.0, {GLFW_KEY_S}, glm::dvec2(300, 0)}
+  };
+}
+
+Benchmark::Benchmark(const Options& options,
+                     const std::vector<Segment>& script)
+    : options_(options), script_(script), script_length_(0)
+    , frame_(0), last_frame_end_(Clock::now()), heap_allocations_(0)
+    , measuring_(false)
+    , rendered_frames_(0) {
+  for (const Segment& segment : script_) {
+    script_length_ += segment.duration;
+  }
+  frame_times_.reserve(options_.frames);
+}
+
+void Benchmark::beginFrame() {
+  measuring_ = frame_ >= options_.warmup_frames;
+
+  // Find the segment of the script, that the frame is in.
+  double time = frame_ * options_.time_step;
+  if (script_length_ > 0) {
+    time = std::fmod(time, script_length_);
+  }
+  const Segment* current = nullptr;
+  for (const Segment& segment : script_) {
+    current = &segment;
+    if (time < segment.duration) { break; }
+    time -= segment.duration;
+  }
+
+  if (current) {
+    input_.keys = current->keys;
+    input_.cursor_pos += current->cursor_speed * options_.time_step;
+  }
+}
+
+void Benchmark::endFrame() {
+  Clock::time_point now = Clock::now();
+  if (measuring_) {
+    frame_times_.push_back(
+        std::chrono::duration<double, std::milli>(now - last_frame_end_)
+          .count());
+
+    Profiler::Frame frame = Profiler::LastFrame();
+    for (const Profiler::Event& event : frame.events) {
+      // The jobs' scopes overlap the phases of the main and render threads.
+      if (event.depth != 0) { continue; }
+      auto& phases = event.role == Profiler::kWorkerThread ? job_phases_
+                                                           : cpu_phases_;
+      phases[Profiler::EventName(event)] += event.end - event.begin;
+    }
+    for (const Profiler::GpuEvent& event : frame.gpu_events) {
+      gpu_phases_[event.name] += event.duration;
+    }
+    heap_allocations_ += frame.heap_allocations;
+  }
+  last_frame_end_ = now;
+  frame_++;
+}
+
+void Benchmark::recordRenderStats(const RenderQueue::Stats& stats) {
+  if (!measuring_) { return; }
+
+  std::lock_guard<std::mutex> lock(render_stats_mutex_);
+  render_stats_.draws += stats.draws;
+  render_stats_.program_switches += stats.program_switches;
+  render_stats_.state_changes += stats.state_changes;
+  render_stats_.texture_binds += stats.texture_binds;
+  rendered_frames_++;
+}
+
+bool Benchmark::writeResults() {
+  std::ofstream file{options_.output};
+  if (!file) {
+    std::cerr << "Unable to write the results to " << options_.output
+              << std::endl;
+    return false;
+  }
+
+  std::vector<double> times = frame_times_;
+  std::sort(times.begin(), times.end());
+  auto percentile = [&times](double p) {
+    if (times.empty()) { return 0.0; }
+    size_t rank = static_cast<size_t>(std::ceil(p / 100 * times.size()));
+    return times[std::max<size_t>(rank, 1) - 1];
+  };
+  double sum = 0;
+  for (double time : times) { sum += time; }
+  size_t frames = std::max<size_t>(times.size(), 1);
+
+  file << std::fixed << std::setprecision(3);
+  file << "{\n"
+       << "  \"scene\": \"" << options_.scene << "\",\n"
+       << "  \"renderer\": \"" << renderer_ << "\",\n"
+       << "  \"frames\": " << times.size() << ",\n"
+       << "  \"warmup_frames\": " << options_.warmup_frames << ",\n"
+       << "  \"time_step\": " << std::setprecision(6) << options_.time_step
+       << std::setprecision(3) << ",\n"
+       << "  \"resolution\": [" << options_.width << ", "
+                                 << options_.height << "],\n"
+       << "  \"frame_time_ms\": {\n"
+       << "    \"mean\": " << sum / frames << ",\n"
+       << "    \"p50\": " << percentile(50) << ",\n"
+       << "    \"p90\": " << percentile(90) << ",\n"
+       << "    \"p95\": " << percentile(95) << ",\n"
+       << "    \"p99\": " << percentile(99) << ",\n"
+       << "    \"max\": " << (times.empty() ? 0.0 : times.back()) << "\n"
+       << "  },\n"
+       << "  \"heap_allocations_per_frame\": "
+       << (AllocationCounter::enabled() ? heap_allocations_ / double(frames)
+                                        : -1.0) << ",\n";
+
+  // The average time per frame.
+  auto print_phases = [&](const char* name,
+                          const std::map<std::string, double>& phases) {
+    file << "  \"" << name << "\": {";
+    bool first = true;
+    for (const auto& phase : phases) {
+      file << (first ? "\n" : ",\n") << "    \"" << phase.first << "\": "
+           << phase.second / frames / 1e3;
+      first = false;
+    }
+    file << "\n  },\n";
+  };
+  print_phases("cpu_phases_ms", cpu_phases_);
+  // Summed over the worker threads.
+  print_phases("cpu_job_phases_ms", job_phases_);
+  print_phases("gpu_phases_ms", gpu_phases_);
+
+  file << "  \"memory_peak_mb\": {";
+  bool first = true;
+  for (const MemoryStats::Category& category : MemoryStats::Categories()) {
+    file << (first ? "\n" : ",\n") << "    \""
+         << (category.kind == MemoryStats::kCpu ? "cpu " : "gpu ")
+         << category.name << "\": " << category.peak / (1024.0 * 1024.0);
+    first = false;
+  }
+  file << "\n  },\n";
+
+  std::lock_guard<std::mutex> lock(render_stats_mutex_);
+  double rendered = std::max<size_t>(rendered_frames_, 1);
+  file << "  \"draw_stats_per_frame\": {\n"
+       << "    \"draws\": " << render_stats_.draws / rendered << ",\n"
+       << "    \"program_switches\": "
+       << render_stats_.program_switches / rendered << ",\n"
+       << "    \"state_changes\": "
+       << render_stats_.state_changes / rendered << ",\n"
+       << "    \"texture_binds\": "
+       << render_stats_.texture_binds / rendered << "\n"
+       << "  }\n"
+       << "}\n";
+
+  std::cout << "The benchmark results are written to " << options_.output
+            << std::endl;
+  return static_cast<bool>(file);
+}
+
+}  // namespace engine
@@ -0,0 +1,104 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_BENCHMARK_H_
+#define ENGINE_BENCHMARK_H_
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+#include "./input.h"
+#include "./render_queue.h"
+
+// If it is 1, the game can be run in the --benchmark mode. The results
+// include the profiled phases and the heap allocations, so such a build
+// can't compile out the profiling (see the release target of the Makefile).
+#ifndef ENGINE_BENCHMARK
+  #define ENGINE_BENCHMARK 1
+#endif
+
+namespace engine {
+
+// Runs a scene for a fixed number of frames, with fixed time steps, while
+// the input is replayed from a script. It collects the frame times, the
+// time of the profiled phases and the draw statistics, and writes them as
+// JSON, so the builds can be compared. See GameEngine::RunBenchmark.
+class Benchmark {
+ public:
+  struct Options {
+    std::string scene = "main";
+    size_t frames = 1000;
+    size_t warmup_frames = 60;  // these aren't measured
+    double time_step = 1.0 / 60.0;  // seconds of game time per frame
+    int width = 1280, height = 720;
+    std::string output = "benchmark.json";
+  };
+
+  // A part of the input script: the keys held, and the cursor's speed, for a
+  // while. The script is repeated, if the benchmark is longer.
+  struct Segment {
+    double duration;  // seconds
+    std::set<int> keys;
+    glm::dvec2 cursor_speed;  // pixels per second
+  };
+
+  // Returns true, if the arguments contain --benchmark. The options can be
+  // set with --scene=name, --frames=n, --warmup=n, --step=seconds,
+  // --size=WxH and --output=file.
+  static bool ParseArgs(int argc, char* argv[], Options* options);
+
+  // Walks and runs around, while turning the camera.
+  static std::vector<Segment> DefaultScript();
+
+  explicit Benchmark(const Options& options,
+                     const std::vector<Segment>& script = DefaultScript());
+
+  const Options& options() const { return options_; }
+  const Input::Script* input() const { return &input_; }
+  bool finished() const {
+    return frame_ >= options_.warmup_frames + options_.frames;
+  }
+  void set_renderer(const std::string& renderer) { renderer_ = renderer; }
+
+  // Called by the main loop, before and after a frame.
+  void beginFrame();
+  void endFrame();
+
+  // Called by the thread that renders, after a frame is rendered.
+  void recordRenderStats(const RenderQueue::Stats& stats);
+
+  bool writeResults();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  Options options_;
+  std::vector<Segment> script_;
+  double script_length_;
+  Input::Script input_;
+  std::string renderer_;
+
+  size_t frame_;
+  Clock::time_point last_frame_end_;
+  std::vector<double> frame_times_;  // milliseconds
+  // The summed time of the top level CPU scopes (of the main and the render
+  // threads, and of the jobs separately) and of the GPU scopes, in
+  // microseconds.
+  std::map<std::string, double> cpu_phases_, job_phases_, gpu_phases_;
+  uint64_t heap_allocations_;
+
+  // Written by the thread that renders.
+  std::atomic<bool> measuring_;
+  std::mutex render_stats_mutex_;
+  RenderQueue::Stats render_stats_;
+  size_t rendered_frames_;
+};
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,305 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Keyframe sampling of a generated skeletal animation, with the channel
+// count and the key density of the character's clips (64 bones, 4 seconds
+// at 30 keys per second), and the evaluation of a pose of a 64 node skeleton.
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "./harness.h"
+#include "../job_system.h"
+#include "../mesh/animation_clip.h"
+#include "../mesh/keyframe_interpolation.h"
+#include "../mesh/skeleton.h"
+
+namespace engine {
+namespace benchmarks {
+namespace {
+
+constexpr unsigned kChannelCount = 64;
+constexpr unsigned kKeyCount = 120;
+constexpr double kDuration = kKeyCount - 1;  // in ticks
+
+std::string ChannelName(unsigned i) {
+  return "mixamorig_Bone" + std::to_string(i);
+}
+
+const aiAnimation* Clip() {
+  static std::unique_ptr<aiAnimation> clip = []() {
+    std::unique_ptr<aiAnimation> clip{new aiAnimation{}};
+    clip->mDuration = kDuration;
+    clip->mTicksPerSecond = 30;
+    clip->mNumChannels = kChannelCount;
+    clip->mChannels = new aiNodeAnim*[kChannelCount];
+    for (unsigned c = 0; c < kChannelCount; ++c) {
+      aiNodeAnim* channel = new aiNodeAnim{};
+      channel->mNodeName = aiString{ChannelName(c)};
+      channel->mNumPositionKeys = kKeyCount;
+      channel->mPositionKeys = new aiVectorKey[kKeyCount];
+      channel->mNumRotationKeys = kKeyCount;
+      channel->mRotationKeys = new aiQuatKey[kKeyCount];
+      channel->mNumScalingKeys = kKeyCount;
+      channel->mScalingKeys = new aiVectorKey[kKeyCount];
+      for (unsigned k = 0; k < kKeyCount; ++k) {
+        float phase = 0.1f * k + c;
+        channel->mPositionKeys[k] = aiVectorKey{
+            double(k), aiVector3D{std::sin(phase), 1, std::cos(phase)}};
+        channel->mRotationKeys[k] = aiQuatKey{
+            double(k), aiQuaternion{aiVector3D{0, 1, 0}, phase}};
+        channel->mScalingKeys[k] = aiVectorKey{double(k), aiVector3D{1, 1, 1}};
+      }
+      clip->mChannels[c] = channel;
+    }
+    return clip;
+  }();
+  return clip.get();
+}
+
+// The sample times, that a frame at 60 fps would use.
+float SampleTime(size_t i) {
+  return std::fmod(i * 0.5f, float(kDuration));
+}
+
+Registrar rotation{"animation/interpolate_rotation/keys:120",
+                   [](size_t iterations) {
+  const aiNodeAnim* channel = Clip()->mChannels[0];
+  aiQuaternion out;
+  for (size_t i = 0; i < iterations; ++i) {
+    calcInterpolatedRotation(out, SampleTime(i), channel);
+    DoNotOptimize(out);
+  }
+}};
+
+Registrar rotation_cursor{"animation/interpolate_rotation/keys:120,cursor",
+                          [](size_t iterations) {
+  const aiNodeAnim* channel = Clip()->mChannels[0];
+  aiQuaternion out;
+  unsigned cursor = 0;
+  for (size_t i = 0; i < iterations; ++i) {
+    calcInterpolatedRotation(out, SampleTime(i), channel, &cursor);
+    DoNotOptimize(out);
+  }
+}};
+
+Registrar position{"animation/interpolate_position/keys:120",
+                   [](size_t iterations) {
+  const aiNodeAnim* channel = Clip()->mChannels[0];
+  aiVector3D out;
+  for (size_t i = 0; i < iterations; ++i) {
+    calcInterpolatedPosition(out, SampleTime(i), channel);
+    DoNotOptimize(out);
+  }
+}};
+
+// What a frame does for every node of the skeleton: finding the channel by
+// name, and sampling its scaling, rotation and translation.
+Registrar skeleton{"animation/sample_skeleton/channels:64,keys:120",
+                   [](size_t iterations) {
+  const aiAnimation* clip = Clip();
+  static std::vector<std::string> names = []() {
+    std::vector<std::string> names;
+    for (unsigned c = 0; c < kChannelCount; ++c) {
+      names.push_back(ChannelName(c));
+    }
+    return names;
+  }();
+  for (size_t i = 0; i < iterations; ++i) {
+    float time = SampleTime(i);
+    for (const std::string& name : names) {
+      const aiNodeAnim* channel = findNodeAnim(clip, name);
+      aiVector3D scaling, translation;
+      aiQuaternion rotation;
+      calcInterpolatedScaling(scaling, time, channel);
+      calcInterpolatedRotation(rotation, time, channel);
+      calcInterpolatedPosition(translation, time, channel);
+      DoNotOptimize(scaling);
+      DoNotOptimize(rotation);
+      DoNotOptimize(translation);
+    }
+  }
+}};
+
+// The same with the channels bound to the nodes in advance, like
+// AnimatedMeshRenderer::bindChannels does it, and with keyframe cursors.
+Registrar skeleton_bound{"animation/sample_skeleton_bound/channels:64,keys:120",
+                         [](size_t iterations) {
+  const aiAnimation* clip = Clip();
+  std::vector<const aiNodeAnim*> channels(clip->mChannels,
+                                          clip->mChannels + kChannelCount);
+  std::vector<KeyframeCursor> cursors(kChannelCount);
+  for (size_t i = 0; i < iterations; ++i) {
+    float time = SampleTime(i);
+    for (size_t c = 0; c < channels.size(); ++c) {
+      const aiNodeAnim* channel = channels[c];
+      KeyframeCursor& cursor = cursors[c];
+      aiVector3D scaling, translation;
+      aiQuaternion rotation;
+      calcInterpolatedScaling(scaling, time, channel, &cursor.scaling);
+      calcInterpolatedRotation(rotation, time, channel, &cursor.rotation);
+      calcInterpolatedPosition(translation, time, channel, &cursor.position);
+      DoNotOptimize(scaling);
+      DoNotOptimize(rotation);
+      DoNotOptimize(translation);
+    }
+  }
+}};
+
+// The same pose, decoded from the compressed clip.
+Registrar sample_clip{"animation/sample_compressed_clip/channels:64",
+                      [](size_t iterations) {
+  const aiAnimation* clip = Clip();
+  static AnimationClip compressed{
+      clip, std::vector<const aiNodeAnim*>(clip->mChannels,
+                                           clip->mChannels + kChannelCount)};
+  LocalPose pose;
+  pose.resize(kChannelCount);
+  for (size_t i = 0; i < iterations; ++i) {
+    compressed.samplePose(SampleTime(i), &pose);
+    DoNotOptimize(pose.rotations.data());
+  }
+}};
+
+Registrar find_channel{"animation/find_node_anim/channels:64",
+                       [](size_t iterations) {
+  const aiAnimation* clip = Clip();
+  std::string name = ChannelName(kChannelCount - 1);
+  for (size_t i = 0; i < iterations; ++i) {
+    DoNotOptimize(findNodeAnim(clip, name));
+  }
+}};
+
+// A skeleton with kChannelCount nodes, that has a binary tree hierarchy,
+// and a pose, in which every node is animated.
+const Skeleton& PoseSkeleton() {
+  static Skeleton skeleton = []() {
+    Skeleton skeleton;
+    for (unsigned i = 0; i < kChannelCount; ++i) {
+      skeleton.addNode(ChannelName(i), i == 0 ? -1 : (i - 1) / 2, i,
+                       glm::mat4());
+    }
+    return skeleton;
+  }();
+  return skeleton;
+}
+
+const LocalPose& Pose() {
+  static LocalPose pose = []() {
+    LocalPose pose;
+    pose.resize(kChannelCount);
+    for (unsigned i = 0; i < kChannelCount; ++i) {
+      pose.translations[i] = glm::vec3(std::sin(i), 1, std::cos(i));
+      pose.rotations[i] = glm::angleAxis(0.1f * i, glm::vec3(0, 1, 0));
+      pose.animated[i] = true;
+    }
+    return pose;
+  }();
+  return pose;
+}
+
+// Evaluating a pose with a recursive walk of the hierarchy, with a matrix
+// multiplication for every part of every local transformation.
+void ModelTransformsRecursive(const Skeleton& skeleton, const LocalPose& pose,
+                              const std::vector<std::vector<int>>& children,
+                              int node, const glm::mat4& parent_transform,
+                              glm::mat4* model_transforms) {
+  glm::mat4 local = glm::translate(glm::mat4(), pose.translations[node]) *
+                    glm::mat4_cast(pose.rotations[node]) *
+                    glm::scale(glm::mat4(), pose.scales[node]);
+  model_transforms[node] = parent_transform * local;
+  for (int child : children[node]) {
+    ModelTransformsRecursive(skeleton, pose, children, child,
+                             model_transforms[node], model_transforms);
+  }
+}
+
+Registrar model_recursive{"animation/model_transforms_recursive/nodes:64",
+                          [](size_t iterations) {
+  const Skeleton& skeleton = PoseSkeleton();
+  std::vector<std::vector<int>> children(skeleton.size());
+  for (size_t i = 1; i < skeleton.size(); ++i) {
+    children[skeleton.parents[i]].push_back(i);
+  }
+  std::vector<glm::mat4> model_transforms(skeleton.size());
+  for (size_t i = 0; i < iterations; ++i) {
+    ModelTransformsRecursive(skeleton, Pose(), children, 0, glm::mat4(),
+                             model_transforms.data());
+    DoNotOptimize(model_transforms.data());
+  }
+}};
+
+Registrar model_linear{"animation/model_transforms_linear/nodes:64",
+                       [](size_t iterations) {
+  const Skeleton& skeleton = PoseSkeleton();
+  std::vector<glm::mat4> model_transforms(skeleton.size());
+  for (size_t i = 0; i < iterations; ++i) {
+    ComputeModelTransforms(skeleton, Pose(), model_transforms.data());
+    DoNotOptimize(model_transforms.data());
+  }
+}};
+
+// The poses of a crowd, that shares the clip and the skeleton, but every
+// instance has its own pose buffers, and samples the clip at a different time.
+constexpr size_t kInstanceCount = 256;
+
+struct InstancePose {
+  LocalPose pose;
+  std::vector<glm::mat4> model_transforms;
+};
+
+void EvaluateCrowd(const AnimationClip& clip, size_t iteration,
+                   size_t begin, size_t end,
+                   std::vector<InstancePose>* instances) {
+  for (size_t i = begin; i < end; ++i) {
+    InstancePose& instance = (*instances)[i];
+    clip.samplePose(SampleTime(iteration + i), &instance.pose);
+    ComputeModelTransforms(PoseSkeleton(), instance.pose,
+                           instance.model_transforms.data());
+  }
+}
+
+const AnimationClip& CrowdClip() {
+  const aiAnimation* clip = Clip();
+  static AnimationClip compressed{
+      clip, std::vector<const aiNodeAnim*>(clip->mChannels,
+                                           clip->mChannels + kChannelCount)};
+  return compressed;
+}
+
+std::vector<InstancePose> CrowdPoses() {
+  std::vector<InstancePose> instances(kInstanceCount);
+  for (InstancePose& instance : instances) {
+    instance.pose.resize(kChannelCount);
+    instance.model_transforms.resize(kChannelCount);
+  }
+  return instances;
+}
+
+Registrar crowd_serial{"animation/crowd_poses/instances:256,serial",
+                       [](size_t iterations) {
+  const AnimationClip& clip = CrowdClip();
+  std::vector<InstancePose> instances = CrowdPoses();
+  for (size_t i = 0; i < iterations; ++i) {
+    EvaluateCrowd(clip, i, 0, instances.size(), &instances);
+    DoNotOptimize(instances.data());
+  }
+}};
+
+Registrar crowd_parallel{"animation/crowd_poses/instances:256,parallel",
+                         [](size_t iterations) {
+  const AnimationClip& clip = CrowdClip();
+  std::vector<InstancePose> instances = CrowdPoses();
+  for (size_t i = 0; i < iterations; ++i) {
+    JobSystem::Default().parallelFor(0, instances.size(),
+        [&clip, &instances, i](size_t begin, size_t end) {
+      EvaluateCrowd(clip, i, begin, end, &instances);
+    });
+    DoNotOptimize(instances.data());
+  }
+}};
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace engine
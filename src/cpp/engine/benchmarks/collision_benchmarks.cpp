@@ -0,0 +1,62 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Culling tests of the bounding boxes of a terrain sized scene.
+
+#include <random>
+#include <vector>
+
+#include "./harness.h"
+#include "./fixtures.h"
+#include "../collision/bounding_box.h"
+
+namespace engine {
+namespace benchmarks {
+namespace {
+
+constexpr size_t kBoxCount = 4096;
+constexpr float kWorldSize = 4096;
+
+const std::vector<BoundingBox>& Boxes() {
+  static std::vector<BoundingBox> boxes = []() {
+    std::mt19937 random{42};
+    std::uniform_real_distribution<float> pos{0, kWorldSize};
+    std::uniform_real_distribution<float> extent{1, 64};
+    std::vector<BoundingBox> result;
+    for (size_t i = 0; i < kBoxCount; ++i) {
+      glm::vec3 mins(pos(random), pos(random) / 16, pos(random));
+      glm::vec3 maxes = mins + glm::vec3(extent(random), extent(random),
+                                         extent(random));
+      result.push_back(BoundingBox{mins, maxes});
+    }
+    return result;
+  }();
+  return boxes;
+}
+
+Registrar frustum{"collision/bbox_frustum/boxes:4096", [](size_t iterations) {
+  const std::vector<BoundingBox>& boxes = Boxes();
+  static Frustum frustum = TerrainFrustum(glm::vec3(0, 300, 0), kWorldSize);
+  for (size_t i = 0; i < iterations; ++i) {
+    size_t visible = 0;
+    for (const BoundingBox& box : boxes) {
+      visible += box.collidesWithFrustum(frustum);
+    }
+    DoNotOptimize(visible);
+  }
+}};
+
+Registrar sphere{"collision/bbox_sphere/boxes:4096", [](size_t iterations) {
+  const std::vector<BoundingBox>& boxes = Boxes();
+  glm::vec3 center(kWorldSize/2, 100, kWorldSize/2);
+  for (size_t i = 0; i < iterations; ++i) {
+    size_t inside = 0;
+    for (const BoundingBox& box : boxes) {
+      inside += box.collidesWithSphere(center, 1024);
+    }
+    DoNotOptimize(inside);
+  }
+}};
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace engine
@@ -0,0 +1,131 @@
+// Copyright (c) 2014, Tamas Csala
+
+// The per-frame systems of the entity storage over 100k entities, that all
+// have a rigid body. The serial versions run the same per entity work with
+// each() on the calling thread, the others are the systems themselves, that
+// use parallelEach().
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "./harness.h"
+#include "../ecs/systems.h"
+
+namespace engine {
+namespace benchmarks {
+namespace {
+
+constexpr size_t kEntityCount = 100000;
+
+// Stands in for the physics snapshot of the Scene: the interpolated transform
+// of a body is looked up by binary search, like in PhysicsSnapshot::find.
+class BodyTransforms {
+ public:
+  explicit BodyTransforms(size_t count) : keys_(count), bodies_(count) {
+    for (size_t i = 0; i < count; ++i) {
+      Body& body = bodies_[i];
+      // The keys are only compared, the bodies are never dereferenced.
+      body.body = reinterpret_cast<const btRigidBody*>(&keys_[i]);
+      body.prev_pos = glm::vec3(std::sin(i), i * 0.01f, std::cos(i));
+      body.pos = body.prev_pos + glm::vec3(0, -0.1f, 0);
+      body.prev_rot = glm::angleAxis(0.001f * i, glm::vec3(0, 1, 0));
+      body.rot = glm::angleAxis(0.001f * i + 0.01f, glm::vec3(0, 1, 0));
+    }
+    std::sort(bodies_.begin(), bodies_.end());
+  }
+
+  const btRigidBody* body(size_t i) const {
+    return reinterpret_cast<const btRigidBody*>(&keys_[i]);
+  }
+
+  bool bodyTransform(const btRigidBody* body,
+                     glm::vec3* pos, glm::quat* rot) const {
+    Body key;
+    key.body = body;
+    auto iter = std::lower_bound(bodies_.begin(), bodies_.end(), key);
+    if (iter == bodies_.end() || iter->body != body) { return false; }
+    *pos = glm::mix(iter->prev_pos, iter->pos, alpha_);
+    *rot = glm::slerp(iter->prev_rot, iter->rot, alpha_);
+    return true;
+  }
+
+ private:
+  struct Body {
+    const btRigidBody* body;
+    glm::vec3 prev_pos, pos;
+    glm::quat prev_rot, rot;
+
+    bool operator<(const Body& other) const { return body < other.body; }
+  };
+
+  std::vector<char> keys_;
+  std::vector<Body> bodies_;
+  float alpha_ = 0.5f;
+};
+
+struct World {
+  BodyTransforms bodies{kEntityCount};
+  ecs::Registry registry;
+
+  World() {
+    for (size_t i = 0; i < kEntityCount; ++i) {
+      registry.create(ecs::TransformComponent{},
+                      ecs::RigidBodyHandle{const_cast<btRigidBody*>(
+                          bodies.body(i))});
+    }
+  }
+};
+
+World& TheWorld() {
+  static World world;
+  return world;
+}
+
+Registrar update_serial{"ecs/update_transforms/entities:100k,serial",
+                        [](size_t iterations) {
+  World* world = &TheWorld();
+  for (size_t i = 0; i < iterations; ++i) {
+    world->registry.each<ecs::TransformComponent>(
+        [](ecs::Entity, ecs::TransformComponent& transform) {
+      ecs::UpdateTransform(transform);
+    });
+    DoNotOptimize(world->registry.size());
+  }
+}};
+
+Registrar update_parallel{"ecs/update_transforms/entities:100k,parallel",
+                          [](size_t iterations) {
+  World* world = &TheWorld();
+  for (size_t i = 0; i < iterations; ++i) {
+    ecs::UpdateTransforms(world->registry);
+    DoNotOptimize(world->registry.size());
+  }
+}};
+
+Registrar sync_serial{"ecs/sync_rigid_bodies/entities:100k,serial",
+                      [](size_t iterations) {
+  World* world = &TheWorld();
+  const BodyTransforms& bodies = world->bodies;
+  for (size_t i = 0; i < iterations; ++i) {
+    world->registry.each<ecs::RigidBodyHandle, ecs::TransformComponent>(
+        [&bodies](ecs::Entity, ecs::RigidBodyHandle& handle,
+                  ecs::TransformComponent& transform) {
+      bodies.bodyTransform(handle.body, &transform.pos, &transform.rot);
+    });
+    DoNotOptimize(world->registry.size());
+  }
+}};
+
+Registrar sync_parallel{"ecs/sync_rigid_bodies/entities:100k,parallel",
+                        [](size_t iterations) {
+  World* world = &TheWorld();
+  for (size_t i = 0; i < iterations; ++i) {
+    ecs::SyncRigidBodies(world->registry, world->bodies);
+    DoNotOptimize(world->registry.size());
+  }
+}};
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace engine
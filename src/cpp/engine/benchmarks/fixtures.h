@@ -0,0 +1,61 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_BENCHMARKS_FIXTURES_H_
+#define ENGINE_BENCHMARKS_FIXTURES_H_
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../collision/frustum.h"
+#include "../height_map.h"
+
+// Deterministic inputs, that are shared by the benchmarks.
+
+namespace engine {
+namespace benchmarks {
+
+// The frustum of a view-projection matrix (the same as Camera's).
+inline Frustum MakeFrustum(const glm::mat4& m) {
+  // m[i][j] is j-th row, i-th column
+  auto plane = [&m](int row, float sign) {
+    return Plane{m[0][3] + sign*m[0][row], m[1][3] + sign*m[1][row],
+                 m[2][3] + sign*m[2][row], m[3][3] + sign*m[3][row]};
+  };
+  // left, right, top, down, near, far
+  return Frustum{{plane(0, 1), plane(0, -1), plane(1, -1), plane(1, 1),
+                  Plane{m[0][2], m[1][2], m[2][2], m[3][2]}, plane(2, -1)}};
+}
+
+// A camera above the terrain, looking towards its far corner.
+inline Frustum TerrainFrustum(const glm::vec3& cam_pos, float size) {
+  glm::mat4 proj = glm::perspectiveFov<float>(glm::radians(60.0f), 1920, 1080,
+                                              0.5f, size);
+  glm::mat4 view = glm::lookAt(cam_pos, glm::vec3(size, 0, size),
+                               glm::vec3(0, 1, 0));
+  return MakeFrustum(proj * view);
+}
+
+// A size x size, 8 bit heightmap of rolling hills.
+inline HeightMap<unsigned char> MakeHeightMap(int size) {
+  std::vector<std::array<unsigned char, 1>> heights(size * size);
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      double h = 127.5 + 64 * std::sin(x * 0.013) * std::cos(y * 0.017)
+                       + 48 * std::sin((x + y) * 0.051)
+                       + 15 * std::cos(x * 0.23 - y * 0.19);
+      heights[y*size + x][0] =
+          static_cast<unsigned char>(glm::clamp(h, 0.0, 255.0));
+    }
+  }
+  return HeightMap<unsigned char>{size, size, std::move(heights)};
+}
+
+}  // namespace benchmarks
+}  // namespace engine
+
+#endif
@@ -0,0 +1,200 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./harness.h"
+
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+namespace engine {
+namespace benchmarks {
+
+namespace {
+
+struct Options {
+  std::string filter;
+  size_t repetitions = 15;
+  double min_time_ms = 20;
+  std::string json;
+  bool list = false;
+};
+
+// The statistics of the time of an iteration, in nanoseconds.
+struct Result {
+  std::string name;
+  size_t iterations;
+  std::vector<double> samples;
+  double mean, median, stddev, min, max;
+};
+
+bool ParseArgs(int argc, char* argv[], Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    size_t eq = arg.find('=');
+    std::string name = arg.substr(0, eq);
+    std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+    if (name == "--filter") {
+      options->filter = value;
+    } else if (name == "--repetitions") {
+      options->repetitions =
+          std::max<size_t>(std::strtoul(value.c_str(), nullptr, 10), 1);
+    } else if (name == "--min_time_ms") {
+      options->min_time_ms = std::strtod(value.c_str(), nullptr);
+    } else if (name == "--json") {
+      options->json = value;
+    } else if (name == "--list") {
+      options->list = true;
+    } else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+double TimeNs(const Body& body, size_t iterations) {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point start = Clock::now();
+  body(iterations);
+  return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// Finds an iteration count, with which the body runs for at least min_time.
+size_t Calibrate(const Body& body, double min_time_ns) {
+  size_t iterations = 1;
+  while (true) {
+    double time = TimeNs(body, iterations);
+    if (time >= min_time_ns || iterations >= (size_t(1) << 30)) {
+      return iterations;
+    }
+    // Aim a bit higher than the estimate, but grow at most 10x at once.
+    double estimate = time > 0 ? 1.4 * min_time_ns / time * iterations
+                               : 10.0 * iterations;
+    iterations = std::max(iterations + 1, static_cast<size_t>(
+        std::min(estimate, 10.0 * iterations)));
+  }
+}
+
+Result Run(const Benchmark& benchmark, const Options& options) {
+  Result result;
+  result.name = benchmark.name;
+
+  benchmark.body(1);  // warm up, and do the lazy setup
+  result.iterations = Calibrate(benchmark.body, options.min_time_ms * 1e6);
+  for (size_t i = 0; i < options.repetitions; ++i) {
+    result.samples.push_back(TimeNs(benchmark.body, result.iterations) /
+                             result.iterations);
+  }
+
+  std::vector<double> sorted = result.samples;
+  std::sort(sorted.begin(), sorted.end());
+  size_t n = sorted.size();
+  double sum = 0;
+  for (double sample : sorted) { sum += sample; }
+  result.mean = sum / n;
+  result.median = n % 2 ? sorted[n/2] : (sorted[n/2 - 1] + sorted[n/2]) / 2;
+  double square_sum = 0;
+  for (double sample : sorted) {
+    square_sum += (sample - result.mean) * (sample - result.mean);
+  }
+  result.stddev = n > 1 ? std::sqrt(square_sum / (n - 1)) : 0.0;
+  result.min = sorted.front();
+  result.max = sorted.back();
+
+  return result;
+}
+
+void Print(const Result& result) {
+  double cv = result.mean > 0 ? 100 * result.stddev / result.mean : 0.0;
+  std::printf("%-52s %12.1f %12.1f %7.2f%% %12.1f %12.1f %10zu\n",
+              result.name.c_str(), result.mean, result.median, cv,
+              result.min, result.max, result.iterations);
+}
+
+bool WriteJson(const std::string& filename, const Options& options,
+               const std::vector<Result>& results) {
+  std::ofstream file{filename};
+  if (!file) {
+    std::cerr << "Unable to write the results to " << filename << std::endl;
+    return false;
+  }
+
+  file << std::fixed << std::setprecision(3);
+  file << "{\n"
+       << "  \"repetitions\": " << options.repetitions << ",\n"
+       << "  \"min_time_ms\": " << options.min_time_ms << ",\n"
+       << "  \"time_unit\": \"ns\",\n"
+       << "  \"benchmarks\": [";
+  bool first = true;
+  for (const Result& result : results) {
+    file << (first ? "\n" : ",\n")
+         << "    {\n"
+         << "      \"name\": \"" << result.name << "\",\n"
+         << "      \"iterations\": " << result.iterations << ",\n"
+         << "      \"mean\": " << result.mean << ",\n"
+         << "      \"median\": " << result.median << ",\n"
+         << "      \"stddev\": " << result.stddev << ",\n"
+         << "      \"min\": " << result.min << ",\n"
+         << "      \"max\": " << result.max << ",\n"
+         << "      \"samples\": [";
+    for (size_t i = 0; i < result.samples.size(); ++i) {
+      file << (i ? ", " : "") << result.samples[i];
+    }
+    file << "]\n    }";
+    first = false;
+  }
+  file << "\n  ]\n}\n";
+
+  return true;
+}
+
+}  // namespace
+
+std::vector<Benchmark>& Registry() {
+  static std::vector<Benchmark> registry;
+  return registry;
+}
+
+int RunBenchmarks(int argc, char* argv[]) {
+  Options options;
+  if (!ParseArgs(argc, argv, &options)) {
+    return 1;
+  }
+
+  std::vector<Benchmark> selected;
+  for (const Benchmark& benchmark : Registry()) {
+    if (benchmark.name.find(options.filter) != std::string::npos) {
+      selected.push_back(benchmark);
+    }
+  }
+
+  if (options.list) {
+    for (const Benchmark& benchmark : selected) {
+      std::cout << benchmark.name << std::endl;
+    }
+    return 0;
+  }
+
+  std::printf("%-52s %12s %12s %8s %12s %12s %10s\n", "benchmark (ns/iter)",
+              "mean", "median", "cv", "min", "max", "iterations");
+  std::vector<Result> results;
+  for (const Benchmark& benchmark : selected) {
+    results.push_back(Run(benchmark, options));
+    Print(results.back());
+  }
+
+  if (!options.json.empty() && !WriteJson(options.json, options, results)) {
+    return 1;
+  }
+
+  return 0;
+}
+
+}  // namespace benchmarks
+}  // namespace engine
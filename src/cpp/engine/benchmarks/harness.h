@@ -0,0 +1,58 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_BENCHMARKS_HARNESS_H_
+#define ENGINE_BENCHMARKS_HARNESS_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+// A minimal microbenchmark harness for the engine's CPU hot paths. The suite
+// runs without a window, a context, or assets (see `make benchmarks`):
+//
+//   ./LoD_benchmarks [--filter=substring] [--repetitions=N]
+//                    [--min_time_ms=T] [--json=results.json] [--list]
+//
+// Every benchmark is calibrated to run for at least min_time_ms, and then
+// measured repetitions times, which gives the mean, median, standard
+// deviation, min and max of the time per iteration.
+
+namespace engine {
+namespace benchmarks {
+
+// Runs the measured operation 'iterations' times. The setup, that shouldn't
+// be measured, should be done once (for ex. in a function local static), as
+// the body is called once before the calibration, to warm it up.
+using Body = std::function<void(size_t iterations)>;
+
+struct Benchmark {
+  std::string name;
+  Body body;
+};
+
+// The registered benchmarks, in the order of registration.
+std::vector<Benchmark>& Registry();
+
+// Registers a benchmark during the static initialization, like:
+//   static Registrar foo{"area/foo", [](size_t iterations) { ... }};
+struct Registrar {
+  Registrar(const std::string& name, Body body) {
+    Registry().push_back(Benchmark{name, std::move(body)});
+  }
+};
+
+// Stops the compiler from optimizing away the calculation of value.
+template<typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Parses the arguments, runs the benchmarks, and prints the results.
+// Returns the exit code.
+int RunBenchmarks(int argc, char* argv[]);
+
+}  // namespace benchmarks
+}  // namespace engine
+
+#endif
@@ -0,0 +1,70 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Queries of a generated 2048x2048 heightmap: the min-max of the areas of the
+// quadtree's leaves, and interpolated height fetches (like the ones of the
+// character controller).
+
+#include <random>
+#include <vector>
+
+#include "./harness.h"
+#include "./fixtures.h"
+
+namespace engine {
+namespace benchmarks {
+namespace {
+
+constexpr int kMapSize = 2048;
+
+const HeightMap<unsigned char>& Map() {
+  static HeightMap<unsigned char> map = MakeHeightMap(kMapSize);
+  return map;
+}
+
+Body MinMaxOfArea(int area_size) {
+  return [area_size](size_t iterations) {
+    const HeightMap<unsigned char>& map = Map();
+    int x = area_size, y = area_size;
+    for (size_t i = 0; i < iterations; ++i) {
+      DoNotOptimize(map.getMinMaxOfArea(x, y, area_size, area_size));
+      x += area_size;
+      if (x >= kMapSize - area_size) {
+        x = area_size;
+        y = y + area_size < kMapSize - area_size ? y + area_size : area_size;
+      }
+    }
+  };
+}
+
+Registrar min_max_32{"height_map/min_max_of_area/size:32", MinMaxOfArea(32)};
+Registrar min_max_128{"height_map/min_max_of_area/size:128",
+                      MinMaxOfArea(128)};
+
+Registrar height_at{"height_map/height_at_interpolated", [](size_t iterations) {
+  const HeightMap<unsigned char>& map = Map();
+  static std::vector<glm::dvec2> points = []() {
+    std::mt19937 random{42};
+    std::uniform_real_distribution<double> coord{1, kMapSize - 2};
+    std::vector<glm::dvec2> result(4096);
+    for (glm::dvec2& point : result) {
+      point = glm::dvec2(coord(random), coord(random));
+    }
+    return result;
+  }();
+  for (size_t i = 0; i < iterations; ++i) {
+    const glm::dvec2& point = points[i % points.size()];
+    DoNotOptimize(map.heightAt(point.x, point.y));
+  }
+}};
+
+Registrar height_at_int{"height_map/height_at_texel", [](size_t iterations) {
+  const HeightMap<unsigned char>& map = Map();
+  for (size_t i = 0; i < iterations; ++i) {
+    int s = (i * 7919) % kMapSize, t = (i * 104729) % kMapSize;
+    DoNotOptimize(map.heightAt(s, t));
+  }
+}};
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace engine
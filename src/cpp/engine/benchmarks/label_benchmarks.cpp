@@ -0,0 +1,67 @@
+// Copyright (c) 2014, Tamas Csala
+
+// The CPU side of Label::set_text: laying out the glyphs of a text. The
+// upload of the vertices needs a context, so it isn't measured.
+
+#include <string>
+#include <stdexcept>
+
+#include "./harness.h"
+#include "../gui/text_layout.h"
+
+namespace engine {
+namespace benchmarks {
+namespace {
+
+// The real font's metrics, with glyphs of a fixed size. Loading the glyphs
+// with freetype-gl would upload the atlas, so they are made up instead, but
+// the lookups work the same way (without kerning pairs).
+texture_font_t* Font() {
+  static texture_font_t* font = []() {
+    texture_atlas_t* atlas = texture_atlas_new(512, 512, 1);
+    texture_font_t* font =
+        texture_font_new_from_file(atlas, 12, "src/resources/fonts/Vera.ttf");
+    if (!font) {
+      throw std::runtime_error("Unable to load src/resources/fonts/Vera.ttf "
+                               "(run the benchmarks from the repo's root).");
+    }
+    for (wchar_t ch = 32; ch < 127; ++ch) {
+      texture_glyph_t* glyph = texture_glyph_new();
+      glyph->charcode = ch;
+      glyph->width = 7;
+      glyph->height = 9;
+      glyph->offset_x = 1;
+      glyph->offset_y = 9;
+      glyph->advance_x = 8;
+      glyph->s1 = glyph->t1 = 1.0f / 64;
+      vector_push_back(font->glyphs, &glyph);
+    }
+    return font;
+  }();
+  return font;
+}
+
+Body Layout(size_t length, size_t cursor_pos) {
+  std::wstring text;
+  for (size_t i = 0; i < length; ++i) {
+    text += wchar_t(L'a' + i % 26);
+  }
+  return [text, cursor_pos](size_t iterations) {
+    texture_font_t* font = Font();
+    for (size_t i = 0; i < iterations; ++i) {
+      FrameVector<glm::vec4> attribs;
+      DoNotOptimize(gui::LayoutText(font, text, cursor_pos, &attribs));
+      DoNotOptimize(attribs.data());
+      FrameArena::ThreadLocal().reset();
+    }
+  };
+}
+
+Registrar short_text{"label/set_text_layout/chars:16", Layout(16, -1)};
+Registrar long_text{"label/set_text_layout/chars:256", Layout(256, -1)};
+Registrar with_cursor{"label/set_text_layout/chars:64,cursor",
+                      Layout(64, 32)};
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace engine
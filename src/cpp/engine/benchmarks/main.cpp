@@ -0,0 +1,7 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./harness.h"
+
+int main(int argc, char* argv[]) {
+  return engine::benchmarks::RunBenchmarks(argc, argv);
+}
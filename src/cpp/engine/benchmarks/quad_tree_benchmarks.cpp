@@ -0,0 +1,62 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Building the CDLOD quadtree of a 2048x2048 heightmap (which includes the
+// min-max calculation of every node), and selecting the nodes to render,
+// from a camera that moves along the terrain.
+
+#include <cmath>
+
+#include "./harness.h"
+#include "./fixtures.h"
+#include "../cdlod/quad_tree_node.h"
+
+namespace engine {
+namespace benchmarks {
+namespace {
+
+constexpr int kMapSize = 2048;
+constexpr int kNodeDimension = 128;
+
+const HeightMap<unsigned char>& Map() {
+  static HeightMap<unsigned char> map = MakeHeightMap(kMapSize);
+  return map;
+}
+
+uint8_t RootLevel() {
+  return std::log2(kMapSize) - std::log2(kNodeDimension);
+}
+
+Registrar build{"quad_tree/build/size:2048", [](size_t iterations) {
+  const HeightMap<unsigned char>& map = Map();
+  for (size_t i = 0; i < iterations; ++i) {
+    cdlod::QuadTreeNode root(kMapSize/2, kMapSize/2, RootLevel(),
+                             kNodeDimension);
+    double min, max;
+    root.countMinMaxOfArea(map, &min, &max);
+    DoNotOptimize(max);
+  }
+}};
+
+Registrar select_nodes{"quad_tree/select/size:2048", [](size_t iterations) {
+  static cdlod::QuadTreeNode root = []() {
+    cdlod::QuadTreeNode root(kMapSize/2, kMapSize/2, RootLevel(),
+                             kNodeDimension);
+    double min, max;
+    root.countMinMaxOfArea(Map(), &min, &max);
+    return root;
+  }();
+  cdlod::QuadTreeSelection selection{kNodeDimension};
+  for (size_t i = 0; i < iterations; ++i) {
+    // Walks the diagonal of the terrain in 64 steps.
+    float t = (i % 64) / 64.0f * kMapSize;
+    glm::vec3 cam_pos(t, 150, t);
+    Frustum frustum = TerrainFrustum(cam_pos, kMapSize);
+    selection.clear();
+    root.selectNodes(cam_pos, frustum, &selection);
+    DoNotOptimize(selection.render_data().size());
+  }
+}};
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace engine
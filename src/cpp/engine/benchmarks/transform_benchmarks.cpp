@@ -0,0 +1,85 @@
+// Copyright (c) 2014, Tamas Csala
+
+// World space queries of the leaf of a deep hierarchy, with the caches warm,
+// and after the root moved (which invalidates the whole chain).
+
+#include <memory>
+#include <vector>
+
+#include "./harness.h"
+#include "../transform.h"
+
+namespace engine {
+namespace benchmarks {
+namespace {
+
+struct Chain {
+  std::vector<std::unique_ptr<Transform>> nodes;
+
+  explicit Chain(size_t depth) {
+    for (size_t i = 0; i < depth; ++i) {
+      nodes.emplace_back(new Transform{i ? nodes.back().get() : nullptr});
+      nodes.back()->set_local_pos(glm::vec3(0.1f, 1.0f, 0.2f));
+      nodes.back()->set_local_rot(glm::angleAxis(0.05f, glm::vec3(0, 1, 0)));
+      nodes.back()->set_local_scale(glm::vec3(1.01f));
+    }
+  }
+
+  Transform* root() { return nodes.front().get(); }
+  Transform* leaf() { return nodes.back().get(); }
+};
+
+Body CachedMatrix(size_t depth) {
+  auto chain = std::make_shared<Chain>(depth);
+  return [chain](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      DoNotOptimize(chain->leaf()->matrix());
+    }
+  };
+}
+
+Body MatrixAfterRootMoved(size_t depth) {
+  auto chain = std::make_shared<Chain>(depth);
+  return [chain](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      chain->root()->set_local_pos(glm::vec3(i & 7, 0, 0));
+      DoNotOptimize(chain->leaf()->matrix());
+    }
+  };
+}
+
+Body PosRotAfterRootMoved(size_t depth) {
+  auto chain = std::make_shared<Chain>(depth);
+  return [chain](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      chain->root()->set_local_pos(glm::vec3(i & 7, 0, 0));
+      DoNotOptimize(chain->leaf()->pos());
+      DoNotOptimize(chain->leaf()->rot());
+    }
+  };
+}
+
+Body InverseMatrixAfterRootMoved(size_t depth) {
+  auto chain = std::make_shared<Chain>(depth);
+  return [chain](size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      chain->root()->set_local_pos(glm::vec3(i & 7, 0, 0));
+      DoNotOptimize(chain->leaf()->inverse_matrix());
+    }
+  };
+}
+
+Registrar cached_8{"transform/matrix_cached/depth:8", CachedMatrix(8)};
+Registrar cached_64{"transform/matrix_cached/depth:64", CachedMatrix(64)};
+Registrar moved_8{"transform/matrix_root_moved/depth:8",
+                  MatrixAfterRootMoved(8)};
+Registrar moved_64{"transform/matrix_root_moved/depth:64",
+                   MatrixAfterRootMoved(64)};
+Registrar pos_rot_64{"transform/pos_rot_root_moved/depth:64",
+                     PosRotAfterRootMoved(64)};
+Registrar inverse_64{"transform/inverse_matrix_root_moved/depth:64",
+                     InverseMatrixAfterRootMoved(64)};
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace engine
@@ -10,6 +10,7 @@
 
 #include "./timer.h"
 #include "./game_object.h"
+#include "./frame_buffered.h"
 #include "./height_map_interface.h"
 #include "collision/frustum.h"
 
@@ -21,7 +22,7 @@ class CameraTransform : public Transform {
 
   // We shouldn't inherit the parent's rotation, like how a normal Transform does
   virtual const quat rot() const override { return rot_; }
-  virtual void set_rot(const quat& new_rot) override { rot_ = new_rot; }
+  virtual void set_rot(const quat& new_rot) override { set_local_rot(new_rot); }
 
   // We have custom up and right vectors
   virtual vec3 up() const override { return up_; }
@@ -51,9 +52,9 @@ class Camera : public GameObject {
     height_ = height;
   }
 
-  const glm::mat4& cameraMatrix() const { return cam_mat_; }
-  const glm::mat4& projectionMatrix() const { return proj_mat_; }
-  const Frustum& frustum() const { return frustum_; }
+  const glm::mat4& cameraMatrix() const { return view_.get().cam_mat; }
+  const glm::mat4& projectionMatrix() const { return view_.get().proj_mat; }
+  const Frustum& frustum() const { return view_.get().frustum; }
 
   float fovx() const { return fovy_*width_/height_;}
   void set_fovx(float fovx) { fovy_ = fovx*height_/width_; }
@@ -84,24 +85,30 @@ class Camera : public GameObject {
  private:
   float fovy_, z_near_, z_far_, width_, height_;
 
-  glm::mat4 cam_mat_, proj_mat_;
-  Frustum frustum_;
+  // They are recalculated in every update, so the render thread can have
+  // its own copy.
+  struct View {
+    glm::mat4 cam_mat, proj_mat;
+    Frustum frustum;
+  };
+  FrameBuffered<View> view_;
 
   void updateCameraMatrix() {
     const Transform* t = transform();
-    cam_mat_ = glm::lookAt(t->pos(), t->pos()+t->forward(), t->up());
+    view_.get().cam_mat = glm::lookAt(t->pos(), t->pos()+t->forward(), t->up());
   }
 
   void updateProjectionMatrix() {
-    proj_mat_ = glm::perspectiveFov<float>(fovy_, width_, height_, z_near_, z_far_);
+    view_.get().proj_mat = glm::perspectiveFov<float>(fovy_, width_, height_,
+                                                      z_near_, z_far_);
   }
 
   void updateFrustum() {
-    glm::mat4 m = proj_mat_ * cam_mat_;
+    glm::mat4 m = view_.get().proj_mat * view_.get().cam_mat;
 
     // REMEMBER: m[i][j] is j-th row, i-th column!!!
 
-    frustum_ = Frustum{{
+    view_.get().frustum = Frustum{{
       // left
      {m[0][3] + m[0][0],
       m[1][3] + m[1][0],
@@ -1,4 +1,5 @@
 #include "grid_mesh.h"
+#include "../context_objects.h"
 
 #include "../../oglwrap/context.h"
 #include "../../oglwrap/smart_enums.h"
@@ -6,7 +7,10 @@
 namespace engine {
 namespace cdlod {
 
-GridMesh::GridMesh(GLubyte dimension) : dimension_(dimension) { }
+GridMesh::GridMesh(GLubyte dimension)
+    : dimension_(dimension)
+    , mesh_memory_(MemoryStats::kGpu, "terrain", "grid mesh")
+    , render_data_memory_(MemoryStats::kGpu, "terrain", "render data") { }
 
 GLushort GridMesh::indexOf(int x, int y) {
   x += dimension_/2;
@@ -49,6 +53,16 @@ void GridMesh::setupPositions(gl::VertexAttrib attrib) {
   gl::Bind(aIndices_);
   aIndices_.data(indices);
   gl::Unbind(vao_);
+
+  vao_setups_.push_back([this, attrib]() mutable {
+    gl::Bind(aPositions_);
+    attrib.pointer(2, gl::DataType::kShort).enable();
+    gl::Unbind(aPositions_);
+    gl::Bind(aIndices_);
+  });
+
+  mesh_memory_.set_bytes(positions.size() * sizeof(svec2) +
+                         indices.size() * sizeof(GLushort));
 }
 
 void GridMesh::setupRenderData(gl::VertexAttrib attrib) {
@@ -59,19 +73,26 @@ void GridMesh::setupRenderData(gl::VertexAttrib attrib) {
     attrib.setup<glm::vec4>().enable();
     attrib.divisor(1);
     gl::Unbind(vao_);
+
+    vao_setups_.push_back([this, attrib]() mutable {
+      gl::Bind(aRenderData_);
+      attrib.setup<glm::vec4>().enable();
+      attrib.divisor(1);
+    });
   }
 #endif
 }
 
-void GridMesh::addToRenderList(const glm::vec4& render_data) {
-  render_data_.push_back(render_data);
-}
-
-void GridMesh::clearRenderList() {
-  render_data_.erase(render_data_.begin(), render_data_.end());
+void GridMesh::recreateVertexArray() {
+  ContextObjects::Recreate(&vao_);
+  gl::Bind(vao_);
+  for (auto& setup : vao_setups_) {
+    setup();
+  }
+  gl::Unbind(vao_);
 }
 
-void GridMesh::render() {
+void GridMesh::render(const std::vector<glm::vec4>& render_data) {
 #if defined(glDrawElementsInstanced) && defined(glVertexAttribDivisor)
   if (glVertexAttribDivisor) {
     using gl::PrimType;
@@ -79,23 +100,30 @@ void GridMesh::render() {
 
     gl::Bind(vao_);
     gl::Bind(aRenderData_);
-    aRenderData_.data(render_data_);
+    aRenderData_.data(render_data);
+    // The number of nodes changes almost every frame, so only the largest
+    // upload is registered, instead of locking the stats every frame.
+    size_t bytes = render_data.size() * sizeof(glm::vec4);
+    if (bytes > render_data_memory_.bytes()) {
+      render_data_memory_.set_bytes(bytes);
+    }
 
     gl::DrawElementsInstanced(PrimType::kTriangleStrip,
                               index_count_,
                               IndexType::kUnsignedShort,
-                              render_data_.size());   // instance count
+                              render_data.size());   // instance count
     gl::Unbind(vao_);
   }
 #endif
 }
 
-void GridMesh::render(gl::UniformObject<glm::vec4> uRenderData) const {
+void GridMesh::render(const std::vector<glm::vec4>& render_data,
+                      gl::UniformObject<glm::vec4> uRenderData) const {
   using gl::PrimType;
   using gl::IndexType;
 
   gl::Bind(vao_);
-  for(auto& data : render_data_) {
+  for(auto& data : render_data) {
     uRenderData = data;
     gl::DrawElements(PrimType::kTriangleStrip,
                     index_count_,
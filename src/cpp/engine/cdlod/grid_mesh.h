@@ -3,10 +3,14 @@
 #ifndef ENGINE_CDLOD_GRID_MESH_H_
 #define ENGINE_CDLOD_GRID_MESH_H_
 
+#include <vector>
+#include <functional>
+
 #include "../oglwrap_config.h"
 #include "../../oglwrap/buffer.h"
 #include "../../oglwrap/vertex_attrib.h"
 #include "../../oglwrap/uniform.h"
+#include "../memory_stats.h"
 
 namespace engine {
 
@@ -35,7 +39,10 @@ class GridMesh {
   gl::IndexBuffer aIndices_;
   gl::ArrayBuffer aPositions_, aRenderData_;
   int index_count_, dimension_;
-  std::vector<glm::vec4> render_data_; // xy: offset, z: scale, w: level
+  // The size of the positions and the indices, and of the render data.
+  MemoryStats::Allocation mesh_memory_, render_data_memory_;
+  // The attribute setups of the vao, for recreateVertexArray.
+  std::vector<std::function<void()>> vao_setups_;
 
   GLushort indexOf(int x, int y);
 
@@ -43,16 +50,18 @@ class GridMesh {
   GridMesh(GLubyte dimension);
   void setupPositions(gl::VertexAttrib attrib);
   void setupRenderData(gl::VertexAttrib attrib);
+  // Recreates the vao on the current context, with the same attributes, if
+  // it was set up on another one (see ContextObjects).
+  void recreateVertexArray();
 
-  // xy: offset, z: scale, w: level
-  void addToRenderList(const glm::vec4& render_data);
-  void clearRenderList();
-
+  // Renders an instance for every element of render_data
+  // (xy: offset, z: scale, w: level).
   // render with vertex attrib divisor
-  void render();
+  void render(const std::vector<glm::vec4>& render_data);
 
   // render with uniforms
-  void render(gl::UniformObject<glm::vec4> uRenderData) const;
+  void render(const std::vector<glm::vec4>& render_data,
+              gl::UniformObject<glm::vec4> uRenderData) const;
 
   int dimension() const {return dimension_;}
 };
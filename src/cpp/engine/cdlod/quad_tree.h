@@ -5,9 +5,10 @@
 
 #include <memory>
 #include "./quad_grid_mesh.h"
+#include "./quad_tree_node.h"
 #include "../camera.h"
-#include "../collision/bounding_box.h"
 #include "../height_map_interface.h"
+#include "../memory_stats.h"
 
 namespace engine {
 namespace cdlod {
@@ -16,46 +17,22 @@ class QuadTree {
   QuadGridMesh mesh_;
   GLubyte node_dimension_;
 
-  struct Node {
-    GLshort x, z;
-    BoundingBox bbox;
-    GLushort size;
-    GLubyte level;
-    std::unique_ptr<Node> tl, tr, bl, br;
-
-    Node(GLshort x, GLshort z, GLubyte level, GLubyte dimension, bool root = false);
-
-    // Helper to create the quadtree in four threads
-    static void Init(GLshort x, GLshort z, GLubyte level,
-                     GLubyte dimension, std::unique_ptr<Node>* node);
-
-    bool collidesWithSphere(const glm::vec3& center, float radius) {
-      return bbox.collidesWithSphere(center, radius);
-    }
-
-    void countMinMaxOfArea(const HeightMapInterface& hmap,
-                           double *min, double *max, bool root = false);
-
-    // Helper to run countMinMaxOfArea in thread
-    static void CountMinMaxOfArea(Node* node, const HeightMapInterface& hmap,
-                                  double *min, double *max) {
-      node->countMinMaxOfArea(hmap, min, max);
-    }
-
-    void selectNodes(const glm::vec3& cam_pos, const Frustum& frustum,
-                     QuadGridMesh& grid_mesh, int node_dimension);
-  };
-
-  Node root_;
+  QuadTreeNode root_;
+  QuadTreeSelection selection_;
+  MemoryStats::Allocation nodes_memory_;
 
  public:
   QuadTree(const HeightMapInterface& hmap, int node_dimension = 128)
       : mesh_(node_dimension), node_dimension_(node_dimension)
       , root_(hmap.w()/2, hmap.h()/2,
         std::max(log2(std::max(hmap.w(), hmap.h())) - log2(node_dimension), 0.0),
-        node_dimension, true) {
+        node_dimension)
+      , selection_(node_dimension)
+      , nodes_memory_(MemoryStats::kCpu, "quadtree", "nodes",
+                      QuadTreeNode::NodeCount(root_.level) *
+                      sizeof(QuadTreeNode)) {
     double min, max;
-    root_.countMinMaxOfArea(hmap, &min, &max, true);
+    root_.countMinMaxOfArea(hmap, &min, &max);
   }
 
   GLubyte node_dimension() const {
@@ -71,21 +48,39 @@ class QuadTree {
     mesh_.setupRenderData(attrib);
   }
 
+  // See GridMesh::recreateVertexArray.
+  void recreateVertexArray() {
+    mesh_.recreateVertexArray();
+  }
+
+  // Selects the nodes to render. It doesn't use OpenGL, so it can run on a
+  // worker thread, but not while the selection is rendered.
+  void select(const glm::vec3& cam_pos, const Frustum& frustum) {
+    selection_.clear();
+    root_.selectNodes(cam_pos, frustum, &selection_);
+  }
+
+  // render the last selection with vertex attrib divisor
+  void renderSelected() {
+    mesh_.render(selection_.render_data());
+  }
+
+  // render the last selection with uniforms
+  void renderSelected(const gl::UniformObject<glm::vec4>& uRenderData) {
+    mesh_.render(selection_.render_data(), uRenderData);
+  }
+
   // render with vertex attrib divisor
   void render(const engine::Camera& cam) {
-    mesh_.clearRenderList();
-    root_.selectNodes(cam.transform()->pos(), cam.frustum(),
-                      mesh_, node_dimension_);
-    mesh_.render();
+    select(cam.transform()->pos(), cam.frustum());
+    renderSelected();
   }
 
   // render with uniforms
   void render(const engine::Camera& cam,
               const gl::UniformObject<glm::vec4>& uRenderData) {
-    mesh_.clearRenderList();
-    root_.selectNodes(cam.transform()->pos(), cam.frustum(),
-                      mesh_, node_dimension_);
-    mesh_.render(uRenderData);
+    select(cam.transform()->pos(), cam.frustum());
+    renderSelected(uRenderData);
   }
 };
 
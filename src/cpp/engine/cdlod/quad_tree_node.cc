@@ -0,0 +1,112 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <algorithm>
+#include "./quad_tree_node.h"
+#include "../misc.h"
+#include "../job_system.h"
+
+namespace engine {
+namespace cdlod {
+
+constexpr uint8_t QuadTreeNode::kMinParallelLevel;
+
+QuadTreeNode::QuadTreeNode(int16_t x, int16_t z, uint8_t level,
+                           uint8_t dimension)
+    : x(x), z(z), size(dimension * (1 << level)), level(level)
+    , tl(nullptr), tr(nullptr), bl(nullptr), br(nullptr) {
+  if (level > 0) {
+    if (level >= kMinParallelLevel) {
+      // The creation of say a 14-depth quadtree is slow, so the upper levels
+      // build their subtrees as parallel jobs.
+      JobSystem::TaskGroup group;
+      group.run([&]() {
+        tl = make_unique<QuadTreeNode>(x-size/4, z+size/4, level-1, dimension);
+      });
+      group.run([&]() {
+        tr = make_unique<QuadTreeNode>(x+size/4, z+size/4, level-1, dimension);
+      });
+      group.run([&]() {
+        bl = make_unique<QuadTreeNode>(x-size/4, z-size/4, level-1, dimension);
+      });
+      br = make_unique<QuadTreeNode>(x+size/4, z-size/4, level-1, dimension);
+      group.wait();
+    } else {
+      tl = make_unique<QuadTreeNode>(x-size/4, z+size/4, level-1, dimension);
+      tr = make_unique<QuadTreeNode>(x+size/4, z+size/4, level-1, dimension);
+      bl = make_unique<QuadTreeNode>(x-size/4, z-size/4, level-1, dimension);
+      br = make_unique<QuadTreeNode>(x+size/4, z-size/4, level-1, dimension);
+    }
+  }
+}
+
+void QuadTreeNode::countMinMaxOfArea(const HeightMapInterface& hmap,
+                                     double *min, double *max) {
+  glm::dvec2 min_xz(x-size/2, z-size/2);
+  glm::dvec2 max_xz(x+size/2, z+size/2);
+
+  if (level == 0) {
+    glm::dvec2 min_max_y = hmap.getMinMaxOfArea(x, z, size, size);
+    *min = min_max_y.x;
+    *max = min_max_y.y;
+  } else {
+    double tl_min, tr_min, bl_min, br_min;
+    double tl_max, tr_max, bl_max, br_max;
+    if (level >= kMinParallelLevel) {
+      JobSystem::TaskGroup group;
+      group.run([&]() { tl->countMinMaxOfArea(hmap, &tl_min, &tl_max); });
+      group.run([&]() { tr->countMinMaxOfArea(hmap, &tr_min, &tr_max); });
+      group.run([&]() { bl->countMinMaxOfArea(hmap, &bl_min, &bl_max); });
+      br->countMinMaxOfArea(hmap, &br_min, &br_max);
+      group.wait();
+    } else {
+      tl->countMinMaxOfArea(hmap, &tl_min, &tl_max);
+      tr->countMinMaxOfArea(hmap, &tr_min, &tr_max);
+      bl->countMinMaxOfArea(hmap, &bl_min, &bl_max);
+      br->countMinMaxOfArea(hmap, &br_min, &br_max);
+    }
+    *min = std::min(tl_min, std::min(tr_min, std::min(bl_min, br_min)));
+    *max = std::max(tl_max, std::max(tr_max, std::max(bl_max, br_max)));
+  }
+
+  bbox = BoundingBox{glm::vec3(min_xz.x, *min, min_xz.y),
+                     glm::vec3(max_xz.x, *max, max_xz.y)};
+}
+
+void QuadTreeNode::selectNodes(const glm::vec3& cam_pos,
+                               const Frustum& frustum,
+                               QuadTreeSelection* selection) const {
+  float scale = 1 << level;
+  float lod_range = scale * 128;
+
+  if (!bbox.collidesWithFrustum(frustum)) { return; }
+
+  // if we can cover the whole area or if we are a leaf
+  if (!bbox.collidesWithSphere(cam_pos, lod_range) || level == 0) {
+    selection->add(x, z, scale, level);
+  } else {
+    bool btl = tl->collidesWithSphere(cam_pos, lod_range);
+    bool btr = tr->collidesWithSphere(cam_pos, lod_range);
+    bool bbl = bl->collidesWithSphere(cam_pos, lod_range);
+    bool bbr = br->collidesWithSphere(cam_pos, lod_range);
+
+    // Ask childs to render what we can't
+    if (btl) {
+      tl->selectNodes(cam_pos, frustum, selection);
+    }
+    if (btr) {
+      tr->selectNodes(cam_pos, frustum, selection);
+    }
+    if (bbl) {
+      bl->selectNodes(cam_pos, frustum, selection);
+    }
+    if (bbr) {
+      br->selectNodes(cam_pos, frustum, selection);
+    }
+
+    // Render, what the childs didn't do
+    selection->add(x, z, scale, level, !btl, !btr, !bbl, !bbr);
+  }
+}
+
+}  // namespace cdlod
+}  // namespace engine
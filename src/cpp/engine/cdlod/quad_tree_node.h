@@ -0,0 +1,84 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_CDLOD_QUAD_TREE_NODE_H_
+#define ENGINE_CDLOD_QUAD_TREE_NODE_H_
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+#include "../collision/bounding_box.h"
+#include "../collision/frustum.h"
+#include "../height_map_interface.h"
+
+namespace engine {
+namespace cdlod {
+
+// The nodes selected for rendering, as the instance data of the grid mesh
+// (xy: offset, z: scale, w: level). Building it doesn't use OpenGL.
+class QuadTreeSelection {
+ public:
+  // The dimension of a node, that is the size of the four subquads together.
+  explicit QuadTreeSelection(int node_dimension)
+      : node_dimension_(node_dimension) {}
+
+  void clear() { render_data_.clear(); }
+
+  // Adds a node's subquads. tl = top left, br = bottom right
+  void add(float offset_x, float offset_y, float scale, float level,
+           bool tl, bool tr, bool bl, bool br) {
+    glm::vec4 data(offset_x, offset_y, scale, level);
+    float dim4 = scale * node_dimension_/4;
+    if (tl) { render_data_.push_back(data + glm::vec4(-dim4, dim4, 0, 0)); }
+    if (tr) { render_data_.push_back(data + glm::vec4(dim4, dim4, 0, 0)); }
+    if (bl) { render_data_.push_back(data + glm::vec4(-dim4, -dim4, 0, 0)); }
+    if (br) { render_data_.push_back(data + glm::vec4(dim4, -dim4, 0, 0)); }
+  }
+
+  // Adds all four subquads
+  void add(float offset_x, float offset_y, float scale, float level) {
+    add(offset_x, offset_y, scale, level, true, true, true, true);
+  }
+
+  const std::vector<glm::vec4>& render_data() const { return render_data_; }
+
+ private:
+  int node_dimension_;
+  std::vector<glm::vec4> render_data_;
+};
+
+// A node of the CDLOD quadtree. It only uses the CPU: the rendering is done
+// by the QuadTree, so the nodes can be built and selected without a context.
+struct QuadTreeNode {
+  int16_t x, z;
+  BoundingBox bbox;
+  uint16_t size;
+  uint8_t level;
+  std::unique_ptr<QuadTreeNode> tl, tr, bl, br;
+
+  // Nodes at least this high process their children as parallel jobs.
+  static constexpr uint8_t kMinParallelLevel = 3;
+
+  QuadTreeNode(int16_t x, int16_t z, uint8_t level, uint8_t dimension);
+
+  bool collidesWithSphere(const glm::vec3& center, float radius) const {
+    return bbox.collidesWithSphere(center, radius);
+  }
+
+  void countMinMaxOfArea(const HeightMapInterface& hmap,
+                         double *min, double *max);
+
+  void selectNodes(const glm::vec3& cam_pos, const Frustum& frustum,
+                   QuadTreeSelection* selection) const;
+
+  // A full quadtree with levels 0..level has (4^(level+1) - 1) / 3 nodes.
+  static size_t NodeCount(uint8_t level) {
+    return ((size_t(1) << 2*(level+1)) - 1) / 3;
+  }
+};
+
+}  // namespace cdlod
+}  // namespace engine
+
+#endif
@@ -2,13 +2,16 @@
 
 #include "./terrain_mesh.h"
 #include "../../oglwrap/smart_enums.h"
+#include "../profiler.h"
 
 namespace engine {
 namespace cdlod {
 
 TerrainMesh::TerrainMesh(engine::ShaderManager* manager,
                          const HeightMapInterface& height_map)
-    : mesh_(height_map), height_map_(height_map) {
+    : mesh_(height_map)
+    , height_map_memory_(MemoryStats::kGpu, "terrain", "height map")
+    , height_map_(height_map), is_setup_(false) {
   gl::ShaderSource vs_src{"engine/cdlod_terrain.vert"};
 
   #ifdef glVertexAttribDivisor
@@ -36,40 +39,47 @@ void TerrainMesh::setup(const gl::Program& program, int tex_unit) {
           program, "CDLODTerrain_uRenderData");
     }
 
-  uCamPos_ = engine::make_unique<gl::LazyUniform<glm::vec3>>(
-      program, "CDLODTerrain_uCamPos");
-
   tex_unit_ = tex_unit;
+  is_setup_ = true;
   gl::UniformSampler(program, "CDLODTerrain_uHeightMap") = tex_unit;
   gl::Uniform<glm::vec2>(program, "CDLODTerrain_uTexSize") =
       glm::vec2(height_map_.w(), height_map_.h());
 
   gl::BindToTexUnit(height_map_tex_, tex_unit);
   height_map_.upload(height_map_tex_);
+  height_map_memory_.set_bytes(MemoryStats::BoundTextureBytes());
   height_map_tex_.minFilter(gl::kLinear);
   height_map_tex_.magFilter(gl::kLinear);
   gl::Unbind(height_map_tex_);
 }
 
 void TerrainMesh::render(const Camera& cam) {
-  if (!uCamPos_) {
+  select(cam.transform()->pos(), cam.frustum());
+  renderSelected();
+}
+
+void TerrainMesh::select(const glm::vec3& cam_pos, const Frustum& frustum) {
+  ENGINE_PROFILE_SCOPE("CDLOD selection");
+  mesh_.select(cam_pos, frustum);
+}
+
+void TerrainMesh::renderSelected() {
+  if (!is_setup_) {
     throw std::logic_error("engine::cdlod::terrain requires a setup() call, "
                            "before the use of the render() function.");
   }
 
   gl::BindToTexUnit(height_map_tex_, tex_unit_);
 
-  uCamPos_->set(cam.transform()->pos());
-
   gl::FrontFace(gl::kCcw);
   gl::TemporaryEnable cullface{gl::kCullFace};
 
   #ifdef glVertexAttribDivisor
     if (glVertexAttribDivisor)
-      mesh_.render(cam);
+      mesh_.renderSelected();
     else
   #endif
-    mesh_.render(cam, *uRenderData_);
+    mesh_.renderSelected(*uRenderData_);
 
   gl::UnbindFromTexUnit(height_map_tex_, tex_unit_);
 }
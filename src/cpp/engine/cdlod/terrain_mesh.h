@@ -11,6 +11,7 @@
 #include "../../oglwrap/textures/texture_2D.h"
 
 #include "./quad_tree.h"
+#include "../memory_stats.h"
 #include "../shader_manager.h"
 
 namespace engine {
@@ -22,16 +23,24 @@ class TerrainMesh {
   explicit TerrainMesh(engine::ShaderManager* manager,
                        const HeightMapInterface& height_map);
   void setup(const gl::Program& program, int tex_unit);
+  // See GridMesh::recreateVertexArray.
+  void recreateVertexArray() { mesh_.recreateVertexArray(); }
   void render(const Camera& cam);
+
+  // Selects the nodes to render, without using OpenGL (see QuadTree::select).
+  void select(const glm::vec3& cam_pos, const Frustum& frustum);
+  // Renders the nodes selected by the last select() call.
+  void renderSelected();
   const HeightMapInterface& height_map() { return height_map_; }
 
  private:
   QuadTree mesh_;
   gl::Texture2D height_map_tex_;
+  MemoryStats::Allocation height_map_memory_;
   std::unique_ptr<gl::LazyUniform<glm::vec4>> uRenderData_;
-  std::unique_ptr<gl::LazyUniform<glm::vec3>> uCamPos_;
   const HeightMapInterface& height_map_;
   int tex_unit_;
+  bool is_setup_;
 };
 
 }  // namespace cdlod
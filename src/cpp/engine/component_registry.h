@@ -0,0 +1,139 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_COMPONENT_REGISTRY_H_
+#define ENGINE_COMPONENT_REGISTRY_H_
+
+#include <memory>
+#include <vector>
+#include <typeindex>
+#include <unordered_map>
+
+namespace engine {
+
+class GameObject;
+
+// Indexes the objects of a scene by type, so that they can be found without
+// walking the scene graph. An index for a type T is built at the first query
+// for T, and after that, it is kept up to date as objects are added or
+// removed, both in constant time.
+//
+// The objects are in the order they were registered in (a GameObject is
+// registered after its constructor added its components, so the components
+// come first), except that removing an object moves the last one into its
+// place. So the order doesn't match the depth first search of
+// GameObject::findComponent, and it shouldn't be relied on, if there might be
+// more than one object of a type.
+template<typename Object>
+class BasicComponentRegistry {
+ public:
+  BasicComponentRegistry() = default;
+  BasicComponentRegistry(const BasicComponentRegistry&) = delete;
+  BasicComponentRegistry& operator=(const BasicComponentRegistry&) = delete;
+
+  // Registers a fully constructed object (but not its components).
+  // Registering an object twice has no effect.
+  void add(Object* obj) {
+    if (objects_.add(obj, obj)) {
+      for (auto& index : indices_) {
+        index.second->add(obj);
+      }
+    }
+  }
+
+  // Can be called from the object's destructor too.
+  void remove(Object* obj) {
+    if (objects_.remove(obj)) {
+      for (auto& index : indices_) {
+        index.second->remove(obj);
+      }
+    }
+  }
+
+  // Returns the first registered object whose type is T, or nullptr.
+  template<typename T>
+  T* first() {
+    const std::vector<T*>& found = all<T>();
+    return found.empty() ? nullptr : found.front();
+  }
+
+  // Returns all the registered objects whose type is T.
+  template<typename T>
+  const std::vector<T*>& all() {
+    std::unique_ptr<IndexBase>& index = indices_[std::type_index(typeid(T))];
+    if (!index) {
+      Index<T>* new_index = new Index<T>{};
+      index = std::unique_ptr<IndexBase>{new_index};
+      for (Object* obj : objects_.values) {
+        new_index->add(obj);
+      }
+    }
+    return static_cast<Index<T>*>(index.get())->found.values;
+  }
+
+ private:
+  // The values are keyed by the objects. Every key knows its slot, so that it
+  // can be removed by moving the last value into its place.
+  template<typename T>
+  struct SlotVector {
+    std::vector<T*> values;
+    std::vector<const Object*> keys;
+    std::unordered_map<const Object*, size_t> slots;
+
+    // Returns false if the key is already added.
+    bool add(const Object* key, T* value) {
+      if (!slots.emplace(key, values.size()).second) { return false; }
+      values.push_back(value);
+      keys.push_back(key);
+      return true;
+    }
+
+    // Returns false if the key wasn't added.
+    bool remove(const Object* key) {
+      auto iter = slots.find(key);
+      if (iter == slots.end()) { return false; }
+      size_t slot = iter->second;
+      slots.erase(iter);
+
+      if (slot + 1 != values.size()) {
+        values[slot] = values.back();
+        keys[slot] = keys.back();
+        slots[keys[slot]] = slot;
+      }
+      values.pop_back();
+      keys.pop_back();
+      return true;
+    }
+  };
+
+  struct IndexBase {
+    virtual ~IndexBase() {}
+    virtual void add(Object* obj) = 0;
+    virtual void remove(Object* obj) = 0;
+  };
+
+  template<typename T>
+  struct Index : public IndexBase {
+    SlotVector<T> found;
+
+    virtual void add(Object* obj) override {
+      T* t = dynamic_cast<T*>(obj);
+      if (t) {
+        found.add(obj, t);
+      }
+    }
+
+    // The object might be under destruction, so it can't be dynamic_casted.
+    virtual void remove(Object* obj) override {
+      found.remove(obj);
+    }
+  };
+
+  SlotVector<Object> objects_;
+  std::unordered_map<std::type_index, std::unique_ptr<IndexBase>> indices_;
+};
+
+using ComponentRegistry = BasicComponentRegistry<GameObject>;
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,43 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_CONTEXT_OBJECTS_H_
+#define ENGINE_CONTEXT_OBJECTS_H_
+
+#include <memory>
+#include <vector>
+#include <utility>
+
+namespace engine {
+
+// The OpenGL container objects (vertex arrays and framebuffers) aren't shared
+// between contexts, unlike the buffers, textures and programs. The scenes,
+// that are created on the loader's context (see GameEngine::LoadSceneAsync),
+// recreate them on the window's context in GameObject::contextChanged(). The
+// replaced objects are kept until they can be deleted on the context they
+// were created on, as their names might mean other objects in the window's.
+class ContextObjects {
+ public:
+  // Replaces a vertex array, a framebuffer or a shape (which owns a vertex
+  // array) with a new one, that is created with args on the current context.
+  template<typename T, typename... Args>
+  static void Recreate(T* object, Args&&... args) {
+    Replaced().push_back(std::shared_ptr<void>{
+        new T(std::move(*object)),
+        [](void* replaced) { delete static_cast<T*>(replaced); }});
+    *object = T(std::forward<Args>(args)...);
+  }
+
+  // Deletes the replaced objects. The context, that they were created on,
+  // must be current.
+  static void DeleteReplaced() { Replaced().clear(); }
+
+ private:
+  static std::vector<std::shared_ptr<void>>& Replaced() {
+    static std::vector<std::shared_ptr<void>> replaced;
+    return replaced;
+  }
+};
+
+}  // namespace engine
+
+#endif
@@ -11,11 +11,11 @@ namespace debug {
 template<typename Shape_t>
 Shape_t *DebugShape<Shape_t>::shape_ = nullptr;
 template<typename Shape_t>
-engine::ShaderProgram *DebugShape<Shape_t>::prog_ = nullptr;
+GLFWwindow *DebugShape<Shape_t>::shape_context_ = nullptr;
 template<typename Shape_t>
-gl::LazyUniform<glm::mat4> *DebugShape<Shape_t>::uProjectionMatrix_;
+engine::ShaderProgram *DebugShape<Shape_t>::prog_ = nullptr;
 template<typename Shape_t>
-gl::LazyUniform<glm::mat4> *DebugShape<Shape_t>::uCameraMatrix_;
+RenderQueue::State *DebugShape<Shape_t>::state_ = nullptr;
 template<typename Shape_t>
 gl::LazyUniform<glm::mat4> *DebugShape<Shape_t>::uModelMatrix_;
 template<typename Shape_t>
@@ -24,36 +24,95 @@ gl::LazyUniform<glm::vec3> *DebugShape<Shape_t>::uColor_;
 template<typename Shape_t>
 DebugShape<Shape_t>::DebugShape(GameObject* parent, const glm::vec3& color)
       : GameObject(parent), color_(color) {
+  InitStatics(scene_);
+}
+
+template<typename Shape_t>
+void DebugShape<Shape_t>::InitStatics(Scene* scene) {
   if (!shape_) {
     shape_ = new Shape_t{{Shape_t::kPosition, Shape_t::kNormal}};
+    shape_context_ = glfwGetCurrentContext();
   }
   if (!prog_) {
     prog_ = new engine::ShaderProgram{
-                scene_->shader_manager()->get("engine/simple_shape.vert"),
-                scene_->shader_manager()->get("engine/simple_shape.frag")};
+                scene->shader_manager()->get("engine/simple_shape.vert"),
+                scene->shader_manager()->get("engine/simple_shape.frag")};
     (*prog_ | "aPosition").bindLocation(shape_->kPosition);
     (*prog_ | "aNormal").bindLocation(shape_->kNormal);
-    uProjectionMatrix_ = new gl::LazyUniform<glm::mat4>{*prog_, "uProjectionMatrix"};
-    uCameraMatrix_ = new gl::LazyUniform<glm::mat4>{*prog_, "uCameraMatrix"};
     uModelMatrix_ = new gl::LazyUniform<glm::mat4>{*prog_, "uModelMatrix"};
     uColor_ = new gl::LazyUniform<glm::vec3>{*prog_, "uColor"};
+    state_ = new RenderQueue::State{prog_, RenderQueue::kCullFace,
+                                    [](const Camera&) {
+      gl::FrontFace(shape_->faceWinding());
+    }};
+  }
+}
+
+template<typename Shape_t>
+void DebugShape<Shape_t>::contextChanged() {
+  // The shape is shared by every instance, it's only recreated once.
+  if (shape_context_ != glfwGetCurrentContext()) {
+    ContextObjects::Recreate(
+        shape_, Shape_t({Shape_t::kPosition, Shape_t::kNormal}));
+    shape_context_ = glfwGetCurrentContext();
   }
 }
 
 template<typename Shape_t>
 void DebugShape<Shape_t>::render() {
-  gl::Use(*prog_);
-  const auto& cam = *scene_->camera();
-  uCameraMatrix_->set(cam.cameraMatrix());
-  uProjectionMatrix_->set(cam.projectionMatrix());
-  uModelMatrix_->set(transform()->matrix());
-  uColor_->set(color_);
-
-  gl::FrontFace(shape_->faceWinding());
-  gl::TemporaryEnable cullface{gl::kCullFace};
+  PushInstance(scene_, instance_.get());
+}
+
+template<typename Shape_t>
+void DebugShape<Shape_t>::PushInstance(Scene* scene,
+                                       const Instance& instance) {
+  // The transform of the camera might be updated during rendering, but its
+  // matrices are buffered per frame.
+  glm::vec4 view_pos = scene->camera()->cameraMatrix() *
+                       instance.model_matrix[3];
+  scene->render_queue()->push(RenderQueue::kOpaque, -view_pos.z,
+                              RenderQueue::Command{
+                                state_, RenderQueue::Material{},
+                                &DebugShape::DrawInstance, nullptr, shape_, 0,
+                                instance.model_matrix,
+                                glm::vec4(instance.color, 1.0f),
+                                nullptr});
+}
+
+template<typename Shape_t>
+void DebugShape<Shape_t>::DrawInstance(const RenderQueue::Command& command,
+                                       const Camera&) {
+  uModelMatrix_->set(command.model_matrix);
+  uColor_->set(glm::vec3(command.param));
   shape_->render();
 }
 
+template<typename Shape_t>
+void DebugShape<Shape_t>::CollectEntities(Scene* scene,
+                                          std::vector<Instance>* instances,
+                                          unsigned mesh_id) {
+  scene->entities().eachChunk<ecs::TransformComponent, ecs::RenderHandle>(
+      [instances, mesh_id](size_t count, const ecs::Entity*,
+                           ecs::TransformComponent* transforms,
+                           ecs::RenderHandle* render_handles) {
+    for (size_t i = 0; i < count; ++i) {
+      const ecs::RenderHandle& handle = render_handles[i];
+      if (handle.visible && handle.mesh == mesh_id) {
+        instances->push_back(Instance{transforms[i].matrix, handle.color});
+      }
+    }
+  });
+}
+
+template<typename Shape_t>
+void DebugShape<Shape_t>::RenderInstances(
+    Scene* scene, const std::vector<Instance>& instances) {
+  InitStatics(scene);
+  for (const Instance& instance : instances) {
+    PushInstance(scene, instance);
+  }
+}
+
 }  // namespace debug
 }  // namespace engine
 
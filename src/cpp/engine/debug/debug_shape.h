@@ -9,8 +9,14 @@
 #include "../../oglwrap/shapes/cube_shape.h"
 #include "../../oglwrap/shapes/sphere_shape.h"
 
+#include <vector>
+
 #include "../scene.h"
 #include "../game_object.h"
+#include "../render_queue.h"
+#include "../frame_buffered.h"
+#include "../ecs/components.h"
+#include "../context_objects.h"
 
 namespace engine {
 namespace debug {
@@ -23,16 +29,46 @@ class DebugShape : public GameObject {
   glm::vec3 color() { return color_; }
   void set_color(const glm::vec3& color) { color_ = color; }
 
+  // What is needed to render a shape.
+  struct Instance {
+    glm::mat4 model_matrix;
+    glm::vec3 color;
+  };
+
+  // Appends every entity of the scene, that has a TransformComponent and a
+  // visible RenderHandle with the given mesh id. It doesn't use OpenGL, so
+  // it can be called from prepareRender().
+  static void CollectEntities(Scene* scene, std::vector<Instance>* instances,
+                              unsigned mesh_id = 0);
+
+  // Queues a draw of the shape for every instance into the scene's render
+  // queue. The program is only set up once for all of them (and for the
+  // other debug shapes of the same type).
+  static void RenderInstances(Scene* scene,
+                              const std::vector<Instance>& instances);
+
  private:
+  static void InitStatics(Scene* scene);
+  static void PushInstance(Scene* scene, const Instance& instance);
+  static void DrawInstance(const RenderQueue::Command& command,
+                           const Camera& camera);
+
   static Shape_t *shape_;
+  // The context that the shape_'s vertex array was created on.
+  static GLFWwindow *shape_context_;
 
   static engine::ShaderProgram *prog_;
-  static gl::LazyUniform<glm::mat4> *uProjectionMatrix_, *uCameraMatrix_,
-                                    *uModelMatrix_;
+  static RenderQueue::State *state_;
+  static gl::LazyUniform<glm::mat4> *uModelMatrix_;
   static gl::LazyUniform<glm::vec3> *uColor_;
   glm::vec3 color_;
+  FrameBuffered<Instance> instance_;
 
+  virtual void prepareRender() override {
+    instance_.get() = Instance{transform()->matrix(), color_};
+  }
   virtual void render() override;
+  virtual void contextChanged() override;
 };
 
 using Cube = DebugShape<gl::CubeShape>;
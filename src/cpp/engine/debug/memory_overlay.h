@@ -0,0 +1,88 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_DEBUG_MEMORY_OVERLAY_H_
+#define ENGINE_DEBUG_MEMORY_OVERLAY_H_
+
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+
+#include "../profiler.h"
+#include "../memory_stats.h"
+#include "../game_object.h"
+#include "../gui/label.h"
+
+namespace engine {
+namespace debug {
+
+// Shows the live and the peak memory of every category, in megabytes.
+// Toggled with F5 (it starts hidden), and F6 dumps the stats to the stdout.
+class MemoryOverlay : public GameObject {
+ public:
+  static constexpr size_t kMaxRows = 12;
+
+  explicit MemoryOverlay(GameObject* parent,
+                         const gui::Font& font = gui::Font{
+                           "src/resources/fonts/Vera.ttf", 14,
+                           glm::vec4(0, 1, 1, 1)})
+      : GameObject(parent), kRefreshInterval(1.0), visible_(false)
+      , last_refresh_(0) {
+    for (size_t i = 0; i < kMaxRows; ++i) {
+      rows_.push_back(addComponent<gui::Label>(
+          L" ", glm::vec2{-0.95f, -0.3f - 0.05f * i}, font));
+      rows_.back()->set_enabled(false);
+    }
+  }
+
+ private:
+  const double kRefreshInterval;  // seconds
+  bool visible_;
+  std::vector<gui::Label*> rows_;
+  double last_refresh_;
+
+  virtual void keyAction(int key, int scancode, int action, int mods) override {
+    if (action != GLFW_PRESS) { return; }
+    if (key == GLFW_KEY_F5) {
+      visible_ = !visible_;
+      for (gui::Label* row : rows_) { row->set_enabled(visible_); }
+    } else if (key == GLFW_KEY_F6) {
+      MemoryStats::Dump(std::cout);
+    }
+  }
+
+  // The labels use OpenGL, so they are updated here.
+  virtual void render2D() override {
+    double now = Profiler::Now() / 1e6;
+    if (!visible_ || now - last_refresh_ < kRefreshInterval) { return; }
+    last_refresh_ = now;
+
+    auto megabytes = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+    std::vector<std::wstring> lines;
+    for (MemoryStats::Kind kind : {MemoryStats::kCpu, MemoryStats::kGpu}) {
+      std::wostringstream total;
+      total << std::fixed << std::setprecision(1)
+            << (kind == MemoryStats::kCpu ? L"CPU" : L"GPU") << L" total: "
+            << megabytes(MemoryStats::Total(kind)) << L" MB";
+      lines.push_back(total.str());
+    }
+    for (const MemoryStats::Category& category : MemoryStats::Categories()) {
+      std::wostringstream text;
+      text << std::fixed << std::setprecision(1)
+           << (category.kind == MemoryStats::kCpu ? L"CPU " : L"GPU ")
+           << std::wstring(category.name.begin(), category.name.end())
+           << L": " << megabytes(category.live) << L" MB (peak "
+           << megabytes(category.peak) << L" MB)";
+      lines.push_back(text.str());
+    }
+
+    for (size_t row = 0; row < kMaxRows; ++row) {
+      rows_[row]->set_text(row < lines.size() ? lines[row] : L" ");
+    }
+  }
+};
+
+}  // namespace debug
+}  // namespace engine
+
+#endif
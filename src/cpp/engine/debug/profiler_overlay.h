@@ -0,0 +1,114 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_DEBUG_PROFILER_OVERLAY_H_
+#define ENGINE_DEBUG_PROFILER_OVERLAY_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+
+#include "../profiler.h"
+#include "../allocation_counter.h"
+#include "../game_object.h"
+#include "../gui/label.h"
+
+namespace engine {
+namespace debug {
+
+// Shows the average time of the top level CPU scopes and of the GPU scopes,
+// in milliseconds per frame, and the heap allocations per frame (if they are
+// counted). The top level scopes of the jobs are listed separately, as they
+// run in parallel with the frame's phases. Toggled with F3.
+class ProfilerOverlay : public GameObject {
+ public:
+  static constexpr size_t kMaxRows = 16;
+
+  explicit ProfilerOverlay(GameObject* parent,
+                           const gui::Font& font = gui::Font{
+                             "src/resources/fonts/Vera.ttf", 14,
+                             glm::vec4(1, 1, 0, 1)})
+      : GameObject(parent), kRefreshInterval(0.5), visible_(true)
+      , frame_count_(0), heap_allocations_(0), last_refresh_(0) {
+    for (size_t i = 0; i < kMaxRows; ++i) {
+      rows_.push_back(addComponent<gui::Label>(
+          L" ", glm::vec2{-0.95f, 0.9f - 0.05f * i}, font));
+    }
+  }
+
+ private:
+  const double kRefreshInterval;  // seconds
+  bool visible_;
+  std::vector<gui::Label*> rows_;
+  // The summed times (in microseconds) since the last refresh.
+  std::map<std::string, double> cpu_times_, job_times_, gpu_times_;
+  size_t frame_count_;
+  uint64_t heap_allocations_;
+  double last_refresh_;
+
+  virtual void keyAction(int key, int scancode, int action, int mods) override {
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS) {
+      visible_ = !visible_;
+      for (gui::Label* row : rows_) { row->set_enabled(visible_); }
+    }
+  }
+
+  // The labels are updated here, as it runs on the thread that has the
+  // context, before the labels are rendered.
+  virtual void render2D() override {
+    Profiler::Frame frame = Profiler::LastFrame();
+    for (const Profiler::Event& event : frame.events) {
+      if (event.depth != 0) { continue; }
+      auto& times = event.role == Profiler::kWorkerThread ? job_times_
+                                                          : cpu_times_;
+      times[Profiler::EventName(event)] += event.end - event.begin;
+    }
+    for (const Profiler::GpuEvent& event : frame.gpu_events) {
+      gpu_times_[event.name] += event.duration;
+    }
+    heap_allocations_ += frame.heap_allocations;
+    frame_count_++;
+
+    double now = Profiler::Now() / 1e6;
+    if (now - last_refresh_ < kRefreshInterval) { return; }
+    last_refresh_ = now;
+
+    size_t row = 0;
+    if (AllocationCounter::enabled()) {
+      std::wostringstream text;
+      text << L"Heap allocations: " << heap_allocations_ / frame_count_
+           << L" / frame";
+      rows_[row++]->set_text(text.str());
+    }
+    auto print = [&](const std::string& prefix,
+                     const std::map<std::string, double>& times) {
+      for (const auto& time : times) {
+        if (row == kMaxRows) { return; }
+        std::wostringstream text;
+        text << std::fixed << std::setprecision(2)
+             << std::wstring(prefix.begin(), prefix.end())
+             << std::wstring(time.first.begin(), time.first.end()) << ": "
+             << time.second / frame_count_ / 1e3 << " ms";
+        rows_[row++]->set_text(text.str());
+      }
+    };
+    print("CPU ", cpu_times_);
+    print("Jobs ", job_times_);
+    print("GPU ", gpu_times_);
+    for (; row < kMaxRows; ++row) {
+      rows_[row]->set_text(L" ");
+    }
+
+    cpu_times_.clear();
+    job_times_.clear();
+    gpu_times_.clear();
+    heap_allocations_ = 0;
+    frame_count_ = 0;
+  }
+};
+
+}  // namespace debug
+}  // namespace engine
+
+#endif
@@ -0,0 +1,51 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_ECS_COMPONENTS_H_
+#define ENGINE_ECS_COMPONENTS_H_
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+class btRigidBody;
+
+namespace engine {
+namespace ecs {
+
+// A flat (parentless) transform. The matrix is calculated from the other
+// members by UpdateTransforms.
+struct TransformComponent {
+  glm::vec3 pos;
+  glm::quat rot;
+  glm::vec3 scale;
+  glm::mat4 matrix;
+
+  TransformComponent() : scale(1, 1, 1) {}
+  TransformComponent(const glm::vec3& pos, const glm::quat& rot = glm::quat(),
+                     const glm::vec3& scale = glm::vec3(1, 1, 1))
+      : pos(pos), rot(rot), scale(scale) {}
+};
+
+// A non-owning handle to a bullet rigid body. The body's motion state is
+// copied into the entity's TransformComponent by SyncRigidBodies.
+struct RigidBodyHandle {
+  btRigidBody* body;
+
+  explicit RigidBodyHandle(btRigidBody* body = nullptr) : body(body) {}
+};
+
+// Describes what to draw for an entity. The meaning of the mesh id is up to
+// the system that renders it.
+struct RenderHandle {
+  unsigned mesh;
+  glm::vec3 color;
+  bool visible;
+
+  explicit RenderHandle(unsigned mesh = 0, const glm::vec3& color = glm::vec3())
+      : mesh(mesh), color(color), visible(true) {}
+};
+
+}  // namespace ecs
+}  // namespace engine
+
+#endif
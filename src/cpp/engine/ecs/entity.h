@@ -0,0 +1,32 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_ECS_ENTITY_H_
+#define ENGINE_ECS_ENTITY_H_
+
+#include <cstdint>
+
+namespace engine {
+namespace ecs {
+
+// A handle to an entity in a Registry. The generation makes handles of
+// destroyed entities invalid, even if their index gets reused.
+struct Entity {
+  uint32_t index;
+  uint32_t generation;
+
+  Entity() : index(uint32_t(-1)), generation(0) {}
+  Entity(uint32_t index, uint32_t generation)
+      : index(index), generation(generation) {}
+
+  bool valid() const { return index != uint32_t(-1); }
+
+  bool operator==(const Entity& other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+}  // namespace ecs
+}  // namespace engine
+
+#endif
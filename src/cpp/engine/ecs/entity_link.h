@@ -0,0 +1,65 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_ECS_ENTITY_LINK_H_
+#define ENGINE_ECS_ENTITY_LINK_H_
+
+#include "../scene.h"
+#include "../game_object.h"
+#include "./components.h"
+
+namespace engine {
+namespace ecs {
+
+// Connects a GameObject (the parent of the link) to an entity of the
+// scene's registry. An owning link destroys the entity with itself, a
+// viewing link only looks at it. If both have a transform, the link can
+// keep them in sync, in either direction.
+class EntityLink : public GameObject {
+ public:
+  enum class Ownership { kOwn, kView };
+  enum class Sync { kNone, kEntityToObject, kObjectToEntity };
+
+  EntityLink(GameObject* parent, Entity entity,
+             Ownership ownership = Ownership::kOwn,
+             Sync sync = Sync::kEntityToObject)
+      : GameObject(parent), entity_(entity)
+      , ownership_(ownership), sync_(sync) {}
+
+  virtual ~EntityLink() {
+    if (ownership_ == Ownership::kOwn && scene_) {
+      scene_->entities().destroy(entity_);
+    }
+  }
+
+  Entity entity() const { return entity_; }
+
+  template<typename T>
+  T* get() { return scene_ ? scene_->entities().get<T>(entity_) : nullptr; }
+
+ private:
+  Entity entity_;
+  Ownership ownership_;
+  Sync sync_;
+
+  virtual void update() override {
+    if (sync_ == Sync::kNone || !parent_) { return; }
+
+    TransformComponent* transform = get<TransformComponent>();
+    if (!transform) { return; }
+
+    if (sync_ == Sync::kEntityToObject) {
+      parent_->transform()->set_pos(transform->pos);
+      parent_->transform()->set_rot(transform->rot);
+      parent_->transform()->set_scale(transform->scale);
+    } else {
+      transform->pos = parent_->transform()->pos();
+      transform->rot = parent_->transform()->rot();
+      transform->scale = parent_->transform()->scale();
+    }
+  }
+};
+
+}  // namespace ecs
+}  // namespace engine
+
+#endif
@@ -0,0 +1,168 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_ECS_REGISTRY_INL_H_
+#define ENGINE_ECS_REGISTRY_INL_H_
+
+#include <algorithm>
+#include <type_traits>
+
+#include "./registry.h"
+#include "../job_system.h"
+
+namespace engine {
+namespace ecs {
+
+template<typename... Components>
+struct MaskOf;
+
+template<>
+struct MaskOf<> {
+  static ComponentMask value() { return 0; }
+};
+
+template<typename T, typename... Rest>
+struct MaskOf<T, Rest...> {
+  static ComponentMask value() {
+    return ComponentType<T>::mask() | MaskOf<Rest...>::value();
+  }
+};
+
+template<typename Func, typename... Components>
+void ForEachRow(Func& func, size_t count, const Entity* entities,
+                Components*... components) {
+  for (size_t i = 0; i < count; ++i) {
+    func(entities[i], components[i]...);
+  }
+}
+
+template<typename T>
+void Registry::registerType() {
+  size_t id = ComponentType<T>::id();
+  if (!column_prototypes_[id]) {
+    column_prototypes_[id] = std::unique_ptr<ColumnBase>{new Column<T>{}};
+  }
+}
+
+template<typename... Components>
+Entity Registry::create(Components&&... components) {
+  int dummy[] = {0, (registerType<typename std::decay<Components>::type>(), 0)...};
+  (void)dummy;
+
+  Archetype* arch = archetype(
+      MaskOf<typename std::decay<Components>::type...>::value());
+  Entity entity = newEntity(arch);
+
+  int dummy2[] = {0, (arch->column<typename std::decay<Components>::type>()
+                          ->data.push_back(std::forward<Components>(components)),
+                      0)...};
+  (void)dummy2;
+
+  return entity;
+}
+
+template<typename T>
+T* Registry::get(Entity entity) {
+  if (!alive(entity)) { return nullptr; }
+  const Record& record = records_[entity.index];
+  if (record.archetype->mask() & ComponentType<T>::mask()) {
+    return &record.archetype->column<T>()->data[record.row];
+  } else {
+    return nullptr;
+  }
+}
+
+template<typename T>
+bool Registry::has(Entity entity) const {
+  return alive(entity) &&
+      (records_[entity.index].archetype->mask() & ComponentType<T>::mask());
+}
+
+template<typename T>
+void Registry::add(Entity entity, T&& component) {
+  using Component = typename std::decay<T>::type;
+
+  if (!alive(entity)) { return; }
+  if (Component* existing = get<Component>(entity)) {
+    *existing = std::forward<T>(component);
+    return;
+  }
+
+  registerType<Component>();
+  ComponentMask mask = records_[entity.index].archetype->mask();
+  Archetype* dst = archetype(mask | ComponentType<Component>::mask());
+  move(entity, dst);
+  dst->column<Component>()->data.push_back(std::forward<T>(component));
+}
+
+template<typename T>
+void Registry::remove(Entity entity) {
+  if (!has<T>(entity)) { return; }
+
+  ComponentMask mask = records_[entity.index].archetype->mask();
+  move(entity, archetype(mask & ~ComponentType<T>::mask()));
+}
+
+template<typename... Components, typename Func>
+void Registry::eachChunk(Func func) {
+  ComponentMask required = MaskOf<Components...>::value();
+  for (auto& arch : archetypes_) {
+    if ((arch->mask() & required) == required && arch->size() != 0) {
+      func(arch->size(), arch->entities(), arch->template data<Components>()...);
+    }
+  }
+}
+
+template<typename... Components, typename Func>
+void Registry::each(Func func) {
+  ComponentMask required = MaskOf<Components...>::value();
+  for (auto& arch : archetypes_) {
+    if ((arch->mask() & required) == required && arch->size() != 0) {
+      ForEachRow(func, arch->size(), arch->entities(),
+                 arch->template data<Components>()...);
+    }
+  }
+}
+
+template<typename... Components, typename Func>
+void Registry::parallelEach(Func func, size_t min_chunk_size) {
+  struct Range {
+    Archetype* archetype;
+    size_t begin, end;
+  };
+
+  ComponentMask required = MaskOf<Components...>::value();
+  size_t total = 0;
+  for (auto& arch : archetypes_) {
+    if ((arch->mask() & required) == required) {
+      total += arch->size();
+    }
+  }
+
+  size_t thread_count = JobSystem::Default().concurrency();
+  size_t chunk_size = std::max(min_chunk_size, total / thread_count + 1);
+
+  // Split the archetypes into roughly equal sized ranges.
+  std::vector<Range> ranges;
+  for (auto& arch : archetypes_) {
+    if ((arch->mask() & required) == required) {
+      for (size_t begin = 0; begin < arch->size(); begin += chunk_size) {
+        ranges.push_back(Range{arch.get(), begin,
+                               std::min(begin + chunk_size, arch->size())});
+      }
+    }
+  }
+
+  JobSystem::Default().parallelFor(0, ranges.size(),
+      [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      const Range& r = ranges[i];
+      ForEachRow(func, r.end - r.begin, r.archetype->entities() + r.begin,
+                 (r.archetype->template data<Components>() + r.begin)...);
+    }
+  }, 1);
+}
+
+}  // namespace ecs
+}  // namespace engine
+
+#endif
@@ -0,0 +1,102 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <atomic>
+#include <stdexcept>
+
+#include "./registry.h"
+
+namespace engine {
+namespace ecs {
+
+size_t NextComponentTypeId() {
+  static std::atomic<size_t> next_id{0};
+  size_t id = next_id++;
+  if (id >= kMaxComponentTypes) {
+    throw std::length_error("Too many ECS component types");
+  }
+  return id;
+}
+
+bool Registry::alive(Entity entity) const {
+  return entity.index < records_.size() &&
+         records_[entity.index].archetype != nullptr &&
+         records_[entity.index].generation == entity.generation;
+}
+
+void Registry::destroy(Entity entity) {
+  if (!alive(entity)) { return; }
+
+  Record& record = records_[entity.index];
+  removeRow(record.archetype, record.row);
+  record.archetype = nullptr;
+  record.generation++;
+  free_indices_.push_back(entity.index);
+}
+
+Archetype* Registry::archetype(ComponentMask mask) {
+  auto iter = archetype_by_mask_.find(mask);
+  if (iter != archetype_by_mask_.end()) {
+    return iter->second;
+  }
+
+  Archetype* arch = new Archetype{mask};
+  archetypes_.push_back(std::unique_ptr<Archetype>{arch});
+  archetype_by_mask_[mask] = arch;
+  for (size_t i = 0; i < kMaxComponentTypes; ++i) {
+    if (mask & (ComponentMask(1) << i)) {
+      arch->columns_[i] = column_prototypes_[i]->makeEmpty();
+    }
+  }
+
+  return arch;
+}
+
+Entity Registry::newEntity(Archetype* archetype) {
+  uint32_t index;
+  if (!free_indices_.empty()) {
+    index = free_indices_.back();
+    free_indices_.pop_back();
+  } else {
+    index = records_.size();
+    records_.push_back(Record{nullptr, 0, 0});
+  }
+
+  Entity entity{index, records_[index].generation};
+  archetype->entities_.push_back(entity);
+  records_[index].archetype = archetype;
+  records_[index].row = archetype->entities_.size() - 1;
+
+  return entity;
+}
+
+void Registry::move(Entity entity, Archetype* dst) {
+  Archetype* src = records_[entity.index].archetype;
+  size_t row = records_[entity.index].row;
+
+  for (size_t i = 0; i < kMaxComponentTypes; ++i) {
+    if (src->columns_[i] && dst->columns_[i]) {
+      src->columns_[i]->moveRowTo(row, dst->columns_[i].get());
+    }
+  }
+  dst->entities_.push_back(entity);
+  removeRow(src, row);
+
+  records_[entity.index].archetype = dst;
+  records_[entity.index].row = dst->entities_.size() - 1;
+}
+
+void Registry::removeRow(Archetype* archetype, size_t row) {
+  for (auto& column : archetype->columns_) {
+    if (column) {
+      column->swapRemove(row);
+    }
+  }
+
+  Entity last = archetype->entities_.back();
+  archetype->entities_[row] = last;
+  archetype->entities_.pop_back();
+  records_[last.index].row = row;
+}
+
+}  // namespace ecs
+}  // namespace engine
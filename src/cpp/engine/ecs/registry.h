@@ -0,0 +1,172 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_ECS_REGISTRY_H_
+#define ENGINE_ECS_REGISTRY_H_
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "./entity.h"
+
+namespace engine {
+namespace ecs {
+
+// Every component type gets a bit in the mask of the archetypes.
+using ComponentMask = uint64_t;
+constexpr size_t kMaxComponentTypes = 64;
+
+size_t NextComponentTypeId();
+
+template<typename T>
+struct ComponentType {
+  static size_t id() {
+    static const size_t id = NextComponentTypeId();
+    return id;
+  }
+  static ComponentMask mask() { return ComponentMask(1) << id(); }
+};
+
+// A type erased, contiguous array of components of one type.
+class ColumnBase {
+ public:
+  virtual ~ColumnBase() {}
+  virtual std::unique_ptr<ColumnBase> makeEmpty() const = 0;
+  // Moves the last element to 'row', and removes the last element.
+  virtual void swapRemove(size_t row) = 0;
+  // Appends the element at 'row' to 'dst', which must have the same type.
+  virtual void moveRowTo(size_t row, ColumnBase* dst) = 0;
+};
+
+template<typename T>
+class Column : public ColumnBase {
+ public:
+  std::vector<T> data;
+
+  virtual std::unique_ptr<ColumnBase> makeEmpty() const override {
+    return std::unique_ptr<ColumnBase>{new Column<T>{}};
+  }
+
+  virtual void swapRemove(size_t row) override {
+    if (row + 1 != data.size()) {
+      data[row] = std::move(data.back());
+    }
+    data.pop_back();
+  }
+
+  virtual void moveRowTo(size_t row, ColumnBase* dst) override {
+    static_cast<Column<T>*>(dst)->data.push_back(std::move(data[row]));
+  }
+};
+
+// Stores every entity that has exactly the same set of components. Each
+// component type is stored in its own contiguous array (column), the rows of
+// the columns belong to the entity with the same row in entities.
+class Archetype {
+ public:
+  explicit Archetype(ComponentMask mask) : mask_(mask), columns_() {}
+
+  ComponentMask mask() const { return mask_; }
+  size_t size() const { return entities_.size(); }
+  const Entity* entities() const { return entities_.data(); }
+
+  template<typename T>
+  Column<T>* column() {
+    return static_cast<Column<T>*>(columns_[ComponentType<T>::id()].get());
+  }
+
+  template<typename T>
+  T* data() { return column<T>()->data.data(); }
+
+ private:
+  ComponentMask mask_;
+  std::unique_ptr<ColumnBase> columns_[kMaxComponentTypes];
+  std::vector<Entity> entities_;
+
+  friend class Registry;
+};
+
+// Stores entities in archetype tables, and lets systems iterate over the
+// entities with a given set of components in tight loops.
+// Creating or destroying entities, or adding and removing components
+// invalidates the component pointers, so it shouldn't be done inside each().
+class Registry {
+ public:
+  Registry() = default;
+  Registry(const Registry&) = delete;
+  Registry& operator=(const Registry&) = delete;
+
+  // Creates an entity with the given components.
+  template<typename... Components>
+  Entity create(Components&&... components);
+
+  void destroy(Entity entity);
+  bool alive(Entity entity) const;
+
+  // The number of alive entities.
+  size_t size() const { return records_.size() - free_indices_.size(); }
+
+  // Returns nullptr if the entity isn't alive, or doesn't have a T component.
+  template<typename T>
+  T* get(Entity entity);
+
+  template<typename T>
+  bool has(Entity entity) const;
+
+  // Adds (or overwrites) a component. This moves the entity to another archetype.
+  template<typename T>
+  void add(Entity entity, T&& component);
+
+  template<typename T>
+  void remove(Entity entity);
+
+  // Calls func(count, entities, Components*...) for every archetype that has
+  // all of the Components, with pointers to their contiguous arrays.
+  template<typename... Components, typename Func>
+  void eachChunk(Func func);
+
+  // Calls func(entity, Components&...) for every entity that has all of the
+  // Components.
+  template<typename... Components, typename Func>
+  void each(Func func);
+
+  // Same as each(), but the entities are processed on multiple threads, so
+  // func must only touch the components of the entity it is called with.
+  template<typename... Components, typename Func>
+  void parallelEach(Func func, size_t min_chunk_size = 4096);
+
+ private:
+  struct Record {
+    Archetype* archetype;
+    size_t row;
+    uint32_t generation;
+  };
+
+  std::vector<Record> records_;
+  std::vector<uint32_t> free_indices_;
+  std::vector<std::unique_ptr<Archetype>> archetypes_;
+  std::unordered_map<ComponentMask, Archetype*> archetype_by_mask_;
+  // Creates new columns for an archetype, by cloning the columns of another one.
+  std::unique_ptr<ColumnBase> column_prototypes_[kMaxComponentTypes];
+
+  Archetype* archetype(ComponentMask mask);
+
+  template<typename T>
+  void registerType();
+
+  Entity newEntity(Archetype* archetype);
+
+  // Moves an entity to another archetype (with the common components).
+  void move(Entity entity, Archetype* dst);
+
+  // Removes the row of an archetype, and fixes the record of the moved entity.
+  void removeRow(Archetype* archetype, size_t row);
+};
+
+}  // namespace ecs
+}  // namespace engine
+
+#include "./registry-inl.h"
+
+#endif
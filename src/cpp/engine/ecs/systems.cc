@@ -0,0 +1,16 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./systems.h"
+
+namespace engine {
+namespace ecs {
+
+void UpdateTransforms(Registry& registry) {
+  registry.parallelEach<TransformComponent>(
+      [](Entity, TransformComponent& transform) {
+    UpdateTransform(transform);
+  });
+}
+
+}  // namespace ecs
+}  // namespace engine
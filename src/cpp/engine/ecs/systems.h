@@ -0,0 +1,41 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_ECS_SYSTEMS_H_
+#define ENGINE_ECS_SYSTEMS_H_
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "./registry.h"
+#include "./components.h"
+
+namespace engine {
+namespace ecs {
+
+// Copies the world transform of the rigid bodies, interpolated for the
+// current frame, into the TransformComponents. The bodies are looked up with
+// bodies.bodyTransform(body, &pos, &rot), like Scene::bodyTransform, which is
+// called on multiple threads at the same time.
+template<typename BodyTransforms>
+void SyncRigidBodies(Registry& registry, const BodyTransforms& bodies) {
+  registry.parallelEach<RigidBodyHandle, TransformComponent>(
+      [&bodies](Entity, RigidBodyHandle& handle,
+                TransformComponent& transform) {
+    if (handle.body) {
+      bodies.bodyTransform(handle.body, &transform.pos, &transform.rot);
+    }
+  });
+}
+
+// Recalculates TransformComponent::matrix from pos, rot and scale.
+inline void UpdateTransform(TransformComponent& transform) {
+  transform.matrix = glm::scale(glm::mat4_cast(transform.rot), transform.scale);
+  transform.matrix[3] = glm::vec4(transform.pos, 1);
+}
+
+// Calls UpdateTransform for every TransformComponent.
+void UpdateTransforms(Registry& registry);
+
+}  // namespace ecs
+}  // namespace engine
+
+#endif
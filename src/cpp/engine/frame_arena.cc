@@ -0,0 +1,62 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./frame_arena.h"
+
+#include <cstdint>
+#include <algorithm>
+
+namespace engine {
+
+constexpr size_t FrameArena::kDefaultBlockSize;
+
+FrameArena::FrameArena(size_t block_size)
+    : block_size_(block_size), current_block_(0), offset_(0), used_(0)
+    , capacity_(0), memory_(MemoryStats::kCpu, "frame arenas") {
+  addBlock(block_size_);
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+  while (true) {
+    Block& block = blocks_[current_block_];
+    uintptr_t begin = reinterpret_cast<uintptr_t>(block.data.get());
+    uintptr_t aligned = (begin + offset_ + alignment - 1) & ~(alignment - 1);
+    size_t end = aligned - begin + bytes;
+    if (end <= block.size) {
+      used_ += end - offset_;
+      offset_ = end;
+      return reinterpret_cast<void*>(aligned);
+    }
+
+    // The rest of the block is wasted until the next reset.
+    if (current_block_ + 1 == blocks_.size()) {
+      addBlock(std::max(block_size_, bytes + alignment));
+    }
+    current_block_++;
+    offset_ = 0;
+  }
+}
+
+void FrameArena::reset() {
+  if (blocks_.size() > 1) {
+    size_t size = capacity_;
+    blocks_.clear();
+    capacity_ = 0;
+    addBlock(size);
+  }
+  current_block_ = 0;
+  offset_ = 0;
+  used_ = 0;
+}
+
+FrameArena& FrameArena::ThreadLocal() {
+  thread_local FrameArena arena;
+  return arena;
+}
+
+void FrameArena::addBlock(size_t size) {
+  blocks_.push_back(Block{std::unique_ptr<char[]>{new char[size]}, size});
+  capacity_ += size;
+  memory_.set_bytes(capacity_);
+}
+
+}  // namespace engine
@@ -0,0 +1,91 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_FRAME_ARENA_H_
+#define ENGINE_FRAME_ARENA_H_
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+#include "./memory_stats.h"
+
+namespace engine {
+
+// A linear (bump) allocator for the transient allocations of a frame. Every
+// thread has its own arena (see ThreadLocal), which is reset once per frame:
+// the main thread's after a frame, the render thread's after it rendered a
+// frame, and the workers' after each job. So the memory must not outlive the
+// frame, nor be handed to an other thread. Freeing is a no-op.
+class FrameArena {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  explicit FrameArena(size_t block_size = kDefaultBlockSize);
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+  // Frees everything. If the frame needed more than one block, they are
+  // replaced by a single block that is big enough for all of it, so in the
+  // steady state the arena doesn't allocate at all.
+  void reset();
+
+  size_t used() const { return used_; }
+  size_t capacity() const { return capacity_; }
+
+  // The arena of the calling thread.
+  static FrameArena& ThreadLocal();
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  size_t block_size_;
+  std::vector<Block> blocks_;
+  size_t current_block_, offset_;
+  size_t used_, capacity_;
+  MemoryStats::Allocation memory_;
+
+  void addBlock(size_t size);
+};
+
+// An STL allocator, that allocates from the calling thread's frame arena.
+template<typename T>
+class FrameAllocator {
+ public:
+  using value_type = T;
+
+  FrameAllocator() = default;
+  template<typename U>
+  FrameAllocator(const FrameAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(
+        FrameArena::ThreadLocal().allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, size_t) {}
+
+  template<typename U>
+  struct rebind { using other = FrameAllocator<U>; };
+};
+
+template<typename T, typename U>
+bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&) {
+  return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&) {
+  return false;
+}
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,32 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_FRAME_BUFFERED_H_
+#define ENGINE_FRAME_BUFFERED_H_
+
+#include "./frame_pipeline.h"
+
+namespace engine {
+
+// A value with a copy for every frame in flight. On the main thread, get()
+// returns the copy of the frame being simulated, on the render thread, it
+// returns the copy of the frame being rendered. Without pipelining, it is
+// always the same copy. The main thread should rewrite it every frame (in
+// update or prepareRender), as the other copies aren't kept in sync.
+template<typename T>
+class FrameBuffered {
+ public:
+  FrameBuffered() = default;
+  explicit FrameBuffered(const T& value) {
+    for (T& copy : copies_) { copy = value; }
+  }
+
+  T& get() { return copies_[FramePipeline::CurrentSlot()]; }
+  const T& get() const { return copies_[FramePipeline::CurrentSlot()]; }
+
+ private:
+  T copies_[FramePipeline::kMaxDepth];
+};
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,153 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <mutex>
+#include <thread>
+#include <cassert>
+#include <algorithm>
+#include <condition_variable>
+
+#include "./frame_pipeline.h"
+
+namespace engine {
+
+namespace {
+
+struct PipelineState {
+  GLFWwindow* window = nullptr;
+  size_t depth = 1;
+  std::function<void()> render_frame;
+
+  std::thread render_thread;
+  std::mutex mutex;
+  std::condition_variable changed;
+  // The number of frames submitted and rendered since Start.
+  size_t submitted = 0, rendered = 0;
+  bool should_quit = false;
+};
+
+PipelineState state;
+
+// Written only by the threads that use them.
+size_t simulation_slot = 0, render_slot = 0;
+thread_local bool is_render_thread = false;
+// The static initializers run on the main thread.
+const std::thread::id main_thread = std::this_thread::get_id();
+// Set by SlotScope, -1 if the thread uses its own slot.
+thread_local int slot_override = -1;
+
+}  // namespace
+
+constexpr size_t FramePipeline::kMaxDepth;
+
+void FramePipeline::Start(GLFWwindow* window, size_t depth,
+                          std::function<void()> render_frame) {
+  assert(!running());
+
+  state.window = window;
+  state.depth = std::max<size_t>(1, std::min(depth, kMaxDepth));
+  state.render_frame = std::move(render_frame);
+  state.submitted = state.rendered = 0;
+  state.should_quit = false;
+  simulation_slot = render_slot = 0;
+
+  glfwMakeContextCurrent(nullptr);
+  state.render_thread = std::thread{RenderLoop};
+}
+
+void FramePipeline::Stop() {
+  if (is_render_thread) { return; }
+  assert(IsMainThread());
+  if (!running()) { return; }
+
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.should_quit = true;
+    state.changed.notify_all();
+  }
+  state.render_thread.join();
+
+  glfwMakeContextCurrent(state.window);
+  // The pipeline might be stopped while a frame is simulated, whose data is
+  // already written into its slot, and it is rendered on this thread from
+  // there. The slots are reset by the next Start.
+}
+
+bool FramePipeline::running() {
+  return state.render_thread.joinable();
+}
+
+bool FramePipeline::IsMainThread() {
+  return std::this_thread::get_id() == main_thread;
+}
+
+bool FramePipeline::IsRenderThread() {
+  return is_render_thread;
+}
+
+void FramePipeline::BeginFrame() {
+  if (!running()) { return; }
+
+  std::unique_lock<std::mutex> lock(state.mutex);
+  // The slot is free, if the frame, that used it before, is rendered.
+  state.changed.wait(lock, []() {
+    return state.submitted - state.rendered < state.depth;
+  });
+  simulation_slot = state.submitted % state.depth;
+}
+
+void FramePipeline::SubmitFrame() {
+  if (!running()) { return; }
+
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.submitted++;
+  state.changed.notify_all();
+}
+
+void FramePipeline::Flush() {
+  if (!running() || is_render_thread) { return; }
+
+  std::unique_lock<std::mutex> lock(state.mutex);
+  state.changed.wait(lock, []() { return state.rendered == state.submitted; });
+}
+
+size_t FramePipeline::CurrentSlot() {
+  if (slot_override >= 0) { return slot_override; }
+  return is_render_thread ? render_slot : simulation_slot;
+}
+
+FramePipeline::SlotScope::SlotScope(size_t slot) : previous_(slot_override) {
+  slot_override = static_cast<int>(slot);
+}
+
+FramePipeline::SlotScope::~SlotScope() {
+  slot_override = previous_;
+}
+
+void FramePipeline::RenderLoop() {
+  is_render_thread = true;
+  glfwMakeContextCurrent(state.window);
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(state.mutex);
+      state.changed.wait(lock, []() {
+        return state.rendered < state.submitted || state.should_quit;
+      });
+      // Finish the frames in flight before quitting.
+      if (state.rendered == state.submitted) { break; }
+      render_slot = state.rendered % state.depth;
+    }
+
+    state.render_frame();
+    glfwSwapBuffers(state.window);
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.rendered++;
+    state.changed.notify_all();
+  }
+
+  glfwMakeContextCurrent(nullptr);
+  is_render_thread = false;
+}
+
+}  // namespace engine
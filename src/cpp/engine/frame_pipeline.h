@@ -0,0 +1,82 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_FRAME_PIPELINE_H_
+#define ENGINE_FRAME_PIPELINE_H_
+
+#include <cstddef>
+#include <functional>
+#include "./oglwrap_config.h"
+#include <GLFW/glfw3.h>
+
+namespace engine {
+
+// Renders the frames on a separate thread, while the main thread simulates
+// the next ones. Every frame in flight has a slot, the simulated frame's data
+// is written into its slot (see FrameBuffered), while the render thread reads
+// the slot of the frame it renders. The render thread owns the OpenGL context
+// while the pipeline is running, so the main thread mustn't call OpenGL then.
+class FramePipeline {
+ public:
+  // The maximal number of frames in flight.
+  static constexpr size_t kMaxDepth = 3;
+
+  // Moves the window's context from the calling thread to a new render
+  // thread, that calls render_frame for every submitted frame, and then
+  // swaps the buffers. With depth frames in flight, the simulation can be
+  // depth - 1 frames ahead of the rendering.
+  static void Start(GLFWwindow* window, size_t depth,
+                    std::function<void()> render_frame);
+
+  // Waits for the frames in flight, stops the render thread, and makes the
+  // context current on the main thread again. Does nothing if the pipeline
+  // isn't running, or if it's called from the render thread. Must not be
+  // called from other threads. The main thread keeps using the slot of the
+  // frame that it simulates.
+  static void Stop();
+
+  static bool running();
+
+  // If the calling thread is the one that started the program. Scenes might
+  // be constructed on other threads (see GameEngine::LoadSceneAsync), which
+  // mustn't control the pipeline.
+  static bool IsMainThread();
+
+  // If the calling thread is the render thread of the running pipeline.
+  static bool IsRenderThread();
+
+  // Called by the main thread before simulating a frame. Waits until the
+  // next frame's slot isn't used by the render thread anymore.
+  static void BeginFrame();
+
+  // Passes the simulated frame to the render thread.
+  static void SubmitFrame();
+
+  // Waits until every submitted frame is rendered. Can be called from the
+  // main thread, when it has to modify data that the render thread uses.
+  static void Flush();
+
+  // The slot, that the calling thread should use.
+  static size_t CurrentSlot();
+
+  // Makes the calling thread use a given slot while it exists. The jobs,
+  // that the main or the render thread starts, should work on the slot of
+  // the thread that started them, as any thread might run them.
+  class SlotScope {
+   public:
+    explicit SlotScope(size_t slot);
+    ~SlotScope();
+
+   private:
+    int previous_;
+
+    SlotScope(const SlotScope&) = delete;
+    SlotScope& operator=(const SlotScope&) = delete;
+  };
+
+ private:
+  static void RenderLoop();
+};
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,40 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./frame_uniforms.h"
+
+#include <cstddef>
+
+#include "../oglwrap/smart_enums.h"
+
+namespace engine {
+
+constexpr GLuint FrameUniforms::kBindingPoint;
+constexpr size_t FrameUniforms::kMaxShadowMaps;
+
+FrameUniforms::FrameUniforms() : data_(Data()) {
+  gl::Bind(buffer_);
+  buffer_.data(sizeof(Data), nullptr, gl::kDynamicDraw);
+  gl::Unbind(buffer_);
+}
+
+void FrameUniforms::upload() {
+  gl::Bind(buffer_);
+  buffer_.subData(0, sizeof(Data), &data());
+  gl::Unbind(buffer_);
+  buffer_.bindBase(kBindingPoint);
+}
+
+void FrameUniforms::uploadShadows() {
+  const Data& frame = data();
+  size_t count = glm::clamp<int32_t>(frame.shadow_count, 0, kMaxShadowMaps);
+
+  gl::Bind(buffer_);
+  buffer_.subData(offsetof(Data, shadow_cp), count * sizeof(glm::mat4),
+                  frame.shadow_cp);
+  buffer_.subData(offsetof(Data, shadow_count),
+                  offsetof(Data, padding) - offsetof(Data, shadow_count),
+                  &frame.shadow_count);
+  gl::Unbind(buffer_);
+}
+
+}  // namespace engine
@@ -0,0 +1,57 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_FRAME_UNIFORMS_H_
+#define ENGINE_FRAME_UNIFORMS_H_
+
+#include <cstdint>
+
+#include "./oglwrap_config.h"
+#include "../oglwrap/buffer.h"
+
+#include "./frame_buffered.h"
+
+namespace engine {
+
+// The data, that is the same for every program during a frame, in a uniform
+// buffer. The shaders read it through the EngineFrameData block, declared by
+// including "engine/frame_data.vert".
+class FrameUniforms {
+ public:
+  static constexpr GLuint kBindingPoint = 0;
+  static constexpr size_t kMaxShadowMaps = 16;
+
+  // Mirrors EngineFrameData in std140 layout.
+  struct Data {
+    glm::mat4 camera_matrix;
+    glm::mat4 projection_matrix;
+    glm::mat4 shadow_cp[kMaxShadowMaps];
+    glm::vec3 camera_pos;
+    float time;
+    glm::vec3 sun_pos;
+    int32_t shadow_count;
+    glm::ivec2 shadow_atlas_size;
+    glm::ivec2 padding;
+  };
+  static_assert(sizeof(Data) == 1200, "Data must match the std140 layout");
+
+  FrameUniforms();
+
+  // The main thread fills it in prepareRender, the shadow data is written on
+  // the render thread, after the shadow pass.
+  Data& data() { return data_.get(); }
+  const Data& data() const { return data_.get(); }
+
+  // Uploads the whole block, and binds it to kBindingPoint.
+  void upload();
+
+  // Only uploads the shadow data.
+  void uploadShadows();
+
+ private:
+  gl::UniformBuffer buffer_;
+  FrameBuffered<Data> data_;
+};
+
+}  // namespace engine
+
+#endif
@@ -7,6 +7,11 @@
 
 #include "../oglwrap/smart_enums.h"
 #include "./game_engine.h"
+#include "./timer.h"
+#include "./input.h"
+#include "./profiler.h"
+#include "./frame_arena.h"
+#include "./context_objects.h"
 
 static double last_debug_time = 0;
 
@@ -27,12 +32,22 @@ static void GlInit() {
 
 namespace engine {
 
+size_t GameEngine::pipeline_depth_ = 1;
 Scene *GameEngine::scene_ = nullptr;
 Scene *GameEngine::new_scene_ = nullptr;
 GLFWwindow *GameEngine::window_ = nullptr;
+GLFWwindow *GameEngine::loader_window_ = nullptr;
+glm::vec2 GameEngine::window_size_;
+std::thread GameEngine::loader_thread_;
+Scene *GameEngine::loaded_scene_ = nullptr;
+std::atomic<bool> GameEngine::scene_loaded_{false};
+std::atomic<float> GameEngine::loading_progress_{0.0f};
+std::function<void(float)> GameEngine::loading_screen_;
+bool GameEngine::resize_pending_ = false;
+Benchmark *GameEngine::benchmark_ = nullptr;
 ShaderManager *GameEngine::shader_manager_ = new ShaderManager{};
 
-void GameEngine::InitContext() {
+void GameEngine::InitContext(bool hidden, int width, int height) {
   PrintDebugText("Creating the OpenGL context");
     glfwSetErrorCallback(ErrorCallback);
 
@@ -43,19 +58,36 @@ void GameEngine::InitContext() {
     // Window creation
     GLFWmonitor *monitor = glfwGetPrimaryMonitor();
     const GLFWvidmode *vidmode = glfwGetVideoMode(monitor);
+    if (hidden) {
+      glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+      window_ = glfwCreateWindow(width ? width : vidmode->width,
+                                 height ? height : vidmode->height,
+                                 "Land of Dreams", nullptr, nullptr);
+    } else {
 #if ENGINE_NO_FULLSCREEN
-    window_ = glfwCreateWindow(vidmode->width, vidmode->height,
-                               "Land of Dreams", nullptr, nullptr);
+      window_ = glfwCreateWindow(vidmode->width, vidmode->height,
+                                 "Land of Dreams", nullptr, nullptr);
 #else
-    window_ = glfwCreateWindow(vidmode->width, vidmode->height,
-                               "Land of Dreams", monitor, nullptr);
+      window_ = glfwCreateWindow(vidmode->width, vidmode->height,
+                                 "Land of Dreams", monitor, nullptr);
 #endif
+    }
 
     if (!window_) {
       std::cerr << "FATAL: Couldn't create a glfw window. Aborting now." << std::endl;
       glfwTerminate();
       std::terminate();
     }
+
+    // The context of the scene loader (see LoadSceneAsync).
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    loader_window_ = glfwCreateWindow(1, 1, "Loader", nullptr, window_);
+    glfwDefaultWindowHints();
+    if (!loader_window_) {
+      std::cerr << "FATAL: Couldn't create a glfw window. Aborting now." << std::endl;
+      glfwTerminate();
+      std::terminate();
+    }
   PrintDebugTime();
 
   // Check the created OpenGL context's version
@@ -65,6 +97,8 @@ void GameEngine::InitContext() {
   int width, height;
   glfwGetFramebufferSize(window_, &width, &height);
   std::cout << " - Resolution: "  << width << " x " << height << std::endl;
+  glfwGetWindowSize(window_, &width, &height);
+  window_size_ = glm::vec2(width, height);
 
   if (ogl_major_version < 2 || (ogl_major_version == 2 && ogl_minor_version < 1)) {
     std::cerr << "At least OpenGL version 2.1 is required to run this program\n";
@@ -95,21 +129,165 @@ void GameEngine::InitContext() {
   glfwSetCursorPosCallback(window_, MouseMoved);
 }
 
+void GameEngine::FinishLoading() {
+  loader_thread_.join();
+  // The current scene might be rendered by the render thread.
+  FramePipeline::Stop();
+
+  if (!loaded_scene_) {
+    std::cerr << "Stopping now." << std::endl;
+    Destroy();
+    std::terminate();
+  }
+
+  // The new scene's vertex arrays and framebuffers are recreated on the
+  // window's context, and the ones it created are deleted on the loader's.
+  loaded_scene_->contextChangedAll();
+  glfwMakeContextCurrent(loader_window_);
+  ContextObjects::DeleteReplaced();
+  glfwMakeContextCurrent(window_);
+
+  delete scene_;
+  scene_ = loaded_scene_;
+  loaded_scene_ = nullptr;
+  scene_->activate();
+
+  if (resize_pending_) {
+    resize_pending_ = false;
+    int width, height;
+    glfwGetFramebufferSize(window_, &width, &height);
+    ScreenResizeCallback(window_, width, height);
+  }
+}
+
 void GameEngine::Run() {
   while (!glfwWindowShouldClose(window_)) {
-    if (new_scene_) {
-      delete scene_;
-      scene_ = new_scene_;
-      new_scene_ = nullptr;
+    if (loading()) {
+      if (scene_loaded_) {
+        FinishLoading();
+      } else if (!scene_) {
+        // There's nothing to run yet, only animate the loading screen.
+        gl::Clear().Color().Depth();
+        if (loading_screen_) {
+          loading_screen_(loading_progress_);
+        }
+        glfwSwapBuffers(window_);
+        glfwPollEvents();
+        continue;
+      }
     }
-    gl::Clear().Color().Depth();
-    scene_->turn();
 
+    // The current scene keeps running while the next one is loading.
+    RunFrame();
+    Profiler::EndFrame();
+  }
+
+  Destroy();
+}
+
+void GameEngine::RunFrame() {
+  if (new_scene_) {
+    FramePipeline::Stop();
+    delete scene_;
+    scene_ = new_scene_;
+    new_scene_ = nullptr;
+    scene_->activate();
+  }
+
+  // The pipeline is stopped by everything that needs the context on the
+  // main thread, and it is restarted here.
+  bool pipelined = pipeline_depth_ > 1 && scene_->pipelining_supported();
+  if (pipelined && !FramePipeline::running()) {
+    FramePipeline::Start(window_, pipeline_depth_, []() {
+      gl::Clear().Color().Depth();
+      scene_->submit();
+      Profiler::EndGpuFrame();
+      if (benchmark_) {
+        benchmark_->recordRenderStats(scene_->render_stats());
+      }
+      FrameArena::ThreadLocal().reset();
+    });
+  } else if (!pipelined) {
+    FramePipeline::Stop();
+  }
+
+  if (pipelined) {
+    FramePipeline::BeginFrame();
+    scene_->simulate();
+  }
+
+  // Removing objects stops the pipeline, then the simulated frame is
+  // rendered here.
+  if (pipelined && FramePipeline::running()) {
+    FramePipeline::SubmitFrame();
+  } else {
+    gl::Clear().Color().Depth();
+    if (pipelined) {
+      scene_->submit();
+    } else {
+      scene_->turn();
+    }
+    Profiler::EndGpuFrame();
+    if (benchmark_) {
+      benchmark_->recordRenderStats(scene_->render_stats());
+    }
     glfwSwapBuffers(window_);
-    glfwPollEvents();
   }
 
+  glfwPollEvents();
+
+  FrameArena::ThreadLocal().reset();
+}
+
+bool GameEngine::RunBenchmark(Benchmark* benchmark) {
+  benchmark_ = benchmark;
+  benchmark->set_renderer(
+      reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+  Timer::set_fixed_step(benchmark->options().time_step);
+  Input::set_script(benchmark->input());
+
+  while (!benchmark->finished() && !glfwWindowShouldClose(window_)) {
+    benchmark->beginFrame();
+    RunFrame();
+    Profiler::EndFrame();
+    benchmark->endFrame();
+  }
+
+  // The render thread might still record the stats of the last frames.
+  FramePipeline::Stop();
+  Input::set_script(nullptr);
+  Timer::set_fixed_step(0);
+  bool success = benchmark->finished();
+  if (!success) {
+    std::cerr << "The benchmark was interrupted." << std::endl;
+  }
+  success = benchmark->writeResults() && success;
+  benchmark_ = nullptr;
+
   Destroy();
+  return success;
+}
+
+void GameEngine::ScreenResizeCallback(GLFWwindow* window,
+                                      int width, int height) {
+  // The loader thread reads the cached window size, it is updated, and the
+  // new scene is resized, when the loading is finished.
+  if (loading()) {
+    resize_pending_ = true;
+  } else {
+    int window_width, window_height;
+    glfwGetWindowSize(window_, &window_width, &window_height);
+    window_size_ = glm::vec2(window_width, window_height);
+  }
+
+  // The objects might resize their OpenGL resources.
+  if (scene_) {
+    FramePipeline::Stop();
+  }
+  gl::Viewport(width, height);
+  if (scene_) {
+    scene_->screenResizedAll(width, height);
+  }
 }
 
 void GameEngine::KeyCallback(GLFWwindow* window, int key, int scancode,
@@ -134,6 +312,7 @@ void GameEngine::KeyCallback(GLFWwindow* window, int key, int scancode,
     }
   }
 
+  if (!ForwardsInput()) { return; }
   scene_->keyActionAll(key, scancode, action, mods);
 }
 
@@ -3,8 +3,14 @@
 #ifndef ENGINE_GAME_ENGINE_H_
 #define ENGINE_GAME_ENGINE_H_
 
+#include <atomic>
+#include <thread>
 #include <typeinfo>
+#include <functional>
+#include <algorithm>
 #include "./scene.h"
+#include "./benchmark.h"
+#include "./frame_pipeline.h"
 
 #define ENGINE_NO_FULLSCREEN 1
 
@@ -14,12 +20,25 @@ class ShaderManager;
 
 class GameEngine {
  public:
-  // Initializes the OpenGL context
-  static void InitContext();
+  // Initializes the OpenGL context. A hidden window is created for the
+  // benchmarks, with the given size (instead of the screen's).
+  static void InitContext(bool hidden = false, int width = 0, int height = 0);
 
   static void Destroy() {
+    FramePipeline::Stop();
+    if (loader_thread_.joinable()) {
+      // The loading can't be cancelled. The loaded scene is deleted with the
+      // context, that it was created on.
+      loader_thread_.join();
+      glfwMakeContextCurrent(loader_window_);
+      delete loaded_scene_;
+      loaded_scene_ = nullptr;
+      glfwMakeContextCurrent(window_);
+    }
+    loading_screen_ = nullptr;
     delete scene_;
     delete new_scene_;
+    glfwDestroyWindow(loader_window_);
     glfwDestroyWindow(window_);
     glfwTerminate();
   }
@@ -30,6 +49,8 @@ class GameEngine {
     static_assert(std::is_base_of<Scene, Scene_t>::value,
                   "The given template type is not a Scene");
 
+    // The new scene is created with the context on the main thread.
+    FramePipeline::Stop();
     try {
       new_scene_ = new Scene_t();
     } catch(const std::exception& err) {
@@ -40,24 +61,114 @@ class GameEngine {
     }
   }
 
+  // Creates a new scene of the specified type on a loader thread, and
+  // replaces the current scene with it, when it is ready. The loader has its
+  // own context, that shares the resources of the window's, so the current
+  // scene keeps running meanwhile (or if there's none, the loading screen is
+  // animated, see set_loading_screen). The vertex arrays and framebuffers
+  // aren't shared, the new scene's objects recreate them in contextChanged().
+  // The GLFW calls that need the main thread belong to Scene::activate().
+  // It does nothing if a scene is already being loaded.
+  template <typename Scene_t>
+  static void LoadSceneAsync() {
+    static_assert(std::is_base_of<Scene, Scene_t>::value,
+                  "The given template type is not a Scene");
+    if (loading()) { return; }
+
+    loading_progress_ = 0.0f;
+    scene_loaded_ = false;
+    loader_thread_ = std::thread{[]() {
+      glfwMakeContextCurrent(loader_window_);
+      try {
+        loaded_scene_ = new Scene_t();
+      } catch(const std::exception& err) {
+        std::cerr << "Unable to load scene:\n" << err.what() << std::endl;
+        loaded_scene_ = nullptr;
+      }
+      // The uploads must be complete, before the other context uses them.
+      glFinish();
+      glfwMakeContextCurrent(nullptr);
+      scene_loaded_ = true;
+    }};
+  }
+
+  // If a scene is being loaded by LoadSceneAsync.
+  static bool loading() { return loader_thread_.joinable(); }
+
+  // The progress of the scene being loaded, between 0 and 1. The scenes
+  // report it from their constructors.
+  static float loading_progress() { return loading_progress_; }
+  static void set_loading_progress(float progress) {
+    loading_progress_ = progress;
+  }
+
+  // Draws the loading screen every frame with the loading progress, while
+  // LoadSceneAsync creates a scene, and there's no current scene to run. It
+  // is called on the main thread with the window's context, and it's
+  // destroyed by Destroy() with the context.
+  static void set_loading_screen(std::function<void(float)> loading_screen) {
+    loading_screen_ = std::move(loading_screen);
+  }
+
   static Scene* scene() { return scene_; }
 
   static GLFWwindow* window() { return window_; }
 
   static ShaderManager* shader_manager() { return shader_manager_; }
 
-  static glm::vec2 window_size() {
-    int width, height;
-    glfwGetWindowSize(window(), &width, &height);
-    return glm::vec2(width, height);
+  // It is cached, as glfwGetWindowSize can only be called on the main thread,
+  // and the scenes might be created on a loader thread.
+  static glm::vec2 window_size() { return window_size_; }
+
+  // The number of frames in flight. With 1, a frame is rendered right after
+  // it is simulated. With more, the scenes that support it are rendered on a
+  // separate thread, while the main thread simulates up to depth - 1 frames
+  // ahead (see Scene::pipelining_supported).
+  static size_t pipeline_depth() { return pipeline_depth_; }
+  static void set_pipeline_depth(size_t depth) {
+    pipeline_depth_ = std::max<size_t>(1, std::min(depth,
+                                                   FramePipeline::kMaxDepth));
   }
 
   static void Run();
 
+  // Runs the current scene for the benchmark's frames, with fixed time steps
+  // and scripted input, then writes the results and destroys the context.
+  // Returns false if the window was closed before the end, or the results
+  // couldn't be written.
+  static bool RunBenchmark(Benchmark* benchmark);
+
  private:
+  static size_t pipeline_depth_;
   static Scene *scene_;
   static Scene *new_scene_;
   static GLFWwindow *window_;
+  // A hidden window, whose context is shared with window_'s, for the loader.
+  static GLFWwindow *loader_window_;
+  static glm::vec2 window_size_;
+
+  // LoadSceneAsync's state. loaded_scene_ is written by the loader thread,
+  // before it sets scene_loaded_.
+  static std::thread loader_thread_;
+  static Scene *loaded_scene_;
+  static std::atomic<bool> scene_loaded_;
+  static std::atomic<float> loading_progress_;
+  static std::function<void(float)> loading_screen_;
+  // The window was resized while a scene was loading.
+  static bool resize_pending_;
+
+  // The benchmark being run, or nullptr.
+  static Benchmark *benchmark_;
+
+  // Simulates and renders (or submits) a frame, then polls the events.
+  static void RunFrame();
+
+  // Swaps in the scene created by LoadSceneAsync.
+  static void FinishLoading();
+
+  // The input events are forwarded to the current scene, even while the next
+  // one is loading.
+  static bool ForwardsInput() { return scene_ != nullptr; }
   static ShaderManager *shader_manager_;
 
   // Callbacks
@@ -69,25 +180,26 @@ class GameEngine {
                           int action, int mods);
 
   static void CharCallback(GLFWwindow* window, unsigned codepoint) {
+    if (!ForwardsInput()) { return; }
     scene_->charTypedAll(codepoint);
   }
 
-  static void ScreenResizeCallback(GLFWwindow* window, int width, int height) {
-    gl::Viewport(width, height);
-    scene_->screenResizedAll(width, height);
-  }
+  static void ScreenResizeCallback(GLFWwindow* window, int width, int height);
 
   static void MouseScrolledCallback(GLFWwindow* window, double xoffset,
                                     double yoffset) {
+    if (!ForwardsInput()) { return; }
     scene_->mouseScrolledAll(xoffset, yoffset);
   }
 
   static void MouseButtonPressed(GLFWwindow* window, int button,
                                  int action, int mods) {
+    if (!ForwardsInput()) { return; }
     scene_->mouseButtonPressedAll(button, action, mods);
   }
 
   static void MouseMoved(GLFWwindow* window,  double xpos, double ypos) {
+    if (!ForwardsInput()) { return; }
     scene_->mouseMovedAll(xpos, ypos);
   }
 };
@@ -5,15 +5,61 @@
 
 #include <cassert>
 #include <iostream>
+#include <type_traits>
 #include "./game_object.h"
 
 namespace engine {
 
+// OverridesX<T> is false only if T::x is GameObject::x (so T doesn't override
+// it). If the override isn't accessible, the trait conservatively says true.
+#define ENGINE_OVERRIDES_HOOK_TRAIT(Name, hook) \
+  template<typename T, typename = void> \
+  struct Overrides##Name : std::true_type {}; \
+  template<typename T> \
+  struct Overrides##Name<T, typename std::enable_if<std::is_same< \
+      decltype(&T::hook), decltype(&GameObject::hook)>::value>::type> \
+      : std::false_type {};
+
+ENGINE_OVERRIDES_HOOK_TRAIT(ShadowRender, shadowRender)
+ENGINE_OVERRIDES_HOOK_TRAIT(Render, render)
+ENGINE_OVERRIDES_HOOK_TRAIT(Render2D, render2D)
+ENGINE_OVERRIDES_HOOK_TRAIT(CollectDraws, collectDraws)
+ENGINE_OVERRIDES_HOOK_TRAIT(PrepareRender, prepareRender)
+ENGINE_OVERRIDES_HOOK_TRAIT(ScreenResized, screenResized)
+ENGINE_OVERRIDES_HOOK_TRAIT(Update, update)
+ENGINE_OVERRIDES_HOOK_TRAIT(KeyAction, keyAction)
+ENGINE_OVERRIDES_HOOK_TRAIT(CharTyped, charTyped)
+ENGINE_OVERRIDES_HOOK_TRAIT(MouseScrolled, mouseScrolled)
+ENGINE_OVERRIDES_HOOK_TRAIT(MouseButtonPressed, mouseButtonPressed)
+ENGINE_OVERRIDES_HOOK_TRAIT(MouseMoved, mouseMoved)
+ENGINE_OVERRIDES_HOOK_TRAIT(Collision, collision)
+
+#undef ENGINE_OVERRIDES_HOOK_TRAIT
+
+// Returns the bitmask of the hooks that T overrides.
+template<typename T>
+unsigned HandledHooks() {
+  return (OverridesShadowRender<T>::value << GameObject::kShadowRender) |
+         (OverridesRender<T>::value << GameObject::kRender) |
+         (OverridesRender2D<T>::value << GameObject::kRender2D) |
+         (OverridesCollectDraws<T>::value << GameObject::kCollectDraws) |
+         (OverridesPrepareRender<T>::value << GameObject::kPrepareRender) |
+         (OverridesScreenResized<T>::value << GameObject::kScreenResized) |
+         (OverridesUpdate<T>::value << GameObject::kUpdate) |
+         (OverridesKeyAction<T>::value << GameObject::kKeyAction) |
+         (OverridesCharTyped<T>::value << GameObject::kCharTyped) |
+         (OverridesMouseScrolled<T>::value << GameObject::kMouseScrolled) |
+         (OverridesMouseButtonPressed<T>::value
+            << GameObject::kMouseButtonPressed) |
+         (OverridesMouseMoved<T>::value << GameObject::kMouseMoved) |
+         (OverridesCollision<T>::value << GameObject::kCollision);
+}
+
 template<typename Transform_t>
 GameObject::GameObject(GameObject* parent, const Transform_t& transform)
     : scene_(parent ? parent->scene_ : nullptr), parent_(parent)
     , transform_(new Transform_t{transform})
-    , enabled_(true) {
+    , enabled_(true), handled_hooks_(kAllHooks) {
   assert(parent != this);
   if (parent) { transform_->set_parent(parent_->transform()); }
 }
@@ -25,6 +71,9 @@ T* GameObject::addComponent(Args&&... args) {
   try {
     T *obj = new T(this, std::forward<Args>(args)...);
     components_.push_back(std::unique_ptr<GameObject>(obj));
+    obj->handled_hooks_ = HandledHooks<T>();
+    // its components are already registered by now
+    obj->registerInScene();
     // make sure that the object is aware of the screen's size
     obj->initScreenSize();
 
@@ -62,9 +111,8 @@ void GameObject::FindComponents(const GameObject* go, std::vector<T*> *found) {
     if (t) {
       found->push_back(t);
     }
-    FindComponent<T>(comp);
+    FindComponents<T>(comp, found);
   }
-  return;
 }
 
 template<typename T>
@@ -74,29 +122,6 @@ std::vector<T*> GameObject::findComponents() const {
   return found;
 }
 
-inline std::unique_ptr<GameObject> GameObject::removeComponent(GameObject* component_to_remove) {
-  if (component_to_remove == nullptr) {
-    return nullptr;
-  }
-
-  for (auto iter = components_.begin();
-       iter != components_.end(); ++iter) {
-    if (iter->get() == component_to_remove) {
-      auto ptr = iter->release();
-      ptr->scene_ = nullptr;
-      ptr->set_parent(nullptr);
-      components_.erase(iter);
-      return std::unique_ptr<GameObject>{ptr};
-    }
-  }
-
-  return nullptr;
-}
-
-inline void GameObject::ClearComponents() {
-  components_.clear();
-}
-
 }  // namespace engine
 
 #endif
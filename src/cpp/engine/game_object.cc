@@ -13,6 +13,13 @@
 
 namespace engine {
 
+GameObject::~GameObject() {
+  if (scene_ && scene_ != this) {
+    scene_->component_registry().remove(this);
+    scene_->objectDestroyed(this);
+  }
+}
+
 GameObject* GameObject::addComponent(std::unique_ptr<GameObject>&& component) {
   if (component == nullptr) {
     return nullptr;
@@ -23,7 +30,7 @@ GameObject* GameObject::addComponent(std::unique_ptr<GameObject>&& component) {
     components_.push_back(std::move(component));
     obj->parent_ = this;
     obj->transform_->set_parent(transform_.get());
-    obj->scene_ = scene_;
+    obj->set_scene(scene_);
     // make sure that the object is aware of the screen's size
     obj->initScreenSize();
 
@@ -34,6 +41,35 @@ GameObject* GameObject::addComponent(std::unique_ptr<GameObject>&& component) {
   }
 }
 
+std::unique_ptr<GameObject> GameObject::removeComponent(GameObject* component_to_remove) {
+  if (component_to_remove == nullptr) {
+    return nullptr;
+  }
+
+  for (auto iter = components_.begin();
+       iter != components_.end(); ++iter) {
+    if (iter->get() == component_to_remove) {
+      // The render thread might use the component, and the caller might
+      // destroy it right away, so the context is taken back first. A scene
+      // that is loaded on another thread isn't rendered yet.
+      if (FramePipeline::IsMainThread()) { FramePipeline::Stop(); }
+      auto ptr = iter->release();
+      ptr->set_scene(nullptr);
+      ptr->set_parent(nullptr);
+      components_.erase(iter);
+      return std::unique_ptr<GameObject>{ptr};
+    }
+  }
+
+  return nullptr;
+}
+
+void GameObject::ClearComponents() {
+  // The components' destructors might free OpenGL resources.
+  if (FramePipeline::IsMainThread()) { FramePipeline::Stop(); }
+  components_.clear();
+}
+
 void GameObject::set_parent(GameObject* parent) {
   parent_ = parent;
   if (parent) {
@@ -43,11 +79,125 @@ void GameObject::set_parent(GameObject* parent) {
   }
 }
 
+void GameObject::set_scene(Scene* scene) {
+  if (scene_ && scene_ != this) {
+    scene_->component_registry().remove(this);
+    scene_->invalidateHookLists();
+  }
+  scene_ = scene;
+  registerInScene();
+
+  for (auto& comp_ptr : components_) {
+    comp_ptr->set_scene(scene);
+  }
+}
+
+void GameObject::registerInScene() {
+  if (scene_ && scene_ != this) {
+    scene_->component_registry().add(this);
+  }
+  hooksChanged();
+}
+
+void GameObject::hooksChanged() {
+  if (scene_) {
+    scene_->invalidateHookLists();
+  }
+}
+
 void GameObject::set_enabled(bool value) {
-  enabled_ = value;
+  if (enabled_ != value) {
+    enabled_ = value;
+    hooksChanged();
+    if (enabled_) {
+      // The subtree didn't get the screen resize events while it was disabled
+      glm::vec2 window_size = GameEngine::window_size();
+      screenResizedAll(window_size.x, window_size.y);
+    }
+  }
+}
+
+void GameObject::collectHandlers(Hook hook,
+                                 std::vector<GameObject*>* handlers) {
+  if (!enabled_) { return; }
+  if (handles(hook)) {
+    handlers->push_back(this);
+  }
+  for (auto& comp_ptr : components_) {
+    comp_ptr->collectHandlers(hook, handlers);
+  }
+}
+
+void GameObject::collectUpdateHandlers(std::vector<GameObject*>* serial,
+                                       std::vector<UpdateGroup>* parallel) {
+  if (!enabled_) { return; }
+  if (scene_ != this && canUpdateInParallel(true)) {
+    collectUpdateGroups(serial->size(), parallel);
+    return;
+  }
+
+  if (handles(kUpdate)) {
+    serial->push_back(this);
+  }
+  for (auto& comp_ptr : components_) {
+    comp_ptr->collectUpdateHandlers(serial, parallel);
+  }
+}
+
+void GameObject::collectUpdateGroups(size_t serial_index,
+                                     std::vector<UpdateGroup>* parallel) {
+  if (!enabled_) { return; }
+  if (canSplitUpdate()) {
+    if (handles(kUpdate)) {
+      parallel->push_back(
+          UpdateGroup{this, {this}, updatePolicy(), serial_index});
+    }
+    for (auto& comp_ptr : components_) {
+      comp_ptr->collectUpdateGroups(serial_index, parallel);
+    }
+    return;
+  }
+
+  UpdateGroup group{this, {}, 0, serial_index};
+  collectHandlers(kUpdate, &group.handlers);
+  for (GameObject* handler : group.handlers) {
+    group.policy |= handler->updatePolicy();
+  }
+  if (!group.handlers.empty()) {
+    parallel->push_back(std::move(group));
+  }
+}
+
+bool GameObject::canUpdateInParallel(bool is_group_root) const {
+  if (!enabled_) { return true; }
+  if (handles(kUpdate)) {
+    unsigned policy = updatePolicy();
+    if (!(policy & kUpdateThreadSafe)) { return false; }
+    if (is_group_root && (policy & kUpdateWritesParent)) { return false; }
+  }
+  for (auto& comp_ptr : components_) {
+    if (!comp_ptr->canUpdateInParallel(false)) { return false; }
+  }
+  return true;
+}
+
+bool GameObject::canSplitUpdate() const {
+  bool updates = handles(kUpdate);
+  if (updates &&
+      (updatePolicy() & (kUpdateWritesTransform | kUpdateWritesChildren))) {
+    return false;
+  }
+  for (auto& comp_ptr : components_) {
+    if (!comp_ptr->handles(kUpdate)) { continue; }
+    unsigned policy = comp_ptr->updatePolicy();
+    if (policy & kUpdateWritesParent) { return false; }
+    if (updates && (policy & kUpdateReadsParent)) { return false; }
+  }
+  return true;
 }
 
 void GameObject::shadowRenderAll() {
+  if (!enabled_) { return; }
   shadowRender();
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->shadowRenderAll();
@@ -55,6 +205,7 @@ void GameObject::shadowRenderAll() {
 }
 
 void GameObject::renderAll() {
+  if (!enabled_) { return; }
   render();
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->renderAll();
@@ -62,20 +213,46 @@ void GameObject::renderAll() {
 }
 
 void GameObject::render2DAll() {
+  if (!enabled_) { return; }
   render2D();
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->render2DAll();
   }
 }
 
+void GameObject::collectDrawsAll(RenderQueue* queue) {
+  if (!enabled_) { return; }
+  collectDraws(queue);
+  for (size_t i = 0; i < components_.size(); ++i) {
+    components_[i]->collectDrawsAll(queue);
+  }
+}
+
+void GameObject::prepareRenderAll() {
+  if (!enabled_) { return; }
+  prepareRender();
+  for (size_t i = 0; i < components_.size(); ++i) {
+    components_[i]->prepareRenderAll();
+  }
+}
+
 void GameObject::screenResizedAll(size_t width, size_t height) {
+  if (!enabled_) { return; }
   screenResized(width, height);
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->screenResizedAll(width, height);
   }
 }
 
+void GameObject::contextChangedAll() {
+  contextChanged();
+  for (size_t i = 0; i < components_.size(); ++i) {
+    components_[i]->contextChangedAll();
+  }
+}
+
 void GameObject::updateAll() {
+  if (!enabled_) { return; }
   update();
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->updateAll();
@@ -83,6 +260,7 @@ void GameObject::updateAll() {
 }
 
 void GameObject::keyActionAll(int key, int scancode, int action, int mods) {
+  if (!enabled_) { return; }
   keyAction(key, scancode, action, mods);
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->keyActionAll(key, scancode, action, mods);
@@ -90,6 +268,7 @@ void GameObject::keyActionAll(int key, int scancode, int action, int mods) {
 }
 
 void GameObject::charTypedAll(unsigned codepoint) {
+  if (!enabled_) { return; }
   charTyped(codepoint);
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->charTypedAll(codepoint);
@@ -97,6 +276,7 @@ void GameObject::charTypedAll(unsigned codepoint) {
 }
 
 void GameObject::mouseScrolledAll(double xoffset, double yoffset) {
+  if (!enabled_) { return; }
   mouseScrolled(xoffset, yoffset);
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->mouseScrolledAll(xoffset, yoffset);
@@ -104,6 +284,7 @@ void GameObject::mouseScrolledAll(double xoffset, double yoffset) {
 }
 
 void GameObject::mouseButtonPressedAll(int button, int action, int mods) {
+  if (!enabled_) { return; }
   mouseButtonPressed(button, action, mods);
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->mouseButtonPressedAll(button, action, mods);
@@ -111,6 +292,7 @@ void GameObject::mouseButtonPressedAll(int button, int action, int mods) {
 }
 
 void GameObject::mouseMovedAll(double xpos, double ypos) {
+  if (!enabled_) { return; }
   mouseMoved(xpos, ypos);
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->mouseMovedAll(xpos, ypos);
@@ -118,6 +300,7 @@ void GameObject::mouseMovedAll(double xpos, double ypos) {
 }
 
 void GameObject::collisionAll(const GameObject* other) {
+  if (!enabled_) { return; }
   collision(other);
   for (size_t i = 0; i < components_.size(); ++i) {
     components_[i]->collisionAll(other);
@@ -14,20 +14,65 @@
 namespace engine {
 
 class Scene;
+class RenderQueue;
 
 class GameObject {
  public:
+  // The virtual functions, that are called on every object of a scene, for
+  // a phase of the frame, or for an input event. The render phases are the
+  // first kRenderHookCount ones.
+  enum Hook {
+    kShadowRender, kRender, kRender2D, kCollectDraws, kPrepareRender,
+    kScreenResized, kUpdate, kKeyAction, kCharTyped, kMouseScrolled,
+    kMouseButtonPressed, kMouseMoved, kCollision, kHookCount
+  };
+  static constexpr unsigned kRenderHookCount = kPrepareRender;
+  static constexpr unsigned kAllHooks = (1u << kHookCount) - 1;
+
+  // What an object's update() touches, besides the object's own members.
+  // The scene runs the subtrees, whose update handlers are all thread safe,
+  // on worker threads. The flags decide which parts of such a subtree have to
+  // be updated in the same job: a parent and its children are updated in
+  // separate jobs, unless one of them declares, that it depends on the other.
+  // The objects are still updated in depth first order, as seen from the
+  // serial handlers: the jobs between two serial handlers run together, after
+  // the first one, and before the second one.
+  enum UpdatePolicy : unsigned {
+    // May touch anything, so it runs on the main thread (the default).
+    kUpdateSerial = 0,
+    // Only touches what the other flags declare. Mustn't add, remove,
+    // enable or disable objects, modify the physics world, or call OpenGL.
+    kUpdateThreadSafe = 1u << 0,
+    // Reads the parent's state, so it is updated in the same job as the
+    // parent, if the parent has an update handler.
+    kUpdateReadsParent = 1u << 1,
+    // Reads the scene's globals, like the timers and the camera. The camera's
+    // cached matrices are refreshed before such objects are updated.
+    kUpdateReadsScene = 1u << 2,
+    // Writes the own transform, which changes the world transform of every
+    // descendant, so they are updated in the same job.
+    kUpdateWritesTransform = 1u << 3,
+    // Writes the parent's transform, so the parent (and its subtree) has to
+    // be updated in the same job.
+    kUpdateWritesParent = 1u << 4,
+    // Writes the state of its components, so they are updated in the same
+    // job.
+    kUpdateWritesChildren = 1u << 5
+  };
+
   template<typename Transform_t = Transform>
   explicit GameObject(GameObject* parent,
                       const Transform_t& initial_transform = Transform_t{});
-  virtual ~GameObject() {}
+  virtual ~GameObject();
 
   template<typename T, typename... Args>
   T* addComponent(Args&&... contructor_args);
   GameObject* addComponent(std::unique_ptr<GameObject>&& component);
 
   // Returns the first component found by depth first search in the
-  // GameObject hierarchy whose type is T
+  // GameObject hierarchy whose type is T. Use Scene::findByType instead,
+  // if you search the whole scene for a unique object, as that doesn't walk
+  // the hierarchy.
   template<typename T>
   T* findComponent() const { return FindComponent<T>(this); }
 
@@ -35,6 +80,10 @@ class GameObject {
   template<typename T>
   std::vector<T*> findComponents() const;
 
+  // The components should be removed with these, and not destroyed directly,
+  // as they stop the frame pipeline before anything is destroyed, so the
+  // destructors run with the OpenGL context, and the render thread can't use
+  // the removed objects anymore.
   std::unique_ptr<GameObject> removeComponent(GameObject* component_to_remove);
 
   void ClearComponents();
@@ -48,16 +97,40 @@ class GameObject {
 
   Scene* scene() { return scene_; }
   const Scene* scene() const { return scene_; }
-  void set_scene(Scene* scene) { scene_ = scene; }
+  // Moves this object and its components to another scene (or out of any
+  // scene if it is nullptr), and updates the scenes' component registries.
+  void set_scene(Scene* scene);
 
+  // A disabled object, and all of its components are skipped by every hook.
   bool enabled() const { return enabled_; }
   void set_enabled(bool value);
 
+  // If the object's type doesn't override a hook, the scene doesn't call it.
+  bool handles(Hook hook) const { return handled_hooks_ & (1u << hook); }
+
   virtual void shadowRender() {}
   virtual void render() {}
   virtual void render2D() {}
+  // Pushes the draws of a pass (see queue->pass()) into the queue. It is
+  // called on worker threads, before the render functions, so it mustn't
+  // call OpenGL, and it may only read what the render functions may. The
+  // objects, that queue all their draws here, don't need the render
+  // functions of the same pass.
+  virtual void collectDraws(RenderQueue* queue) {}
+  // Called on the main thread after update, to copy the state that the render
+  // functions use into FrameBuffered members. If the frames are pipelined,
+  // the render functions run on a separate thread, so they mustn't read
+  // anything else that update() changes.
+  virtual void prepareRender() {}
   virtual void screenResized(size_t width, size_t height) {}
+  // Called on the main thread, if the object was created on the loader's
+  // context, to recreate the OpenGL objects, that aren't shared between the
+  // contexts (see ContextObjects). It isn't a hook, so it is called even for
+  // the disabled objects.
+  virtual void contextChanged() {}
   virtual void update() {}
+  // A combination of UpdatePolicy flags, that describes update().
+  virtual unsigned updatePolicy() const { return kUpdateSerial; }
   virtual void keyAction(int key, int scancode, int action, int mods) {}
   virtual void charTyped(unsigned codepoint) {}
   virtual void mouseScrolled(double xoffset, double yoffset) {}
@@ -68,7 +141,10 @@ class GameObject {
   virtual void shadowRenderAll();
   virtual void renderAll();
   virtual void render2DAll();
+  virtual void collectDrawsAll(RenderQueue* queue);
+  virtual void prepareRenderAll();
   virtual void screenResizedAll(size_t width, size_t height);
+  void contextChangedAll();
   virtual void updateAll();
   virtual void keyActionAll(int key, int scancode, int action, int mods);
   virtual void charTypedAll(unsigned codepoint);
@@ -83,10 +159,54 @@ class GameObject {
   std::unique_ptr<Transform> transform_;
   std::vector<std::unique_ptr<GameObject>> components_;
   bool enabled_;
+  // A bitmask of the hooks the object overrides. If the object wasn't created
+  // by addComponent<T>, its type isn't known, so every bit is set.
+  unsigned handled_hooks_;
+
+  // Appends the enabled objects of this subtree, that handle 'hook', in
+  // depth first order.
+  void collectHandlers(Hook hook, std::vector<GameObject*>* handlers);
+
+  // The update handlers of (a part of) a subtree, that have to run in the
+  // same job on a worker thread.
+  struct UpdateGroup {
+    GameObject* root;
+    std::vector<GameObject*> handlers;
+    // The union of the handlers' update policies.
+    unsigned policy;
+    // The number of serial handlers, that precede the group in depth first
+    // order.
+    size_t serial_index;
+  };
+
+  // Same as collectHandlers(kUpdate, ...), but the subtrees, whose update
+  // handlers are all thread safe, are collected into groups instead, as many
+  // as their update policies allow.
+  void collectUpdateHandlers(std::vector<GameObject*>* serial,
+                             std::vector<UpdateGroup>* parallel);
 
  private:
   void initScreenSize();
 
+  // Adds this object (but not its components) to its scene's registry.
+  void registerInScene();
+
+  // Whether every enabled update handler of the subtree can run on a worker
+  // thread, if the subtree is updated in a single job.
+  bool canUpdateInParallel(bool is_group_root) const;
+
+  // Whether the update of this object, and the updates of its components'
+  // subtrees can run in separate jobs.
+  bool canSplitUpdate() const;
+
+  // Collects the update groups of a subtree, whose update handlers are all
+  // thread safe.
+  void collectUpdateGroups(size_t serial_index,
+                           std::vector<UpdateGroup>* parallel);
+
+  // Makes the scene rebuild the lists of the objects that handle the hooks.
+  void hooksChanged();
+
   template<typename T>
   static T* FindComponent(const GameObject* obj);
 
@@ -5,6 +5,7 @@
 
 #include <string>
 #include "./label.h"
+#include "../context_objects.h"
 #include "../../oglwrap/shapes/rectangle_shape.h"
 
 namespace engine {
@@ -122,6 +123,11 @@ class Box : public engine::GameObject {
     }
   }
 
+  virtual void contextChanged() override {
+    ContextObjects::Recreate(&rect_, gl::RectangleShape(
+        {gl::RectangleShape::kPosition, gl::RectangleShape::kTexCoord}));
+  }
+
   virtual void render2D() override {
     gl::Use(prog_);
     rect_.render();
@@ -7,9 +7,12 @@
 #include <vector>
 
 #include "../game_engine.h"
+#include "../frame_arena.h"
+#include "../context_objects.h"
 #include "../../oglwrap/smart_enums.h"
 
 #include "./font.h"
+#include "./text_layout.h"
 
 namespace engine {
 namespace gui {
@@ -78,83 +81,14 @@ class Label : public GameObject {
 
   void set_text(const std::wstring& text, size_t cursor_pos = -1) {
     text_ = text;
-    std::vector<glm::vec4> attribs_vec;
-
-    float pen_x = 0, x0, x1, y0, y1, s0, t0, s1, t1;
-    // We have to run to loop for one more than the text size
-    // so we can draw the cursor at end of the text too
-    for (size_t i = 0; i <= text_.size(); ++i) {
-      if (i == cursor_pos) {  // Cursor
-        // we use the black character (-1) as texture
-        texture_glyph_t *glyph = font_.get_glyph(-1);
-
-        x0 = pen_x + 1;
-        y0 = font_.expose()->descender;
-        x1 = pen_x + 2;
-        y1 = y0 + font_.expose()->height - font_.expose()->linegap;
-
-        s0 = glyph->s0;
-        t0 = glyph->t0;
-        s1 = glyph->s1;
-        t1 = glyph->t1;
-
-        glm::vec4 a(x0, y0, s0, t0), b(x0, y1, s0, t1);
-        glm::vec4 c(x1, y0, s1, t0), d(x1, y1, s1, t1);
-
-        attribs_vec.push_back(a);
-        attribs_vec.push_back(b);
-        attribs_vec.push_back(c);
-
-        attribs_vec.push_back(d);
-        attribs_vec.push_back(b);
-        attribs_vec.push_back(c);
-      }
-
-      // The current character (glyph) in the text
-      if (i < text_.size()) {
-        texture_glyph_t *glyph = font_.get_glyph(text_[i]);
-        if (glyph) {
-          int kerning = 0;
-          if (i > 0) { kerning = texture_glyph_get_kerning(glyph, text_[i-1]); }
-
-          pen_x += kerning;
-          x0 = pen_x + glyph->offset_x;
-          y0 = glyph->offset_y;
-          x1 = x0 + glyph->width;
-          y1 = y0 - glyph->height;
-          s0 = glyph->s0;
-          t0 = glyph->t0;
-          s1 = glyph->s1;
-          t1 = glyph->t1;
-
-          glm::vec4 a(x0, y0, s0, t0), b(x0, y1, s0, t1);
-          glm::vec4 c(x1, y0, s1, t0), d(x1, y1, s1, t1);
-
-          attribs_vec.push_back(a);
-          attribs_vec.push_back(b);
-          attribs_vec.push_back(c);
-
-          attribs_vec.push_back(d);
-          attribs_vec.push_back(b);
-          attribs_vec.push_back(c);
-
-          pen_x += glyph->advance_x;
-        }
-      }
-    }
-
+    FrameVector<glm::vec4> attribs_vec;
     // Update the length of the text
-    size_.x = x1;
+    size_.x = LayoutText(font_.expose(), text_, cursor_pos, &attribs_vec);
 
     gl::Use(prog_);
-    gl::Bind(vao_);
     gl::Bind(attribs_);
-    attribs_.data(attribs_vec);
-    (prog_ | "aPosition").pointer(2, gl::kFloat, false,
-                                  4*sizeof(GLfloat), 0).enable();
-    (prog_ | "aTexCoord").pointer(2, gl::kFloat, false, 4*sizeof(GLfloat),
-                                  (const void*)(2*sizeof(GLfloat))).enable();
-    gl::Unbind(vao_);
+    attribs_.data(attribs_vec.size() * sizeof(glm::vec4), attribs_vec.data());
+    setupVertexArray();
 
     vertex_count_ = attribs_vec.size();
   }
@@ -198,6 +132,11 @@ class Label : public GameObject {
     set_position(pos_);
   }
 
+  virtual void contextChanged() override {
+    ContextObjects::Recreate(&vao_);
+    setupVertexArray();
+  }
+
   virtual void render2D() override {
     gl::Use(prog_);
     gl::Bind(vao_);
@@ -208,6 +147,17 @@ class Label : public GameObject {
 
     gl::Unbind(vao_);
   }
+
+ private:
+  void setupVertexArray() {
+    gl::Bind(vao_);
+    gl::Bind(attribs_);
+    (prog_ | "aPosition").pointer(2, gl::kFloat, false,
+                                  4*sizeof(GLfloat), 0).enable();
+    (prog_ | "aTexCoord").pointer(2, gl::kFloat, false, 4*sizeof(GLfloat),
+                                  (const void*)(2*sizeof(GLfloat))).enable();
+    gl::Unbind(vao_);
+  }
 };
 
 }  // namespace gui
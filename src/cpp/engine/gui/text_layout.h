@@ -0,0 +1,92 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_GUI_TEXT_LAYOUT_H_
+#define ENGINE_GUI_TEXT_LAYOUT_H_
+
+#include <string>
+#include <glm/glm.hpp>
+#include "freetype-gl.h"
+
+#include "../frame_arena.h"
+
+namespace engine {
+namespace gui {
+
+// Appends two triangles for every glyph of the text (and for the cursor if
+// cursor_pos isn't -1) to attribs, as xy: position, zw: texcoord. Returns the
+// width of the text. It only uses the glyphs already cached in the font, and
+// doesn't call OpenGL.
+inline float LayoutText(texture_font_t* font, const std::wstring& text,
+                        size_t cursor_pos, FrameVector<glm::vec4>* attribs) {
+  attribs->reserve(attribs->size() + 6 * (text.size() + 1));
+
+  float pen_x = 0, x0, x1 = 0, y0, y1, s0, t0, s1, t1;
+  // We have to run to loop for one more than the text size
+  // so we can draw the cursor at end of the text too
+  for (size_t i = 0; i <= text.size(); ++i) {
+    if (i == cursor_pos) {  // Cursor
+      // we use the black character (-1) as texture
+      texture_glyph_t *glyph = texture_font_get_glyph(font, -1);
+
+      x0 = pen_x + 1;
+      y0 = font->descender;
+      x1 = pen_x + 2;
+      y1 = y0 + font->height - font->linegap;
+
+      s0 = glyph->s0;
+      t0 = glyph->t0;
+      s1 = glyph->s1;
+      t1 = glyph->t1;
+
+      glm::vec4 a(x0, y0, s0, t0), b(x0, y1, s0, t1);
+      glm::vec4 c(x1, y0, s1, t0), d(x1, y1, s1, t1);
+
+      attribs->push_back(a);
+      attribs->push_back(b);
+      attribs->push_back(c);
+
+      attribs->push_back(d);
+      attribs->push_back(b);
+      attribs->push_back(c);
+    }
+
+    // The current character (glyph) in the text
+    if (i < text.size()) {
+      texture_glyph_t *glyph = texture_font_get_glyph(font, text[i]);
+      if (glyph) {
+        int kerning = 0;
+        if (i > 0) { kerning = texture_glyph_get_kerning(glyph, text[i-1]); }
+
+        pen_x += kerning;
+        x0 = pen_x + glyph->offset_x;
+        y0 = glyph->offset_y;
+        x1 = x0 + glyph->width;
+        y1 = y0 - glyph->height;
+        s0 = glyph->s0;
+        t0 = glyph->t0;
+        s1 = glyph->s1;
+        t1 = glyph->t1;
+
+        glm::vec4 a(x0, y0, s0, t0), b(x0, y1, s0, t1);
+        glm::vec4 c(x1, y0, s1, t0), d(x1, y1, s1, t1);
+
+        attribs->push_back(a);
+        attribs->push_back(b);
+        attribs->push_back(c);
+
+        attribs->push_back(d);
+        attribs->push_back(b);
+        attribs->push_back(c);
+
+        pen_x += glyph->advance_x;
+      }
+    }
+  }
+
+  return x1;
+}
+
+}  // namespace gui
+}  // namespace engine
+
+#endif
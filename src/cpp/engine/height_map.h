@@ -30,6 +30,11 @@ class HeightMap : public HeightMapInterface {
                   "Only uchar and ushort heightmaps are supported yet");
   }
 
+  // Uses w*h heights in row major order (for ex. a generated terrain).
+  HeightMap(int w, int h, std::vector<std::array<T, 1>> heights,
+            const std::string& format_string = "CR")
+      : tex_(w, h, std::move(heights), format_string) {}
+
   // The width and height of the texture
   virtual int w() const override { return tex_.w(); }
   virtual int h() const override { return tex_.h(); }
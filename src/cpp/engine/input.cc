@@ -0,0 +1,49 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./input.h"
+
+#include <atomic>
+
+namespace engine {
+
+namespace {
+
+std::atomic<const Input::Script*> current_script{nullptr};
+
+}  // namespace
+
+int Input::GetKey(GLFWwindow* window, int key) {
+  const Script* script = current_script;
+  if (script) {
+    return script->keys.count(key) ? GLFW_PRESS : GLFW_RELEASE;
+  }
+  return glfwGetKey(window, key);
+}
+
+int Input::GetMouseButton(GLFWwindow* window, int button) {
+  const Script* script = current_script;
+  if (script) {
+    return script->mouse_buttons.count(button) ? GLFW_PRESS : GLFW_RELEASE;
+  }
+  return glfwGetMouseButton(window, button);
+}
+
+void Input::GetCursorPos(GLFWwindow* window, double* xpos, double* ypos) {
+  const Script* script = current_script;
+  if (script) {
+    *xpos = script->cursor_pos.x;
+    *ypos = script->cursor_pos.y;
+  } else {
+    glfwGetCursorPos(window, xpos, ypos);
+  }
+}
+
+const Input::Script* Input::script() {
+  return current_script;
+}
+
+void Input::set_script(const Script* script) {
+  current_script = script;
+}
+
+}  // namespace engine
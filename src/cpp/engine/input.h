@@ -0,0 +1,36 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_INPUT_H_
+#define ENGINE_INPUT_H_
+
+#include <set>
+#include "./oglwrap_config.h"
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+namespace engine {
+
+// The polled input state, with the same interface as GLFW's functions. It
+// reads GLFW, unless a script is set, which replaces the keyboard and the
+// mouse, i.e. to make the benchmarks reproducible.
+class Input {
+ public:
+  struct Script {
+    std::set<int> keys;  // the pressed ones
+    std::set<int> mouse_buttons;
+    glm::dvec2 cursor_pos;
+  };
+
+  static int GetKey(GLFWwindow* window, int key);
+  static int GetMouseButton(GLFWwindow* window, int button);
+  static void GetCursorPos(GLFWwindow* window, double* xpos, double* ypos);
+
+  // The script must only be changed between two frames. With nullptr, the
+  // real input is used again.
+  static const Script* script();
+  static void set_script(const Script* script);
+};
+
+}  // namespace engine
+
+#endif
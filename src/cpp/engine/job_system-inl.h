@@ -0,0 +1,40 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_JOB_SYSTEM_INL_H_
+#define ENGINE_JOB_SYSTEM_INL_H_
+
+#include <algorithm>
+#include "./job_system.h"
+
+namespace engine {
+
+template<typename Func>
+void JobSystem::parallelFor(size_t begin, size_t end, Func func,
+                            size_t grain_size) {
+  if (begin >= end) { return; }
+
+  size_t count = end - begin;
+  if (grain_size == 0) {
+    grain_size = std::max<size_t>(1, count / (concurrency() * 4));
+  }
+  if (count <= grain_size) {
+    func(begin, end);
+    return;
+  }
+
+  TaskGroup group{*this};
+  for (size_t range_begin = begin + grain_size; range_begin < end;
+       range_begin += grain_size) {
+    size_t range_end = std::min(range_begin + grain_size, end);
+    group.run([&func, range_begin, range_end]() {
+      func(range_begin, range_end);
+    });
+  }
+  // The calling thread processes the first range.
+  func(begin, begin + grain_size);
+  group.wait();
+}
+
+}  // namespace engine
+
+#endif
@@ -0,0 +1,176 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./job_system.h"
+#include "./frame_arena.h"
+
+namespace engine {
+
+namespace {
+// The pool the current thread is a worker of, and the index of its queue.
+thread_local const JobSystem* current_pool = nullptr;
+thread_local size_t current_queue = 0;
+}
+
+JobSystem::JobSystem(size_t worker_count)
+    : queued_(0), should_quit_(false) {
+  for (size_t i = 0; i < worker_count + 1; ++i) {
+    queues_.push_back(std::unique_ptr<Queue>{new Queue{}});
+  }
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(&JobSystem::workerLoop, this, i + 1);
+  }
+}
+
+JobSystem::~JobSystem() {
+  should_quit_ = true;
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    wake_up_.notify_all();
+  }
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+JobSystem& JobSystem::Default() {
+  static JobSystem instance;
+  return instance;
+}
+
+size_t JobSystem::DefaultWorkerCount() {
+  unsigned cores = std::thread::hardware_concurrency();
+  return cores > 1 ? cores - 1 : 1;
+}
+
+JobSystem::TaskHandle JobSystem::submit(
+    std::function<void()> func, const std::vector<TaskHandle>& dependencies) {
+  TaskHandle task{new Task{std::move(func)}};
+
+  for (const TaskHandle& dependency : dependencies) {
+    if (!dependency) { continue; }
+    std::lock_guard<std::mutex> lock(dependency->mutex_);
+    if (!dependency->finished_) {
+      task->pending_dependencies_++;
+      dependency->continuations_.push_back(task);
+    }
+  }
+
+  // Drop the guard, that protected the task from being started by a
+  // dependency that finishes while the others are being added.
+  if (--task->pending_dependencies_ == 0) {
+    enqueue(task);
+  }
+
+  return task;
+}
+
+void JobSystem::wait(const TaskHandle& task) {
+  while (!task->finished_) {
+    if (!runOne()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::TaskGroup::run(std::function<void()> func) {
+  pending_++;
+  std::atomic<size_t>* pending = &pending_;
+  jobs_.submit(std::bind([pending](std::function<void()>& func) {
+    func();
+    (*pending)--;
+  }, std::move(func)));
+}
+
+void JobSystem::TaskGroup::wait() {
+  while (pending_ > 0) {
+    if (!jobs_.runOne()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::workerLoop(size_t queue_index) {
+  current_pool = this;
+  current_queue = queue_index;
+
+  while (!should_quit_) {
+    if (runOne()) {
+      // A job's transient memory can't outlive it on a worker.
+      FrameArena::ThreadLocal().reset();
+    } else {
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wake_up_.wait(lock, [this]() { return queued_ > 0 || should_quit_; });
+    }
+  }
+}
+
+size_t JobSystem::queueIndex() const {
+  return current_pool == this ? current_queue : 0;
+}
+
+void JobSystem::enqueue(const TaskHandle& task) {
+  // Counted before it's pushed, as a worker might take it and decrement the
+  // counter right away, which would wrap around otherwise.
+  queued_++;
+  Queue& queue = *queues_[queueIndex()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(task);
+  }
+
+  // Locking makes sure that a worker that is just going to sleep either sees
+  // the new job, or gets the notification.
+  { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+  wake_up_.notify_one();
+}
+
+bool JobSystem::runOne() {
+  size_t own_index = queueIndex();
+  TaskHandle task;
+
+  // The newest job from the own queue is probably the hottest in the cache.
+  {
+    Queue& own = *queues_[own_index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+    }
+  }
+
+  // Steal the oldest job from someone else.
+  for (size_t i = 1; !task && i < queues_.size(); ++i) {
+    Queue& other = *queues_[(own_index + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock(other.mutex);
+    if (!other.tasks.empty()) {
+      task = std::move(other.tasks.front());
+      other.tasks.pop_front();
+    }
+  }
+
+  if (!task) { return false; }
+
+  queued_--;
+  execute(task);
+  return true;
+}
+
+void JobSystem::execute(const TaskHandle& task) {
+  task->func_();
+  task->func_ = nullptr;  // release whatever the job captured
+
+  std::vector<TaskHandle> continuations;
+  {
+    std::lock_guard<std::mutex> lock(task->mutex_);
+    task->finished_ = true;
+    continuations.swap(task->continuations_);
+  }
+
+  for (const TaskHandle& continuation : continuations) {
+    if (--continuation->pending_dependencies_ == 0) {
+      enqueue(continuation);
+    }
+  }
+}
+
+}  // namespace engine
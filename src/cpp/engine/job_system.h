@@ -0,0 +1,120 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_JOB_SYSTEM_H_
+#define ENGINE_JOB_SYSTEM_H_
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace engine {
+
+// A work-stealing thread pool. Every worker thread has its own queue, it
+// takes the most recently pushed job from there, and if it's empty, it steals
+// the oldest job from another queue. Threads that wait for jobs (in
+// TaskGroup::wait, JobSystem::wait or parallelFor) run jobs in the meantime,
+// so waiting inside a job doesn't deadlock. An exception escaping a job
+// terminates the program (like with std::thread).
+class JobSystem {
+ public:
+  class Task;
+  using TaskHandle = std::shared_ptr<Task>;
+
+  // Runs jobs on worker_count threads plus the threads that wait for jobs.
+  // By default it is one less than the number of cores.
+  explicit JobSystem(size_t worker_count = DefaultWorkerCount());
+  ~JobSystem();
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  // The instance used by the engine.
+  static JobSystem& Default();
+
+  static size_t DefaultWorkerCount();
+
+  // The number of threads that can run jobs at the same time.
+  size_t concurrency() const { return workers_.size() + 1; }
+
+  // Runs func after every dependency finished.
+  TaskHandle submit(std::function<void()> func,
+                    const std::vector<TaskHandle>& dependencies = {});
+
+  // Waits for a task to finish, running other jobs in the meantime.
+  void wait(const TaskHandle& task);
+
+  // Calls func(range_begin, range_end) for subranges of [begin, end) that
+  // have at most grain_size elements, and waits for all of them. With the
+  // default grain size the range is split into a few ranges per thread.
+  template<typename Func>
+  void parallelFor(size_t begin, size_t end, Func func, size_t grain_size = 0);
+
+  // Fork-join: run() starts a job, wait() waits for all the started jobs.
+  class TaskGroup {
+   public:
+    explicit TaskGroup(JobSystem& jobs = JobSystem::Default())
+        : jobs_(jobs), pending_(0) {}
+    ~TaskGroup() { wait(); }
+
+    void run(std::function<void()> func);
+    void wait();
+
+   private:
+    JobSystem& jobs_;
+    std::atomic<size_t> pending_;
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+  };
+
+  class Task {
+   public:
+    bool finished() const { return finished_; }
+
+   private:
+    std::function<void()> func_;
+    // The number of unfinished dependencies, +1 while it is being submitted.
+    std::atomic<int> pending_dependencies_;
+    std::atomic<bool> finished_;
+    std::mutex mutex_;
+    std::vector<TaskHandle> continuations_;
+
+    explicit Task(std::function<void()>&& func)
+        : func_(std::move(func)), pending_dependencies_(1), finished_(false) {}
+
+    friend class JobSystem;
+  };
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<TaskHandle> tasks;
+  };
+
+  // queues_[0] is used by the threads that aren't workers of this pool.
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> queued_;
+  std::atomic<bool> should_quit_;
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_up_;
+
+  void workerLoop(size_t queue_index);
+  void enqueue(const TaskHandle& task);
+  // Runs one queued job, if there is any. Returns if it found one.
+  bool runOne();
+  void execute(const TaskHandle& task);
+  // The queue of the calling thread.
+  size_t queueIndex() const;
+};
+
+}  // namespace engine
+
+#include "./job_system-inl.h"
+
+#endif
@@ -0,0 +1,178 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./memory_stats.h"
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <algorithm>
+#include <iomanip>
+#include <utility>
+
+namespace engine {
+
+namespace {
+
+struct CategoryState {
+  size_t live = 0, peak = 0, allocations = 0;
+  std::map<std::string, size_t> owners;
+};
+
+struct MemoryState {
+  std::mutex mutex;
+  std::map<std::pair<MemoryStats::Kind, std::string>, CategoryState>
+      categories;
+};
+
+MemoryState& State() {
+  // The allocations might be registered during the static initialization,
+  // and released by the job system's threads after the static destruction,
+  // so the state is never destroyed.
+  static MemoryState* state = new MemoryState;
+  return *state;
+}
+
+double Megabytes(size_t bytes) {
+  return bytes / (1024.0 * 1024.0);
+}
+
+}  // namespace
+
+MemoryStats::Allocation::Allocation(Kind kind, const std::string& category,
+                                    const std::string& owner, size_t bytes)
+    : kind_(kind), category_(category), owner_(owner), bytes_(0)
+    , moved_from_(false) {
+  set_bytes(bytes);
+}
+
+MemoryStats::Allocation::Allocation(const Allocation& other)
+    : kind_(other.kind_), category_(other.category_), owner_(other.owner_)
+    , bytes_(0), moved_from_(false) {
+  set_bytes(other.bytes_);
+}
+
+MemoryStats::Allocation::Allocation(Allocation&& other) noexcept
+    : kind_(other.kind_), category_(std::move(other.category_))
+    , owner_(std::move(other.owner_)), bytes_(other.bytes_)
+    , moved_from_(false) {
+  other.bytes_ = 0;
+  other.moved_from_ = true;
+}
+
+MemoryStats::Allocation&
+MemoryStats::Allocation::operator=(Allocation other) {
+  set_bytes(0);
+  std::swap(kind_, other.kind_);
+  std::swap(category_, other.category_);
+  std::swap(owner_, other.owner_);
+  std::swap(bytes_, other.bytes_);
+  std::swap(moved_from_, other.moved_from_);
+  return *this;
+}
+
+MemoryStats::Allocation::~Allocation() {
+  set_bytes(0);
+}
+
+void MemoryStats::Allocation::set_bytes(size_t bytes) {
+  if (moved_from_ || bytes == bytes_) { return; }
+  Change(kind_, category_, owner_, bytes_, bytes);
+  bytes_ = bytes;
+}
+
+void MemoryStats::Change(Kind kind, const std::string& category,
+                         const std::string& owner, size_t old_bytes,
+                         size_t new_bytes) {
+  MemoryState& state = State();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  CategoryState& cat = state.categories[std::make_pair(kind, category)];
+
+  cat.live = cat.live - old_bytes + new_bytes;
+  cat.peak = std::max(cat.peak, cat.live);
+  if (old_bytes == 0) {
+    cat.allocations++;
+  } else if (new_bytes == 0) {
+    cat.allocations--;
+  }
+
+  size_t& owner_bytes = cat.owners[owner];
+  owner_bytes = owner_bytes - old_bytes + new_bytes;
+  if (owner_bytes == 0) {
+    cat.owners.erase(owner);
+  }
+}
+
+std::vector<MemoryStats::Category> MemoryStats::Categories() {
+  MemoryState& state = State();
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  std::vector<Category> categories;
+  for (const auto& cat : state.categories) {
+    categories.push_back(Category{cat.first.first, cat.first.second,
+                                  cat.second.live, cat.second.peak,
+                                  cat.second.allocations});
+  }
+  return categories;
+}
+
+size_t MemoryStats::Total(Kind kind) {
+  MemoryState& state = State();
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  size_t total = 0;
+  for (const auto& cat : state.categories) {
+    if (cat.first.first == kind) { total += cat.second.live; }
+  }
+  return total;
+}
+
+void MemoryStats::Dump(std::ostream& os) {
+  MemoryState& state = State();
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  std::ios::fmtflags flags = os.flags();
+  os << std::fixed << std::setprecision(2);
+  os << "Memory usage (live / peak MB):" << std::endl;
+  for (const auto& cat : state.categories) {
+    os << (cat.first.first == kCpu ? " CPU " : " GPU ") << cat.first.second
+       << ": " << Megabytes(cat.second.live) << " / "
+       << Megabytes(cat.second.peak) << " in " << cat.second.allocations
+       << " allocations" << std::endl;
+    for (const auto& owner : cat.second.owners) {
+      if (!owner.first.empty()) {
+        os << "   " << owner.first << ": " << Megabytes(owner.second)
+           << std::endl;
+      }
+    }
+  }
+  os.flags(flags);
+}
+
+size_t MemoryStats::BoundTextureBytes(GLenum target, bool mipmapped) {
+  GLint compressed = 0;
+  glGetTexLevelParameteriv(target, 0, GL_TEXTURE_COMPRESSED, &compressed);
+
+  size_t bytes = 0;
+  if (compressed) {
+    GLint size = 0;
+    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE,
+                             &size);
+    bytes = size;
+  } else {
+    GLint width = 0, height = 0, bits = 0;
+    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_HEIGHT, &height);
+    for (GLenum channel : {GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE,
+                           GL_TEXTURE_BLUE_SIZE, GL_TEXTURE_ALPHA_SIZE,
+                           GL_TEXTURE_DEPTH_SIZE}) {
+      GLint channel_bits = 0;
+      glGetTexLevelParameteriv(target, 0, channel, &channel_bits);
+      bits += channel_bits;
+    }
+    bytes = size_t(width) * height * bits / 8;
+  }
+
+  return mipmapped ? bytes + bytes / 3 : bytes;
+}
+
+}  // namespace engine
@@ -0,0 +1,81 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MEMORY_STATS_H_
+#define ENGINE_MEMORY_STATS_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "./oglwrap_config.h"
+
+namespace engine {
+
+// Accounts the big CPU and GPU allocations (buffers, textures, loaded
+// assets) per category (i.e. "shadow maps"), with the live total and the
+// high-water mark of each. The allocations are tagged with their owner too
+// (i.e. a file name), which only shows up in the dump. It is thread safe.
+class MemoryStats {
+ public:
+  enum Kind { kCpu, kGpu };
+
+  struct Category {
+    Kind kind;
+    std::string name;
+    size_t live;  // bytes
+    size_t peak;  // bytes
+    size_t allocations;  // the live ones
+  };
+
+  // Registers some memory for its lifetime. The size can be changed, i.e.
+  // when a render target is resized. A copy registers the same size again.
+  class Allocation {
+   public:
+    Allocation(Kind kind, const std::string& category,
+               const std::string& owner = "", size_t bytes = 0);
+    Allocation(const Allocation& other);
+    Allocation(Allocation&& other) noexcept;
+    Allocation& operator=(Allocation other);
+    ~Allocation();
+
+    size_t bytes() const { return bytes_; }
+    void set_bytes(size_t bytes);
+    void add(size_t bytes) { set_bytes(bytes_ + bytes); }
+
+   private:
+    Kind kind_;
+    std::string category_, owner_;
+    size_t bytes_;
+    bool moved_from_;
+  };
+
+  // A snapshot of the categories, the CPU ones first.
+  static std::vector<Category> Categories();
+
+  // The live total of a kind.
+  static size_t Total(Kind kind);
+
+  // Prints the categories, with their owners.
+  static void Dump(std::ostream& os);
+
+  // The size of level 0 of the texture bound to the target, as reported by
+  // OpenGL (the drivers might pad it). With mipmaps, a third is added.
+  static size_t BoundTextureBytes(GLenum target = GL_TEXTURE_2D,
+                                  bool mipmapped = false);
+
+  // The size of a texture that isn't compressed.
+  static size_t TextureBytes(size_t width, size_t height,
+                             size_t bytes_per_pixel, bool mipmapped = false) {
+    size_t bytes = width * height * bytes_per_pixel;
+    return mipmapped ? bytes + bytes / 3 : bytes;
+  }
+
+ private:
+  static void Change(Kind kind, const std::string& category,
+                     const std::string& owner, size_t old_bytes,
+                     size_t new_bytes);
+};
+
+}  // namespace engine
+
+#endif
@@ -5,23 +5,23 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "../oglwrap_config.h"
 
 #include "anim_state.h"
-#include "../assimp.h"
+#include "animation_clip.h"
 
 namespace engine {
 
 /// A struct storing info per animation
 struct AnimInfo {
-  /// The importer that stores the animations.
-  // It is a shared_ptr because we want to use AnimInfo
-  // in std::vector, which needs copy ctor
-  std::shared_ptr<Assimp::Importer> importer;
+  /// The file, that the animation is loaded from.
+  std::string filename;
 
-  /// Handle for the animations
-  const aiScene* handle;
+  /// The compressed animation. The animations loaded from the same file
+  /// share it.
+  std::shared_ptr<const AnimationClip> clip;
 
   /// The name of the animation.
   std::string name;
@@ -40,9 +40,7 @@ struct AnimInfo {
 
   /// Default constructor
   AnimInfo()
-      : importer(new Assimp::Importer{})
-      , handle(nullptr)
-      , flags(0)
+      : flags(0)
       , speed(1.0f)
   { }
 };
@@ -7,6 +7,8 @@
 
 namespace engine {
 
+class AnimationClip;
+
 /// Animation modifying flags.
 enum class AnimFlag : GLbitfield {
   /// Doesn't do anything.
@@ -38,8 +40,8 @@ enum class AnimFlag : GLbitfield {
 
 /// A class storing an animation's state.
 struct AnimationState {
-  /// The handle to the animation.
-  const aiScene* handle;
+  /// The animation's clip.
+  const AnimationClip* clip;
 
   /// The index of the animation in the anim vector.
   size_t idx;
@@ -56,7 +58,7 @@ struct AnimationState {
 
   /// Default constructor.
   AnimationState()
-      : handle(nullptr)
+      : clip(nullptr)
       , idx(0)
       , flags(0)
       , speed(1.0f)
@@ -4,6 +4,7 @@
 #define ENGINE_MESH_ANIMATED_MESH_RENDERER_H_
 
 #include <string>
+#include <vector>
 #include <functional>
 
 #include "../oglwrap_config.h"
@@ -14,12 +15,20 @@
 #include "./anim_state.h"
 #include "./skinning_data.h"
 #include "./anim_info.h"
+#include "./bone_palette.h"
 
 namespace engine {
 
 class Animation;
 
-/// A class for loading and displaying animations.
+/**
+ * @brief A class for loading and displaying animations.
+ *
+ * The mesh, the skeleton and the animations are shared by the instances, that
+ * play them, once the animations are added, they aren't modified. The state
+ * and the pose of an instance is in its Animation, so the poses of different
+ * instances can be evaluated on different threads at the same time.
+ */
 class AnimatedMeshRenderer : public MeshRenderer {
   /// Stores data related to skin definition.
   SkinningData skinning_data_;
@@ -27,6 +36,9 @@ class AnimatedMeshRenderer : public MeshRenderer {
   /// The animations.
   AnimData anims_;
 
+  /// The bones' transformations, as the shaders read them.
+  BonePalette bone_palette_;
+
  public:
   /**
    * @brief Loads in the mesh and the skeleton for an asset, and prepares it
@@ -34,9 +46,12 @@ class AnimatedMeshRenderer : public MeshRenderer {
    *
    * @param filename   The name of the file.
    * @param flags      The assimp post-process flags to use while loading the mesh.
+   * @param encoding   The encoding of the bones in the bone palette. The
+   *                   shaders have to be compiled with the same BONE_ENCODING.
    */
   AnimatedMeshRenderer(const std::string& filename,
-                       gl::Bitfield<aiPostProcessSteps> flags);
+                       gl::Bitfield<aiPostProcessSteps> flags,
+                       BoneEncoding encoding = BoneEncoding::kMat3x4);
 
   /// Returns a reference to the animation resources
   const AnimData& getAnimData() const { return anims_; }
@@ -52,6 +67,15 @@ class AnimatedMeshRenderer : public MeshRenderer {
    */
   ExternalBoneTree markBoneExternal(const std::string& bone_name);
 
+  /**
+   * @brief Returns if a bone was marked external by markBoneExternal().
+   *
+   * The global transformation of such a pinned bone is written into its
+   * ExternalBoneTree by every updateBoneInfo() call, so then the updates
+   * can't run on different threads at the same time.
+   */
+  bool hasPinnedBones() const;
+
   /**
    * @brief Returns the number of bones this scene has.
    *
@@ -67,6 +91,10 @@ class AnimatedMeshRenderer : public MeshRenderer {
    */
   size_t getBoneAttribNum();
 
+  /// Returns the encoding of the bone palette. Its integer value should be
+  /// inserted into the shaders as the BONE_ENCODING macro.
+  BoneEncoding getBoneEncoding() const { return bone_palette_.encoding(); }
+
   /**
    * @brief Loads in bone weight and id information to the given array of
    *        attribute arrays.
@@ -89,30 +117,37 @@ class AnimatedMeshRenderer : public MeshRenderer {
 
   // -------------------------------- Animation --------------------------------
 
-  /// Updates the bones' transformations.
+  /**
+   * @brief Updates the animation's pose, and its bones' transformations.
+   *
+   * It only modifies the animation, so it can be called for different
+   * animations on different threads at the same time, unless the mesh has
+   * pinned bones (see hasPinnedBones()). The animation ended callback is
+   * called on the calling thread.
+   */
   void updateBoneInfo(Animation& animation,
-                      float time_in_seconds);
+                      float time_in_seconds) const;
 
   /**
-   * @brief Uploads the bones' transformations into the given uniform array.
+   * @brief Uploads the animation's bone transformations into the bone
+   *        palette, if they changed since the last upload, and binds it to
+   *        BonePalette::kBindingPoint.
    *
-   * @param bones - The uniform naming the bones array. It should be indexable.
+   * Every pass, that draws the mesh, should call it, but the palette is only
+   * written by the first one after updateBoneInfo().
    */
-  void uploadBoneInfo(gl::LazyUniform<glm::mat4>& bones);
+  void uploadBoneInfo(const Animation& animation);
 
   /**
-   * @brief Updates the bones transformation and uploads them into the given
-   *        uniforms.
+   * @brief Updates the bones transformation and uploads them into the bone
+   *        palette.
    *
    * @param animation        The animation to update.
    * @param time_in_seconds  Expect a time value as a float, optimally since
    *                         the start of the program.
-   * @param bones            The uniform naming the bones array. It should be
-   *                         indexable.
    */
   void updateAndUploadBoneInfo(Animation& animation,
-                               float time_in_seconds,
-                               gl::LazyUniform<glm::mat4>& bones);
+                               float time_in_seconds);
 
   // --------------------------- Animation Control -----------------------------
 
@@ -150,6 +185,19 @@ class AnimatedMeshRenderer : public MeshRenderer {
   /// Fills the bone_mapping with data.
   void mapBones();
 
+  /// Appends the node, and its subtree to skinning_data_.skeleton, in depth
+  /// first order.
+  void mapNodes(const aiNode* node, int parent = -1);
+
+  /**
+   * @brief Returns the animation's channel for every node of the skeleton
+   *        (or nullptr for the nodes that it doesn't move).
+   *
+   * @param animation   The animation to bind. Its root bone must be already
+   *                    known.
+   */
+  std::vector<const aiNodeAnim*> bindChannels(const aiAnimation* animation);
+
   /**
    * @brief A recursive functions that should be started from the root node, and
    * it returns the first bone under it.
@@ -227,110 +275,21 @@ class AnimatedMeshRenderer : public MeshRenderer {
   // -------------------------------- Animation --------------------------------
 
   /**
-   * @brief Returns the index of the currently active translation keyframe for
-   *        the given animation and time.
-   *
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for a keyframe.
-   */
-  unsigned findPosition(float anim_time, const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns the index of the currently active rotation keyframe for
-   *        the given animation and time.
+   * @brief Samples the current animation into the animation's local pose.
    *
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for a keyframe.
-   */
-  unsigned findRotation(float anim_time, const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns the index of the currently active scaling keyframe for
-   *        the given animation and time.
-   *
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for a keyframe.
-   */
-  unsigned findScaling(float anim_time, const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns a linearly interpolated value between the previous and next
-   *        translation keyframes.
-   *
-   * @param out         Returns the result here.
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for the keyframes.
-   */
-  void calcInterpolatedPosition(aiVector3D& out, float anim_time,
-                                const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns a spherically interpolated value (always choosing the shorter
-   * path) between the previous and next rotation keyframes.
-   *
-   * @param out         Returns the result here.
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for the keyframes.
-   */
-  void calcInterpolatedRotation(aiQuaternion& out, float anim_time,
-                                const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns a linearly interpolated value between the previous and next
-   *        scaling keyframes.
-   *
-   * @param out         Returns the result here.
-   * @param anim_time   The time elapsed since the start of this animation.
-   * @param node_anim   The animation node, in which the function should search
-   *                    for the keyframes.
-   */
-  void calcInterpolatedScaling(aiVector3D& out, float anim_time,
-                               const aiNodeAnim* node_anim);
-
-  /**
-   * @brief Returns the animation node in the given animation, referenced by
-   *        its name.
-   *
-   * Returns nullptr if it doesn't find a node with that name,
-   * which usually means that it's not a bone.
-   *
-   * @param animation - The animation, this function should search in.
-   * @param node_name - The name of the bone to search.
-   */
-  const aiNodeAnim* findNodeAnim(const aiAnimation* animation,
-                                 const std::string node_name);
-
-  /**
-   * @brief Recursive function that travels through the entire node hierarchy,
-   *        and creates transformation values in world space.
-   *
-   * Bone transformations are stored relative to their parents. That's why it is
-   * needed. Also note, that the translation of the root node on the XZ plane is
-   * treated differently, that offset isn't baked into the animation, you can get
+   * Note, that the translation of the root bone on the XZ plane is treated
+   * differently, that offset isn't baked into the animation, you can get
    * the offset with the offsetSinceLastFrame() function, and you have to
    * externally do the object's movement, as normally it will stay right where
    * it was at the start of the animation.
    *
    * @param animation          The animation to update.
    * @param anim_time          The current animation time.
-   * @param node               The node (bone) whose, and whose child's
-   *                           transformation should be updated. You should call
-   *                           this function with the root node.
-   * @param parent_transform   The transformation of the parent node. You should
-   *                           call it with an identity matrix.
    */
-  void updateBoneTree(Animation& animation,
-                      float anim_time,
-                      const aiNode* node,
-                      const glm::mat4& parent_transform = glm::mat4());
+  void samplePose(Animation& animation, float anim_time) const;
 
   /**
-   * @brief Does the same thing as readNodeHierarchy, but it is used to create
+   * @brief Does the same thing as samplePose, but it is used to create
    *        transitions between animations, so it interpolates between four
    *        keyframes not two.
    *
@@ -338,18 +297,22 @@ class AnimatedMeshRenderer : public MeshRenderer {
    * @param prev_animation_time   The animation time of when, the last animation
    *                              was interrupted.
    * @param next_animation_time   The current animation time.
-   * @param node                  The node (bone) whose, and whose child's
-   *                              transformation should be updated. You should
-   *                              call this function with the root node.
-   * @param parent_transform      The transformation of the parent node. You
-   *                              should call it with an identity matrix.
+   * @param factor                The weight of the current animation.
+   */
+  void samplePoseInTransition(Animation& animation,
+                              float prev_animation_time,
+                              float next_animation_time,
+                              float factor) const;
+
+  /**
+   * @brief Computes the model space transformations of the animation's local
+   *        pose, and the bones' final transformations from them.
+   *
+   * The bones under a pinned bone are moved from outside, so they are left
+   * alone. The external bones are shared by every instance, and the pinned
+   * bones' global transformations are written into them.
    */
-  void updateBoneTreeInTransition(Animation& animation,
-                                  float prev_animation_time,
-                                  float next_animation_time,
-                                  float factor,
-                                  const aiNode* node,
-                                  const glm::mat4& parent_transform = glm::mat4());
+  void updateSkinning(Animation& animation) const;
 
 };  // AnimatedMeshRenderer
 }  // namespace engine
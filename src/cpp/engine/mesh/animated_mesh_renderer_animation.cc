@@ -1,276 +1,131 @@
 // Copyright (c) 2014, Tamas Csala
 
+#include <atomic>
+
 #include "animated_mesh_renderer.h"
 #include "animation.h"
+#include "animation_clip.h"
+#include "../profiler.h"
 
 namespace engine {
 
-template <typename T, typename U>
-T mix(const T& x, const T& y, const U& a) {
-   return x*(1-a) + y*a;
-}
-
-unsigned AnimatedMeshRenderer::findPosition(float anim_time,
-                                            const aiNodeAnim* node_anim) {
-   // Find the first one that is bigger or equals
-   for (unsigned i = 0; i < node_anim->mNumPositionKeys - 1; i++) {
-      if (anim_time <= (float)node_anim->mPositionKeys[i + 1].mTime) {
-         return i;
-      }
-   }
-   return node_anim->mNumPositionKeys - 2;
-}
-
-unsigned AnimatedMeshRenderer::findRotation(float anim_time,
-                                            const aiNodeAnim* node_anim) {
-   for (unsigned i = 0; i < node_anim->mNumRotationKeys - 1; i++) {
-      if (anim_time <= (float)node_anim->mRotationKeys[i + 1].mTime) {
-         return i;
-      }
-   }
-   return node_anim->mNumRotationKeys - 2;
-}
-
-unsigned AnimatedMeshRenderer::findScaling(float anim_time,
-                                           const aiNodeAnim* node_anim) {
-   for (unsigned i = 0; i < node_anim->mNumScalingKeys - 1; i++) {
-      if (anim_time <= (float)node_anim->mScalingKeys[i + 1].mTime) {
-         return i;
-      }
-   }
-   return node_anim->mNumScalingKeys - 2;
-}
-
-void AnimatedMeshRenderer::calcInterpolatedPosition(
-                                                aiVector3D& out,
-                                                float anim_time,
-                                                const aiNodeAnim* node_anim) {
-   const auto& keys = node_anim->mPositionKeys;
-   const auto& numKeys = node_anim->mNumPositionKeys;
-   if (numKeys == 1) {
-      out = keys[0].mValue;
-      return;
-   }
-   size_t i = findPosition(anim_time, node_anim);
-   float deltaTime = keys[i + 1].mTime - keys[i].mTime;
-   float factor = (anim_time - (float)keys[i].mTime) / deltaTime;
-   factor = glm::clamp(factor, 0.0f, 1.0f);
+/// The version of the last pose, that any instance computed.
+static std::atomic<unsigned> last_bone_version{0};
 
-   const aiVector3D& start = keys[i].mValue;
-   const aiVector3D& end   = keys[i + 1].mValue;
-   out = mix(start, end, factor);
-}
+void AnimatedMeshRenderer::samplePose(Animation& anim,
+                                      float anim_time) const {
+   LocalPose& pose = anim.pose_;
+   anim.current_anim_.clip->samplePose(anim_time, &pose);
 
-void AnimatedMeshRenderer::calcInterpolatedRotation(
-                                                aiQuaternion& out,
-                                                float anim_time,
-                                                const aiNodeAnim* node_anim) {
-   const auto& keys = node_anim->mRotationKeys;
-   const auto& numKeys = node_anim->mNumRotationKeys;
-   if (numKeys == 1) {
-      out = keys[0].mValue;
-      return;
-   }
-   size_t i = findRotation(anim_time, node_anim);
-   float deltaTime = keys[i + 1].mTime - keys[i].mTime;
-   float factor = (anim_time - (float)keys[i].mTime) / deltaTime;
-   factor = glm::clamp(factor, 0.0f, 1.0f);
-
-   const aiQuaternion& start = keys[i].mValue;
-   const aiQuaternion& end   = keys[i + 1].mValue;
-   aiQuaternion::Interpolate(out, start, end, factor);
-   out = out.Normalize();
-}
-
-void AnimatedMeshRenderer::calcInterpolatedScaling(
-                                                aiVector3D& out,
-                                                float anim_time,
-                                                const aiNodeAnim* node_anim) {
-   const auto& keys = node_anim->mScalingKeys;
-   const auto& numKeys = node_anim->mNumScalingKeys;
-   if (numKeys == 1) {
-      out = keys[0].mValue;
-      return;
-   }
-   size_t i = findRotation(anim_time, node_anim);
-   float deltaTime = keys[i + 1].mTime - keys[i].mTime;
-   float factor = (anim_time - (float)keys[i].mTime) / deltaTime;
-   factor = glm::clamp(factor, 0.0f, 1.0f);
-
-   const aiVector3D& start = keys[i].mValue;
-   const aiVector3D& end   = keys[i + 1].mValue;
-   out = mix(start, end, factor);
-}
-
-const aiNodeAnim* AnimatedMeshRenderer::findNodeAnim(const aiAnimation* animation,
-                                                     const std::string node_name) {
-   for (unsigned i = 0; i < animation->mNumChannels; i++) {
-      const aiNodeAnim* node_anim = animation->mChannels[i];
-      if (std::string(node_anim->mNodeName.data) == node_name) {
-         return node_anim;
+   size_t root = skinning_data_.root_bone_node;
+   if (root < pose.animated.size() && pose.animated[root]) {
+      glm::vec3& translation = pose.translations[root];
+      anim.current_anim_.offset = glm::vec3(translation.x, 0, translation.z);
+      if (anim.current_anim_.flags.test(AnimFlag::Mirrored)) {
+         anim.current_anim_.offset *= -1;
       }
+      translation = glm::vec3(0, translation.y, 0);
    }
-   return nullptr;
 }
 
-void AnimatedMeshRenderer::updateBoneTree(Animation& anim,
-                                          float anim_time,
-                                          const aiNode* node,
-                                          const glm::mat4& parent_transform) {
-   std::string node_name(node->mName.data);
-   const aiAnimation* animation = anim.current_anim_.handle->mAnimations[anim.current_anim_.handle->mNumAnimations-1];
-   const aiNodeAnim* node_anim = findNodeAnim(animation, node_name);
-   glm::mat4 local_transform = engine::convertMatrix(node->mTransformation);
-
-   if (node_anim) {
-      // Interpolate the transformations and get the matrices
-      aiVector3D scaling;
-      calcInterpolatedScaling(scaling, anim_time, node_anim);
-      glm::mat4 scalingM = glm::scale(glm::mat4(), glm::vec3(scaling.x, scaling.y, scaling.z));
-
-      aiQuaternion rotation;
-      calcInterpolatedRotation(rotation, anim_time, node_anim);
-      glm::mat4 rotationM = engine::convertMatrix(rotation.GetMatrix());
-
-      aiVector3D translation;
-      calcInterpolatedPosition(translation, anim_time, node_anim);
-      glm::mat4 translationM;
-
-      if (node_name == skinning_data_.root_bone) {
-         anim.current_anim_.offset = glm::vec3(translation.x, 0, translation.z);
-         if (anim.current_anim_.flags.test(AnimFlag::Mirrored)) {
-            anim.current_anim_.offset *= -1;
-         }
-         translationM = glm::translate(glm::mat4(), glm::vec3(0, translation.y, 0));
-      } else {
-         translationM = glm::translate(glm::mat4(), glm::vec3(translation.x, translation.y, translation.z));
-      }
-      // Combine the transformations
-      local_transform = translationM * rotationM * scalingM;
-   }
-
-   glm::mat4 global_transform = parent_transform * local_transform;
-
-   if (skinning_data_.bone_mapping.find(node_name) != skinning_data_.bone_mapping.end()) {
-      unsigned bone_idx = skinning_data_.bone_mapping[node_name];
-      if (skinning_data_.bone_info[bone_idx].external == false) {
-         skinning_data_.bone_info[bone_idx].final_transform =
-            global_transform * skinning_data_.bone_info[bone_idx].bone_offset;
-      }
-      if (skinning_data_.bone_info[bone_idx].pinned == true) {
-         *skinning_data_.bone_info[bone_idx].global_transform_ptr = global_transform;
-         // A pinned bone has all external child
-         return;
+void AnimatedMeshRenderer::samplePoseInTransition(Animation& anim,
+                                                  float prev_anim_time,
+                                                  float next_anim_time,
+                                                  float factor) const {
+   LocalPose& prev_pose = anim.transition_pose_;
+   LocalPose& pose = anim.pose_;
+   anim.last_anim_.clip->samplePose(prev_anim_time, &prev_pose);
+   anim.current_anim_.clip->samplePose(next_anim_time, &pose);
+
+   for (size_t i = 0; i < skinning_data_.skeleton.size(); i++) {
+      pose.animated[i] = prev_pose.animated[i] && pose.animated[i];
+      if (!pose.animated[i]) {
+         continue;
       }
-   }
-   for (unsigned i = 0; i < node->mNumChildren; i++) {
-      updateBoneTree(anim, anim_time, node->mChildren[i], global_transform);
-   }
-}
-
-void AnimatedMeshRenderer::updateBoneTreeInTransition(
-                                             Animation& anim,
-                                             float prev_anim_time,
-                                             float next_anim_time,
-                                             float factor,
-                                             const aiNode* node,
-                                             const glm::mat4& parent_transform) {
-   std::string node_name(node->mName.data);
-   const aiAnimation* prev_animation = anim.last_anim_.handle->mAnimations[anim.last_anim_.handle->mNumAnimations - 1];
-   const aiAnimation* next_animation = anim.current_anim_.handle->mAnimations[anim.current_anim_.handle->mNumAnimations - 1];
-   const aiNodeAnim* prev_node_anim = findNodeAnim(prev_animation, node_name);
-   const aiNodeAnim* next_node_anim = findNodeAnim(next_animation, node_name);
-
-   glm::mat4 local_transform = engine::convertMatrix(node->mTransformation);
-
-   if (prev_node_anim && next_node_anim) {
-      // Interpolate the transformations and get the matrices
-      aiVector3D prev_scaling, next_scaling;
-      calcInterpolatedScaling(prev_scaling, prev_anim_time, prev_node_anim);
-      calcInterpolatedScaling(next_scaling, next_anim_time, next_node_anim);
-      aiVector3D scaling = mix(prev_scaling, next_scaling, factor);
-      glm::mat4 scalingM = glm::scale(glm::mat4(), glm::vec3(scaling.x, scaling.y, scaling.z));
-
-      aiQuaternion prev_rotation, next_rotation, rotation;
-      calcInterpolatedRotation(prev_rotation, prev_anim_time, prev_node_anim);
-      calcInterpolatedRotation(next_rotation, next_anim_time, next_node_anim);
+      glm::vec3 next_translation = pose.translations[i];
+      glm::vec3 translation =
+         glm::mix(prev_pose.translations[i], next_translation, factor);
+      pose.scales[i] = glm::mix(prev_pose.scales[i], pose.scales[i], factor);
 
       // Spherical linear interpolation, that chooses the shorter path.
-      aiQuaternion::Interpolate(rotation, prev_rotation, next_rotation, factor);
-      glm::mat4 rotationM = engine::convertMatrix(rotation.GetMatrix());
+      pose.rotations[i] =
+         glm::slerp(prev_pose.rotations[i], pose.rotations[i], factor);
 
-      aiVector3D prev_translation, next_translation;
-      calcInterpolatedPosition(prev_translation, prev_anim_time, prev_node_anim);
-      calcInterpolatedPosition(next_translation, next_anim_time, next_node_anim);
-      aiVector3D translation = mix(prev_translation, next_translation, factor);
-      glm::mat4 translationM;
-      if (node_name == skinning_data_.root_bone) {
+      if (i == skinning_data_.root_bone_node) {
          anim.current_anim_.offset =
             glm::vec3(next_translation.x, 0, next_translation.z);
          if (anim.current_anim_.flags.test(AnimFlag::Mirrored)) {
             anim.current_anim_.offset *= -1;
          }
-         translationM = glm::translate(glm::mat4(), glm::vec3(0, translation.y, 0));
+         pose.translations[i] = glm::vec3(0, translation.y, 0);
       } else {
-         translationM = glm::translate(glm::mat4(), glm::vec3(translation.x, translation.y, translation.z));
+         pose.translations[i] = translation;
       }
-      // Combine the transformations
-      local_transform = translationM * rotationM * scalingM;
    }
+}
 
-   glm::mat4 global_transform = parent_transform * local_transform;
+void AnimatedMeshRenderer::updateSkinning(Animation& anim) const {
+   const Skeleton& skeleton = skinning_data_.skeleton;
+   std::vector<glm::mat4>& model_transforms = anim.model_transforms_;
+   ComputeModelTransforms(skeleton, anim.pose_, model_transforms.data());
+
+   // The nodes under a pinned bone are left alone. The parents come before
+   // their children, so one pass is enough to propagate this.
+   std::vector<unsigned char>& skipped = anim.skipped_nodes_;
+   for (size_t i = 0; i < skeleton.size(); i++) {
+      int parent = skeleton.parents[i];
+      skipped[i] = parent >= 0 && skipped[parent];
+      int bone_idx = skeleton.bones[i];
+      if (bone_idx < 0) {
+         continue;
+      }
 
-   if (skinning_data_.bone_mapping.find(node_name) != skinning_data_.bone_mapping.end()) {
-      unsigned bone_idx = skinning_data_.bone_mapping[node_name];
-      if (skinning_data_.bone_info[bone_idx].external == false) {
-         skinning_data_.bone_info[bone_idx].final_transform =
-            global_transform * skinning_data_.bone_info[bone_idx].bone_offset;
+      const SkinningData::BoneInfo& bone = skinning_data_.bone_info[bone_idx];
+      glm::mat4& transform = anim.bone_transforms_[bone_idx];
+      if (skipped[i] || bone.external) {
+         // Moved from outside.
+         transform = bone.final_transform;
+         continue;
       }
-      if (skinning_data_.bone_info[bone_idx].pinned == true) {
-         *skinning_data_.bone_info[bone_idx].global_transform_ptr = global_transform;
+      MultiplyTransforms(model_transforms[i], bone.bone_offset, &transform);
+      if (bone.pinned == true) {
+         *bone.global_transform_ptr = model_transforms[i];
          // A pinned bone has all external child
-         return;
+         skipped[i] = true;
       }
    }
-   for (unsigned i = 0; i < node->mNumChildren; i++) {
-      updateBoneTreeInTransition(
-         anim, prev_anim_time, next_anim_time, factor,
-         node->mChildren[i], global_transform
-      );
-   }
+   anim.bone_version_ = ++last_bone_version;
 }
 
 void AnimatedMeshRenderer::updateBoneInfo(Animation& anim,
-                                          float time) {
-   if (!anim.current_anim_.handle || anim.current_anim_.handle->mAnimations == 0
-      || !anim.last_anim_.handle || anim.last_anim_.handle->mAnimations == 0) {
+                                          float time) const {
+   ENGINE_PROFILE_SCOPE("bone update");
+   if (!anim.current_anim_.clip || !anim.last_anim_.clip) {
       throw std::runtime_error("Tried to run an invalid animation.");
    }
-   auto last_anim = anim.last_anim_.handle->mAnimations[anim.last_anim_.handle->mNumAnimations - 1];
-   auto current_anim = anim.current_anim_.handle->mAnimations[anim.current_anim_.handle->mNumAnimations - 1];
+   const AnimationClip* last_anim = anim.last_anim_.clip;
+   const AnimationClip* current_anim = anim.current_anim_.clip;
 
-   float last_ticks_per_second = last_anim->mTicksPerSecond > 1e-10 ? // != 0
-                                 last_anim->mTicksPerSecond : 24.0f;
+   float last_ticks_per_second = last_anim->ticks_per_second();
    float last_time_in_ticks = anim.anim_meta_info_.last_period_time * (anim.last_anim_.speed * last_ticks_per_second);
    float last_anim_time;
    if (anim.last_anim_.flags.test(AnimFlag::Repeat)) {
-      last_anim_time = fmod(last_time_in_ticks, (float)last_anim->mDuration);
+      last_anim_time = fmod(last_time_in_ticks, last_anim->duration());
    } else {
-      last_anim_time = std::min(last_time_in_ticks, (float)last_anim->mDuration);
+      last_anim_time = std::min(last_time_in_ticks, last_anim->duration());
    }
    if (anim.last_anim_.flags.test(AnimFlag::Backwards)) {
-      last_anim_time = (float)last_anim->mDuration - last_anim_time;
+      last_anim_time = last_anim->duration() - last_anim_time;
    }
 
-   float current_ticks_per_second = current_anim->mTicksPerSecond > 1e-10 ? // != 0
-                                    current_anim->mTicksPerSecond : 24.0f;
+   float current_ticks_per_second = current_anim->ticks_per_second();
    float current_time_in_ticks =
       (time - anim.anim_meta_info_.end_of_last_anim) * (anim.current_anim_.speed * current_ticks_per_second);
    float current_anim_time;
    if (anim.current_anim_.flags.test(AnimFlag::Repeat)) {
-      current_anim_time = fmod(current_time_in_ticks, (float)current_anim->mDuration);
+      current_anim_time = fmod(current_time_in_ticks, current_anim->duration());
    } else {
-      if (current_time_in_ticks < (float)current_anim->mDuration) {
+      if (current_time_in_ticks < current_anim->duration()) {
          current_anim_time = current_time_in_ticks;
       } else {
          anim.animationEnded(time);
@@ -280,7 +135,7 @@ void AnimatedMeshRenderer::updateBoneInfo(Animation& anim,
    }
 
    if (anim.current_anim_.flags.test(AnimFlag::Backwards)) {
-      current_anim_time = (float)current_anim->mDuration - current_anim_time;
+      current_anim_time = current_anim->duration() - current_anim_time;
    }
 
    bool in_transition =
@@ -288,19 +143,27 @@ void AnimatedMeshRenderer::updateBoneInfo(Animation& anim,
    float transition_factor =
       (time - anim.anim_meta_info_.end_of_last_anim) / anim.anim_meta_info_.transition_time;
 
+   size_t node_count = skinning_data_.skeleton.size();
+   anim.pose_.resize(node_count);
+   anim.transition_pose_.resize(node_count);
+   anim.model_transforms_.resize(node_count);
+   anim.skipped_nodes_.resize(node_count);
+   anim.bone_transforms_.resize(skinning_data_.num_bones);
+
    if (in_transition) {
       // Normal animation
-      updateBoneTree(anim, current_anim_time, scene_->mRootNode);
+      samplePose(anim, current_anim_time);
    } else {
       // Transition between two animations.
-      updateBoneTreeInTransition(anim, last_anim_time, current_anim_time,
-                                 transition_factor, scene_->mRootNode);
+      samplePoseInTransition(anim, last_anim_time, current_anim_time,
+                             transition_factor);
    }
+   updateSkinning(anim);
 
    // Start a new loop if necessary
    if (anim.current_anim_.flags.test(AnimFlag::Repeat)) {
       unsigned loop_count = current_time_in_ticks /
-                        (float)current_anim->mDuration;
+                        current_anim->duration();
       if (loop_count > anim.anim_meta_info_.last_loop_count) {
          if (anim.current_anim_.flags.test(AnimFlag::MirroredRepeat)) {
             anim.current_anim_.flags ^= AnimFlag::Mirrored;
@@ -322,21 +185,14 @@ void AnimatedMeshRenderer::updateBoneInfo(Animation& anim,
    }
 }
 
-/// Updates the bones transformations.
-/** @param time_in_seconds - Expected to be a time value in seconds. */
-void AnimatedMeshRenderer::uploadBoneInfo(
-                                    gl::LazyUniform<glm::mat4>& bones) {
-  for (unsigned i = 0; i < skinning_data_.num_bones; i++) {
-      bones[i] = skinning_data_.bone_info[i].final_transform;
-  }
+void AnimatedMeshRenderer::uploadBoneInfo(const Animation& anim) {
+  bone_palette_.update(anim.bone_transforms_, anim.bone_version_);
 }
 
-void AnimatedMeshRenderer::updateAndUploadBoneInfo(
-                                    Animation& anim,
-                                    float time,
-                                    gl::LazyUniform<glm::mat4>& bones) {
+void AnimatedMeshRenderer::updateAndUploadBoneInfo(Animation& anim,
+                                                   float time) {
   updateBoneInfo(anim, time);
-  uploadBoneInfo(bones);
+  uploadBoneInfo(anim);
 }
 
 } // namespace engine
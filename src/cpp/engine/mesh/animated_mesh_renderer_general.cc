@@ -1,14 +1,19 @@
 // Copyright (c) 2014, Tamas Csala
 
+#include <iostream>
+#include <memory>
+
 #include "animated_mesh_renderer.h"
 
 namespace engine {
 
 AnimatedMeshRenderer::AnimatedMeshRenderer(
                                   const std::string& filename,
-                                  gl::Bitfield<aiPostProcessSteps> flags)
+                                  gl::Bitfield<aiPostProcessSteps> flags,
+                                  BoneEncoding encoding)
   : MeshRenderer(filename, flags)
-  , skinning_data_(scene_->mNumMeshes) {
+  , skinning_data_(scene_->mNumMeshes)
+  , bone_palette_(encoding) {
 }
 
 void AnimatedMeshRenderer::addAnimation(const std::string& filename,
@@ -24,13 +29,29 @@ void AnimatedMeshRenderer::addAnimation(const std::string& filename,
   anims_.names[anim_name] = idx;
   anims_.data.push_back(AnimInfo());
   anims_[idx].name = anim_name;
-  anims_[idx].handle = anims_[idx].importer->ReadFile(filename, aiProcess_Debone);
-  if (!anims_[idx].handle) {
+  anims_[idx].filename = filename;
+  anims_[idx].flags = flags;
+  anims_[idx].speed = speed;
+
+  // The animations loaded from the same file share the clip.
+  for (size_t i = 0; i < idx; ++i) {
+    if (anims_[i].filename == filename) {
+      anims_[idx].clip = anims_[i].clip;
+      anims_[idx].start_offset = anims_[i].start_offset;
+      anims_[idx].end_offset = anims_[i].end_offset;
+      return;
+    }
+  }
+
+  // The imported scene is only needed until the animation is compressed.
+  Assimp::Importer importer;
+  const aiScene* scene = importer.ReadFile(filename, aiProcess_Debone);
+  if (!scene) {
     throw std::runtime_error("Error parsing " + filename
-                              + " : " + anims_[idx].importer->GetErrorString());
+                              + " : " + importer.GetErrorString());
   }
 
-  auto node = getRootBone(scene_->mRootNode, anims_[idx].handle);
+  auto node = getRootBone(scene_->mRootNode, scene);
   if (!node) {
     throw std::runtime_error(
       "Animation error: The mesh's skeleton, and the animated skeleton '"
@@ -44,8 +65,19 @@ void AnimatedMeshRenderer::addAnimation(const std::string& filename,
   v = node->mPositionKeys[node->mNumPositionKeys - 1].mValue;
   anims_[idx].end_offset =  glm::vec3(v.x, v.y, v.z);
 
-  anims_[idx].flags = flags;
-  anims_[idx].speed = speed;
+  const aiAnimation* animation = scene->mAnimations[scene->mNumAnimations - 1];
+  AnimationClip::Stats stats;
+  anims_[idx].clip = std::make_shared<AnimationClip>(
+      animation, bindChannels(animation), AnimationClip::kDefaultSampleRate,
+      &stats);
+  cpu_memory_.add(stats.compressed_size);
+
+  std::cout << " - Animation '" << anim_name << "': "
+            << stats.source_size / 1024 << " KB -> "
+            << stats.compressed_size / 1024 << " KB (max error: "
+            << stats.max_translation_error << " units, "
+            << stats.max_rotation_error << " radians, "
+            << stats.max_scale_error << " scale)" << std::endl;
 }
 
 } // namespace engine
@@ -3,7 +3,9 @@
 #include <vector>
 #include <limits>
 #include <string>
+#include <unordered_map>
 #include "./animated_mesh_renderer.h"
+#include "./keyframe_interpolation.h"
 
 namespace engine {
 
@@ -30,6 +32,44 @@ void AnimatedMeshRenderer::mapBones() {
   }
 }
 
+void AnimatedMeshRenderer::mapNodes(const aiNode* node, int parent) {
+  std::string name = node->mName.data;
+  auto bone = skinning_data_.bone_mapping.find(name);
+  int bone_idx = bone != skinning_data_.bone_mapping.end() ? bone->second : -1;
+  int idx = skinning_data_.skeleton.addNode(
+      name, parent, bone_idx, engine::convertMatrix(node->mTransformation));
+
+  for (size_t i = 0; i < node->mNumChildren; ++i) {
+    mapNodes(node->mChildren[i], idx);
+  }
+}
+
+std::vector<const aiNodeAnim*> AnimatedMeshRenderer::bindChannels(
+    const aiAnimation* animation) {
+  if (skinning_data_.skeleton.size() == 0) {
+    mapBones();
+    mapNodes(scene_->mRootNode);
+  }
+
+  std::unordered_map<std::string, const aiNodeAnim*> channels;
+  for (unsigned i = 0; i < animation->mNumChannels; ++i) {
+    const aiNodeAnim* channel = animation->mChannels[i];
+    channels.insert({channel->mNodeName.data, channel});
+  }
+
+  const Skeleton& skeleton = skinning_data_.skeleton;
+  std::vector<const aiNodeAnim*> result(skeleton.size());
+  for (size_t i = 0; i < skeleton.size(); ++i) {
+    const std::string& name = skeleton.names[i];
+    auto channel = channels.find(name);
+    result[i] = channel != channels.end() ? channel->second : nullptr;
+    if (name == skinning_data_.root_bone) {
+      skinning_data_.root_bone_node = i;
+    }
+  }
+  return result;
+}
+
 /**
  * @brief A recursive functions that should be started from the root node, and
  *        it returns the first bone under it.
@@ -146,6 +186,7 @@ void AnimatedMeshRenderer::loadBones() {
 
     // upload
     skinning_data_.vertex_bone_data_buffers[entry].data(buffer_size, data.get());
+    gpu_memory_.add(buffer_size);
   }
 
   // Unbind our things, so they won't be modified from outside
@@ -196,8 +237,10 @@ void AnimatedMeshRenderer::shaderPlumbBones(
   const size_t per_attrib_size =
       sizeof(SkinningData::VertexBoneData_PerAttribute<Index_t>);
 
-  for (size_t entry = 0; entry < entries_.size(); entry++) {
-    gl::Bind(entries_[entry].vao);
+  // Expects the entry's vao to be bound. It is kept, so that
+  // recreateVertexArrays can replay it.
+  auto plumb = [this, idx_t, boneIDs, bone_weights,
+                integerIDs](size_t entry) mutable {
     gl::Bind(skinning_data_.vertex_bone_data_buffers[entry]);
     unsigned char current_attrib_max = skinning_data_.per_mesh_attrib_max[entry];
 
@@ -233,7 +276,13 @@ void AnimatedMeshRenderer::shaderPlumbBones(
       }
       bone_weights[i].static_setup(glm::vec4(0, 0, 0, 0));
     }
+  };
+
+  for (size_t entry = 0; entry < entries_.size(); entry++) {
+    gl::Bind(entries_[entry].vao);
+    plumb(entry);
   }
+  vao_setups_.push_back(plumb);
 
   // Unbind our things, so they won't be modified from outside
   gl::Unbind(gl::kArrayBuffer);
@@ -320,6 +369,15 @@ ExternalBoneTree AnimatedMeshRenderer::markBoneExternal(
   return ebone_tree;
 }
 
+bool AnimatedMeshRenderer::hasPinnedBones() const {
+  for (const SkinningData::BoneInfo& bone : skinning_data_.bone_info) {
+    if (bone.pinned) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /// Returns the number of bones this scene has.
 /** May change the currently active VAO and ArrayBuffer at the first call. */
 size_t AnimatedMeshRenderer::getNumBones() {
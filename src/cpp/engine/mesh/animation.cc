@@ -28,12 +28,12 @@ void Animation::changeAnimation(size_t anim_idx,
                                 float transition_time,
                                 gl::Bitfield<AnimFlag> flags,
                                 float speed) {
-  bool was_last_invalid = (last_anim_.handle == nullptr);
+  bool was_last_invalid = (last_anim_.clip == nullptr);
 
   last_anim_ = current_anim_;
 
   current_anim_.idx = anim_idx;
-  current_anim_.handle = anims_[anim_idx].handle;
+  current_anim_.clip = anims_[anim_idx].clip.get();
   current_anim_name_ = anims_[anim_idx].name;
 
   if (flags.test(AnimFlag::Backwards)) {
@@ -77,7 +77,7 @@ void Animation::setCurrentAnimation(AnimParams new_anim,
       );
     }
     size_t anim_idx = anims_.names.at(new_anim.name);
-    if (current_anim_.handle != anims_[anim_idx].handle) {
+    if (!current_anim_.clip || current_anim_.idx != anim_idx) {
       forceCurrentAnimation(new_anim, current_time);
     }
   }
@@ -112,7 +112,8 @@ void Animation::forceCurrentAnimation(AnimParams new_anim,
 
 void Animation::setAnimToDefault(float current_time) {
   if (current_anim_.flags.test(AnimFlag::Interruptable) &&
-     current_anim_.handle != anims_[anim_meta_info_.default_idx].handle) {
+     (!current_anim_.clip ||
+      current_anim_.idx != anim_meta_info_.default_idx)) {
     forceAnimToDefault(current_time);
   }
 }
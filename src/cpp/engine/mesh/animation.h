@@ -3,11 +3,17 @@
 #ifndef ENGINE_MESH_ANIMATATION_H_
 #define ENGINE_MESH_ANIMATATION_H_
 
+#include <vector>
+
 #include "anim_info.h"
 #include "animated_mesh_renderer.h"
+#include "skeleton.h"
 
 namespace engine {
 
+/// The per-instance state of an animated mesh: the playing animations, and
+/// the pose buffers. Any number of instances can share an
+/// AnimatedMeshRenderer, and they can be updated on different threads.
 class Animation {
   /// Reference to the animation resources held by the AnimatedMeshRenderer.
   const AnimData& anims_;
@@ -24,6 +30,26 @@ class Animation {
   /// The last animation.
   AnimationState last_anim_;
 
+  /// The local transformations of the skeleton's nodes, in the current frame.
+  LocalPose pose_;
+
+  /// The pose of the last animation during a transition.
+  LocalPose transition_pose_;
+
+  /// The model space transformations of the skeleton's nodes.
+  std::vector<glm::mat4> model_transforms_;
+
+  /// Marks the nodes that are under a pinned bone, for the current frame.
+  std::vector<unsigned char> skipped_nodes_;
+
+  /// The final transformations of the bones, indexed like
+  /// SkinningData::bone_info.
+  std::vector<glm::mat4> bone_transforms_;
+
+  /// Identifies the pose in bone_transforms_. Every update gets a new,
+  /// globally unique version, 0 means that the pose was never updated.
+  unsigned bone_version_ = 0;
+
   friend class AnimatedMeshRenderer;
 
 public:
@@ -31,8 +57,18 @@ public:
   Animation(const AnimData& anim_data)
     : anims_(anim_data) {}
 
+  /// Returns the final transformations of the bones, that the last
+  /// AnimatedMeshRenderer::updateBoneInfo() call computed.
+  const std::vector<glm::mat4>& getBoneTransforms() const {
+    return bone_transforms_;
+  }
+
+  /// Returns the version of the bones' transformations, it changes with
+  /// every update.
+  unsigned getBoneVersion() const { return bone_version_; }
+
   /// Returns the currently running animation's name.
-  std::string getCurrentAnimation() const {
+  const std::string& getCurrentAnimation() const {
     return current_anim_name_;
   }
 
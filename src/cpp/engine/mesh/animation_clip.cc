@@ -0,0 +1,296 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "./animation_clip.h"
+#include "./keyframe_interpolation.h"
+
+namespace engine {
+
+constexpr float AnimationClip::kDefaultSampleRate;
+
+namespace {
+
+/// The range of the three smallest components of a unit quaternion.
+const float kSmallestThreeRange = 1.0f / std::sqrt(2.0f);
+const float kMax15Bit = 32767.0f;
+
+struct Range {
+  glm::vec3 min, step;
+};
+
+Range QuantizationRange(const std::vector<glm::vec3>& samples) {
+  glm::vec3 min = samples[0], max = samples[0];
+  for (const glm::vec3& sample : samples) {
+    min = glm::min(min, sample);
+    max = glm::max(max, sample);
+  }
+  return Range{min, (max - min) / 65535.0f};
+}
+
+bool IsConstant(const std::vector<glm::vec3>& samples) {
+  for (const glm::vec3& sample : samples) {
+    glm::vec3 diff = glm::abs(sample - samples[0]);
+    if (std::max(std::max(diff.x, diff.y), diff.z) > 1e-5f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsConstant(const std::vector<glm::quat>& samples) {
+  for (const glm::quat& sample : samples) {
+    if (std::abs(glm::dot(sample, samples[0])) < 1 - 1e-7f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void EncodeVector(const glm::vec3& v, const Range& range, uint16_t* out) {
+  for (int i = 0; i < 3; ++i) {
+    out[i] = range.step[i] > 0
+        ? uint16_t(std::round((v[i] - range.min[i]) / range.step[i])) : 0;
+  }
+}
+
+glm::vec3 DecodeVector(const uint16_t* in, const glm::vec3& min,
+                       const glm::vec3& step) {
+  return min + glm::vec3(in[0], in[1], in[2]) * step;
+}
+
+/// Stores the three smallest components of the quaternion on 15 bits each,
+/// and the index of the largest one in the top bits of the first two values.
+void EncodeRotation(glm::quat q, uint16_t* out) {
+  q = glm::normalize(q);
+  float c[4] = {q.x, q.y, q.z, q.w};
+  int largest = 0;
+  for (int i = 1; i < 4; ++i) {
+    if (std::abs(c[i]) > std::abs(c[largest])) {
+      largest = i;
+    }
+  }
+  // q and -q are the same rotation, the largest component is made positive,
+  // so that its sign doesn't have to be stored.
+  float sign = c[largest] < 0 ? -1.0f : 1.0f;
+  for (int i = 0, j = 0; i < 4; ++i) {
+    if (i != largest) {
+      float normalized = (sign * c[i] / kSmallestThreeRange + 1) / 2;
+      out[j++] = uint16_t(std::round(glm::clamp(normalized, 0.0f, 1.0f) *
+                                     kMax15Bit));
+    }
+  }
+  out[0] |= (largest & 1) << 15;
+  out[1] |= (largest >> 1) << 15;
+}
+
+glm::quat DecodeRotation(const uint16_t* in) {
+  int largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+  float c[4];
+  float sum = 0;
+  for (int i = 0, j = 0; i < 4; ++i) {
+    if (i != largest) {
+      c[i] = ((in[j++] & 0x7FFF) / kMax15Bit * 2 - 1) * kSmallestThreeRange;
+      sum += c[i] * c[i];
+    }
+  }
+  c[largest] = std::sqrt(std::max(0.0f, 1 - sum));
+  return glm::quat(c[3], c[0], c[1], c[2]);
+}
+
+/// Normalized linear interpolation, that chooses the shorter path.
+glm::quat Nlerp(const glm::quat& a, glm::quat b, float factor) {
+  if (glm::dot(a, b) < 0) {
+    b = -b;
+  }
+  return glm::normalize(a * (1 - factor) + b * factor);
+}
+
+glm::vec3 Convert(const aiVector3D& v) {
+  return glm::vec3(v.x, v.y, v.z);
+}
+
+glm::quat Convert(const aiQuaternion& q) {
+  return glm::quat(q.w, q.x, q.y, q.z);
+}
+
+}  // namespace
+
+AnimationClip::AnimationClip(const aiAnimation* animation,
+                             const std::vector<const aiNodeAnim*>& channels,
+                             float sample_rate,
+                             Stats* stats)
+    : tracks_(channels.size()), frame_size_(0)
+    , duration_(animation->mDuration)
+    , ticks_per_second_(animation->mTicksPerSecond > 1e-10 ?  // != 0
+                        animation->mTicksPerSecond : 24.0f) {
+  if (sample_rate <= 0) {
+    throw std::invalid_argument("AnimationClip: invalid sample rate.");
+  }
+  float ticks_per_frame = ticks_per_second_ / sample_rate;
+  frame_count_ = std::max(2, int(std::ceil(duration_ / ticks_per_frame)) + 1);
+  frame_time_ = duration_ > 0 ? duration_ / (frame_count_ - 1) : 1.0f;
+
+  // Resample the channels, and decide which parts of them are constant.
+  std::vector<std::vector<glm::vec3>> translations(channels.size());
+  std::vector<std::vector<glm::quat>> rotations(channels.size());
+  std::vector<std::vector<glm::vec3>> scales(channels.size());
+  std::vector<Range> translation_ranges(channels.size());
+  std::vector<Range> scale_ranges(channels.size());
+  for (size_t node = 0; node < channels.size(); ++node) {
+    const aiNodeAnim* channel = channels[node];
+    Track& track = tracks_[node];
+    track.animated = channel != nullptr;
+    track.translation = track.rotation = track.scale = -1;
+    if (!channel) {
+      continue;
+    }
+
+    KeyframeCursor cursor;
+    for (size_t frame = 0; frame < frame_count_; ++frame) {
+      float time = std::min(frame * frame_time_, duration_);
+      aiVector3D translation, scale;
+      aiQuaternion rotation;
+      calcInterpolatedPosition(translation, time, channel, &cursor.position);
+      calcInterpolatedRotation(rotation, time, channel, &cursor.rotation);
+      calcInterpolatedScaling(scale, time, channel, &cursor.scaling);
+      translations[node].push_back(Convert(translation));
+      rotations[node].push_back(Convert(rotation));
+      scales[node].push_back(Convert(scale));
+    }
+
+    track.translation_min = translations[node][0];
+    if (!IsConstant(translations[node])) {
+      translation_ranges[node] = QuantizationRange(translations[node]);
+      track.translation_min = translation_ranges[node].min;
+      track.translation_step = translation_ranges[node].step;
+      track.translation = frame_size_;
+      frame_size_ += 3;
+    }
+    track.rotation_value = glm::normalize(rotations[node][0]);
+    if (!IsConstant(rotations[node])) {
+      track.rotation = frame_size_;
+      frame_size_ += 3;
+    }
+    track.scale_min = scales[node][0];
+    if (!IsConstant(scales[node])) {
+      scale_ranges[node] = QuantizationRange(scales[node]);
+      track.scale_min = scale_ranges[node].min;
+      track.scale_step = scale_ranges[node].step;
+      track.scale = frame_size_;
+      frame_size_ += 3;
+    }
+  }
+
+  // Quantize the animated parts.
+  frames_.resize(frame_count_ * frame_size_);
+  for (size_t frame = 0; frame < frame_count_; ++frame) {
+    uint16_t* data = frames_.data() + frame * frame_size_;
+    for (size_t node = 0; node < tracks_.size(); ++node) {
+      const Track& track = tracks_[node];
+      if (track.translation >= 0) {
+        EncodeVector(translations[node][frame], translation_ranges[node],
+                     data + track.translation);
+      }
+      if (track.rotation >= 0) {
+        EncodeRotation(rotations[node][frame], data + track.rotation);
+      }
+      if (track.scale >= 0) {
+        EncodeVector(scales[node][frame], scale_ranges[node],
+                     data + track.scale);
+      }
+    }
+  }
+
+  if (stats) {
+    *stats = Stats{};
+    for (unsigned i = 0; i < animation->mNumChannels; ++i) {
+      const aiNodeAnim* channel = animation->mChannels[i];
+      stats->source_size += sizeof(aiNodeAnim) +
+          channel->mNumPositionKeys * sizeof(aiVectorKey) +
+          channel->mNumRotationKeys * sizeof(aiQuatKey) +
+          channel->mNumScalingKeys * sizeof(aiVectorKey);
+    }
+    stats->compressed_size = size();
+    measureErrors(channels, stats);
+  }
+}
+
+size_t AnimationClip::size() const {
+  return sizeof(*this) + tracks_.size() * sizeof(Track) +
+         frames_.size() * sizeof(uint16_t);
+}
+
+void AnimationClip::decodeTrack(const Track& track, const uint16_t* frame,
+                                glm::vec3* translation, glm::quat* rotation,
+                                glm::vec3* scale) const {
+  *translation = track.translation < 0 ? track.translation_min
+      : DecodeVector(frame + track.translation, track.translation_min,
+                     track.translation_step);
+  *rotation = track.rotation < 0 ? track.rotation_value
+      : DecodeRotation(frame + track.rotation);
+  *scale = track.scale < 0 ? track.scale_min
+      : DecodeVector(frame + track.scale, track.scale_min, track.scale_step);
+}
+
+void AnimationClip::samplePose(float anim_time, LocalPose* pose) const {
+  float position = glm::clamp(anim_time, 0.0f, duration_) / frame_time_;
+  size_t frame = std::min(size_t(position), frame_count_ - 2);
+  float factor = glm::clamp(position - frame, 0.0f, 1.0f);
+  const uint16_t* prev_frame = frames_.data() + frame * frame_size_;
+  const uint16_t* next_frame = prev_frame + frame_size_;
+
+  for (size_t node = 0; node < tracks_.size(); ++node) {
+    const Track& track = tracks_[node];
+    pose->animated[node] = track.animated;
+    if (!track.animated) {
+      continue;
+    }
+    glm::vec3 prev_translation, next_translation, prev_scale, next_scale;
+    glm::quat prev_rotation, next_rotation;
+    decodeTrack(track, prev_frame, &prev_translation, &prev_rotation,
+                &prev_scale);
+    decodeTrack(track, next_frame, &next_translation, &next_rotation,
+                &next_scale);
+    pose->translations[node] =
+        glm::mix(prev_translation, next_translation, factor);
+    pose->rotations[node] = Nlerp(prev_rotation, next_rotation, factor);
+    pose->scales[node] = glm::mix(prev_scale, next_scale, factor);
+  }
+}
+
+void AnimationClip::measureErrors(
+    const std::vector<const aiNodeAnim*>& channels, Stats* stats) const {
+  // Compares the clip with the imported keys at four times the sample rate.
+  LocalPose pose;
+  pose.resize(tracks_.size());
+  size_t sample_count = 4 * (frame_count_ - 1) + 1;
+  for (size_t i = 0; i < sample_count; ++i) {
+    float time = duration_ * i / (sample_count - 1);
+    samplePose(time, &pose);
+    for (size_t node = 0; node < channels.size(); ++node) {
+      const aiNodeAnim* channel = channels[node];
+      if (!channel) {
+        continue;
+      }
+      aiVector3D translation, scale;
+      aiQuaternion rotation;
+      calcInterpolatedPosition(translation, time, channel);
+      calcInterpolatedRotation(rotation, time, channel);
+      calcInterpolatedScaling(scale, time, channel);
+
+      stats->max_translation_error = std::max(stats->max_translation_error,
+          glm::length(pose.translations[node] - Convert(translation)));
+      float cos_half_angle = std::abs(glm::dot(pose.rotations[node],
+                                               Convert(rotation)));
+      stats->max_rotation_error = std::max(stats->max_rotation_error,
+          2 * std::acos(std::min(cos_half_angle, 1.0f)));
+      stats->max_scale_error = std::max(stats->max_scale_error,
+          glm::length(pose.scales[node] - Convert(scale)));
+    }
+  }
+}
+
+}  // namespace engine
@@ -0,0 +1,122 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MESH_ANIMATION_CLIP_H_
+#define ENGINE_MESH_ANIMATION_CLIP_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "../assimp.h"
+#include "./skeleton.h"
+
+namespace engine {
+
+/**
+ * @brief A skeletal animation, resampled to a fixed rate, and quantized.
+ *
+ * The samples of every frame are stored next to each other, so sampling a
+ * pose only reads two short, consecutive blocks of memory. The translations
+ * and the scalings are stored on 16 bits per component, relative to the
+ * per-track ranges, the rotations are stored with the smallest three
+ * quaternion components on 15 bits each. The tracks that don't change are
+ * stored only once, with full precision.
+ */
+class AnimationClip {
+ public:
+  /// The default number of samples per second.
+  static constexpr float kDefaultSampleRate = 30.0f;
+
+  /// The sizes, and the maximal errors of the compression.
+  struct Stats {
+    /// The size of the imported keys (of every channel) in bytes.
+    size_t source_size;
+
+    /// The size of the compressed clip in bytes.
+    size_t compressed_size;
+
+    float max_translation_error;
+    /// The maximal angle between the original and the decoded rotation.
+    float max_rotation_error;
+    float max_scale_error;
+
+    Stats()
+        : source_size(0), compressed_size(0), max_translation_error(0)
+        , max_rotation_error(0), max_scale_error(0) {}
+  };
+
+  /**
+   * @brief Resamples, and quantizes the bound channels of an animation.
+   *
+   * @param animation    The imported animation.
+   * @param channels     The channel of every node of the skeleton, or
+   *                     nullptr for the nodes that the animation doesn't move.
+   * @param sample_rate  The number of samples per second.
+   * @param stats        If not nullptr, returns the sizes, and the errors
+   *                     measured against the imported keys here.
+   */
+  AnimationClip(const aiAnimation* animation,
+                const std::vector<const aiNodeAnim*>& channels,
+                float sample_rate = kDefaultSampleRate,
+                Stats* stats = nullptr);
+
+  /// The length of the animation in ticks.
+  float duration() const { return duration_; }
+
+  float ticks_per_second() const { return ticks_per_second_; }
+
+  /// The memory used by the clip in bytes.
+  size_t size() const;
+
+  /// Returns if the clip moves the node.
+  bool animates(size_t node) const { return tracks_[node].animated; }
+
+  /**
+   * @brief Decodes the local transformations of the nodes at the given time.
+   *
+   * The nodes that the clip doesn't move are marked as not animated.
+   *
+   * @param anim_time   The time in ticks.
+   * @param pose        Returns the pose here. It must have the size of the
+   *                    skeleton.
+   */
+  void samplePose(float anim_time, LocalPose* pose) const;
+
+ private:
+  /// The data of a node. The offsets are in the frames (in 16-bit units),
+  /// or -1 if that part of the transformation is constant.
+  struct Track {
+    bool animated;
+    int translation, rotation, scale;
+
+    /// The constant value, or the minimum and the quantization step.
+    glm::vec3 translation_min, translation_step;
+    glm::vec3 scale_min, scale_step;
+    glm::quat rotation_value;
+  };
+
+  std::vector<Track> tracks_;
+
+  /// The quantized samples, frame after frame.
+  std::vector<uint16_t> frames_;
+
+  /// The number of 16-bit values per frame.
+  size_t frame_size_;
+
+  size_t frame_count_;
+
+  /// The time between two frames, in ticks.
+  float frame_time_;
+
+  float duration_, ticks_per_second_;
+
+  void decodeTrack(const Track& track, const uint16_t* frame,
+                   glm::vec3* translation, glm::quat* rotation,
+                   glm::vec3* scale) const;
+
+  void measureErrors(const std::vector<const aiNodeAnim*>& channels,
+                     Stats* stats) const;
+};
+
+}  // namespace engine
+
+#endif  // ENGINE_MESH_ANIMATION_CLIP_H_
@@ -0,0 +1,48 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./bone_encoding.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+namespace engine {
+
+size_t BoneEncodingSize(BoneEncoding encoding) {
+  switch (encoding) {
+    case BoneEncoding::kMat4: return 4;
+    case BoneEncoding::kMat3x4: return 3;
+    case BoneEncoding::kDualQuaternion: return 2;
+  }
+  return 4;
+}
+
+void EncodeBone(BoneEncoding encoding, const glm::mat4& transform,
+                glm::vec4* out) {
+  switch (encoding) {
+    case BoneEncoding::kMat4: {
+      for (int i = 0; i < 4; ++i) {
+        out[i] = transform[i];
+      }
+    } break;
+    case BoneEncoding::kMat3x4: {
+      glm::mat4 rows = glm::transpose(transform);
+      for (int i = 0; i < 3; ++i) {
+        out[i] = rows[i];
+      }
+    } break;
+    case BoneEncoding::kDualQuaternion: {
+      // The scaling is removed from the columns, before the rotation is
+      // extracted from them.
+      glm::mat3 rotation{glm::normalize(glm::vec3(transform[0])),
+                         glm::normalize(glm::vec3(transform[1])),
+                         glm::normalize(glm::vec3(transform[2]))};
+      glm::quat real = glm::normalize(glm::quat_cast(rotation));
+      glm::vec3 t = glm::vec3(transform[3]);
+      // dual = 0.5 * (t, 0) * real
+      glm::quat dual = 0.5f * (glm::quat(0, t.x, t.y, t.z) * real);
+      out[0] = glm::vec4(real.x, real.y, real.z, real.w);
+      out[1] = glm::vec4(dual.x, dual.y, dual.z, dual.w);
+    } break;
+  }
+}
+
+}  // namespace engine
@@ -0,0 +1,50 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MESH_BONE_ENCODING_H_
+#define ENGINE_MESH_BONE_ENCODING_H_
+
+#include <cstddef>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+namespace engine {
+
+/**
+ * @brief The ways, the bones' transformations can be stored in a bone palette.
+ *
+ * The values are the ones, that the skinning shaders expect in their
+ * BONE_ENCODING macro.
+ */
+enum class BoneEncoding {
+  /// Four vec4s per bone: the columns of the matrix.
+  kMat4 = 0,
+
+  /// Three vec4s per bone: the first three rows of the matrix. Exact for
+  /// every affine transformation.
+  kMat3x4 = 1,
+
+  /// Two vec4s per bone: a unit dual quaternion (the real part, then the
+  /// dual part). Blends without the candy-wrapper artifacts of the linear
+  /// blend skinning, but it can only represent rotations and translations,
+  /// the scaling of the bones is lost.
+  kDualQuaternion = 2
+};
+
+/// The number of vec4s, that a bone takes in the given encoding.
+size_t BoneEncodingSize(BoneEncoding encoding);
+
+/**
+ * @brief Encodes a bone's transformation.
+ *
+ * @param encoding    The encoding to use.
+ * @param transform   The bone's final transformation.
+ * @param out         Returns the encoded bone here. It must have space for
+ *                    BoneEncodingSize(encoding) vec4s.
+ */
+void EncodeBone(BoneEncoding encoding, const glm::mat4& transform,
+                glm::vec4* out);
+
+}  // namespace engine
+
+#endif  // ENGINE_MESH_BONE_ENCODING_H_
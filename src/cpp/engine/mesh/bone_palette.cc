@@ -0,0 +1,33 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./bone_palette.h"
+#include "../../oglwrap/smart_enums.h"
+
+namespace engine {
+
+constexpr GLuint BonePalette::kBindingPoint;
+
+void BonePalette::update(const std::vector<glm::mat4>& bones,
+                         unsigned version) {
+  if (version != version_ || data_.empty()) {
+    size_t bone_size = BoneEncodingSize(encoding_);
+    bool resized = data_.size() != bones.size() * bone_size;
+    data_.resize(bones.size() * bone_size);
+    for (size_t i = 0; i < bones.size(); ++i) {
+      EncodeBone(encoding_, bones[i], &data_[i * bone_size]);
+    }
+
+    gl::Bind(buffer_);
+    if (resized) {
+      buffer_.data(data_.size() * sizeof(glm::vec4), data_.data(),
+                   gl::kDynamicDraw);
+    } else {
+      buffer_.subData(0, data_.size() * sizeof(glm::vec4), data_.data());
+    }
+    gl::Unbind(buffer_);
+    version_ = version;
+  }
+  buffer_.bindBase(kBindingPoint);
+}
+
+}  // namespace engine
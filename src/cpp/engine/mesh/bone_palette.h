@@ -0,0 +1,51 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MESH_BONE_PALETTE_H_
+#define ENGINE_MESH_BONE_PALETTE_H_
+
+#include <vector>
+
+#include "../oglwrap_config.h"
+#include "../../oglwrap/buffer.h"
+
+#include "./bone_encoding.h"
+
+namespace engine {
+
+/**
+ * @brief The transformations of a skeleton's bones in a uniform buffer.
+ *
+ * It is written at most once per frame, and every pass, that draws the mesh,
+ * only binds it. The shaders read it through the EngineBonePalette block,
+ * as a vec4 array, BoneEncodingSize(encoding()) elements per bone.
+ */
+class BonePalette {
+ public:
+  static constexpr GLuint kBindingPoint = 1;
+
+  explicit BonePalette(BoneEncoding encoding = BoneEncoding::kMat3x4)
+      : encoding_(encoding), version_(0) {}
+
+  BoneEncoding encoding() const { return encoding_; }
+
+  /**
+   * @brief Encodes, and uploads the bones' transformations, if they aren't
+   *        the ones uploaded last time, then binds the buffer to
+   *        kBindingPoint.
+   *
+   * @param bones     The final transformations of the bones.
+   * @param version   Identifies the pose (see Animation::getBoneVersion()).
+   */
+  void update(const std::vector<glm::mat4>& bones, unsigned version);
+
+ private:
+  BoneEncoding encoding_;
+  /// The version of the uploaded pose.
+  unsigned version_;
+  std::vector<glm::vec4> data_;
+  gl::UniformBuffer buffer_;
+};
+
+}  // namespace engine
+
+#endif  // ENGINE_MESH_BONE_PALETTE_H_
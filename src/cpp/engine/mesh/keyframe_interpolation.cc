@@ -0,0 +1,150 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include <algorithm>
+#include <cmath>
+#include "./keyframe_interpolation.h"
+
+namespace engine {
+
+namespace {
+
+/// Returns if the anim_time is between the key's and the next key's time
+/// (the first key with a time not smaller than anim_time is the next one).
+template <typename Key>
+bool isActiveKey(unsigned i, float anim_time, const Key* keys,
+                 unsigned num_keys) {
+   return (i == 0 || (float)keys[i].mTime < anim_time) &&
+          (i == num_keys - 2 || anim_time <= (float)keys[i + 1].mTime);
+}
+
+/**
+ * @brief Returns the index of the active key, that is the last key, whose
+ *        next key's time is not smaller than anim_time (but at most the
+ *        second to last key).
+ *
+ * It tries the cached index, and the one after it first (that's what a
+ * forward playing animation needs), then the index that the time would have,
+ * if the keys were evenly spaced (which they usually are), and does a binary
+ * search only if none of these work.
+ */
+template <typename Key>
+unsigned findKey(float anim_time, const Key* keys, unsigned num_keys,
+                 unsigned* cursor) {
+   unsigned last = num_keys - 2;
+   if (cursor && *cursor <= last) {
+      if (isActiveKey(*cursor, anim_time, keys, num_keys)) {
+         return *cursor;
+      }
+      if (*cursor < last &&
+          isActiveKey(*cursor + 1, anim_time, keys, num_keys)) {
+         return ++*cursor;
+      }
+   }
+
+   unsigned result;
+   float first = keys[0].mTime, length = keys[num_keys - 1].mTime - first;
+   float guess = length > 0
+      ? std::ceil((anim_time - first) * (last + 1) / length) - 1 : 0;
+   if (0 <= guess && guess <= last &&
+       isActiveKey(unsigned(guess), anim_time, keys, num_keys)) {
+      result = guess;
+   } else {
+      auto next = std::lower_bound(
+         keys + 1, keys + num_keys - 1, anim_time,
+         [](const Key& key, float time) { return (float)key.mTime < time; });
+      result = next - keys - 1;
+   }
+
+   if (cursor) {
+      *cursor = result;
+   }
+   return result;
+}
+
+}  // namespace
+
+unsigned findPosition(float anim_time, const aiNodeAnim* node_anim,
+                      unsigned* cursor) {
+   return findKey(anim_time, node_anim->mPositionKeys,
+                  node_anim->mNumPositionKeys, cursor);
+}
+
+unsigned findRotation(float anim_time, const aiNodeAnim* node_anim,
+                      unsigned* cursor) {
+   return findKey(anim_time, node_anim->mRotationKeys,
+                  node_anim->mNumRotationKeys, cursor);
+}
+
+unsigned findScaling(float anim_time, const aiNodeAnim* node_anim,
+                     unsigned* cursor) {
+   return findKey(anim_time, node_anim->mScalingKeys,
+                  node_anim->mNumScalingKeys, cursor);
+}
+
+void calcInterpolatedPosition(aiVector3D& out, float anim_time,
+                              const aiNodeAnim* node_anim, unsigned* cursor) {
+   const auto& keys = node_anim->mPositionKeys;
+   const auto& numKeys = node_anim->mNumPositionKeys;
+   if (numKeys == 1) {
+      out = keys[0].mValue;
+      return;
+   }
+   size_t i = findPosition(anim_time, node_anim, cursor);
+   float deltaTime = keys[i + 1].mTime - keys[i].mTime;
+   float factor = (anim_time - (float)keys[i].mTime) / deltaTime;
+   factor = glm::clamp(factor, 0.0f, 1.0f);
+
+   const aiVector3D& start = keys[i].mValue;
+   const aiVector3D& end   = keys[i + 1].mValue;
+   out = mix(start, end, factor);
+}
+
+void calcInterpolatedRotation(aiQuaternion& out, float anim_time,
+                              const aiNodeAnim* node_anim, unsigned* cursor) {
+   const auto& keys = node_anim->mRotationKeys;
+   const auto& numKeys = node_anim->mNumRotationKeys;
+   if (numKeys == 1) {
+      out = keys[0].mValue;
+      return;
+   }
+   size_t i = findRotation(anim_time, node_anim, cursor);
+   float deltaTime = keys[i + 1].mTime - keys[i].mTime;
+   float factor = (anim_time - (float)keys[i].mTime) / deltaTime;
+   factor = glm::clamp(factor, 0.0f, 1.0f);
+
+   const aiQuaternion& start = keys[i].mValue;
+   const aiQuaternion& end   = keys[i + 1].mValue;
+   aiQuaternion::Interpolate(out, start, end, factor);
+   out = out.Normalize();
+}
+
+void calcInterpolatedScaling(aiVector3D& out, float anim_time,
+                             const aiNodeAnim* node_anim, unsigned* cursor) {
+   const auto& keys = node_anim->mScalingKeys;
+   const auto& numKeys = node_anim->mNumScalingKeys;
+   if (numKeys == 1) {
+      out = keys[0].mValue;
+      return;
+   }
+   size_t i = findScaling(anim_time, node_anim, cursor);
+   float deltaTime = keys[i + 1].mTime - keys[i].mTime;
+   float factor = (anim_time - (float)keys[i].mTime) / deltaTime;
+   factor = glm::clamp(factor, 0.0f, 1.0f);
+
+   const aiVector3D& start = keys[i].mValue;
+   const aiVector3D& end   = keys[i + 1].mValue;
+   out = mix(start, end, factor);
+}
+
+const aiNodeAnim* findNodeAnim(const aiAnimation* animation,
+                               const std::string node_name) {
+   for (unsigned i = 0; i < animation->mNumChannels; i++) {
+      const aiNodeAnim* node_anim = animation->mChannels[i];
+      if (std::string(node_anim->mNodeName.data) == node_name) {
+         return node_anim;
+      }
+   }
+   return nullptr;
+}
+
+}  // namespace engine
@@ -0,0 +1,123 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MESH_KEYFRAME_INTERPOLATION_H_
+#define ENGINE_MESH_KEYFRAME_INTERPOLATION_H_
+
+#include <string>
+#include "../assimp.h"
+
+// The keyframe sampling of the skeletal animations. These only read the
+// assimp animation data, so they don't need a mesh, or an OpenGL context.
+
+namespace engine {
+
+/// The indices of the last used keys of a channel, so that the next sampling
+/// (which is usually at the same, or the next key) doesn't have to search.
+struct KeyframeCursor {
+  unsigned position, rotation, scaling;
+
+  KeyframeCursor() : position(0), rotation(0), scaling(0) {}
+};
+
+template <typename T, typename U>
+T mix(const T& x, const T& y, const U& a) {
+  return x*(1-a) + y*a;
+}
+
+/**
+ * @brief Returns the index of the currently active translation keyframe for
+ *        the given animation and time.
+ *
+ * @param anim_time   The time elapsed since the start of this animation.
+ * @param node_anim   The animation node, in which the function should search
+ *                    for a keyframe.
+ * @param cursor      The index returned by the previous call for this channel
+ *                    (updated to the new index), or nullptr.
+ */
+unsigned findPosition(float anim_time, const aiNodeAnim* node_anim,
+                      unsigned* cursor = nullptr);
+
+/**
+ * @brief Returns the index of the currently active rotation keyframe for
+ *        the given animation and time.
+ *
+ * @param anim_time   The time elapsed since the start of this animation.
+ * @param node_anim   The animation node, in which the function should search
+ *                    for a keyframe.
+ * @param cursor      The index returned by the previous call for this channel
+ *                    (updated to the new index), or nullptr.
+ */
+unsigned findRotation(float anim_time, const aiNodeAnim* node_anim,
+                      unsigned* cursor = nullptr);
+
+/**
+ * @brief Returns the index of the currently active scaling keyframe for
+ *        the given animation and time.
+ *
+ * @param anim_time   The time elapsed since the start of this animation.
+ * @param node_anim   The animation node, in which the function should search
+ *                    for a keyframe.
+ * @param cursor      The index returned by the previous call for this channel
+ *                    (updated to the new index), or nullptr.
+ */
+unsigned findScaling(float anim_time, const aiNodeAnim* node_anim,
+                     unsigned* cursor = nullptr);
+
+/**
+ * @brief Returns a linearly interpolated value between the previous and next
+ *        translation keyframes.
+ *
+ * @param out         Returns the result here.
+ * @param anim_time   The time elapsed since the start of this animation.
+ * @param node_anim   The animation node, in which the function should search
+ *                    for the keyframes.
+ * @param cursor      The cached key index for this channel, or nullptr.
+ */
+void calcInterpolatedPosition(aiVector3D& out, float anim_time,
+                              const aiNodeAnim* node_anim,
+                              unsigned* cursor = nullptr);
+
+/**
+ * @brief Returns a spherically interpolated value (always choosing the shorter
+ * path) between the previous and next rotation keyframes.
+ *
+ * @param out         Returns the result here.
+ * @param anim_time   The time elapsed since the start of this animation.
+ * @param node_anim   The animation node, in which the function should search
+ *                    for the keyframes.
+ * @param cursor      The cached key index for this channel, or nullptr.
+ */
+void calcInterpolatedRotation(aiQuaternion& out, float anim_time,
+                              const aiNodeAnim* node_anim,
+                              unsigned* cursor = nullptr);
+
+/**
+ * @brief Returns a linearly interpolated value between the previous and next
+ *        scaling keyframes.
+ *
+ * @param out         Returns the result here.
+ * @param anim_time   The time elapsed since the start of this animation.
+ * @param node_anim   The animation node, in which the function should search
+ *                    for the keyframes.
+ * @param cursor      The cached key index for this channel, or nullptr.
+ */
+void calcInterpolatedScaling(aiVector3D& out, float anim_time,
+                             const aiNodeAnim* node_anim,
+                             unsigned* cursor = nullptr);
+
+/**
+ * @brief Returns the animation node in the given animation, referenced by
+ *        its name.
+ *
+ * Returns nullptr if it doesn't find a node with that name,
+ * which usually means that it's not a bone.
+ *
+ * @param animation - The animation, this function should search in.
+ * @param node_name - The name of the bone to search.
+ */
+const aiNodeAnim* findNodeAnim(const aiAnimation* animation,
+                               const std::string node_name);
+
+}  // namespace engine
+
+#endif
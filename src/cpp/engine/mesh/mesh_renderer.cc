@@ -1,7 +1,10 @@
 // Copyright (c) 2014, Tamas Csala
 
 #include <vector>
+#include <numeric>
+#include <algorithm>
 #include "./mesh_renderer.h"
+#include "../context_objects.h"
 #include "../../oglwrap/context.h"
 #include "../../oglwrap/smart_enums.h"
 
@@ -14,21 +17,40 @@ MeshRenderer::MeshRenderer(const std::string& filename,
                            gl::Bitfield<aiPostProcessSteps> flags)
     : scene_(importer_.ReadFile(filename.c_str(), flags|aiProcess_Triangulate))
     , filename_(filename)
-    , entries_(scene_->mNumMeshes)
+    , entries_(scene_ ? scene_->mNumMeshes : 0)
     , is_setup_positions_(false)
     , is_setup_normals_(false)
     , is_setup_tex_coords_(false)
-    , textures_enabled_(true) {
+    , textures_enabled_(true)
+    , cpu_memory_(MemoryStats::kCpu, "assimp scenes", filename)
+    , gpu_memory_(MemoryStats::kGpu, "meshes", filename) {
   if (!scene_) {
     throw std::runtime_error("Error parsing " + filename_ + " : " +
                              importer_.GetErrorString());
   }
 
+  aiMemoryInfo memory_info;
+  importer_.GetMemoryRequirements(memory_info);
+  cpu_memory_.set_bytes(memory_info.total);
+
   // The world transform is the transform that takes the root node to it's
   // parent's space, which is the OpenGL style world space. The inverse of this
   // is stored as an attribute of the scene's root node.
   world_transformation_ =
     glm::inverse(engine::convertMatrix(scene_->mRootNode->mTransformation));
+
+  draw_order_.resize(entries_.size());
+  std::iota(draw_order_.begin(), draw_order_.end(), 0);
+}
+
+/// Sorts draw_order_ by the entries' material index.
+/** The sort is stable, so entries with the same material keep their order. */
+void MeshRenderer::sortEntriesByMaterial() {
+  std::iota(draw_order_.begin(), draw_order_.end(), 0);
+  std::stable_sort(draw_order_.begin(), draw_order_.end(),
+                   [this](size_t a, size_t b) {
+    return entries_[a].material_index < entries_[b].material_index;
+  });
 }
 
 std::vector<int> MeshRenderer::btTriangles(btTriangleIndexVertexArray* triangles) {
@@ -107,6 +129,7 @@ void MeshRenderer::setIndices(size_t index) {
   gl::Bind(entries_[index].indices);
   entries_[index].indices.data(indices_vector);
   entries_[index].idx_count = indices_vector.size();
+  gpu_memory_.add(indices_vector.size() * sizeof(IdxType));
 }
 
 /// Loads in vertex positions and indices, and uploads the former into an attribute array.
@@ -137,6 +160,7 @@ void MeshRenderer::setupPositions(gl::VertexAttrib attrib) {
 
     gl::Bind(entries_[i].verts);
     entries_[i].verts.data(mesh->mNumVertices*sizeof(aiVector3D), mesh->mVertices);
+    gpu_memory_.add(mesh->mNumVertices*sizeof(aiVector3D));
     attrib.setup<glm::vec3>().enable();
 
     // ~~~~~~<{ Load the indices }>~~~~~~
@@ -153,6 +177,11 @@ void MeshRenderer::setupPositions(gl::VertexAttrib attrib) {
     }
   }
 
+  vao_setups_.push_back([this, attrib](size_t i) mutable {
+    gl::Bind(entries_[i].verts);
+    attrib.setup<glm::vec3>().enable();
+  });
+
   gl::Unbind(gl::kArrayBuffer);
   gl::Unbind(gl::kVertexArray);
 }
@@ -182,9 +211,15 @@ void MeshRenderer::setupNormals(gl::VertexAttrib attrib) {
 
     gl::Bind(entries_[i].normals);
     entries_[i].normals.data(mesh->mNumVertices*sizeof(aiVector3D), mesh->mNormals);
+    gpu_memory_.add(mesh->mNumVertices*sizeof(aiVector3D));
     attrib.setup<float>(3).enable();
   }
 
+  vao_setups_.push_back([this, attrib](size_t i) mutable {
+    gl::Bind(entries_[i].normals);
+    attrib.setup<float>(3).enable();
+  });
+
   gl::Unbind(gl::kArrayBuffer);
   gl::Unbind(gl::kVertexArray);
 }
@@ -250,9 +285,33 @@ void MeshRenderer::setupTexCoords(gl::VertexAttrib attrib,
 
     gl::Bind(entries_[i].tex_coords);
     entries_[i].tex_coords.data(tex_coords_vector);
+    gpu_memory_.add(tex_coords_vector.size() * sizeof(aiVector2D));
     attrib.setup<float>(2).enable();
   }
 
+  vao_setups_.push_back([this, attrib](size_t i) mutable {
+    gl::Bind(entries_[i].tex_coords);
+    attrib.setup<float>(2).enable();
+  });
+
+  gl::Unbind(gl::kArrayBuffer);
+  gl::Unbind(gl::kVertexArray);
+
+  // The material indices are known now.
+  sortEntriesByMaterial();
+}
+
+void MeshRenderer::recreateVertexArrays() {
+  for (size_t i = 0; i < entries_.size(); i++) {
+    ContextObjects::Recreate(&entries_[i].vao);
+    gl::Bind(entries_[i].vao);
+    // The index buffer's binding is part of the vao's state.
+    gl::Bind(entries_[i].indices);
+    for (auto& setup : vao_setups_) {
+      setup(i);
+    }
+  }
+
   gl::Unbind(gl::kArrayBuffer);
   gl::Unbind(gl::kVertexArray);
 }
@@ -309,6 +368,7 @@ void MeshRenderer::setupTextures(unsigned short texture_unit,
                                                      srgb ? "CSRGBA" : "CRGBA");
         materials_[tex_type].textures[i].minFilter(gl::kLinear);
         materials_[tex_type].textures[i].magFilter(gl::kLinear);
+        gpu_memory_.add(MemoryStats::BoundTextureBytes());
       } else {
         aiColor4D color(0.f, 0.f, 0.f, 1.0f);
         mat->Get(pKey, type, idx, color);
@@ -318,6 +378,7 @@ void MeshRenderer::setupTextures(unsigned short texture_unit,
                                                 gl::kFloat, &color.r);
         materials_[tex_type].textures[i].minFilter(gl::kNearest);
         materials_[tex_type].textures[i].magFilter(gl::kNearest);
+        gpu_memory_.add(sizeof(color));
       }
     }
   }
@@ -342,38 +403,115 @@ void MeshRenderer::setupSpecularTextures(unsigned short texture_unit) {
                 AI_MATKEY_COLOR_SPECULAR, false);
 }
 
+/// Binds the textures of every active material type for a material index.
+/** Returns the number of binds. */
+size_t MeshRenderer::bindMaterial(unsigned material_index) {
+  size_t binds = 0;
+  for (auto iter = materials_.begin(); iter != materials_.end(); iter++) {
+    auto& material = iter->second;
+    if (material.active && material_index < material.textures.size()) {
+      gl::ActiveTexture(material.tex_unit);
+      gl::Bind(material.textures[material_index]);
+      binds++;
+    }
+  }
+  return binds;
+}
+
+/// Unbinds the textures bound by bindMaterial(material_index).
+/** Returns the number of unbinds. */
+size_t MeshRenderer::unbindMaterial(unsigned material_index) {
+  size_t unbinds = 0;
+  for (auto iter = materials_.begin(); iter != materials_.end(); iter++) {
+    auto& material = iter->second;
+    if (material.active && material_index < material.textures.size()) {
+      gl::ActiveTexture(material.tex_unit);
+      gl::Unbind(material.textures[material_index]);
+      unbinds++;
+    }
+  }
+  return unbinds;
+}
+
+/// Draws a single entry, without binding its material.
+void MeshRenderer::renderEntry(size_t entry_index) {
+  if (!is_setup_positions_) {
+    return;
+  }
+
+  const MeshEntry& entry = entries_[entry_index];
+  gl::Bind(entry.vao);
+  gl::DrawElements(gl::kTriangles, entry.idx_count, entry.idx_type);
+}
+
+/// Returns an entry's material, for RenderQueue commands.
+RenderQueue::Material MeshRenderer::queueMaterial(size_t entry_index) {
+  unsigned material_index = entries_[entry_index].material_index;
+  if (!textures_enabled_ || material_index >= scene_->mNumMaterials) {
+    return RenderQueue::Material{nullptr, 0, nullptr, nullptr};
+  }
+
+  return RenderQueue::Material{
+    this, material_index,
+    [](void* mesh, unsigned index) {
+      return static_cast<MeshRenderer*>(mesh)->bindMaterial(index);
+    },
+    [](void* mesh, unsigned index) {
+      return static_cast<MeshRenderer*>(mesh)->unbindMaterial(index);
+    }
+  };
+}
+
 /// Renders the mesh.
-/** Changes the currently active VAO and may change the Texture2D binding */
-void MeshRenderer::render() {
+/** The entries are drawn sorted by material, and a material's textures are
+  * only bound when it differs from the previous entry's material.
+  * Changes the currently active VAO and may change the Texture2D binding */
+void MeshRenderer::render(size_t instance_count) {
+  render_stats_ = RenderStats{};
   if (!is_setup_positions_) {
     return;  // we can't render the mesh, if we don't have any vertex.
   }
-  for (size_t i = 0 ; i < entries_.size(); i++) {
-    gl::Bind(entries_[i].vao);
 
-    const size_t material_index = entries_[i].material_index;
-
-    if (textures_enabled_) {
-      for (auto iter = materials_.begin(); iter != materials_.end(); iter++) {
-        auto& material = iter->second;
-        if (material.active == true && material_index < scene_->mNumMaterials) {
-          gl::ActiveTexture(material.tex_unit);
-        }
-        gl::Bind(material.textures[material_index]);
-      }
+  size_t active_materials = 0;
+  for (auto iter = materials_.begin(); iter != materials_.end(); iter++) {
+    if (iter->second.active) {
+      active_materials++;
     }
+  }
+
+  // How many binds the naive way (bind and unbind every material for
+  // every entry) would have needed.
+  size_t naive_binds = 0;
+  unsigned bound_material = MeshEntry::kInvalidMaterial;
 
-    gl::DrawElements(gl::kTriangles, entries_[i].idx_count, entries_[i].idx_type);
+  for (size_t i : draw_order_) {
+    const MeshEntry& entry = entries_[i];
+    gl::Bind(entry.vao);
 
-    if (textures_enabled_) {
-      for (auto iter = materials_.begin(); iter != materials_.end(); iter++) {
-        auto& material = iter->second;
-        if (material.active == true && material_index < scene_->mNumMaterials) {
-          gl::ActiveTexture(material.tex_unit);
-        }
-        gl::Unbind(material.textures[material_index]);
+    if (textures_enabled_ && entry.material_index < scene_->mNumMaterials) {
+      naive_binds += 2 * active_materials;
+      if (entry.material_index != bound_material) {
+        render_stats_.texture_binds += bindMaterial(entry.material_index);
+        bound_material = entry.material_index;
       }
     }
+
+    if (instance_count == 1) {
+      gl::DrawElements(gl::kTriangles, entry.idx_count, entry.idx_type);
+    } else {
+      gl::DrawElementsInstanced(gl::kTriangles, entry.idx_count,
+                                entry.idx_type, instance_count);
+    }
+    render_stats_.draw_calls++;
+  }
+
+  // Only the last material's textures have to be unbound.
+  if (bound_material != MeshEntry::kInvalidMaterial) {
+    render_stats_.texture_binds += unbindMaterial(bound_material);
+  }
+
+  if (naive_binds > render_stats_.texture_binds) {
+    render_stats_.texture_binds_saved = naive_binds - render_stats_.texture_binds;
   }
 
   gl::Unbind(gl::kVertexArray);
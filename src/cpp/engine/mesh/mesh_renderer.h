@@ -5,7 +5,9 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 #include <climits>
+#include <functional>
 #include <btBulletDynamicsCommon.h>
 
 #include "../oglwrap_config.h"
@@ -15,6 +17,8 @@
 #include "../../oglwrap/textures/texture_2D.h"
 
 #include "../assimp.h"
+#include "../render_queue.h"
+#include "../memory_stats.h"
 #include "../collision/bounding_box.h"
 
 namespace engine {
@@ -49,6 +53,10 @@ class MeshRenderer {
   /// The vao-s and buffers per mesh.
   std::vector<MeshEntry> entries_;
 
+  /// The attribute setups of the vao-s, called with the entry's index, so
+  /// that they can be replayed by recreateVertexArrays.
+  std::vector<std::function<void(size_t)>> vao_setups_;
+
   /// The transformation that takes the model's world coordinates to the OpenGL style world coordinates.
   glm::mat4 world_transformation_;
 
@@ -73,6 +81,31 @@ class MeshRenderer {
   /// Textures can be disabled, and not used for rendering
   bool textures_enabled_;
 
+  /// The memory of the assimp scenes, and of the buffers and textures.
+  MemoryStats::Allocation cpu_memory_, gpu_memory_;
+
+ public:
+  /// Counters about the last render() call.
+  struct RenderStats {
+    /// The number of DrawElements calls issued.
+    size_t draw_calls;
+    /// The number of texture bind / unbind calls issued.
+    size_t texture_binds;
+    /// How many bind / unbind calls were elided compared to rebinding (and
+    /// unbinding) every material for every entry.
+    size_t texture_binds_saved;
+
+    RenderStats() : draw_calls(0), texture_binds(0), texture_binds_saved(0) {}
+  };
+
+ protected:
+  /// The indices of the entries, sorted by material, so that entries sharing
+  /// a material are drawn after each other without rebinding its textures.
+  std::vector<size_t> draw_order_;
+
+  /// The stats of the last render() call.
+  RenderStats render_stats_;
+
   /// It shouldn't be copyable.
   MeshRenderer(const MeshRenderer& src) = delete;
   /// It shouldn't be copyable.
@@ -97,6 +130,9 @@ public:
   std::vector<int> btTriangles(btTriangleIndexVertexArray* triangles);
 
 private:
+  /// Sorts draw_order_ by the entries' material index.
+  void sortEntriesByMaterial();
+
   template <typename IdxType>
   /// A template for setting different types (byte/short/int) of indices.
   /** This expects the correct vao to be already bound!
@@ -133,6 +169,12 @@ public:
   void setupTexCoords(gl::VertexAttrib attrib,
                       unsigned char tex_coord_set = 0);
 
+  /// Recreates the vao-s on the current context, with the same attributes.
+  /** Needed if the mesh was set up on another context, as the vao-s aren't
+    * shared between contexts (see ContextObjects). The buffers are kept.
+    * Calling this function changes the currently active VAO and ArrayBuffer. */
+  void recreateVertexArrays();
+
   /**
    * @brief Loads in a specified type of texture for every mesh. If no texture
    *        but a single color is specified, then sets up an 1x1 texture with
@@ -166,8 +208,35 @@ public:
   void setupSpecularTextures(unsigned short texture_unit);
 
   /// Renders the mesh.
-  /** Changes the currently active VAO and may change the Texture2D binding */
-  void render();
+  /** The entries are drawn sorted by material, and a material's textures are
+    * only bound when it differs from the previous entry's material.
+    * Changes the currently active VAO and may change the Texture2D binding
+    * @param instance_count - If it's more than one, every entry is drawn with
+    *                         a single instanced draw call. */
+  void render(size_t instance_count = 1);
+
+  /// Returns the counters collected during the last render() call.
+  const RenderStats& render_stats() const { return render_stats_; }
+
+  /// Returns the number of entries (meshes in the file).
+  size_t entry_count() const { return entries_.size(); }
+
+  /// Draws a single entry, without binding its material.
+  /** Changes the currently active VAO. */
+  void renderEntry(size_t entry);
+
+  /// Returns an entry's material, that renderEntry() expects to be bound,
+  /// for RenderQueue commands. Its owner is nullptr if there's nothing to bind.
+  RenderQueue::Material queueMaterial(size_t entry);
+
+  /// Binds the textures of every active material type for a material index.
+  /** Returns the number of binds. Changes the currently active texture unit
+    * and Texture2D binding. */
+  size_t bindMaterial(unsigned material_index);
+
+  /// Unbinds the textures bound by bindMaterial(material_index).
+  /** Returns the number of unbinds. */
+  size_t unbindMaterial(unsigned material_index);
 
   /// Gives information about the mesh's bounding cuboid.
   BoundingBox boundingBox(const glm::mat4& matrix = glm::mat4{}) const;
@@ -194,7 +263,7 @@ public:
   void enableTextures() { textures_enabled_ = true; }
 
   /// Disables the use of textures for rendering.
-  void disableTextures() { textures_enabled_ = true; }
+  void disableTextures() { textures_enabled_ = false; }
 };
 
 }  // namespace engine
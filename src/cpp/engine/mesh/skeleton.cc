@@ -0,0 +1,75 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./skeleton.h"
+
+#if defined(__SSE__)
+  #include <xmmintrin.h>
+#endif
+
+namespace engine {
+
+int Skeleton::addNode(const std::string& name, int parent, int bone,
+                      const glm::mat4& bind_transform) {
+  parents.push_back(parent);
+  bones.push_back(bone);
+  bind_transforms.push_back(bind_transform);
+  names.push_back(name);
+  return parents.size() - 1;
+}
+
+void LocalPose::resize(size_t size) {
+  translations.resize(size);
+  rotations.resize(size);
+  scales.resize(size, glm::vec3(1.0f));
+  animated.resize(size);
+}
+
+void MultiplyTransforms(const glm::mat4& a, const glm::mat4& b,
+                        glm::mat4* result) {
+#if defined(__SSE__)
+  // Every column of the result is a linear combination of a's columns.
+  __m128 a0 = _mm_loadu_ps(&a[0][0]);
+  __m128 a1 = _mm_loadu_ps(&a[1][0]);
+  __m128 a2 = _mm_loadu_ps(&a[2][0]);
+  __m128 a3 = _mm_loadu_ps(&a[3][0]);
+  for (int i = 0; i < 4; ++i) {
+    __m128 col = _mm_mul_ps(a0, _mm_set1_ps(b[i][0]));
+    col = _mm_add_ps(col, _mm_mul_ps(a1, _mm_set1_ps(b[i][1])));
+    col = _mm_add_ps(col, _mm_mul_ps(a2, _mm_set1_ps(b[i][2])));
+    col = _mm_add_ps(col, _mm_mul_ps(a3, _mm_set1_ps(b[i][3])));
+    _mm_storeu_ps(&(*result)[i][0], col);
+  }
+#else
+  *result = a * b;
+#endif
+}
+
+/// Returns translate(t) * mat4_cast(r) * scale(s), without the matrix
+/// multiplications.
+static glm::mat4 ComposeTransform(const glm::vec3& t, const glm::quat& r,
+                                  const glm::vec3& s) {
+  glm::mat3 rotation = glm::mat3_cast(r);
+  return glm::mat4(glm::vec4(rotation[0] * s.x, 0),
+                   glm::vec4(rotation[1] * s.y, 0),
+                   glm::vec4(rotation[2] * s.z, 0),
+                   glm::vec4(t, 1));
+}
+
+void ComputeModelTransforms(const Skeleton& skeleton, const LocalPose& pose,
+                            glm::mat4* model_transforms) {
+  for (size_t i = 0; i < skeleton.size(); ++i) {
+    glm::mat4 local =
+        pose.animated[i] ? ComposeTransform(pose.translations[i],
+                                            pose.rotations[i], pose.scales[i])
+                         : skeleton.bind_transforms[i];
+    int parent = skeleton.parents[i];
+    if (parent < 0) {
+      model_transforms[i] = local;
+    } else {
+      MultiplyTransforms(model_transforms[parent], local,
+                         &model_transforms[i]);
+    }
+  }
+}
+
+}  // namespace engine
@@ -0,0 +1,73 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MESH_SKELETON_H_
+#define ENGINE_MESH_SKELETON_H_
+
+#include <string>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// The node hierarchy of the animated meshes, flattened at load time, so that
+// a pose can be evaluated with a single linear pass, without recursion, and
+// without touching the assimp scene.
+
+namespace engine {
+
+struct Skeleton {
+  /// The parent of every node, or -1 for the root. The nodes are in
+  /// topological order: every node comes after its parent.
+  std::vector<int> parents;
+
+  /// The bone (index in SkinningData::bone_info) of every node, or -1 if the
+  /// node isn't a bone.
+  std::vector<int> bones;
+
+  /// The local transformations from the mesh file. These are used for the
+  /// nodes that the current animation doesn't move.
+  std::vector<glm::mat4> bind_transforms;
+
+  /// The names of the nodes. Only used to bind the animations at load time.
+  std::vector<std::string> names;
+
+  size_t size() const { return parents.size(); }
+
+  /// Appends a node, and returns its index.
+  int addNode(const std::string& name, int parent, int bone,
+              const glm::mat4& bind_transform);
+};
+
+/// The local transformations of a skeleton's nodes, in a structure of arrays
+/// layout, indexed like the skeleton's nodes.
+struct LocalPose {
+  std::vector<glm::vec3> translations;
+  std::vector<glm::quat> rotations;
+  std::vector<glm::vec3> scales;
+
+  /// If it's zero, the node uses its bind transformation.
+  std::vector<unsigned char> animated;
+
+  void resize(size_t size);
+};
+
+/// Sets result to a * b. It's safe to use either of the inputs as the result.
+void MultiplyTransforms(const glm::mat4& a, const glm::mat4& b,
+                        glm::mat4* result);
+
+/**
+ * @brief Computes the model space transformations of every node of the
+ *        skeleton, in a single pass over the nodes.
+ *
+ * @param skeleton          The skeleton of the pose.
+ * @param pose              The local transformations of the nodes.
+ * @param model_transforms  Returns the transformations here. It must have
+ *                          space for skeleton.size() matrices.
+ */
+void ComputeModelTransforms(const Skeleton& skeleton, const LocalPose& pose,
+                            glm::mat4* model_transforms);
+
+}  // namespace engine
+
+#endif  // ENGINE_MESH_SKELETON_H_
@@ -0,0 +1,69 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./skinned_instances.h"
+
+#include <cassert>
+#include <algorithm>
+#include <stdexcept>
+
+#include "../../oglwrap/smart_enums.h"
+
+namespace engine {
+
+constexpr GLuint SkinnedInstances::kBindingPoint;
+
+SkinnedInstances::SkinnedInstances(size_t num_bones, BoneEncoding encoding)
+    : num_bones_(num_bones), encoding_(encoding)
+    , stride_(4 + num_bones * BoneEncodingSize(encoding))
+    , size_(0), capacity_(0) {}
+
+void SkinnedInstances::clear() {
+  data_.clear();
+  size_ = 0;
+}
+
+void SkinnedInstances::resize(size_t size) {
+  data_.resize(size * stride_);
+  size_ = size;
+}
+
+void SkinnedInstances::add(const glm::mat4& model_matrix,
+                           const std::vector<glm::mat4>& bones) {
+  if (bones.size() != num_bones_) {
+    throw std::invalid_argument("SkinnedInstances: wrong number of bones.");
+  }
+  resize(size_ + 1);
+  set(size_ - 1, model_matrix, bones);
+}
+
+void SkinnedInstances::set(size_t instance, const glm::mat4& model_matrix,
+                           const std::vector<glm::mat4>& bones) {
+  assert(instance < size_);
+  assert(bones.size() == num_bones_);
+
+  size_t bone_size = BoneEncodingSize(encoding_);
+  glm::vec4* data = &data_[instance * stride_];
+  for (int i = 0; i < 4; ++i) {
+    data[i] = model_matrix[i];
+  }
+  for (size_t i = 0; i < num_bones_; ++i) {
+    EncodeBone(encoding_, bones[i], data + 4 + i * bone_size);
+  }
+}
+
+void SkinnedInstances::upload() {
+  gl::Bind(buffer_);
+  if (data_.size() > capacity_) {
+    // Grows geometrically, so that a growing crowd doesn't reallocate the
+    // storage every frame.
+    capacity_ = std::max(data_.size(), 2 * capacity_);
+    buffer_.data(capacity_ * sizeof(glm::vec4), nullptr, gl::kDynamicDraw);
+  }
+  if (!data_.empty()) {
+    buffer_.subData(0, data_.size() * sizeof(glm::vec4), data_.data());
+  }
+  gl::Unbind(buffer_);
+  buffer_.bindBase(kBindingPoint);
+}
+
+}  // namespace engine
@@ -0,0 +1,96 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MESH_SKINNED_INSTANCES_H_
+#define ENGINE_MESH_SKINNED_INSTANCES_H_
+
+#include <vector>
+
+#include "../oglwrap_config.h"
+#include "../../oglwrap/buffer.h"
+
+#include "./bone_encoding.h"
+
+namespace engine {
+
+/**
+ * @brief The per-instance data of an instanced skinned mesh: the model matrix,
+ *        and the bone palette of every instance, packed into a single shader
+ *        storage buffer.
+ *
+ * The instances are collected on the main thread (or on its jobs, see set()),
+ * and uploaded at once on the render thread, so a crowd sharing the same mesh
+ * can be drawn with a single instanced draw call per entry. The shaders read
+ * the EngineSkinnedInstances block as a vec4 array: the columns of the model
+ * matrix, then BoneEncodingSize(encoding()) vec4s for every bone, per
+ * instance, indexed by gl_InstanceID.
+ */
+class SkinnedInstances {
+ public:
+  static constexpr GLuint kBindingPoint = 2;
+
+  /**
+   * @param num_bones   The number of bones of the mesh.
+   * @param encoding    The encoding of the bones. The shaders have to be
+   *                    compiled with the same BONE_ENCODING.
+   */
+  SkinnedInstances(size_t num_bones, BoneEncoding encoding);
+
+  BoneEncoding encoding() const { return encoding_; }
+
+  /// The number of instances.
+  size_t size() const { return size_; }
+
+  /// The number of vec4s per instance.
+  size_t stride() const { return stride_; }
+
+  /// Removes every instance.
+  void clear();
+
+  /// Changes the number of instances. The new instances are uninitialized.
+  void resize(size_t size);
+
+  /**
+   * @brief Adds an instance.
+   *
+   * @param model_matrix   The model matrix of the instance.
+   * @param bones          The final transformations of the instance's bones.
+   *                       Throws std::invalid_argument if their number isn't
+   *                       the mesh's.
+   */
+  void add(const glm::mat4& model_matrix,
+           const std::vector<glm::mat4>& bones);
+
+  /**
+   * @brief Overwrites an instance. Different instances can be set on
+   *        different threads at the same time.
+   *
+   * It doesn't throw, as it usually runs in a job, the arguments are only
+   * checked by asserts.
+   *
+   * @param instance       The index of the instance, less than size().
+   * @param model_matrix   The model matrix of the instance.
+   * @param bones          The final transformations of the instance's bones,
+   *                       exactly as many as the mesh has.
+   */
+  void set(size_t instance, const glm::mat4& model_matrix,
+           const std::vector<glm::mat4>& bones);
+
+  /// Uploads the instances, and binds the buffer to kBindingPoint.
+  void upload();
+
+ private:
+  size_t num_bones_;
+  BoneEncoding encoding_;
+  size_t stride_;
+  size_t size_;
+
+  std::vector<glm::vec4> data_;
+
+  gl::ShaderStorageBuffer buffer_;
+  /// The size of the buffer's storage in vec4s. It only grows.
+  size_t capacity_;
+};
+
+}  // namespace engine
+
+#endif  // ENGINE_MESH_SKINNED_INSTANCES_H_
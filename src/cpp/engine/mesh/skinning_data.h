@@ -8,6 +8,7 @@
 #include <vector>
 #include <memory>
 #include "./mesh_renderer.h"
+#include "./skeleton.h"
 
 namespace engine {
 
@@ -62,6 +63,8 @@ struct SkinningData {
   /// and current transformations.
   struct BoneInfo {
     glm::mat4 bone_offset;
+    /// Only used by the external bones, the transformations of the animated
+    /// bones are stored per instance, in the Animation.
     glm::mat4 final_transform;
 
     // For editing bones from outside
@@ -99,11 +102,19 @@ struct SkinningData {
   /// It is need to get the offsets.
   std::string root_bone;
 
+  /// The mesh's node hierarchy, flattened. The animations bind their
+  /// channels to its node indices (see AnimInfo).
+  Skeleton skeleton;
+
+  /// The index of the root bone in skeleton.
+  size_t root_bone_node;
+
   explicit SkinningData(size_t num_meshes = 0)
     : vertex_bone_data_buffers(num_meshes)
     , num_bones(0)
     , max_bone_attrib_num(0)
     , is_setup_bones(false)
+    , root_bone_node(-1)
   { }
 };
 
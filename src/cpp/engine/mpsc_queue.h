@@ -0,0 +1,63 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_MPSC_QUEUE_H_
+#define ENGINE_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+namespace engine {
+
+// Passes values from any number of producer threads to one consumer thread
+// without locking. The producers push the values one by one, and the
+// consumer takes every value, that was pushed so far, at once. Unlike a
+// TripleBuffer, it doesn't drop any value.
+template<typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(nullptr) {}
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  ~MpscQueue() { consumeAll([](T&) {}); }
+
+  // Producer side.
+  void push(T value) {
+    Node* node = new Node{std::move(value), head_.load()};
+    while (!head_.compare_exchange_weak(node->next, node)) {}
+  }
+
+  // Consumer side. Calls func(T&) for every pushed value, in the order they
+  // were pushed in.
+  template<typename Func>
+  void consumeAll(Func func) {
+    // The list is in reverse order.
+    Node* node = head_.exchange(nullptr);
+    Node* reversed = nullptr;
+    while (node) {
+      Node* next = node->next;
+      node->next = reversed;
+      reversed = node;
+      node = next;
+    }
+
+    while (reversed) {
+      Node* next = reversed->next;
+      func(reversed->value);
+      delete reversed;
+      reversed = next;
+    }
+  }
+
+ private:
+  struct Node {
+    T value;
+    Node* next;
+  };
+
+  std::atomic<Node*> head_;
+};
+
+}  // namespace engine
+
+#endif
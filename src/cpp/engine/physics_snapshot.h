@@ -0,0 +1,71 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PHYSICS_SNAPSHOT_H_
+#define ENGINE_PHYSICS_SNAPSHOT_H_
+
+#include <vector>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <btBulletDynamicsCommon.h>
+
+namespace engine {
+
+// The transforms of the non-static bodies of a dynamics world after a
+// physics step, and before it, so that they can be interpolated.
+struct PhysicsSnapshot {
+  struct Body {
+    const btCollisionObject* body;
+    glm::vec3 prev_pos, pos;
+    glm::quat prev_rot, rot;
+
+    bool operator<(const Body& other) const { return body < other.body; }
+  };
+
+  // The simulation time after the step, and the length of the step.
+  double time = 0, time_step = 0;
+  // Sorted by the body pointers.
+  std::vector<Body> bodies;
+
+  const Body* find(const btCollisionObject* body) const {
+    Body key;
+    key.body = body;
+    auto iter = std::lower_bound(bodies.begin(), bodies.end(), key);
+    return iter != bodies.end() && iter->body == body ? &*iter : nullptr;
+  }
+
+  // Records the state of the world after a step. The bodies' previous state
+  // is taken from the snapshot of the previous step (if they were in it).
+  void capture(const btCollisionWorld& world, double time, double time_step,
+               const PhysicsSnapshot& previous) {
+    this->time = time;
+    this->time_step = time_step;
+    bodies.clear();
+
+    const btCollisionObjectArray& objects = world.getCollisionObjectArray();
+    for (int i = 0; i < objects.size(); ++i) {
+      const btRigidBody* rigid_body = btRigidBody::upcast(objects[i]);
+      if (!rigid_body || rigid_body->isStaticObject()) { continue; }
+
+      const btTransform& t = rigid_body->getWorldTransform();
+      const btVector3& o = t.getOrigin();
+      const btQuaternion r = t.getRotation();
+      Body body;
+      body.body = rigid_body;
+      body.pos = glm::vec3(o.x(), o.y(), o.z());
+      body.rot = glm::quat(r.getW(), r.getX(), r.getY(), r.getZ());
+      bodies.push_back(body);
+    }
+    std::sort(bodies.begin(), bodies.end());
+
+    for (Body& body : bodies) {
+      const Body* prev = previous.find(body.body);
+      body.prev_pos = prev ? prev->pos : body.pos;
+      body.prev_rot = prev ? prev->rot : body.rot;
+    }
+  }
+};
+
+}  // namespace engine
+
+#endif
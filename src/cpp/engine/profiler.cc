@@ -0,0 +1,266 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./profiler.h"
+#include "./allocation_counter.h"
+#include "./frame_pipeline.h"
+
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#ifdef __GNUC__
+  #include <cxxabi.h>
+#endif
+
+namespace engine {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+const Clock::time_point start_time = Clock::now();
+
+// The scopes finished on a thread, since the last EndFrame.
+struct ThreadBuffer {
+  std::mutex mutex;
+  std::vector<Profiler::Event> events;
+  uint32_t id;
+  uint32_t depth = 0;
+  Profiler::ThreadRole role;
+  // The thread exited, the buffer can be reused by a new one.
+  bool unused = false;
+};
+
+struct ProfilerState {
+  // Guards the members, it is locked before the buffers' mutexes.
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> threads;
+  std::deque<Profiler::Frame> frames;
+  std::vector<Profiler::GpuEvent> gpu_events;
+  double frame_begin = 0;
+  uint64_t frame_begin_allocations = 0;
+};
+
+ProfilerState state;
+
+// Releases the thread's buffer when the thread exits, as the render thread
+// is restarted quite often.
+struct ThreadBufferHandle {
+  ThreadBuffer* buffer = nullptr;
+
+  ~ThreadBufferHandle() {
+    if (buffer) {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      buffer->unused = true;
+    }
+  }
+};
+
+Profiler::ThreadRole CurrentRole() {
+  if (FramePipeline::IsMainThread()) { return Profiler::kMainThread; }
+  if (FramePipeline::IsRenderThread()) { return Profiler::kRenderThread; }
+  return Profiler::kWorkerThread;
+}
+
+ThreadBuffer* CurrentThread() {
+  thread_local ThreadBufferHandle handle;
+  if (!handle.buffer) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (auto& thread : state.threads) {
+      if (thread->unused) {
+        thread->unused = false;
+        thread->role = CurrentRole();
+        handle.buffer = thread.get();
+        return handle.buffer;
+      }
+    }
+    state.threads.push_back(std::unique_ptr<ThreadBuffer>{new ThreadBuffer});
+    handle.buffer = state.threads.back().get();
+    handle.buffer->id = state.threads.size() - 1;
+    handle.buffer->role = CurrentRole();
+  }
+  return handle.buffer;
+}
+
+// Only used on the thread that has the context. The queries of a frame are
+// read at the end of the next frame.
+struct GpuQuery {
+  GLuint id;
+  const char* name;
+  double cpu_begin;
+};
+
+struct GpuState {
+  std::vector<GpuQuery> queries[2];
+  size_t used[2] = {0, 0};
+  unsigned current = 0;
+  bool scope_open = false;
+};
+
+GpuState gpu;
+
+}  // namespace
+
+constexpr size_t Profiler::kHistorySize;
+
+double Profiler::Now() {
+  return std::chrono::duration<double, std::micro>(
+      Clock::now() - start_time).count();
+}
+
+Profiler::CpuScope::CpuScope(const char* name)
+    : name_(name), is_type_name_(false), begin_(Now()) {
+  CurrentThread()->depth++;
+}
+
+Profiler::CpuScope::CpuScope(const std::type_info& type)
+    : name_(type.name()), is_type_name_(true), begin_(Now()) {
+  CurrentThread()->depth++;
+}
+
+Profiler::CpuScope::~CpuScope() {
+  double end = Now();
+  ThreadBuffer* thread = CurrentThread();
+  thread->depth--;
+
+  std::lock_guard<std::mutex> lock(thread->mutex);
+  thread->events.push_back(
+      Event{name_, is_type_name_, begin_, end, thread->id, thread->depth,
+            thread->role});
+}
+
+Profiler::GpuScope::GpuScope(const char* name) : active_(false) {
+  if (gpu.scope_open || !GLEW_ARB_timer_query) { return; }
+
+  std::vector<GpuQuery>& queries = gpu.queries[gpu.current];
+  size_t& used = gpu.used[gpu.current];
+  if (used == queries.size()) {
+    GpuQuery query;
+    glGenQueries(1, &query.id);
+    queries.push_back(query);
+  }
+
+  GpuQuery& query = queries[used++];
+  query.name = name;
+  query.cpu_begin = Now();
+  glBeginQuery(GL_TIME_ELAPSED, query.id);
+  gpu.scope_open = active_ = true;
+}
+
+Profiler::GpuScope::~GpuScope() {
+  if (active_) {
+    glEndQuery(GL_TIME_ELAPSED);
+    gpu.scope_open = false;
+  }
+}
+
+void Profiler::EndFrame() {
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  Frame frame;
+  frame.begin = state.frame_begin;
+  frame.end = state.frame_begin = Now();
+  for (auto& thread : state.threads) {
+    std::lock_guard<std::mutex> thread_lock(thread->mutex);
+    frame.events.insert(frame.events.end(), thread->events.begin(),
+                        thread->events.end());
+    thread->events.clear();
+  }
+  frame.gpu_events.swap(state.gpu_events);
+  uint64_t allocations = AllocationCounter::Total();
+  frame.heap_allocations = allocations - state.frame_begin_allocations;
+  state.frame_begin_allocations = allocations;
+
+  state.frames.push_back(std::move(frame));
+  if (state.frames.size() > kHistorySize) {
+    state.frames.pop_front();
+  }
+}
+
+void Profiler::EndGpuFrame() {
+  unsigned previous = 1 - gpu.current;
+  std::vector<GpuEvent> results;
+  for (size_t i = 0; i < gpu.used[previous]; ++i) {
+    const GpuQuery& query = gpu.queries[previous][i];
+    GLint available = 0;
+    glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) { continue; }
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsed);
+    results.push_back(GpuEvent{query.name, query.cpu_begin, elapsed / 1e3});
+  }
+  gpu.used[previous] = 0;
+  gpu.current = previous;
+
+  if (!results.empty()) {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.gpu_events.insert(state.gpu_events.end(),
+                            results.begin(), results.end());
+  }
+}
+
+Profiler::Frame Profiler::LastFrame() {
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return state.frames.empty() ? Frame{} : state.frames.back();
+}
+
+std::string Profiler::EventName(const Event& event) {
+#ifdef __GNUC__
+  if (event.is_type_name) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(event.name, nullptr, nullptr,
+                                          &status);
+    if (status == 0) {
+      std::string name{demangled};
+      std::free(demangled);
+      return name;
+    }
+  }
+#endif
+  return event.name;
+}
+
+bool Profiler::ExportChromeTrace(const std::string& filename) {
+  std::deque<Frame> frames;
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    frames = state.frames;
+  }
+
+  std::ofstream file{filename};
+  if (!file) {
+    std::cerr << "Unable to write the trace to " << filename << std::endl;
+    return false;
+  }
+
+  // The CPU threads are in process 0, the GPU is process 1.
+  file << std::fixed << std::setprecision(3);
+  file << "{\"traceEvents\":[\n"
+       << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,"
+          "\"args\":{\"name\":\"CPU\"}},\n"
+       << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+          "\"args\":{\"name\":\"GPU\"}}";
+  for (const Frame& frame : frames) {
+    for (const Event& event : frame.events) {
+      file << ",\n{\"name\":\"" << EventName(event) << "\",\"cat\":\"cpu\","
+           << "\"ph\":\"X\",\"ts\":" << event.begin
+           << ",\"dur\":" << event.end - event.begin
+           << ",\"pid\":0,\"tid\":" << event.thread << "}";
+    }
+    for (const GpuEvent& event : frame.gpu_events) {
+      file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"gpu\","
+           << "\"ph\":\"X\",\"ts\":" << event.cpu_begin
+           << ",\"dur\":" << event.duration << ",\"pid\":1,\"tid\":0}";
+    }
+  }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+  return static_cast<bool>(file);
+}
+
+}  // namespace engine
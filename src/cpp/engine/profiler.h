@@ -0,0 +1,136 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_PROFILER_H_
+#define ENGINE_PROFILER_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <typeinfo>
+
+#include "./oglwrap_config.h"
+
+// The profiling markers are compiled out if it is 0 (the release build
+// defines it so).
+#ifndef ENGINE_PROFILING
+  #define ENGINE_PROFILING 1
+#endif
+
+namespace engine {
+
+// Collects scoped CPU timings from every thread, and GPU timings from the
+// thread that has the context, per frame. The last kHistorySize frames are
+// kept, for the overlay and for exporting them as a Chrome trace (which can
+// be opened at chrome://tracing).
+class Profiler {
+ public:
+  static constexpr size_t kHistorySize = 120;
+
+  // The kind of thread, that recorded an event. The top level scopes of the
+  // main and the render threads are the phases of a frame, while the jobs'
+  // scopes on the workers overlap them (see JobSystem).
+  enum ThreadRole : uint8_t { kMainThread, kRenderThread, kWorkerThread };
+
+  // A finished CPU scope, times are in microseconds since the start.
+  struct Event {
+    const char* name;
+    bool is_type_name;  // a mangled type name, from a type_info
+    double begin, end;
+    uint32_t thread;
+    uint32_t depth;  // on its own thread
+    ThreadRole role;
+  };
+
+  // A finished GPU scope. The GPU doesn't report when it started, so
+  // cpu_begin is when the scope was opened on the CPU.
+  struct GpuEvent {
+    const char* name;
+    double cpu_begin;
+    double duration;  // microseconds
+  };
+
+  struct Frame {
+    double begin, end;
+    std::vector<Event> events;
+    std::vector<GpuEvent> gpu_events;
+    // The calls of operator new during the frame, on every thread. It's 0 if
+    // they aren't counted (see AllocationCounter).
+    uint64_t heap_allocations;
+  };
+
+  // A CPU scope. The name must outlive the profiler (i.e. a literal).
+  class CpuScope {
+   public:
+    explicit CpuScope(const char* name);
+    // Named after a type, i.e. the type of an object of the scene.
+    explicit CpuScope(const std::type_info& type);
+    ~CpuScope();
+    CpuScope(const CpuScope&) = delete;
+    CpuScope& operator=(const CpuScope&) = delete;
+
+   private:
+    const char* name_;
+    bool is_type_name_;
+    double begin_;
+  };
+
+  // A GPU scope, measured with a GL_TIME_ELAPSED query. Those queries can't
+  // be nested, so a scope opened inside another one is ignored. It must only
+  // be used on the thread that has the context.
+  class GpuScope {
+   public:
+    explicit GpuScope(const char* name);
+    ~GpuScope();
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+
+   private:
+    bool active_;
+  };
+
+  // Closes the current frame. Called by the main thread, after the frame is
+  // simulated (and rendered if the frames aren't pipelined). The CPU scopes
+  // finished by then on any thread are added to the frame.
+  static void EndFrame();
+
+  // Called by the thread that has the context, after a frame is rendered.
+  // The queries are double buffered, the results of the previous frame are
+  // read here, if they are available. If they aren't, they are dropped
+  // instead of waiting for them.
+  static void EndGpuFrame();
+
+  // The last closed frame. The GPU events are one frame behind the CPU.
+  static Frame LastFrame();
+
+  // Writes the recorded frames in the Chrome trace event format.
+  static bool ExportChromeTrace(const std::string& filename);
+
+  // Microseconds since the profiler was started.
+  static double Now();
+
+  // The readable name of an event.
+  static std::string EventName(const Event& event);
+};
+
+}  // namespace engine
+
+#if ENGINE_PROFILING
+  #define ENGINE_PROFILE_CONCAT_(a, b) a##b
+  #define ENGINE_PROFILE_CONCAT(a, b) ENGINE_PROFILE_CONCAT_(a, b)
+  #define ENGINE_PROFILE_SCOPE(name) \
+    engine::Profiler::CpuScope ENGINE_PROFILE_CONCAT(profile_scope_, \
+                                                     __LINE__){name}
+  // Measures the hook of an object, named after the object's type.
+  #define ENGINE_PROFILE_OBJECT_SCOPE(object) \
+    engine::Profiler::CpuScope ENGINE_PROFILE_CONCAT(profile_scope_, \
+                                                     __LINE__){typeid(object)}
+  #define ENGINE_PROFILE_GPU_SCOPE(name) \
+    engine::Profiler::GpuScope ENGINE_PROFILE_CONCAT(profile_gpu_scope_, \
+                                                     __LINE__){name}
+#else
+  #define ENGINE_PROFILE_SCOPE(name)
+  #define ENGINE_PROFILE_OBJECT_SCOPE(object)
+  #define ENGINE_PROFILE_GPU_SCOPE(name)
+#endif
+
+#endif
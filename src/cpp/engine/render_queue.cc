@@ -0,0 +1,160 @@
+// Copyright (c) 2014, Tamas Csala
+
+#include "./render_queue.h"
+
+#include <cstring>
+
+#include "./camera.h"
+#include "./profiler.h"
+
+namespace engine {
+
+std::atomic<unsigned> RenderQueue::State::next_id_{0};
+
+// The key of an opaque command, from the most significant bit:
+//   layer (2) | state (12) | material (16) | depth (24) | unused (10)
+// and of a translucent one:
+//   layer (2) | inverted depth (24) | state (12) | material (16) | unused (10)
+uint64_t RenderQueue::Key(Layer layer, float depth, const Command& command) {
+  // The bits of a non-negative float are ordered like the floats themselves.
+  uint32_t depth_bits = 0;
+  if (depth > 0) {
+    std::memcpy(&depth_bits, &depth, sizeof depth_bits);
+  }
+  uint64_t depth_key = depth_bits >> 8;
+
+  uint64_t material_key = 0;
+  if (command.material.owner) {
+    uintptr_t owner = reinterpret_cast<uintptr_t>(command.material.owner);
+    material_key = ((owner >> 4) * 31 + command.material.index) & 0xFFFF;
+  }
+
+  uint64_t state_key = command.state->id();
+  uint64_t key = uint64_t(layer) << 62;
+  if (layer == kOpaque) {
+    key |= state_key << 50 | material_key << 34 | depth_key << 10;
+  } else {
+    key |= (0xFFFFFF - depth_key) << 38 | state_key << 26 | material_key << 10;
+  }
+
+  return key;
+}
+
+void RenderQueue::push(Layer layer, float depth, const Command& command) {
+  keys_.push_back(std::make_pair(Key(layer, depth, command),
+                                 static_cast<uint32_t>(commands_.size())));
+  commands_.push_back(command);
+}
+
+void RenderQueue::append(RenderQueue* other) {
+  uint32_t offset = static_cast<uint32_t>(commands_.size());
+  for (const auto& key : other->keys_) {
+    keys_.push_back(std::make_pair(key.first, key.second + offset));
+  }
+  commands_.insert(commands_.end(), other->commands_.begin(),
+                   other->commands_.end());
+  other->commands_.clear();
+  other->keys_.clear();
+}
+
+// LSD radix sort, a byte at a time. The passes, in which every key has the
+// same byte, are skipped. It is stable, so the commands with the same key
+// keep their order.
+void RenderQueue::sortKeys() {
+  sort_buffer_.resize(keys_.size());
+  for (unsigned shift = 0; shift < 64; shift += 8) {
+    size_t counts[256] = {0};
+    for (const auto& key : keys_) {
+      counts[(key.first >> shift) & 0xFF]++;
+    }
+    if (counts[(keys_[0].first >> shift) & 0xFF] == keys_.size()) {
+      continue;
+    }
+
+    size_t offset = 0;
+    for (size_t& count : counts) {
+      size_t bucket_size = count;
+      count = offset;
+      offset += bucket_size;
+    }
+    for (const auto& key : keys_) {
+      sort_buffer_[counts[(key.first >> shift) & 0xFF]++] = key;
+    }
+    keys_.swap(sort_buffer_);
+  }
+}
+
+void RenderQueue::execute(const Camera& camera) {
+  stats_ = Stats{};
+  if (commands_.empty()) { return; }
+  ENGINE_PROFILE_SCOPE("execute queue");
+
+  sortKeys();
+
+  // The capabilities are restored after the queue is drawn.
+  gl::TemporarySet capabilities{{{gl::kBlend, false},
+                                 {gl::kCullFace, false}}};
+  gl::BlendFunc(gl::kSrcAlpha, gl::kOneMinusSrcAlpha);
+  unsigned flags = 0;
+
+  const State* state = nullptr;
+  const ShaderProgram* program = nullptr;
+  Material material{nullptr, 0, nullptr, nullptr};
+
+  for (const auto& key : keys_) {
+    const Command& command = commands_[key.second];
+
+    if (command.state != state) {
+      state = command.state;
+      if (state->program() != program) {
+        program = state->program();
+        gl::Use(*program);
+        program->update();
+        stats_.program_switches++;
+      }
+
+      unsigned changed = flags ^ state->flags();
+      if (changed & kBlend) {
+        if (state->flags() & kBlend) {
+          gl::Enable(gl::kBlend);
+        } else {
+          gl::Disable(gl::kBlend);
+        }
+      }
+      if (changed & kCullFace) {
+        if (state->flags() & kCullFace) {
+          gl::Enable(gl::kCullFace);
+        } else {
+          gl::Disable(gl::kCullFace);
+        }
+      }
+      flags = state->flags();
+
+      state->setup(camera);
+      stats_.state_changes++;
+    }
+
+    if (command.material != material) {
+      if (material.owner) {
+        stats_.texture_binds += material.unbind(material.owner, material.index);
+      }
+      material = command.material;
+      if (material.owner) {
+        stats_.texture_binds += material.bind(material.owner, material.index);
+      }
+    }
+
+    command.draw(command, camera);
+    stats_.draws++;
+  }
+
+  if (material.owner) {
+    stats_.texture_binds += material.unbind(material.owner, material.index);
+  }
+  gl::Unbind(gl::kVertexArray);
+
+  commands_.clear();
+  keys_.clear();
+}
+
+}  // namespace engine
@@ -0,0 +1,139 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_RENDER_QUEUE_H_
+#define ENGINE_RENDER_QUEUE_H_
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <functional>
+
+#include "./oglwrap_config.h"
+#include "../oglwrap/oglwrap.h"
+
+#include "./shader_manager.h"
+
+namespace engine {
+
+class Camera;
+
+// Collects the draws of a pass as compact commands instead of issuing them
+// right away, sorts them by a 64 bit key, and executes them, only switching
+// the program, the capabilities and the material if they differ from the
+// previous command's. Pushing commands doesn't use OpenGL, so the draw
+// lists can be built on any thread, one queue per thread, and appended to
+// the queue, that is executed.
+class RenderQueue {
+ public:
+  enum Pass { kShadowPass, kMainPass };
+
+  // The capabilities a draw needs. The ones that aren't set are disabled.
+  enum StateFlags {
+    kBlend = 1 << 0,  // with (SrcAlpha, OneMinusSrcAlpha)
+    kCullFace = 1 << 1
+  };
+
+  // Opaque draws are sorted by state, by material, then front to back.
+  // Translucent ones are drawn after them, back to front.
+  enum Layer { kOpaque, kTranslucent };
+
+  // A program, with the capabilities its draws need. The setup function is
+  // called after the program is made current, to set the uniforms that are
+  // the same for all of its draws. It must outlive the commands using it.
+  class State {
+   public:
+    State(ShaderProgram* program, unsigned flags,
+          std::function<void(const Camera&)> setup = nullptr)
+        : program_(program), flags_(flags), setup_(std::move(setup))
+        , id_(next_id_++ & kStateIdMask) {}
+
+    ShaderProgram* program() const { return program_; }
+    unsigned flags() const { return flags_; }
+    uint64_t id() const { return id_; }
+    void setup(const Camera& camera) const {
+      if (setup_) { setup_(camera); }
+    }
+
+   private:
+    ShaderProgram* program_;
+    unsigned flags_;
+    std::function<void(const Camera&)> setup_;
+    uint64_t id_;
+
+    static std::atomic<unsigned> next_id_;
+  };
+
+  // What a draw binds besides the program, i.e. the textures of a mesh's
+  // material. bind and unbind return the number of texture (un)binds.
+  struct Material {
+    void* owner;  // nullptr if there's nothing to bind
+    unsigned index;
+    size_t (*bind)(void* owner, unsigned index);
+    size_t (*unbind)(void* owner, unsigned index);
+
+    bool operator==(const Material& other) const {
+      return owner == other.owner && index == other.index;
+    }
+    bool operator!=(const Material& other) const { return !(*this == other); }
+  };
+
+  struct Command {
+    const State* state;
+    Material material;
+    // Sets the per draw uniforms, and draws part of the mesh.
+    void (*draw)(const Command& command, const Camera& camera);
+    void* object;  // the one that pushed the command
+    void* mesh;
+    unsigned part;
+    // Per draw data.
+    glm::mat4 model_matrix;
+    glm::vec4 param;
+    // Data owned by the object, that must be valid until it is executed.
+    const void* data;
+  };
+
+  // The counters of the last execute() call.
+  struct Stats {
+    size_t draws;
+    size_t program_switches;
+    size_t state_changes;
+    size_t texture_binds;
+
+    Stats() : draws(0), program_switches(0), state_changes(0)
+            , texture_binds(0) {}
+  };
+
+  explicit RenderQueue(Pass pass = kMainPass) : pass_(pass) {}
+
+  // The pass, that the queue is executed in.
+  Pass pass() const { return pass_; }
+
+  // Queues a command, depth is its distance from the camera.
+  void push(Layer layer, float depth, const Command& command);
+
+  // Moves the commands of another queue into this one.
+  void append(RenderQueue* other);
+
+  // Sorts and draws the queued commands, and clears the queue.
+  void execute(const Camera& camera);
+
+  size_t size() const { return commands_.size(); }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  static constexpr uint64_t kStateIdMask = (1u << 12) - 1;
+
+  Pass pass_;
+  std::vector<Command> commands_;
+  // The sort keys, with the command's index.
+  std::vector<std::pair<uint64_t, uint32_t>> keys_, sort_buffer_;
+  Stats stats_;
+
+  static uint64_t Key(Layer layer, float depth, const Command& command);
+  void sortKeys();
+};
+
+}  // namespace engine
+
+#endif
@@ -7,16 +7,11 @@ namespace engine {
 
 Scene::Scene()
     : GameObject(nullptr)
+    , physics_target_time_(0), physics_time_(0), physics_alpha_(1)
     , physics_thread_should_quit_(false)
-    , physics_thread_{[this](){
-      while (true) {
-        physics_can_run_.waitOne();
-        if (physics_thread_should_quit_) { return; }
-        updatePhysics();
-        physics_finished_.set();
-      }
-    }}
-    , camera_(nullptr), shadow_(nullptr), window_(GameEngine::window()) {
+    , physics_thread_{[this](){ physicsLoop(); }}
+    , camera_(nullptr), shadow_(nullptr), window_(GameEngine::window())
+    , render_target_(nullptr) {
   set_scene(this);
 }
 
@@ -24,5 +19,54 @@ ShaderManager* Scene::shader_manager() {
   return GameEngine::shader_manager();
 }
 
+void Scene::physicsLoop() {
+  std::unique_lock<std::mutex> wake_lock(physics_wake_mutex_);
+  while (true) {
+    // The target time is only advanced after the derived scene's constructor
+    // finished, so until then, neither world_ nor the virtual functions can
+    // be used. The target only changes when a frame is updated, and that
+    // notifies the thread, so it doesn't have to wake up by itself.
+    physics_wake_.wait(wake_lock, [this]() {
+      return physics_thread_should_quit_ ||
+             physics_target_time_ > physics_time_;
+    });
+    if (physics_thread_should_quit_) { break; }
+    double target_time = physics_target_time_;
+    double time_step = physics_time_step();
+    if (!world_ || physics_time_ + time_step > target_time) {
+      // Not a whole step yet, wait for the next frame.
+      physics_wake_.wait(wake_lock, [this, target_time]() {
+        return physics_thread_should_quit_ ||
+               physics_target_time_ != target_time;
+      });
+      continue;
+    }
+    wake_lock.unlock();
+
+    // If it can't keep up, the simulation slows down instead of trying to
+    // catch up with more and more steps.
+    double max_lag = kMaxPhysicsStepsBehind * time_step;
+    if (target_time - physics_time_ > max_lag) {
+      physics_time_ = target_time - max_lag;
+    }
+
+    stepPhysics(time_step);
+    wake_lock.lock();
+  }
+}
+
+void Scene::stepPhysics(double time_step) {
+  {
+    ENGINE_PROFILE_SCOPE("physics step");
+    std::lock_guard<std::recursive_mutex> lock(world_mutex_);
+    updatePhysics(time_step);
+    physics_time_ += time_step;
+    physics_snapshots_.back().capture(*world_, physics_time_, time_step,
+                                      last_physics_snapshot_);
+  }
+  last_physics_snapshot_ = physics_snapshots_.back();
+  physics_snapshots_.publish();
+}
+
 
 }  // namespace engine
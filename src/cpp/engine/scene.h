@@ -3,8 +3,14 @@
 #ifndef ENGINE_SCENE_H_
 #define ENGINE_SCENE_H_
 
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <functional>
 #include <btBulletDynamicsCommon.h>
 
 #include "./oglwrap_config.h"
@@ -12,9 +18,18 @@
 
 #include "./timer.h"
 #include "./camera.h"
+#include "./job_system.h"
 #include "./game_object.h"
 #include "./shader_manager.h"
-#include "./auto_reset_event.h"
+#include "./render_queue.h"
+#include "./frame_uniforms.h"
+#include "./component_registry.h"
+#include "./triple_buffer.h"
+#include "./physics_snapshot.h"
+#include "./frame_pipeline.h"
+#include "./frame_buffered.h"
+#include "./profiler.h"
+#include "./ecs/registry.h"
 
 #include "../shadow.h"
 
@@ -26,22 +41,59 @@ class Scene : public GameObject {
  public:
   Scene();
   virtual ~Scene() {
+    // close the physics thread, before the bodies are destroyed
+    {
+      std::lock_guard<std::mutex> lock(physics_wake_mutex_);
+      physics_thread_should_quit_ = true;
+    }
+    physics_wake_.notify_one();
+    physics_thread_.join();
+
     // The GameObject's destructor have to run here
     // as they might use the scene ptr in their destructor
     for (auto& comp_ptr : components_) {
       comp_ptr.reset();
     }
-
-    // close the physics thread
-    physics_thread_should_quit_ = true;
-    physics_can_run_.set();
-    physics_thread_.join();
   }
 
   virtual float gravity() const { return 9.81f; }
 
+  // The physics runs on its own thread, in fixed steps of this length (in
+  // seconds of game time), so its results don't depend on the frame rate.
+  // With a fixed timer step (in the benchmarks), it is stepped on the main
+  // thread instead, so that every run simulates the same states.
+  virtual double physics_time_step() const { return 1.0 / 60.0; }
+
+  // The physics thread holds world_mutex() while it steps the world, so every
+  // other access to the world (adding or removing a body, changing one that
+  // is in the world, a ray test...) must hold it too, but only for that
+  // access. The updates read the bodies' transforms from bodyTransform().
   const btDynamicsWorld* world() const { return world_.get(); }
   btDynamicsWorld* world() { return world_.get(); }
+  std::recursive_mutex& world_mutex() { return world_mutex_; }
+
+  void addRigidBody(btRigidBody* body) {
+    std::lock_guard<std::recursive_mutex> lock(world_mutex_);
+    world_->addRigidBody(body);
+  }
+
+  void removeRigidBody(btCollisionObject* body) {
+    std::lock_guard<std::recursive_mutex> lock(world_mutex_);
+    world_->removeCollisionObject(body);
+  }
+
+  // The transform of a non-static body for the current frame, interpolated
+  // between the last two physics steps. Returns false if the body wasn't
+  // simulated yet. The bodies' motion states shouldn't be used for this,
+  // as they are written by the physics thread.
+  bool bodyTransform(const btCollisionObject* body,
+                     glm::vec3* pos, glm::quat* rot) const {
+    const PhysicsSnapshot::Body* state = physics_snapshots_.front().find(body);
+    if (!state) { return false; }
+    *pos = glm::mix(state->prev_pos, state->pos, physics_alpha_);
+    *rot = glm::slerp(state->prev_rot, state->rot, physics_alpha_);
+    return true;
+  }
 
   const Timer& game_time() const { return game_time_; }
   Timer& game_time() { return game_time_; }
@@ -60,8 +112,81 @@ class Scene : public GameObject {
   Shadow* shadow() { return shadow_; }
   void set_shadow(Shadow* shadow) { shadow_ = shadow; }
 
+  // The draws queued during render() are sorted and executed after every
+  // object was rendered. It's only used on the thread that renders, the
+  // draws collected on the worker threads are appended to it before the
+  // objects are rendered.
+  RenderQueue* render_queue() { return &render_queue_; }
+  const RenderQueue::Stats& render_stats() const {
+    return render_queue_.stats();
+  }
+
+  // The camera, the time and the shadow data are filled by the scene, the
+  // other fields (i.e. the sun) by the objects in their prepareRender().
+  FrameUniforms* frame_uniforms() { return &frame_uniforms_; }
+
   ShaderManager* shader_manager();
 
+  const ComponentRegistry& component_registry() const {
+    return component_registry_;
+  }
+  ComponentRegistry& component_registry() { return component_registry_; }
+
+  // Returns an object of the scene whose type is T, without walking the
+  // scene graph. If there are more objects of this type, which one is
+  // returned is unspecified (see ComponentRegistry), so it is meant for the
+  // types, that a scene has at most one object of. Use findComponent for the
+  // first one in depth first order.
+  template<typename T>
+  T* findByType() { return component_registry_.first<T>(); }
+
+  // Returns all the objects of the scene whose type is T, in an unspecified
+  // order.
+  template<typename T>
+  const std::vector<T*>& findAllByType() {
+    return component_registry_.all<T>();
+  }
+
+  // The data-oriented storage for entities that are too numerous to be
+  // GameObjects. See ecs::EntityLink for using them from GameObjects.
+  const ecs::Registry& entities() const { return entities_; }
+  ecs::Registry& entities() { return entities_; }
+
+  // Called when the set of objects that handle the hooks might have changed
+  // (an object was added, removed, enabled or disabled).
+  void invalidateHookLists() { dirty_hook_lists_ = kAllHooks; }
+
+  // Called by the destructor of the objects of the scene.
+  void objectDestroyed(GameObject* obj) {
+    invalidateHookLists();
+    // The render thread might still use the object, and it owns the context,
+    // that the destructors of the object's components might need. The object
+    // itself should have been removed with GameObject::removeComponent or
+    // ClearComponents, which already stopped the pipeline.
+    if (FramePipeline::IsMainThread()) { FramePipeline::Stop(); }
+    // If a hook is being dispatched, the lists might still be iterated.
+    if (dispatching_hooks_) {
+      for (auto& handlers : hook_lists_) {
+        std::replace(handlers.begin(), handlers.end(), obj,
+                     static_cast<GameObject*>(nullptr));
+      }
+      for (UpdateGroup& group : parallel_updates_) {
+        if (group.root == obj) { group.root = nullptr; }
+        std::replace(group.handlers.begin(), group.handlers.end(), obj,
+                     static_cast<GameObject*>(nullptr));
+      }
+      for (auto& handlers : frame_hook_lists_) {
+        std::replace(handlers.get().begin(), handlers.get().end(), obj,
+                     static_cast<GameObject*>(nullptr));
+      }
+    }
+  }
+
+  // The systems are run in the order they were added, every frame, after
+  // the GameObjects are updated.
+  using System = std::function<void(ecs::Registry&)>;
+  void addSystem(const System& system) { systems_.push_back(system); }
+
   GLFWwindow* window() const { return window_; }
   void set_window(GLFWwindow* window) { window_ = window; }
 
@@ -74,21 +199,62 @@ class Scene : public GameObject {
         case GLFW_KEY_F2:
           environment_time_.toggle();
           break;
+        case GLFW_KEY_F4:
+          if (Profiler::ExportChromeTrace("frame_trace.json")) {
+            std::cout << "The profile is written to frame_trace.json"
+                      << std::endl;
+          }
+          break;
         default:
           break;
       }
     }
   }
 
-  virtual void turn() {
-    physics_finished_.waitOne();
+  // If the scene's render functions only read the state, that is written in
+  // prepareRender() or into FrameBuffered members, and it doesn't call OpenGL
+  // outside of them (and of its constructor), then the frames can be
+  // rendered on a separate thread, while the next frame is simulated.
+  virtual bool pipelining_supported() const { return false; }
+
+  // Called on the main thread, when the scene becomes the current one. The
+  // constructor might run on a loader thread (see GameEngine::LoadSceneAsync),
+  // so the GLFW calls that are only allowed on the main thread (like
+  // glfwSetInputMode) should be made here.
+  virtual void activate() {}
+
+  // The framebuffer, that is bound and cleared before a frame is rendered.
+  gl::Framebuffer* render_target() const { return render_target_; }
+  void set_render_target(gl::Framebuffer* fbo) { render_target_ = fbo; }
+
+  // Simulates a frame, on the main thread.
+  void simulate() {
+    ENGINE_PROFILE_SCOPE("simulate");
     updateAll();
-    physics_can_run_.set();
+    prepareRenderAll();
+  }
+
+  // Renders the last simulated frame, on the thread that has the context.
+  void submit() {
+    ENGINE_PROFILE_SCOPE("submit");
+    if (render_target_) {
+      gl::Bind(*render_target_);
+      gl::Clear().Color().Depth();
+    }
+    frame_uniforms_.upload();
+    if (camera_) {
+      collectPasses();
+    }
     shadowRenderAll();
     renderAll();
     render2DAll();
   }
 
+  virtual void turn() {
+    simulate();
+    submit();
+  }
+
  protected:
   // Bullet classes
   std::unique_ptr<btCollisionConfiguration> collision_config_;
@@ -98,49 +264,382 @@ class Scene : public GameObject {
   std::unique_ptr<btDynamicsWorld> world_;
 
   // physics thread data
-  AutoResetEvent physics_can_run_{false}, physics_finished_{true};
-  bool physics_thread_should_quit_;
+  std::recursive_mutex world_mutex_;
+  // The game time, that the physics thread should simulate until. The
+  // thread sleeps on physics_wake_ until it is far enough ahead for a step.
+  std::atomic<double> physics_target_time_;
+  std::mutex physics_wake_mutex_;
+  std::condition_variable physics_wake_;
+  // Only used by the physics thread (or by updateAll with a fixed timer
+  // step).
+  double physics_time_;
+  PhysicsSnapshot last_physics_snapshot_;
+  // Written by the physics thread after every step, read by the main thread.
+  TripleBuffer<PhysicsSnapshot> physics_snapshots_;
+  // The interpolation factor for the current frame.
+  float physics_alpha_;
+  std::atomic<bool> physics_thread_should_quit_;
   std::thread physics_thread_;
 
+  // Don't let the physics fall behind more than this many steps, when it
+  // can't keep up with the game time.
+  static constexpr int kMaxPhysicsStepsBehind = 5;
+
+  void physicsLoop();
+  // Steps the world once, and publishes its snapshot.
+  void stepPhysics(double time_step);
+
   // Own data
   Camera* camera_;
   Shadow* shadow_;
   Timer game_time_, environment_time_, camera_time_;
   GLFWwindow* window_;
+  gl::Framebuffer* render_target_;
+  RenderQueue render_queue_;
+  RenderQueue shadow_queue_{RenderQueue::kShadowPass};
+  // The draw lists of the collector jobs, for each pass. They are kept
+  // between the frames, so their capacity is reused.
+  std::vector<RenderQueue> draw_lists_[2];
+  FrameUniforms frame_uniforms_;
+
+  ComponentRegistry component_registry_;
+
+  // For every hook, the enabled objects that override it, in depth first
+  // order. They are rebuilt lazily, when they are dispatched the next time
+  // after a change in the scene graph.
+  // The kUpdate list only has the handlers that run on the main thread, the
+  // others are in parallel_updates_.
+  std::vector<GameObject*> hook_lists_[kHookCount];
+  std::vector<UpdateGroup> parallel_updates_;
+  // The render hooks are dispatched with a copy of their lists, made when the
+  // frame was simulated, so the render thread can't see the scene change.
+  FrameBuffered<std::vector<GameObject*>> frame_hook_lists_[kRenderHookCount];
+  unsigned dirty_hook_lists_ = kAllHooks;
+  unsigned dispatching_hooks_ = 0;
+
+  void rebuildHookList(Hook hook) {
+    hook_lists_[hook].clear();
+    if (hook == kUpdate) {
+      parallel_updates_.clear();
+      collectUpdateHandlers(&hook_lists_[hook], &parallel_updates_);
+    } else {
+      collectHandlers(hook, &hook_lists_[hook]);
+    }
+    dirty_hook_lists_ &= ~(1u << hook);
+  }
+
+  template<typename Func>
+  void dispatch(Hook hook, Func func) {
+    unsigned bit = 1u << hook;
+    std::vector<GameObject*>& handlers = hook_lists_[hook];
+    if ((dirty_hook_lists_ & bit) && !(dispatching_hooks_ & bit)) {
+      rebuildHookList(hook);
+    }
+
+    unsigned was_dispatching = dispatching_hooks_;
+    dispatching_hooks_ |= bit;
+    for (size_t i = 0; i < handlers.size(); ++i) {
+      if (handlers[i]) {
+        ENGINE_PROFILE_OBJECT_SCOPE(*handlers[i]);
+        func(handlers[i]);
+      }
+    }
+    dispatching_hooks_ = was_dispatching;
+  }
+
+  // Dispatches a render hook, with the lists of the frame being rendered.
+  template<typename Func>
+  void dispatchFrame(Hook hook, Func func) {
+    // Without pipelining, an object might be destroyed while rendering.
+    bool on_main_thread = !FramePipeline::running();
+    unsigned was_dispatching = dispatching_hooks_;
+    if (on_main_thread) { dispatching_hooks_ |= 1u << hook; }
+
+    const std::vector<GameObject*>& handlers = frame_hook_lists_[hook].get();
+    for (size_t i = 0; i < handlers.size(); ++i) {
+      if (handlers[i]) {
+        ENGINE_PROFILE_OBJECT_SCOPE(*handlers[i]);
+        func(handlers[i]);
+      }
+    }
+
+    if (on_main_thread) { dispatching_hooks_ = was_dispatching; }
+  }
+
+  ecs::Registry entities_;
+  std::vector<System> systems_;
 
   virtual void updateAll() override {
+    ENGINE_PROFILE_SCOPE("update");
     game_time_.tick();
     environment_time_.tick();
     camera_time_.tick();
 
-    GameObject::updateAll();
+    if (Timer::fixed_step() > 0) {
+      // The physics thread isn't woken up, it keeps waiting for a target,
+      // but it reads physics_time_ under the lock.
+      std::lock_guard<std::mutex> lock(physics_wake_mutex_);
+      double time_step = physics_time_step();
+      while (world_ && physics_time_ + time_step <= game_time_.current) {
+        stepPhysics(time_step);
+      }
+    } else {
+      {
+        std::lock_guard<std::mutex> lock(physics_wake_mutex_);
+        physics_target_time_ = game_time_.current;
+      }
+      physics_wake_.notify_one();
+    }
+    physics_snapshots_.update();
+    const PhysicsSnapshot& snapshot = physics_snapshots_.front();
+    if (snapshot.time_step > 0) {
+      // The rendered state lags one step behind the game time.
+      physics_alpha_ = glm::clamp(
+          (game_time_.current - snapshot.time) / snapshot.time_step, 0.0, 1.0);
+    } else {
+      physics_alpha_ = 1.0f;
+    }
+
+    updateObjects();
+
+    ENGINE_PROFILE_SCOPE("systems");
+    for (auto& system : systems_) {
+      system(entities_);
+    }
+  }
+
+  // Updates the objects in depth first order. The groups of the subtrees,
+  // that declared their update thread safe, are updated on the worker
+  // threads: the ones between two serial handlers run at the same time,
+  // after the first handler, and before the second one.
+  void updateObjects() {
+    if (dirty_hook_lists_ & (1u << kUpdate)) {
+      rebuildHookList(kUpdate);
+    }
+
+    dispatching_hooks_ |= 1u << kUpdate;
+    const std::vector<GameObject*>& serial = hook_lists_[kUpdate];
+    size_t next_group = 0;
+    for (size_t i = 0; i <= serial.size(); ++i) {
+      size_t end_group = next_group;
+      while (end_group < parallel_updates_.size() &&
+             parallel_updates_[end_group].serial_index <= i) {
+        end_group++;
+      }
+      if (end_group != next_group) {
+        updateParallelGroups(next_group, end_group);
+        next_group = end_group;
+      }
+
+      if (i < serial.size() && serial[i]) {
+        ENGINE_PROFILE_OBJECT_SCOPE(*serial[i]);
+        serial[i]->update();
+      }
+    }
+    dispatching_hooks_ &= ~(1u << kUpdate);
+  }
+
+  // Updates the [begin, end) range of parallel_updates_ on the worker
+  // threads, one job per group.
+  void updateParallelGroups(size_t begin, size_t end) {
+    ENGINE_PROFILE_SCOPE("parallel update");
+
+    // The transform caches aren't thread safe, so update the ones, that are
+    // shared between the jobs, before they start reading them.
+    unsigned policy = 0;
+    for (size_t i = begin; i < end; ++i) {
+      const UpdateGroup& group = parallel_updates_[i];
+      if (group.root && group.root->parent()) {
+        group.root->parent()->transform()->worldToLocalMatrix();
+      }
+      policy |= group.policy;
+    }
+    if (camera_ && (policy & kUpdateReadsScene)) {
+      camera_->transform()->worldToLocalMatrix();
+    }
+
+    // The jobs write the FrameBuffered members of the frame being simulated.
+    size_t slot = FramePipeline::CurrentSlot();
+    JobSystem::Default().parallelFor(begin, end,
+        [this, slot](size_t first, size_t last) {
+      FramePipeline::SlotScope slot_scope{slot};
+      for (size_t i = first; i < last; ++i) {
+        for (GameObject* obj : parallel_updates_[i].handlers) {
+          if (obj) {
+            ENGINE_PROFILE_OBJECT_SCOPE(*obj);
+            obj->update();
+          }
+        }
+      }
+    });
+  }
+
+  virtual void prepareRenderAll() override {
+    ENGINE_PROFILE_SCOPE("prepareRender");
+    dispatch(kPrepareRender, [](GameObject* obj) { obj->prepareRender(); });
+
+    for (unsigned hook = 0; hook < kRenderHookCount; ++hook) {
+      if (dirty_hook_lists_ & (1u << hook)) {
+        rebuildHookList(static_cast<Hook>(hook));
+      }
+      frame_hook_lists_[hook].get() = hook_lists_[hook];
+    }
+
+    FrameUniforms::Data& frame = frame_uniforms_.data();
+    if (camera_) {
+      frame.camera_matrix = camera_->cameraMatrix();
+      frame.projection_matrix = camera_->projectionMatrix();
+      frame.camera_pos = camera_->transform()->pos();
+    }
+    frame.time = game_time_.current;
+    frame.shadow_count = 0;
+  }
+
+  // Collects the draws of the shadow and the main pass at the same time.
+  void collectPasses() {
+    RenderQueue* queues[] = {&render_queue_, &shadow_queue_};
+    size_t pass_count = 1;
+    if (shadow_) {
+      shadow_->resetSlots();
+      pass_count = 2;
+    }
+
+    // The jobs read the FrameBuffered members of the frame being rendered.
+    size_t slot = FramePipeline::CurrentSlot();
+    JobSystem::Default().parallelFor(0, pass_count,
+        [this, &queues, slot](size_t begin, size_t end) {
+      FramePipeline::SlotScope slot_scope{slot};
+      for (size_t i = begin; i < end; ++i) {
+        collectDrawsAll(queues[i]);
+      }
+    }, 1);
+  }
+
+  // Runs the collectDraws() handlers on the worker threads, each job pushing
+  // into its own list. The lists are appended to the queue in the handlers'
+  // order, so the result doesn't depend on the scheduling.
+  virtual void collectDrawsAll(RenderQueue* queue) override {
+    const std::vector<GameObject*>& handlers =
+        frame_hook_lists_[kCollectDraws].get();
+    if (handlers.empty()) { return; }
+    ENGINE_PROFILE_SCOPE("collectDraws");
+
+    JobSystem& jobs = JobSystem::Default();
+    size_t job_count = std::min(handlers.size(), jobs.concurrency());
+    std::vector<RenderQueue>& lists = draw_lists_[queue->pass()];
+    if (lists.size() < job_count) {
+      lists.resize(job_count, RenderQueue{queue->pass()});
+    }
+
+    // The jobs read the FrameBuffered members of the frame being rendered.
+    size_t slot = FramePipeline::CurrentSlot();
+    jobs.parallelFor(0, job_count,
+        [&handlers, &lists, job_count, slot](size_t begin, size_t end) {
+      FramePipeline::SlotScope slot_scope{slot};
+      for (size_t job = begin; job < end; ++job) {
+        size_t first = job * handlers.size() / job_count;
+        size_t last = (job + 1) * handlers.size() / job_count;
+        for (size_t i = first; i < last; ++i) {
+          if (handlers[i]) {
+            ENGINE_PROFILE_OBJECT_SCOPE(*handlers[i]);
+            handlers[i]->collectDraws(&lists[job]);
+          }
+        }
+      }
+    }, 1);
+
+    for (size_t job = 0; job < job_count; ++job) {
+      queue->append(&lists[job]);
+    }
   }
 
   virtual void shadowRenderAll() override {
+    ENGINE_PROFILE_SCOPE("shadowRender");
+    ENGINE_PROFILE_GPU_SCOPE("shadow pass");
     if (camera_ && shadow_) {
       shadow_->begin(); {
-        GameObject::shadowRenderAll();
+        shadow_queue_.execute(*camera_);
+        dispatchFrame(kShadowRender,
+                      [](GameObject* obj) { obj->shadowRender(); });
       } shadow_->end();
+
+      FrameUniforms::Data& frame = frame_uniforms_.data();
+      frame.shadow_count = std::min(shadow_->getDepth(),
+                                    FrameUniforms::kMaxShadowMaps);
+      std::copy(shadow_->shadowCPs().begin(),
+                shadow_->shadowCPs().begin() + frame.shadow_count,
+                frame.shadow_cp);
+      frame.shadow_atlas_size = shadow_->getAtlasDimensions();
+      frame_uniforms_.uploadShadows();
     }
   }
 
   virtual void renderAll() override {
-    if (camera_) { GameObject::renderAll(); }
+    ENGINE_PROFILE_SCOPE("render");
+    ENGINE_PROFILE_GPU_SCOPE("main pass");
+    if (camera_) {
+      dispatchFrame(kRender, [](GameObject* obj) { obj->render(); });
+      render_queue_.execute(*camera_);
+    }
   }
 
   virtual void render2DAll() override {
+    ENGINE_PROFILE_SCOPE("render2D");
+    ENGINE_PROFILE_GPU_SCOPE("2D pass");
     gl::TemporarySet capabilities{{{gl::kBlend, true},
                                    {gl::kCullFace, false},
                                    {gl::kDepthTest, false}}};
     gl::BlendFunc(gl::kSrcAlpha, gl::kOneMinusSrcAlpha);
 
-    GameObject::render2DAll();
+    dispatchFrame(kRender2D, [](GameObject* obj) { obj->render2D(); });
   }
 
-  virtual void updatePhysics() {
-    if (world_) {
-      world_->stepSimulation(game_time().dt, 0);
-    }
+ public:
+  virtual void screenResizedAll(size_t width, size_t height) override {
+    dispatch(kScreenResized, [=](GameObject* obj) {
+      obj->screenResized(width, height);
+    });
+  }
+
+  virtual void keyActionAll(int key, int scancode,
+                            int action, int mods) override {
+    dispatch(kKeyAction, [=](GameObject* obj) {
+      obj->keyAction(key, scancode, action, mods);
+    });
+  }
+
+  virtual void charTypedAll(unsigned codepoint) override {
+    dispatch(kCharTyped, [=](GameObject* obj) { obj->charTyped(codepoint); });
+  }
+
+  virtual void mouseScrolledAll(double xoffset, double yoffset) override {
+    dispatch(kMouseScrolled, [=](GameObject* obj) {
+      obj->mouseScrolled(xoffset, yoffset);
+    });
+  }
+
+  virtual void mouseButtonPressedAll(int button, int action,
+                                     int mods) override {
+    dispatch(kMouseButtonPressed, [=](GameObject* obj) {
+      obj->mouseButtonPressed(button, action, mods);
+    });
+  }
+
+  virtual void mouseMovedAll(double xpos, double ypos) override {
+    dispatch(kMouseMoved, [=](GameObject* obj) { obj->mouseMoved(xpos, ypos); });
+  }
+
+  virtual void collisionAll(const GameObject* other) override {
+    dispatch(kCollision, [=](GameObject* obj) { obj->collision(other); });
+  }
+
+ protected:
+
+  // Advances the world by one fixed step. Called on the physics thread,
+  // while holding the world_mutex(), so it runs in parallel with the update
+  // of the objects.
+  virtual void updatePhysics(double time_step) {
+    world_->stepSimulation(time_step, 0);
   }
 };
 
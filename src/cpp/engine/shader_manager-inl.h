@@ -10,12 +10,14 @@ namespace engine {
 
 template<typename... Args>
 ShaderFile* ShaderManager::load(Args&&... args) {
-  auto shader = new ShaderFile{std::forward<Args>(args)...};
-  shaders_[shader->source_file_name()] = std::unique_ptr<ShaderFile>{shader};
-  return shader;
+  std::shared_ptr<ShaderFile> shader{
+      new ShaderFile{std::forward<Args>(args)...}};
+  shaders_[shader->source_file_name()] = shader;
+  return shader.get();
 }
 
 inline ShaderFile* ShaderManager::get(const std::string& filename) {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   auto iter = shaders_.find(filename);
   if (iter != shaders_.end()) {
     return iter->second.get();
@@ -27,6 +29,7 @@ inline ShaderFile* ShaderManager::get(const std::string& filename) {
 
 inline ShaderFile* ShaderManager::publish(const std::string& filename,
                                           const gl::ShaderSource& src) {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   return load(filename, src);
 }
 
@@ -39,7 +39,7 @@ void ShaderFile::findIncludes(std::string &src) {
 
     ShaderFile *included_shader =
       GameEngine::shader_manager()->get(included_filename);
-    includes_.push_back(included_shader);
+    includes_.push_back(included_shader->shared_from_this());
 
     // Replace the include directive with the included statements
     src.replace(include_pos, line_end - include_pos,
@@ -5,6 +5,8 @@
 
 #include <map>
 #include <set>
+#include <mutex>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -17,7 +19,12 @@ namespace engine {
 class ShaderFile;
 class ShaderProgram;
 class ShaderManager {
-  std::map<std::string, std::unique_ptr<ShaderFile>> shaders_;
+  // A shader, that is replaced by publish(), is kept alive by the programs
+  // and the shaders that include it, until they are destroyed.
+  std::map<std::string, std::shared_ptr<ShaderFile>> shaders_;
+  // A scene might be loaded on a loader thread, while the current one runs.
+  // It's recursive, as the included files are loaded by the ShaderFiles.
+  std::recursive_mutex mutex_;
   template<typename... Args>
   ShaderFile* load(Args&&... args);
  public:
@@ -25,7 +32,8 @@ class ShaderManager {
   ShaderFile* get(const std::string& filename);
 };
 
-class ShaderFile : public gl::Shader {
+class ShaderFile : public gl::Shader
+                 , public std::enable_shared_from_this<ShaderFile> {
  private:
   gl::ShaderType shader_type(const std::string& filename) {
     size_t dot_position = filename.find_last_of('.');
@@ -53,7 +61,7 @@ class ShaderFile : public gl::Shader {
       : gl::Shader(shader_type(filename)) {
     std::string src_str = src.source();
     findIncludes(src_str);
-    for (ShaderFile *included : includes_) {
+    for (const auto& included : includes_) {
       if (included->state_ == gl::Shader::kCompileFailure) {
         state_ = gl::Shader::kCompileFailure;
         return;
@@ -79,7 +87,7 @@ class ShaderFile : public gl::Shader {
 
  private:
   std::function<void(const gl::Program&)> update_func_;
-  std::vector<ShaderFile*> includes_;
+  std::vector<std::shared_ptr<ShaderFile>> includes_;
   std::string exports_;
 
   void findExports(std::string &src);
@@ -102,7 +110,7 @@ class ShaderProgram : public gl::Program {
   ShaderProgram(ShaderProgram&& prog) = default;
 
   void update() const {
-    for (auto shader : shaders_) {
+    for (const auto& shader : shaders_) {
       shader->update(*this);
     }
   }
@@ -119,16 +127,16 @@ class ShaderProgram : public gl::Program {
 
   // Depth First Search for all the included files, recursively
   ShaderProgram& attachShader(ShaderFile *shader) {
-    if (shaders_.insert(shader).second) {
-      for (auto include : shader->includes_) {
-        attachShader(include);
+    if (shaders_.insert(shader->shared_from_this()).second) {
+      for (const auto& include : shader->includes_) {
+        attachShader(include.get());
       }
     }
     return *this;
   }
 
   virtual const Program& link() override {
-    for (auto shader_file : shaders_) {
+    for (const auto& shader_file : shaders_) {
       const gl::Shader& shader = *shader_file;
       gl::Program::attachShader(shader);
     }
@@ -138,7 +146,7 @@ class ShaderProgram : public gl::Program {
   }
 
  private:
-  std::set<ShaderFile*> shaders_;
+  std::set<std::shared_ptr<ShaderFile>> shaders_;
 };
 
 }  // namespace engine
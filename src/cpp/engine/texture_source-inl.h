@@ -11,7 +11,54 @@ namespace engine {
 
 template<typename T, char NUM_COMPONENTS>
 TextureSource<T, NUM_COMPONENTS>::TextureSource(const std::string& file_name,
-                                                std::string format_string) {
+                                                std::string format_string)
+    : memory_(MemoryStats::kCpu, "texture sources", file_name) {
+  parseFormatString(format_string);
+
+  Magick::Image image(file_name);
+  w_ = image.columns();
+  h_ = image.rows();
+  data_.resize(w_ * h_);
+  memory_.set_bytes(data_.size() * sizeof(data_[0]));
+
+  MagickCore::StorageType type = MagickCore::UndefinedPixel;
+  if (std::is_same<T, char>::value ||
+     std::is_same<T, unsigned char>::value) {
+    type = MagickCore::CharPixel;
+  } else if (std::is_same<T, short>::value ||
+     std::is_same<T, unsigned short>::value) {
+    type = MagickCore::ShortPixel;
+  } else if (std::is_same<T, int>::value ||
+     std::is_same<T, unsigned int>::value) {
+    type = MagickCore::IntegerPixel;
+  } else if (std::is_same<T, long>::value ||
+     std::is_same<T, unsigned long>::value) {
+    type = MagickCore::LongPixel;
+  } else if (std::is_same<T, float>::value) {
+    type = MagickCore::FloatPixel;
+  } else if (std::is_same<T, double>::value) {
+    type = MagickCore::FloatPixel;
+  } else {
+    abort();
+  }
+
+  image.write(0, 0, w_, h_, format_string_, type, data_.data());
+}
+
+template<typename T, char NUM_COMPONENTS>
+TextureSource<T, NUM_COMPONENTS>::TextureSource(
+    int w, int h, std::vector<std::array<T, NUM_COMPONENTS>> data,
+    std::string format_string)
+    : data_(std::move(data)), w_(w), h_(h)
+    , memory_(MemoryStats::kCpu, "texture sources", "generated",
+              data_.size() * sizeof(data_[0])) {
+  assert(data_.size() == size_t(w_) * h_);
+  parseFormatString(format_string);
+}
+
+template<typename T, char NUM_COMPONENTS>
+void TextureSource<T, NUM_COMPONENTS>::parseFormatString(
+    std::string format_string) {
   // Preprocess format_string: 'S', 'C' and 'I' have special meaning
   size_t s_pos = format_string.find('S');
   if(s_pos != std::string::npos) {
@@ -42,34 +89,6 @@ TextureSource<T, NUM_COMPONENTS>::TextureSource(const std::string& file_name,
 
   assert(NUM_COMPONENTS <= 4);
   assert(format_string.length() == NUM_COMPONENTS);
-
-  Magick::Image image(file_name);
-  w_ = image.columns();
-  h_ = image.rows();
-  data_.resize(w_ * h_);
-
-  MagickCore::StorageType type = MagickCore::UndefinedPixel;
-  if (std::is_same<T, char>::value ||
-     std::is_same<T, unsigned char>::value) {
-    type = MagickCore::CharPixel;
-  } else if (std::is_same<T, short>::value ||
-     std::is_same<T, unsigned short>::value) {
-    type = MagickCore::ShortPixel;
-  } else if (std::is_same<T, int>::value ||
-     std::is_same<T, unsigned int>::value) {
-    type = MagickCore::IntegerPixel;
-  } else if (std::is_same<T, long>::value ||
-     std::is_same<T, unsigned long>::value) {
-    type = MagickCore::LongPixel;
-  } else if (std::is_same<T, float>::value) {
-    type = MagickCore::FloatPixel;
-  } else if (std::is_same<T, double>::value) {
-    type = MagickCore::FloatPixel;
-  } else {
-    abort();
-  }
-
-  image.write(0, 0, w_, h_, format_string_, type, data_.data());
 }
 
 template<typename T, char NUM_COMPONENTS>
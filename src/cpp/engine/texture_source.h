@@ -10,6 +10,7 @@
 #include "./oglwrap_config.h"
 #include "../oglwrap/textures/texture_2D.h"
 #include "../oglwrap/context.h"
+#include "./memory_stats.h"
 
 namespace engine {
 
@@ -19,6 +20,10 @@ class TextureSource {
   std::string format_string_;
   std::vector<std::array<T, NUM_COMPONENTS>> data_;
   int w_, h_;
+  MemoryStats::Allocation memory_;
+
+  // Processes the 'S', 'C' and 'I' flags, and stores the rest.
+  void parseFormatString(std::string format_string);
 
  public:
   // Loads in a texture from a file
@@ -29,6 +34,11 @@ class TextureSource {
   TextureSource(const std::string& file_name,
                 std::string format_string = "CSRGBA");
 
+  // Uses already loaded (or generated) data, of w*h texels in row major
+  // order, with the same format string as above.
+  TextureSource(int w, int h, std::vector<std::array<T, NUM_COMPONENTS>> data,
+                std::string format_string = "CSRGBA");
+
   virtual ~TextureSource() {}
 
   // getters
@@ -19,15 +19,19 @@ class Timer {
 
   double tick() {
     if (!stopped_) {
-      double time = glfwGetTime();
-      if (last_time_ != 0) {
-        dt = time - last_time_;
-        // we don't want to take really big bursts into account.
-        if (dt > 0.5) {
-          dt = 0;
+      if (FixedStep() > 0) {
+        dt = FixedStep();
+      } else {
+        double time = glfwGetTime();
+        if (last_time_ != 0) {
+          dt = time - last_time_;
+          // we don't want to take really big bursts into account.
+          if (dt > 0.5) {
+            dt = 0;
+          }
         }
+        last_time_ = time;
       }
-      last_time_ = time;
       current += dt;
     }
     return current;
@@ -50,6 +54,17 @@ class Timer {
       stop();
     }
   }
+
+  // If it is positive, every timer advances by this much per tick, instead
+  // of the real elapsed time (i.e. for reproducible benchmarks).
+  static double fixed_step() { return FixedStep(); }
+  static void set_fixed_step(double step) { FixedStep() = step; }
+
+ private:
+  static double& FixedStep() {
+    static double step = 0;
+    return step;
+  }
 };
 
 }  // namespace engine
@@ -35,21 +35,130 @@ class Transformation {
   vec3 pos_, scale_;
   quat rot_;
 
+  // Should be called after every modification of pos_, rot_ or scale_.
+  void markDirty() {
+    local_dirty_ = true;
+    invalidateWorld();
+  }
+
+ private:
+  // The matrices are cached, and only recalculated if this transform, or one
+  // of its ancestors changed. A modification marks the world matrix of the
+  // whole subtree dirty, but it stops at the nodes that are already dirty, as
+  // their descendants must be dirty too. So a query of a clean transform
+  // doesn't have to look at its ancestors. The caches are updated lazily by
+  // the const getters, so they aren't thread safe: don't read a transform on
+  // multiple threads while it or any of its ancestors might be modified or
+  // read for the first time.
+  mutable mat4 local_mat_, world_mat_, inv_world_mat_;
+  mutable quat world_rot_;
+  mutable bool local_dirty_, world_dirty_, inv_dirty_;
+  mutable unsigned long version_;
+  std::vector<Transformation*> children_;
+
+  void invalidateWorld() {
+    if (!world_dirty_) {
+      world_dirty_ = true;
+      for (Transformation* child : children_) {
+        child->invalidateWorld();
+      }
+    }
+  }
+
+  void addChild(Transformation* child) {
+    children_.push_back(child);
+  }
+
+  void removeChild(Transformation* child) {
+    auto iter = std::find(children_.begin(), children_.end(), child);
+    assert(iter != children_.end());
+    *iter = children_.back();
+    children_.pop_back();
+  }
+
+  void updateCache() const {
+    if (!world_dirty_) {
+      return;
+    }
+
+    if (local_dirty_) {
+      local_mat_ = glm::scale(glm::mat4_cast(rot_), scale_);
+      local_mat_[3] = vec4(pos_, 1);
+      local_dirty_ = false;
+    }
+
+    if (parent_) {
+      parent_->updateCache();
+      world_mat_ = parent_->world_mat_ * local_mat_;
+      world_rot_ = parent_->rot() * rot_;
+    } else {
+      world_mat_ = local_mat_;
+      world_rot_ = rot_;
+    }
+    version_++;
+    world_dirty_ = false;
+    inv_dirty_ = true;
+  }
+
  public:
   Transformation(Transformation* parent = nullptr)
       : parent_(parent)
-      , scale_(1, 1, 1) {
+      , scale_(1, 1, 1)
+      , local_dirty_(true), world_dirty_(true), inv_dirty_(true)
+      , version_(0) {
     assert(parent != this);
+    if (parent_) { parent_->addChild(this); }
+  }
+
+  // A copy has the same parent and local transformation, but no children.
+  Transformation(const Transformation& other)
+      : parent_(other.parent_)
+      , pos_(other.pos_), scale_(other.scale_), rot_(other.rot_)
+      , local_dirty_(true), world_dirty_(true), inv_dirty_(true)
+      , version_(0) {
+    if (parent_) { parent_->addChild(this); }
   }
 
-  virtual ~Transformation() {}
+  Transformation& operator=(const Transformation& other) {
+    if (this != &other) {
+      set_parent(other.parent_);
+      pos_ = other.pos_;
+      scale_ = other.scale_;
+      rot_ = other.rot_;
+      markDirty();
+    }
+    return *this;
+  }
 
-  void set_parent(Transformation* parent) { parent_ = parent; }
+  // The children are left without a parent.
+  virtual ~Transformation() {
+    if (parent_) { parent_->removeChild(this); }
+    for (Transformation* child : children_) {
+      child->parent_ = nullptr;
+      child->invalidateWorld();
+    }
+  }
+
+  void set_parent(Transformation* parent) {
+    assert(parent != this);
+    if (parent_ == parent) { return; }
+    if (parent_) { parent_->removeChild(this); }
+    parent_ = parent;
+    if (parent_) { parent_->addChild(this); }
+    invalidateWorld();
+  }
   Transformation* parent() const { return parent_; }
 
+  // Increases every time the world matrix is recalculated.
+  unsigned long version() const {
+    updateCache();
+    return version_;
+  }
+
   virtual const vec3 pos() const {
     if (parent_) {
-      return vec3{parent_->localToWorldMatrix() * vec4{pos_, 1}};
+      updateCache();
+      return vec3{world_mat_[3]};
     } else {
       return pos_;
     }
@@ -62,6 +171,7 @@ class Transformation {
     } else {
       pos_ = new_pos;
     }
+    markDirty();
   }
 
   const vec3& local_pos() const {
@@ -70,11 +180,13 @@ class Transformation {
 
   virtual void set_local_pos(const vec3& new_pos) {
     pos_ = new_pos;
+    markDirty();
   }
 
   virtual const vec3 scale() const {
     if (parent_) {
-      return mat3(parent_->localToWorldMatrix()) * scale_;
+      parent_->updateCache();
+      return mat3(parent_->world_mat_) * scale_;
     } else {
       return scale_;
     }
@@ -86,6 +198,7 @@ class Transformation {
     } else {
       scale_ = new_scale;
     }
+    markDirty();
   }
 
   const vec3& local_scale() const {
@@ -94,11 +207,13 @@ class Transformation {
 
   virtual void set_local_scale(const vec3& new_scale) {
     scale_ = new_scale;
+    markDirty();
   }
 
   virtual const quat rot() const {
     if (parent_) {
-      return parent_->rot() * rot_;
+      updateCache();
+      return world_rot_;
     } else {
       return rot_;
     }
@@ -110,6 +225,7 @@ class Transformation {
     } else {
       rot_ = new_rot;
     }
+    markDirty();
   }
 
   const quat& local_rot() const {
@@ -118,6 +234,7 @@ class Transformation {
 
   virtual void set_local_rot(const quat& new_rot) {
     rot_ = new_rot;
+    markDirty();
   }
 
   // Sets the rotation, so that 'local_space_vec' in local space will be
@@ -194,18 +311,22 @@ class Transformation {
   }
 
   mat4 worldToLocalMatrix() const {
-    return glm::inverse(localToWorldMatrix());
+    updateCache();
+    if (inv_dirty_) {
+      inv_world_mat_ = glm::inverse(world_mat_);
+      inv_dirty_ = false;
+    }
+    return inv_world_mat_;
   }
 
   virtual mat4 localToWorldMatrix() const {
-    mat4 local_transf = glm::scale(glm::mat4_cast(rot_), scale_);
-    local_transf[3] = vec4(pos_, 1);
+    updateCache();
+    return world_mat_;
+  }
 
-    if (parent_) {
-      return parent_->localToWorldMatrix() * local_transf;
-    } else {
-      return local_transf;
-    }
+  mat4 localMatrix() const {
+    updateCache();
+    return local_mat_;
   }
 
   // To help the users to decide which matrix they need, in case of confusion
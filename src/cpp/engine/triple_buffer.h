@@ -0,0 +1,48 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef ENGINE_TRIPLE_BUFFER_H_
+#define ENGINE_TRIPLE_BUFFER_H_
+
+#include <atomic>
+
+namespace engine {
+
+// Passes values from one producer thread to one consumer thread without
+// locking. The producer fills back() and publishes it, the consumer calls
+// update() to move the latest published value to front(). Neither side ever
+// waits for the other, values published between two updates are dropped.
+template<typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() : back_(0), middle_(1), front_(2) {}
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  // Producer side.
+  T& back() { return buffers_[back_]; }
+  void publish() { back_ = middle_.exchange(back_ | kFresh) & kIndexMask; }
+
+  // Consumer side. Returns if there was a newly published value.
+  bool update() {
+    if (!(middle_.load() & kFresh)) { return false; }
+    front_ = middle_.exchange(front_) & kIndexMask;
+    return true;
+  }
+  const T& front() const { return buffers_[front_]; }
+  T& front() { return buffers_[front_]; }
+
+ private:
+  // middle_ stores the index of the buffer that is passed between the two
+  // threads, and whether it has a value that the consumer hasn't seen yet.
+  static constexpr unsigned kIndexMask = 3, kFresh = 4;
+
+  T buffers_[3];
+  unsigned back_;
+  std::atomic<unsigned> middle_;
+  unsigned front_;
+};
+
+}  // namespace engine
+
+#endif
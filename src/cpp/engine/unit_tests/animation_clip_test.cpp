@@ -0,0 +1,99 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Compresses a generated animation, and checks the errors, that the
+// compression reports, the size of the clip, and the decoded pose.
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../mesh/animation_clip.h"
+
+size_t fail_num = 0;
+
+void Assert(bool condition, const std::string& msg) {
+  if (!condition) {
+    std::cout << "Failed: " + msg << std::endl;
+    fail_num++;
+  }
+}
+
+constexpr unsigned kChannelCount = 32;
+constexpr unsigned kKeyCount = 120;
+
+// Every odd channel only rotates, the others move, rotate, and scale too.
+aiAnimation* MakeAnimation() {
+  aiAnimation* animation = new aiAnimation{};
+  animation->mDuration = kKeyCount - 1;
+  animation->mTicksPerSecond = 30;
+  animation->mNumChannels = kChannelCount;
+  animation->mChannels = new aiNodeAnim*[kChannelCount];
+  for (unsigned c = 0; c < kChannelCount; ++c) {
+    aiNodeAnim* channel = new aiNodeAnim{};
+    bool moves = c % 2 == 0;
+    channel->mNumPositionKeys = channel->mNumScalingKeys = kKeyCount;
+    channel->mNumRotationKeys = kKeyCount;
+    channel->mPositionKeys = new aiVectorKey[kKeyCount];
+    channel->mRotationKeys = new aiQuatKey[kKeyCount];
+    channel->mScalingKeys = new aiVectorKey[kKeyCount];
+    for (unsigned k = 0; k < kKeyCount; ++k) {
+      float phase = 0.1f * k + c;
+      channel->mPositionKeys[k].mTime = k;
+      channel->mPositionKeys[k].mValue = moves
+          ? aiVector3D(10 * std::sin(phase), 1, std::cos(phase))
+          : aiVector3D(0, 2, 0);
+      channel->mRotationKeys[k].mTime = k;
+      channel->mRotationKeys[k].mValue =
+          aiQuaternion(aiVector3D(0.6f, 0.8f, 0), phase);
+      channel->mScalingKeys[k].mTime = k;
+      channel->mScalingKeys[k].mValue = moves
+          ? aiVector3D(1, 1 + 0.1f * std::sin(phase), 1)
+          : aiVector3D(1, 1, 1);
+    }
+    animation->mChannels[c] = channel;
+  }
+  return animation;
+}
+
+int main() {
+  aiAnimation* animation = MakeAnimation();
+  // The last node isn't animated.
+  std::vector<const aiNodeAnim*> channels(animation->mChannels,
+                                          animation->mChannels + kChannelCount);
+  channels.push_back(nullptr);
+
+  engine::AnimationClip::Stats stats;
+  engine::AnimationClip clip{animation, channels,
+                             engine::AnimationClip::kDefaultSampleRate, &stats};
+
+  Assert(clip.duration() == kKeyCount - 1, "duration");
+  Assert(stats.compressed_size * 5 <= stats.source_size,
+         "the clip is at least 5 times smaller");
+  Assert(stats.max_translation_error < 1e-2f, "translation error");
+  Assert(stats.max_rotation_error < 1e-2f, "rotation error");
+  Assert(stats.max_scale_error < 1e-3f, "scale error");
+  Assert(clip.animates(0) && !clip.animates(kChannelCount), "animated nodes");
+
+  engine::LocalPose pose;
+  pose.resize(channels.size());
+  clip.samplePose(10.5f, &pose);
+  Assert(pose.animated[1] && !pose.animated[kChannelCount], "pose flags");
+  Assert(pose.translations[1] == glm::vec3(0, 2, 0),
+         "constant tracks are exact");
+  // Halfway between the 10th and the 11th key.
+  glm::vec3 expected = glm::mix(
+      glm::vec3(10 * std::sin(1.0f), 1, std::cos(1.0f)),
+      glm::vec3(10 * std::sin(1.1f), 1, std::cos(1.1f)), 0.5f);
+  Assert(glm::length(pose.translations[0] - expected) < 1e-2f,
+         "decoded translation");
+
+  delete animation;
+
+  if (fail_num == 0) {
+    std::cout << "All tests passed." << std::endl;
+  } else {
+    std::cout << fail_num << " tests failed." << std::endl;
+  }
+  return fail_num != 0;
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Encodes bone transformations, and decodes them the same way as the
+// skinning shaders do, for every encoding.
+
+#include <iostream>
+#include <string>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../mesh/bone_encoding.h"
+
+using engine::BoneEncoding;
+
+size_t fail_num = 0;
+
+void Assert(bool condition, const std::string& msg) {
+  if (!condition) {
+    std::cout << "Failed: " + msg << std::endl;
+    fail_num++;
+  }
+}
+
+bool Near(const glm::mat4& a, const glm::mat4& b) {
+  for (int i = 0; i < 4; ++i) {
+    if (glm::length(a[i] - b[i]) > 1e-4f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The getBoneMatrix() of ayumi.vert, for a single bone.
+glm::mat4 Decode(BoneEncoding encoding, const glm::vec4* bone) {
+  switch (encoding) {
+    case BoneEncoding::kMat4:
+      return glm::mat4(bone[0], bone[1], bone[2], bone[3]);
+    case BoneEncoding::kMat3x4:
+      return glm::transpose(glm::mat4(bone[0], bone[1], bone[2],
+                                      glm::vec4(0, 0, 0, 1)));
+    case BoneEncoding::kDualQuaternion: {
+      glm::vec4 r = bone[0] / glm::length(bone[0]);
+      glm::vec4 d = bone[1] / glm::length(bone[0]);
+      glm::vec3 t = 2.0f * (r.w * glm::vec3(d) - d.w * glm::vec3(r) +
+                            glm::cross(glm::vec3(r), glm::vec3(d)));
+      float x = r.x, y = r.y, z = r.z, w = r.w;
+      return glm::mat4(
+        1 - 2*(y*y + z*z), 2*(x*y + w*z), 2*(x*z - w*y), 0,
+        2*(x*y - w*z), 1 - 2*(x*x + z*z), 2*(y*z + w*x), 0,
+        2*(x*z + w*y), 2*(y*z - w*x), 1 - 2*(x*x + y*y), 0,
+        t.x, t.y, t.z, 1);
+    }
+  }
+  return glm::mat4();
+}
+
+int main() {
+  glm::mat4 rigid = glm::rotate(
+      glm::translate(glm::mat4(), glm::vec3(1, -2, 3)),
+      2.5f, glm::normalize(glm::vec3(1, 2, -1)));
+  glm::mat4 scaled = glm::scale(rigid, glm::vec3(2, 2, 2));
+
+  Assert(engine::BoneEncodingSize(BoneEncoding::kMat4) == 4, "mat4 size");
+  Assert(engine::BoneEncodingSize(BoneEncoding::kMat3x4) == 3, "mat3x4 size");
+  Assert(engine::BoneEncodingSize(BoneEncoding::kDualQuaternion) == 2,
+         "dual quaternion size");
+
+  glm::vec4 bone[4];
+  for (BoneEncoding encoding : {BoneEncoding::kMat4, BoneEncoding::kMat3x4,
+                                BoneEncoding::kDualQuaternion}) {
+    engine::EncodeBone(encoding, rigid, bone);
+    Assert(Near(Decode(encoding, bone), rigid),
+           "rigid transformation, encoding " + std::to_string(int(encoding)));
+  }
+
+  engine::EncodeBone(BoneEncoding::kMat3x4, scaled, bone);
+  Assert(Near(Decode(BoneEncoding::kMat3x4, bone), scaled),
+         "the 3x4 matrices keep the scaling");
+  engine::EncodeBone(BoneEncoding::kDualQuaternion, scaled, bone);
+  Assert(Near(Decode(BoneEncoding::kDualQuaternion, bone), rigid),
+         "the dual quaternions drop the scaling");
+
+  if (fail_num == 0) {
+    std::cout << "All tests passed." << std::endl;
+  } else {
+    std::cout << fail_num << " tests failed." << std::endl;
+  }
+  return fail_num != 0;
+}
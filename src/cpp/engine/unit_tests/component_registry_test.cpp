@@ -0,0 +1,113 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Checks that the indices of the component registry follow the objects, that
+// are added and removed (even from their destructors), and the order of the
+// found objects.
+
+#include <memory>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "../component_registry.h"
+
+size_t fail_num = 0;
+
+void Assert(bool condition, const std::string& msg) {
+  if (!condition) {
+    std::cout << "Failed: " + msg << std::endl;
+    fail_num++;
+  }
+}
+
+struct Object;
+using Registry = engine::BasicComponentRegistry<Object>;
+
+// Like GameObject, it unregisters itself in its destructor.
+struct Object {
+  Registry* registry;
+  explicit Object(Registry* registry) : registry(registry) {}
+  virtual ~Object() { registry->remove(this); }
+};
+
+struct Light : Object { using Object::Object; };
+struct Sun : Light { using Light::Light; };
+struct Tree : Object { using Object::Object; };
+
+template<typename T>
+bool Contains(const std::vector<T*>& found, const T* obj) {
+  return std::find(found.begin(), found.end(), obj) != found.end();
+}
+
+void IndexTest() {
+  Registry registry;
+  std::unique_ptr<Object> tree1{new Tree{&registry}};
+  std::unique_ptr<Object> sun{new Sun{&registry}};
+  registry.add(tree1.get());
+  registry.add(sun.get());
+  registry.add(sun.get());
+
+  // The index is built at the first query.
+  Assert(registry.all<Tree>().size() == 1, "Index built from the objects");
+  Assert(registry.first<Light>() == sun.get(), "Found through the base class");
+  Assert(registry.all<Sun>().size() == 1, "Added twice");
+
+  // Then it is updated.
+  std::unique_ptr<Object> tree2{new Tree{&registry}};
+  std::unique_ptr<Object> tree3{new Tree{&registry}};
+  registry.add(tree2.get());
+  registry.add(tree3.get());
+  const std::vector<Tree*>& trees = registry.all<Tree>();
+  Assert(trees.size() == 3, "Index updated");
+  Assert(trees[0] == tree1.get() && trees[1] == tree2.get() &&
+         trees[2] == tree3.get(), "Registration order");
+
+  // Removing swaps the last one into the hole.
+  registry.remove(tree1.get());
+  Assert(trees.size() == 2 && trees[0] == tree3.get() &&
+         trees[1] == tree2.get(), "Swap remove");
+
+  // The objects are removed from their destructors, when their dynamic type
+  // is already the base class.
+  tree3.reset();
+  Assert(trees.size() == 1 && trees[0] == tree2.get(), "Destroyed object");
+  sun.reset();
+  Assert(registry.first<Light>() == nullptr, "Destroyed sun");
+  Assert(registry.all<Sun>().empty(), "Destroyed sun");
+
+  // A removed object can be added again.
+  registry.add(tree1.get());
+  Assert(registry.all<Tree>().size() == 2, "Added again");
+  Assert(Contains(registry.all<Tree>(), static_cast<Tree*>(tree1.get())),
+         "Added again");
+}
+
+// Every object is removed in constant time, so the teardown of a large
+// scene is linear.
+void TeardownTest() {
+  Registry registry;
+  std::vector<std::unique_ptr<Object>> objects;
+  for (int i = 0; i < 100000; ++i) {
+    Object* obj = i % 2 ? static_cast<Object*>(new Tree{&registry})
+                        : static_cast<Object*>(new Light{&registry});
+    objects.emplace_back(obj);
+    registry.add(obj);
+  }
+  Assert(registry.all<Tree>().size() == 50000, "Large index");
+  Assert(registry.all<Light>().size() == 50000, "Large index");
+
+  objects.clear();
+  Assert(registry.all<Tree>().empty(), "Teardown");
+  Assert(registry.all<Light>().empty(), "Teardown");
+}
+
+int main() {
+  IndexTest();
+  TeardownTest();
+
+  if (fail_num) {
+    std::cout << "Number of failures: " << fail_num << std::endl;
+  } else {
+    std::cout << "Test was successful" << std::endl;
+  }
+}
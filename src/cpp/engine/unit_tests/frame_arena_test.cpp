@@ -0,0 +1,68 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Checks the frame arena's allocations, and that a frame that is repeated
+// doesn't touch the heap once the arena warmed up (if the allocations are
+// counted).
+
+#include <cstdint>
+#include <iostream>
+
+#include "../frame_arena.h"
+#include "../allocation_counter.h"
+
+size_t fail_num = 0;
+
+void Assert(bool condition, const std::string& msg) {
+  if (!condition) {
+    std::cout << "Failed: " + msg << std::endl;
+    fail_num++;
+  }
+}
+
+// Something like what a label does with its text.
+void SimulateFrame(size_t vertex_count) {
+  engine::FrameVector<float> vertices;
+  for (size_t i = 0; i < vertex_count; ++i) {
+    vertices.push_back(i);
+  }
+  engine::FrameVector<double> other(vertex_count / 2, 1.0);
+  engine::FrameArena::ThreadLocal().reset();
+}
+
+int main() {
+  engine::FrameArena arena{1024};
+
+  void* a = arena.allocate(10, 1);
+  void* b = arena.allocate(8, 8);
+  Assert(reinterpret_cast<uintptr_t>(b) % 8 == 0, "alignment");
+  Assert(static_cast<char*>(b) >= static_cast<char*>(a) + 10, "overlap");
+
+  // Doesn't fit in the first block.
+  arena.allocate(4000, 16);
+  Assert(arena.capacity() > 1024, "the arena grows");
+  size_t capacity = arena.capacity();
+  arena.reset();
+  Assert(arena.used() == 0, "the reset frees everything");
+  Assert(arena.capacity() == capacity, "the blocks are merged on reset");
+  void* c = arena.allocate(4000, 16);
+  Assert(arena.capacity() == capacity, "the merged block is reused");
+  Assert(c != nullptr, "allocate after reset");
+
+  // Warm up, then the same frame mustn't allocate.
+  SimulateFrame(100000);
+  SimulateFrame(100000);
+  uint64_t allocations;
+  {
+    engine::AllocationCounter::Scope scope;
+    SimulateFrame(100000);
+    allocations = scope.count();
+  }
+  Assert(allocations == 0, "steady state frames don't allocate");
+
+  if (fail_num == 0) {
+    std::cout << "All tests passed." << std::endl;
+  } else {
+    std::cout << fail_num << " tests failed." << std::endl;
+  }
+  return fail_num != 0;
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Checks that the keyframe search finds the same keys as a linear scan would,
+// with and without a cursor, for forward and backward playback, and seeks, on
+// both evenly and unevenly spaced keys.
+
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../mesh/keyframe_interpolation.h"
+
+size_t fail_num = 0;
+
+void Assert(bool condition, const std::string& msg) {
+  if (!condition) {
+    std::cout << "Failed: " + msg << std::endl;
+    fail_num++;
+  }
+}
+
+// The search, that the animations used to do.
+unsigned LinearSearch(float anim_time, const aiVectorKey* keys,
+                      unsigned num_keys) {
+  for (unsigned i = 0; i < num_keys - 1; i++) {
+    if (anim_time <= (float)keys[i + 1].mTime) {
+      return i;
+    }
+  }
+  return num_keys - 2;
+}
+
+// A channel with the same position and scaling key times.
+aiNodeAnim* MakeChannel(unsigned num_keys, bool uniform, std::mt19937* random) {
+  std::uniform_real_distribution<double> step{0.1, 3.0};
+  aiNodeAnim* channel = new aiNodeAnim{};
+  channel->mNumPositionKeys = channel->mNumScalingKeys = num_keys;
+  channel->mPositionKeys = new aiVectorKey[num_keys];
+  channel->mScalingKeys = new aiVectorKey[num_keys];
+  double time = 0;
+  for (unsigned i = 0; i < num_keys; ++i) {
+    channel->mPositionKeys[i].mTime = channel->mScalingKeys[i].mTime = time;
+    channel->mPositionKeys[i].mValue = aiVector3D(i, 0, 0);
+    channel->mScalingKeys[i].mValue = aiVector3D(1, i, 1);
+    time += uniform ? 1.0 : step(*random);
+  }
+  return channel;
+}
+
+void CheckTimes(const aiNodeAnim* channel, float from, float to, float step,
+                const std::string& msg) {
+  const aiVectorKey* keys = channel->mPositionKeys;
+  unsigned num_keys = channel->mNumPositionKeys;
+  unsigned cursor = 0;
+  size_t mismatches = 0;
+  for (float time = from; step > 0 ? time <= to : time >= to; time += step) {
+    unsigned expected = LinearSearch(time, keys, num_keys);
+    mismatches += engine::findPosition(time, channel, &cursor) != expected;
+    mismatches += engine::findPosition(time, channel) != expected;
+  }
+  Assert(mismatches == 0, msg);
+}
+
+int main() {
+  std::mt19937 random{42};
+  for (bool uniform : {true, false}) {
+    std::string kind = uniform ? " (uniform)" : " (uneven)";
+    for (unsigned num_keys : {2u, 3u, 120u, 1000u}) {
+      aiNodeAnim* channel = MakeChannel(num_keys, uniform, &random);
+      float length = channel->mPositionKeys[num_keys - 1].mTime;
+      CheckTimes(channel, -1, length + 1, 0.05f, "forward playback" + kind);
+      CheckTimes(channel, length + 1, -1, -0.05f, "backward playback" + kind);
+      CheckTimes(channel, 0, length, length / 7 + 0.3f, "seeking" + kind);
+
+      // Exactly at the keys.
+      unsigned cursor = num_keys - 2;
+      size_t mismatches = 0;
+      for (unsigned i = 0; i < num_keys; ++i) {
+        float time = channel->mPositionKeys[i].mTime;
+        unsigned expected = LinearSearch(time, channel->mPositionKeys,
+                                         num_keys);
+        mismatches += engine::findPosition(time, channel, &cursor) != expected;
+      }
+      Assert(mismatches == 0, "times of the keys" + kind);
+      delete channel;
+    }
+  }
+
+  // The scaling has to be sampled from the scaling keys.
+  aiNodeAnim* channel = MakeChannel(10, true, &random);
+  aiVector3D scaling;
+  engine::calcInterpolatedScaling(scaling, 4.5f, channel);
+  Assert(scaling.y == 4.5f, "scaling interpolation");
+  delete channel;
+
+  if (fail_num == 0) {
+    std::cout << "All tests passed." << std::endl;
+  } else {
+    std::cout << fail_num << " tests failed." << std::endl;
+  }
+  return fail_num != 0;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Checks that the values, that are pushed to an MpscQueue from several
+// threads are all consumed exactly once, and in the order that every
+// producer pushed them in.
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+#include "../mpsc_queue.h"
+
+size_t fail_num = 0;
+
+void Assert(bool condition, const std::string& msg) {
+  if (!condition) {
+    std::cout << "Failed: " + msg << std::endl;
+    fail_num++;
+  }
+}
+
+constexpr int kProducerCount = 4;
+constexpr int kValueCount = 100000;
+
+int main() {
+  engine::MpscQueue<std::pair<int, int>> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducerCount; ++p) {
+    producers.emplace_back([&queue, p]() {
+      for (int i = 0; i < kValueCount; ++i) {
+        queue.push(std::make_pair(p, i));
+      }
+    });
+  }
+
+  // Consume while the producers are running.
+  std::vector<int> next(kProducerCount, 0);
+  bool in_order = true;
+  auto consume = [&](std::pair<int, int>& value) {
+    in_order &= value.second == next[value.first];
+    next[value.first] = value.second + 1;
+  };
+  for (int i = 0; i < 1000; ++i) {
+    queue.consumeAll(consume);
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  queue.consumeAll(consume);
+
+  Assert(in_order, "Per producer order");
+  for (int p = 0; p < kProducerCount; ++p) {
+    Assert(next[p] == kValueCount, "Every value is consumed");
+  }
+
+  if (fail_num) {
+    std::cout << "Number of failures: " << fail_num << std::endl;
+  } else {
+    std::cout << "Test was successful" << std::endl;
+  }
+}
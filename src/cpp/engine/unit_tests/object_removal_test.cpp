@@ -0,0 +1,117 @@
+// Copyright (c) 2014, Tamas Csala
+
+// Removes GameObjects from a scene, that is rendered on the render thread,
+// while the next frames are simulated. The removed objects must be destroyed
+// with the OpenGL context current, and the render thread mustn't render them
+// after they are removed. It needs a display, and it is linked with the
+// engine.
+
+#include <set>
+#include <mutex>
+#include <iostream>
+
+#include "../game_engine.h"
+
+using engine::Benchmark;
+using engine::GameEngine;
+using engine::GameObject;
+
+size_t fail_num = 0;
+
+void Assert(bool condition, const std::string& msg) {
+  if (!condition) {
+    std::cout << "Failed: " + msg << std::endl;
+    fail_num++;
+  }
+}
+
+// The probes that exist, the render thread checks that it only renders them.
+std::mutex live_probes_mutex;
+std::set<const GameObject*> live_probes;
+size_t destroyed_probes = 0;
+bool rendered_dead_probe = false;
+bool destroyed_without_context = false;
+
+class Probe : public GameObject {
+ public:
+  explicit Probe(GameObject* parent) : GameObject(parent) {
+    std::lock_guard<std::mutex> lock(live_probes_mutex);
+    live_probes.insert(this);
+  }
+
+  virtual ~Probe() {
+    // An OpenGL resource would be freed here.
+    if (glfwGetCurrentContext() != GameEngine::window()) {
+      destroyed_without_context = true;
+    }
+    std::lock_guard<std::mutex> lock(live_probes_mutex);
+    live_probes.erase(this);
+    destroyed_probes++;
+  }
+
+ private:
+  virtual void render() override {
+    std::lock_guard<std::mutex> lock(live_probes_mutex);
+    if (!live_probes.count(this)) {
+      rendered_dead_probe = true;
+    }
+  }
+};
+
+class Holder : public GameObject {
+ public:
+  explicit Holder(GameObject* parent) : GameObject(parent) {
+    first_ = addComponent<Probe>();
+    addComponent<Probe>();
+    addComponent<Probe>();
+  }
+
+ private:
+  Probe* first_;
+  size_t frame_ = 0;
+
+  virtual void update() override {
+    frame_++;
+    if (frame_ == 4) {
+      // The frame before this one is still being rendered.
+      Assert(engine::FramePipeline::running(), "Pipelined frame");
+      removeComponent(first_);
+    } else if (frame_ == 8) {
+      Assert(engine::FramePipeline::running(), "Pipelined frame");
+      ClearComponents();
+    }
+  }
+};
+
+struct RemovalScene : public engine::Scene {
+  RemovalScene() {
+    addComponent<Holder>();
+  }
+
+  virtual bool pipelining_supported() const override { return true; }
+};
+
+int main() {
+  Benchmark::Options options;
+  options.frames = 12;
+  options.warmup_frames = 0;
+  options.width = options.height = 64;
+  options.output = "object_removal_test.json";
+
+  GameEngine::InitContext(true, options.width, options.height);
+  GameEngine::set_pipeline_depth(2);
+  GameEngine::LoadScene<RemovalScene>();
+  Benchmark benchmark{options, {{1.0, {}, glm::dvec2{}}}};
+  Assert(GameEngine::RunBenchmark(&benchmark), "Benchmark finished");
+
+  Assert(destroyed_probes == 3, "Every removed object is destroyed");
+  Assert(live_probes.empty(), "Every removed object is destroyed");
+  Assert(!destroyed_without_context, "Destroyed with the context");
+  Assert(!rendered_dead_probe, "Rendered after it was removed");
+
+  if (fail_num) {
+    std::cout << "Number of failures: " << fail_num << std::endl;
+  } else {
+    std::cout << "Test was successful" << std::endl;
+  }
+}
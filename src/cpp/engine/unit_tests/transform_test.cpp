@@ -4,9 +4,8 @@
 #include <cstdlib>
 #include <iostream>
 
-#include <GL/glew.h>
-#include "../../oglwrap/debug/insertion.h"
 #include "../transform.h"
+#include <glm/gtx/io.hpp>
 
 using Transform = engine::Transformation<double>;
 
@@ -60,7 +59,7 @@ void AssertEquals(const glm::dquat& a, const glm::dquat& b, const std::string& m
 }
 
 void AssertEquals(const Transform& a, const Transform& b, const std::string& msg) {
-  AssertEquals(a.getParent(), b.getParent(), msg);
+  AssertEquals(a.parent(), b.parent(), msg);
   AssertEquals(a.local_pos(), b.local_pos(), msg);
   AssertEquals(a.local_rot(), b.local_rot(), msg);
   AssertEquals(a.local_scale(), b.local_scale(), msg);
@@ -86,8 +85,8 @@ glm::dquat RandomQuat() {
 void TestParentChild(Transform& parent,
                      Transform& child,
                      Transform& grand_child) {
-  AssertEquals(&parent, child.getParent(), "Setting up parent relation");
-  AssertEquals(&child, parent.getChildren()[0], "Setting up child relation");
+  AssertEquals(&parent, child.parent(), "Setting up parent relation");
+  AssertEquals(&child, grand_child.parent(), "Setting up grand child relation");
   AssertEquals(parent.pos(), child.pos(), "Location inheriting");
   AssertEquals(child.pos(), grand_child.pos(), "Two levels Location inheriting");
 }
@@ -187,7 +186,7 @@ void DirectionTest() {
 
 
 int GetParentsNum(Transform* t) {
-  Transform* parent = t->getParent();
+  Transform* parent = t->parent();
   if (parent) {
     return GetParentsNum(parent) + 1;
   } else {
@@ -235,13 +234,44 @@ void GlobalSettings(Transform& t) {
   AssertEquals(t.rot()*v, -v, "Setting rot with 'v', '-v'" + prnts);
 }
 
+// The cached matrices of a subtree have to follow the changes of its root,
+// even if they were queried in between.
+void CacheInvalidationTest() {
+  Transform root, middle{&root}, leaf{&middle};
+  leaf.set_local_pos(glm::dvec3(1, 0, 0));
+  AssertEquals(leaf.pos(), glm::dvec3(1, 0, 0), "Cached leaf position");
+
+  root.set_local_pos(glm::dvec3(0, 2, 0));
+  AssertEquals(leaf.pos(), glm::dvec3(1, 2, 0), "Root moved under the cache");
+
+  Transform other_root;
+  other_root.set_local_pos(glm::dvec3(0, 0, 3));
+  middle.set_parent(&other_root);
+  AssertEquals(leaf.pos(), glm::dvec3(1, 0, 3), "Reparented middle");
+
+  {
+    Transform copy = leaf;
+    other_root.set_local_pos(glm::dvec3(0, 0, 4));
+    AssertEquals(copy.pos(), glm::dvec3(1, 0, 4), "Copy follows its parent");
+  }
+
+  {
+    Transform temporary_parent;
+    temporary_parent.set_local_pos(glm::dvec3(0, 5, 0));
+    middle.set_parent(&temporary_parent);
+    AssertEquals(leaf.pos(), glm::dvec3(1, 5, 0), "Temporary parent");
+  }
+  AssertEquals(middle.parent() == nullptr, true, "Orphaned by destruction");
+  AssertEquals(leaf.pos(), glm::dvec3(1, 0, 0), "Parent destroyed");
+}
+
 int main() {
   srand(time(nullptr));
 
   Transform parent, child, grand_child;
   parent.set_pos(RandomVec());
-  parent.addChild(child);
-  child.addChild(grand_child);
+  child.set_parent(&parent);
+  grand_child.set_parent(&child);
   TestParentChild(parent, child, grand_child);
 
   // Test with a thousand random transformations
@@ -251,6 +281,7 @@ int main() {
   }
 
   DirectionTest();
+  CacheInvalidationTest();
   GlobalSettings(parent);
   GlobalSettings(child);
   GlobalSettings(grand_child);
@@ -4,12 +4,15 @@
 #define LOD_LOADING_SCREEN_H_
 
 #include "engine/oglwrap_config.h"
+#include <GLFW/glfw3.h>
 #include "oglwrap/shader.h"
 #include "oglwrap/uniform.h"
 #include "oglwrap/shapes/rectangle_shape.h"
 #include "oglwrap/textures/texture_2D.h"
 #include "oglwrap/smart_enums.h"
 
+#include <algorithm>
+
 #include "engine/game_object.h"
 
 class LoadingScreen {
@@ -17,10 +20,16 @@ class LoadingScreen {
   gl::RectangleShape rect_;
 
   gl::Program prog_;
+  gl::LazyUniform<float> uProgress_, uTime_;
+  // The progress shown by animate().
+  float shown_progress_ = 0.0f;
+  double last_time_ = 0.0;
 
 public:
   LoadingScreen()
-      : rect_({gl::RectangleShape::kPosition, gl::RectangleShape::kTexCoord}) {
+      : rect_({gl::RectangleShape::kPosition, gl::RectangleShape::kTexCoord})
+      , uProgress_(prog_, "uProgress")
+      , uTime_(prog_, "uTime") {
     gl::VertexShader vs("loading.vert");
     gl::FragmentShader fs("loading.frag");
     (prog_ << vs << fs).link();
@@ -40,8 +49,12 @@ public:
     (prog_ | "aTexCoord").bindLocation(rect_.kTexCoord);
   }
 
-  void render() {
+  // Draws the picture, with a progress bar at the bottom, that is filled
+  // to 'progress' (between 0 and 1).
+  void render(float progress = 0.0f) {
     gl::Use(prog_);
+    uProgress_ = progress;
+    uTime_ = glfwGetTime();
     gl::BindToTexUnit(tex_, 0);
 
     gl::TemporarySet capabilies{{{gl::kCullFace, false},
@@ -50,6 +63,17 @@ public:
     rect_.render();
     gl::Unbind(tex_);
   }
+
+  // Like render, but the bar eases towards 'progress' instead of jumping
+  // to it. It is meant to be called every frame, while a scene is loading
+  // (see GameEngine::set_loading_screen).
+  void animate(float progress) {
+    double time = glfwGetTime();
+    float dt = last_time_ ? float(time - last_time_) : 0.0f;
+    last_time_ = time;
+    shown_progress_ += (progress - shown_progress_) * std::min(1.0f, 4.0f*dt);
+    render(shown_progress_);
+  }
 };
 
 #endif  // LOD_LOADING_SCREEN_H_
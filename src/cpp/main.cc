@@ -8,21 +8,63 @@
  */
 
 
+#include <memory>
+
 #include "engine/game_engine.h"
+#include "loading_screen.h"
 #include "scenes/main_scene.h"
 #include "scenes/gui_test_scene.h"
 #include "scenes/bullet_basics_scene.h"
+#include "scenes/crowd_scene.h"
 // #include "scenes/bullet_height_field_scene.h"
 
+using engine::Benchmark;
 using engine::GameEngine;
 
+#if ENGINE_BENCHMARK
+// Runs a scene with scripted input, in a hidden window, see Benchmark.
+static int RunBenchmark(const Benchmark::Options& options) {
+  GameEngine::InitContext(true, options.width, options.height);
+  GameEngine::set_pipeline_depth(2);
+  if (options.scene == "main") {
+    GameEngine::LoadScene<MainScene>();
+  } else if (options.scene == "bullet_basics") {
+    GameEngine::LoadScene<BulletBasicsScene>();
+  } else if (options.scene == "gui_test") {
+    GameEngine::LoadScene<GuiTestScene>();
+  } else if (options.scene == "crowd") {
+    GameEngine::LoadScene<CrowdScene>();
+  } else {
+    std::cerr << "Unknown scene: " << options.scene << std::endl;
+    GameEngine::Destroy();
+    return 1;
+  }
+
+  Benchmark benchmark{options};
+  return GameEngine::RunBenchmark(&benchmark) ? 0 : 1;
+}
+#endif
+
 int main(int argc, char* argv[]) {
   try {
+#if ENGINE_BENCHMARK
+    Benchmark::Options benchmark_options;
+    if (Benchmark::ParseArgs(argc, argv, &benchmark_options)) {
+      return RunBenchmark(benchmark_options);
+    }
+#endif
+
     GameEngine::InitContext();
-    GameEngine::LoadScene<MainScene>();
+    GameEngine::set_pipeline_depth(2);
+    auto loading_screen = std::make_shared<LoadingScreen>();
+    GameEngine::set_loading_screen([loading_screen](float progress) {
+      loading_screen->animate(progress);
+    });
+    GameEngine::LoadSceneAsync<MainScene>();
     // GameEngine::LoadScene<GuiTestScene>();
     // GameEngine::LoadScene<BulletHeightFieldScene>();
     //GameEngine::LoadScene<BulletBasicsScene>();
+    // GameEngine::LoadScene<CrowdScene>();
     GameEngine::Run();
   } catch(const std::exception& err) {
     std::cerr << err.what();
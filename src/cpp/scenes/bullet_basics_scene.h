@@ -4,12 +4,15 @@
 #define LOD_SCENES_BULLET_BASICS_SCENE_H_
 
 #include <vector>
+#include <unordered_map>
 #include <bullet/btBulletDynamicsCommon.h>
 #include "../engine/misc.h"
 #include "../engine/scene.h"
+#include "../engine/mpsc_queue.h"
 #include "../engine/camera.h"
 #include "../engine/game_object.h"
 #include "../engine/debug/debug_shape.h"
+#include "../engine/ecs/systems.h"
 #include "../engine/gui/label.h"
 
 #include "../after_effects.h"
@@ -35,11 +38,11 @@ class BulletRigidBody : public engine::GameObject {
     btRigidBody::btRigidBodyConstructionInfo info(mass, motion_state_.get(),
                                                   shape_.get(), inertia);
     rigid_body_ = engine::make_unique<btRigidBody>(info);
-    scene_->world()->addRigidBody(rigid_body_.get());
+    scene_->addRigidBody(rigid_body_.get());
   }
 
   virtual ~BulletRigidBody() {
-    scene_->world()->removeCollisionObject(rigid_body_.get());
+    scene_->removeRigidBody(rigid_body_.get());
   }
 
   btRigidBody* rigid_body() { return rigid_body_.get(); }
@@ -54,14 +57,12 @@ class BulletRigidBody : public engine::GameObject {
   virtual void update() override {
     if (static_) { return; }
 
-    btTransform t;
-    t.setIdentity();
-    motion_state_->getWorldTransform(t);
-    const btVector3& o = t.getOrigin();
-    parent_->transform()->set_pos(glm::vec3(o.x(), o.y(), o.z()));
-    const btQuaternion& r = t.getRotation();
-    parent_->transform()->set_rot(glm::quat(r.getW(), r.getX(),
-                                            r.getY(), r.getZ()));
+    glm::vec3 pos;
+    glm::quat rot;
+    if (scene_->bodyTransform(rigid_body_.get(), &pos, &rot)) {
+      parent_->transform()->set_pos(pos);
+      parent_->transform()->set_rot(rot);
+    }
   }
 };
 
@@ -76,44 +77,110 @@ class StaticPlane : public engine::GameObject {
   }
 };
 
-class RedCube : public engine::GameObject {
-  Cube* cube_mesh_;
+// The shot cubes are entities, so their transforms, rigid bodies and colors
+// are stored in contiguous arrays, and are synced and drawn in tight loops
+// instead of through a few GameObjects per cube.
+class RedCubes : public engine::GameObject {
  public:
-  explicit RedCube(GameObject* parent, const glm::vec3& pos,
-                   const glm::vec3& v, const glm::quat& rot)
-      : GameObject(parent) {
-    btVector3 half_extents(0.5f, 0.5f, 0.5f);
-    btCollisionShape* shape = new btBoxShape(half_extents);
-    auto rbody = addComponent<BulletRigidBody>(pos, 1.0f, shape, rot);
-    auto rigid_body = rbody->rigid_body();
+  explicit RedCubes(GameObject* parent)
+      : GameObject(parent)
+      , shape_(new btBoxShape(btVector3(0.5f, 0.5f, 0.5f))) {}
+
+  virtual ~RedCubes() {
+    for (auto& cube : cubes_) {
+      scene_->removeRigidBody(cube.rigid_body.get());
+      scene_->entities().destroy(cube.entity);
+    }
+  }
+
+  void addCube(const glm::vec3& pos, const glm::vec3& v, const glm::quat& rot) {
+    CubeBody cube;
+    const float mass = 1.0f;
+    btVector3 inertia(0, 0, 0);
+    shape_->calculateLocalInertia(mass, inertia);
+    btTransform transform;
+    transform.setIdentity();
+    transform.setOrigin(btVector3(pos.x, pos.y, pos.z));
+    transform.setRotation(btQuaternion(rot.x, rot.y, rot.z, rot.w));
+    cube.motion_state = engine::make_unique<btDefaultMotionState>(transform);
+    btRigidBody::btRigidBodyConstructionInfo info(mass, cube.motion_state.get(),
+                                                  shape_.get(), inertia);
+    cube.rigid_body = engine::make_unique<btRigidBody>(info);
+
+    btRigidBody* rigid_body = cube.rigid_body.get();
     rigid_body->setLinearVelocity(btVector3(v.x, v.y, v.z));
     rigid_body->setCollisionFlags(rigid_body->getCollisionFlags() |
         btCollisionObject::CF_CUSTOM_MATERIAL_CALLBACK);
-    rigid_body->setUserPointer(this);
-    cube_mesh_ = addComponent<Cube>(glm::vec3(0.5, 0.0, 0.0));
-    cube_mesh_->set_color({1.0, 0.0, 0.0});
+    rigid_body->setUserPointer(static_cast<GameObject*>(this));
+    scene_->addRigidBody(rigid_body);
+
+    cube.entity = scene_->entities().create(
+        engine::ecs::TransformComponent{pos, rot},
+        engine::ecs::RigidBodyHandle{rigid_body},
+        engine::ecs::RenderHandle{0, glm::vec3(1.0, 0.0, 0.0)});
+    entity_of_body_[rigid_body] = cube.entity;
+    cubes_.push_back(std::move(cube));
   }
 
-  void addColor(const glm::vec3& color) {
-    cube_mesh_->set_color(glm::clamp(cube_mesh_->color() + color, glm::vec3(0.0), glm::vec3(1.0)));
+  // Called from the collision callback, on the physics thread, so the
+  // colors are only applied in the next update.
+  void addColor(const btCollisionObject* body, const glm::vec3& color) {
+    pending_colors_.push(std::make_pair(body, color));
   }
 
-  void set_color(const glm::vec3& color) {
-    cube_mesh_->set_color(color);
+ private:
+  struct CubeBody {
+    std::unique_ptr<btMotionState> motion_state;
+    std::unique_ptr<btRigidBody> rigid_body;
+    engine::ecs::Entity entity;
+  };
+
+  // Every cube has the same shape.
+  std::unique_ptr<btCollisionShape> shape_;
+  std::vector<CubeBody> cubes_;
+  std::unordered_map<const btCollisionObject*, engine::ecs::Entity> entity_of_body_;
+  // Pushed by the physics thread, consumed by update().
+  engine::MpscQueue<std::pair<const btCollisionObject*, glm::vec3>>
+      pending_colors_;
+  engine::FrameBuffered<std::vector<Cube::Instance>> instances_;
+
+  virtual void update() override {
+    pending_colors_.consumeAll(
+        [this](std::pair<const btCollisionObject*, glm::vec3>& pending) {
+      auto iter = entity_of_body_.find(pending.first);
+      if (iter == entity_of_body_.end()) { return; }
+      auto handle =
+          scene_->entities().get<engine::ecs::RenderHandle>(iter->second);
+      if (handle) {
+        handle->color = glm::clamp(handle->color + pending.second,
+                                   glm::vec3(0.0), glm::vec3(1.0));
+      }
+    });
+  }
+
+  virtual void prepareRender() override {
+    instances_.get().clear();
+    Cube::CollectEntities(scene_, &instances_.get());
+  }
+
+  virtual void render() override {
+    Cube::RenderInstances(scene_, instances_.get());
   }
 };
 
 bool CollisionCallback(btManifoldPoint& cp,
                   const btCollisionObjectWrapper* obj1, int id1, int index1,
                   const btCollisionObjectWrapper* obj2, int id2, int index2) {
-  RedCube* red1 = dynamic_cast<RedCube*>((engine::GameObject*)obj1->getCollisionObject()->getUserPointer());
-  RedCube* red2 = dynamic_cast<RedCube*>((engine::GameObject*)obj2->getCollisionObject()->getUserPointer());
+  const btCollisionObject* body1 = obj1->getCollisionObject();
+  const btCollisionObject* body2 = obj2->getCollisionObject();
+  RedCubes* red1 = dynamic_cast<RedCubes*>((engine::GameObject*)body1->getUserPointer());
+  RedCubes* red2 = dynamic_cast<RedCubes*>((engine::GameObject*)body2->getUserPointer());
   if (red1 && red2) {
-    red1->addColor(glm::vec3{0.0f, 1.0f, 1.0f});
-    red2->addColor(glm::vec3{0.0f, 1.0f, 1.0f});
+    red1->addColor(body1, glm::vec3{0.0f, 1.0f, 1.0f});
+    red2->addColor(body2, glm::vec3{0.0f, 1.0f, 1.0f});
   } else {
-    if (red1) { red1->addColor(glm::vec3{0.0f, 1.0f, 0.0f}); }
-    if (red2) { red2->addColor(glm::vec3{0.0f, 1.0f, 0.0f}); }
+    if (red1) { red1->addColor(body1, glm::vec3{0.0f, 1.0f, 0.0f}); }
+    if (red2) { red2->addColor(body2, glm::vec3{0.0f, 1.0f, 0.0f}); }
   }
 
   return false;
@@ -123,16 +190,14 @@ class BulletBasicsScene : public engine::Scene {
   void addSmallRedCube() {
     auto cam = camera();
     glm::vec3 pos = cam->transform()->pos() + 3.0f*cam->transform()->forward();
-    dynamic_objects->addComponent<RedCube>(pos, 20.0f*cam->transform()->forward(),
-                          cam->transform()->rot());
+    red_cubes_->addCube(pos, 20.0f*cam->transform()->forward(),
+                        cam->transform()->rot());
   }
 
-  GameObject* dynamic_objects = nullptr;
+  RedCubes* red_cubes_ = nullptr;
 
  public:
   BulletBasicsScene() {
-    glfwSetInputMode(window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
     collision_config_ = engine::make_unique<btDefaultCollisionConfiguration>();
     dispatcher_ =
         engine::make_unique<btCollisionDispatcher>(collision_config_.get());
@@ -150,7 +215,11 @@ class BulletBasicsScene : public engine::Scene {
     auto skybox = addComponent<Skybox>();
     addComponent<StaticPlane>();
 
-    dynamic_objects = addComponent<GameObject>();
+    red_cubes_ = addComponent<RedCubes>();
+    addSystem([this](engine::ecs::Registry& registry) {
+      engine::ecs::SyncRigidBodies(registry, *this);
+    });
+    addSystem(engine::ecs::UpdateTransforms);
 
     addComponent<AfterEffects>(skybox);
 
@@ -169,12 +238,16 @@ class BulletBasicsScene : public engine::Scene {
     label2->set_font_size(14);
   }
 
+  virtual void activate() override {
+    glfwSetInputMode(window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+  }
+
   virtual void update() override {
     Scene::update();
-    world_->stepSimulation(game_time().dt, 5);
     auto cam = camera()->transform();
     glm::vec3 pos(cam->pos()),fwd(cam->forward()*1000.0f);
     btCollisionWorld::ClosestRayResultCallback rayCallback(btVector3(pos.x,pos.y,pos.z), btVector3(fwd.x,fwd.y,fwd.z));
+    std::lock_guard<std::recursive_mutex> lock(world_mutex());
     world_->rayTest(btVector3(pos.x,pos.y,pos.z), btVector3(fwd.x,fwd.y,fwd.z),rayCallback);
     // if (rayCallback.hasHit()) {
     //   auto rcube = dynamic_cast<RedCube*>(static_cast<GameObject*>(rayCallback.m_collisionObject->getUserPointer()));
@@ -182,12 +255,15 @@ class BulletBasicsScene : public engine::Scene {
     // }
   }
 
+  // Every renderable here copies its per-frame state in prepareRender.
+  virtual bool pipelining_supported() const override { return true; }
+
   virtual void keyAction(int key, int scancode, int action, int mods) override {
     if (action == GLFW_PRESS) {
       if (key == GLFW_KEY_SPACE) {
         addSmallRedCube();
       } else if (key == GLFW_KEY_HOME) {
-        engine::GameEngine::LoadScene<MainScene>();
+        engine::GameEngine::LoadSceneAsync<MainScene>();
       }
     }
   }
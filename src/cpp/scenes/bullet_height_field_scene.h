@@ -15,6 +15,7 @@
 #include "../engine/misc.h"
 #include "../engine/scene.h"
 #include "../engine/camera.h"
+#include "../engine/input.h"
 #include "../engine/game_object.h"
 #include "../engine/debug/debug_shape.h"
 #include "../engine/gui/label.h"
@@ -31,19 +32,19 @@ class BulletRigidBody : public engine::GameObject, public btMotionState {
                   std::unique_ptr<btCollisionShape>&& shape,
                   bool ignore_rotation = false)
       : GameObject(parent), shape_(std::move(shape))
-      , ignore_rotation_(ignore_rotation), up_to_date_(true) {
+      , ignore_rotation_(ignore_rotation) {
     init(mass, shape_.get());
   }
 
   BulletRigidBody(GameObject* parent, float mass,
                   btCollisionShape* shape, bool ignore_rotation = false)
-      : GameObject(parent), ignore_rotation_(ignore_rotation), up_to_date_(true) {
+      : GameObject(parent), ignore_rotation_(ignore_rotation) {
     init(mass, shape);
   }
 
   BulletRigidBody(GameObject* parent, float mass, btCollisionShape* shape,
                   const glm::vec3& pos, bool ignore_rotation = false)
-      : GameObject(parent), ignore_rotation_(ignore_rotation), up_to_date_(true) {
+      : GameObject(parent), ignore_rotation_(ignore_rotation) {
     transform()->set_pos(pos);
     init(mass, shape);
   }
@@ -52,7 +53,7 @@ class BulletRigidBody : public engine::GameObject, public btMotionState {
                   std::unique_ptr<btCollisionShape>&& shape,
                   const glm::vec3& pos, bool ignore_rotation = false)
       : GameObject(parent), shape_(std::move(shape))
-      , ignore_rotation_(ignore_rotation), up_to_date_(true) {
+      , ignore_rotation_(ignore_rotation) {
     transform()->set_pos(pos);
     init(mass, shape_.get());
   }
@@ -60,7 +61,7 @@ class BulletRigidBody : public engine::GameObject, public btMotionState {
   BulletRigidBody(GameObject* parent, float mass, btCollisionShape* shape,
                   const glm::vec3& pos, const glm::fquat& rot,
                   bool ignore_rotation = false)
-      : GameObject(parent), ignore_rotation_(ignore_rotation), up_to_date_(true) {
+      : GameObject(parent), ignore_rotation_(ignore_rotation) {
     transform()->set_pos(pos);
     transform()->set_rot(rot);
     init(mass, shape);
@@ -71,14 +72,14 @@ class BulletRigidBody : public engine::GameObject, public btMotionState {
                   const glm::vec3& pos, const glm::fquat& rot,
                   bool ignore_rotation = false)
       : GameObject(parent), shape_(std::move(shape))
-      , ignore_rotation_(ignore_rotation), up_to_date_(true) {
+      , ignore_rotation_(ignore_rotation) {
     transform()->set_pos(pos);
     transform()->set_rot(rot);
     init(mass, shape.get());
   }
 
   virtual ~BulletRigidBody() {
-    scene_->world()->removeCollisionObject(bt_rigid_body_.get());
+    scene_->removeRigidBody(bt_rigid_body_.get());
   }
 
   btRigidBody* bt_rigid_body() { return bt_rigid_body_.get(); }
@@ -87,8 +88,7 @@ class BulletRigidBody : public engine::GameObject, public btMotionState {
  private:
   std::unique_ptr<btCollisionShape> shape_;
   std::unique_ptr<btRigidBody> bt_rigid_body_;
-  bool ignore_rotation_, up_to_date_;
-  btTransform new_transform_;
+  bool ignore_rotation_;
 
   void init(float mass, btCollisionShape* shape) {
     btVector3 inertia(0, 0, 0);
@@ -97,37 +97,36 @@ class BulletRigidBody : public engine::GameObject, public btMotionState {
     bt_rigid_body_ = engine::make_unique<btRigidBody>(info);
     bt_rigid_body_->setUserPointer(parent_);
     if (mass == 0.0f) { bt_rigid_body_->setRestitution(1.0f); }
-    scene_->world()->addRigidBody(bt_rigid_body_.get());
+    scene_->addRigidBody(bt_rigid_body_.get());
   }
 
+  // Only called when the body is created.
   virtual void getWorldTransform(btTransform &t) const override {
-    if (up_to_date_) {
-      const glm::vec3& pos = transform()->pos();
-      t.setOrigin(btVector3{pos.x, pos.y, pos.z});
-      if (!ignore_rotation_) {
-        const glm::fquat& rot = transform()->rot();
-        t.setRotation(btQuaternion{rot.x, rot.y, rot.z, rot.w});
-      }
-    } else {
-      t = new_transform_;
+    const glm::vec3& pos = transform()->pos();
+    t.setOrigin(btVector3{pos.x, pos.y, pos.z});
+    if (!ignore_rotation_) {
+      const glm::fquat& rot = transform()->rot();
+      t.setRotation(btQuaternion{rot.x, rot.y, rot.z, rot.w});
     }
   }
 
-  virtual void setWorldTransform(const btTransform &t) override {
-    new_transform_ = t;
-    up_to_date_ = false;
+  // This is called on the physics thread, the new transform is read from the
+  // scene's snapshots in update() instead.
+  virtual void setWorldTransform(const btTransform &t) override {}
+
+  // Copies the body's transform to the parent object.
+  virtual unsigned updatePolicy() const override {
+    return kUpdateThreadSafe | kUpdateReadsScene | kUpdateWritesParent;
   }
 
   virtual void update() override {
-    if (!up_to_date_) {
-      const btVector3& o = new_transform_.getOrigin();
-      parent_->transform()->set_pos(glm::vec3(o.x(), o.y(), o.z()));
+    glm::vec3 pos;
+    glm::quat rot;
+    if (scene_->bodyTransform(bt_rigid_body_.get(), &pos, &rot)) {
+      parent_->transform()->set_pos(pos);
       if (!ignore_rotation_) {
-        const btQuaternion& r = new_transform_.getRotation();
-        parent_->transform()->set_rot(glm::quat(r.getW(), r.getX(),
-                                                r.getY(), r.getZ()));
+        parent_->transform()->set_rot(rot);
       }
-      up_to_date_ = true;
     }
   }
 };
@@ -166,6 +165,7 @@ class BulletCube : public engine::GameObject {
     transform()->set_rot(rot);
     btVector3 half_extents(0.5f, 0.5f, 0.5f);
     btCollisionShape* shape = new btBoxShape(half_extents);
+    std::lock_guard<std::recursive_mutex> lock(scene_->world_mutex());
     auto rbody = addComponent<BulletRigidBody>(
         1.0f, std::unique_ptr<btCollisionShape>{shape});
     auto bt_rigid_body = rbody->bt_rigid_body();
@@ -186,6 +186,11 @@ class BulletCube : public engine::GameObject {
  private:
   engine::debug::Cube* mesh_;
 
+  // Writes its mesh's color.
+  virtual unsigned updatePolicy() const override {
+    return kUpdateThreadSafe | kUpdateWritesChildren;
+  }
+
   virtual void update() override {
     glm::vec3 color = mesh_->color();
     color = glm::vec3(color.r, std::min(0.98f*color.g, 0.9f),
@@ -206,6 +211,7 @@ class BulletSphere : public engine::GameObject {
       : GameObject(parent) {
     transform()->set_pos(pos);
     btCollisionShape* shape = new btSphereShape(0.5f);
+    std::lock_guard<std::recursive_mutex> lock(scene_->world_mutex());
     auto rbody = addComponent<BulletRigidBody>(
         1.0f, std::unique_ptr<btCollisionShape>{shape});
     auto bt_rigid_body = rbody->bt_rigid_body();
@@ -223,6 +229,11 @@ class BulletSphere : public engine::GameObject {
  private:
   engine::debug::Sphere* mesh_;
 
+  // Writes its mesh's color.
+  virtual unsigned updatePolicy() const override {
+    return kUpdateThreadSafe | kUpdateWritesChildren;
+  }
+
   virtual void update() override {
     glm::vec3 color = mesh_->color();
     color = glm::vec3(color.r, std::min(0.98f*color.g, 0.9f),
@@ -247,6 +258,7 @@ class BulletFreeFlyCamera : public engine::FreeFlyCamera {
                       speed_per_sec, mouse_sensitivity) {
     float radius = 2.0f * z_near;
     btCollisionShape* shape = new btSphereShape(radius);
+    std::lock_guard<std::recursive_mutex> lock(scene_->world_mutex());
     auto rbody = addComponent<BulletRigidBody>(
       0.001f, std::unique_ptr<btCollisionShape>{shape}, true);
     bt_rigid_body_ = rbody->bt_rigid_body();
@@ -266,7 +278,7 @@ class BulletFreeFlyCamera : public engine::FreeFlyCamera {
   virtual void update() override {
     glm::dvec2 cursor_pos;
     GLFWwindow* window = scene_->window();
-    glfwGetCursorPos(window, &cursor_pos.x, &cursor_pos.y);
+    engine::Input::GetCursorPos(window, &cursor_pos.x, &cursor_pos.y);
     static glm::dvec2 prev_cursor_pos;
     glm::dvec2 diff = cursor_pos - prev_cursor_pos;
     prev_cursor_pos = cursor_pos;
@@ -301,21 +313,22 @@ class BulletFreeFlyCamera : public engine::FreeFlyCamera {
 
     // Calculate the offset
     glm::vec3 offset;
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    if (engine::Input::GetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
       offset += transform()->forward();
     }
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    if (engine::Input::GetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
       offset -= transform()->forward();
     }
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    if (engine::Input::GetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
       offset += transform()->right();
     }
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    if (engine::Input::GetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
       offset -= transform()->right();
     }
     offset *= speed_per_sec_;
 
     // Update the "position"
+    std::lock_guard<std::recursive_mutex> lock(scene_->world_mutex());
     bt_rigid_body_->setLinearVelocity(btVector3{offset.x, offset.y, offset.z});
 
     update_cache();
@@ -352,7 +365,7 @@ class BulletForest : public engine::GameObject {
         , model_matrix_(transform.matrix())
         , tree_info_(tree_info)
         , bbox_(bbox)
-        , uModelCameraMatrix_(prog, "uModelCameraMatrix")
+        , uModelMatrix_(prog, "uModelMatrix")
         , shadow_uMCP_(shadow_prog, "uMCP")
         , uNormalMatrix_(prog, "uNormalMatrix") {
       rbody_ = addComponent<BulletRigidBody>(0, tree_info->shape_.get());
@@ -362,8 +375,10 @@ class BulletForest : public engine::GameObject {
     const glm::mat4 model_matrix_;
     TreeInfo *tree_info_;
     BulletRigidBody *rbody_;
+    // A disabled object wouldn't be updated, so this can't use enabled().
+    bool in_world_ = true;
     const engine::BoundingBox bbox_;
-    gl::LazyUniform<glm::mat4> uModelCameraMatrix_, shadow_uMCP_;
+    gl::LazyUniform<glm::mat4> uModelMatrix_, shadow_uMCP_;
     gl::LazyUniform<glm::mat3> uNormalMatrix_;
 
     virtual void update() override {
@@ -371,13 +386,13 @@ class BulletForest : public engine::GameObject {
       const auto& campos = cam->transform()->pos();
 
       if (glm::length(transform()->pos() - campos) < 1000) {
-        if (!enabled()) {
-          set_enabled(true);
-          scene_->world()->addRigidBody(rbody_->bt_rigid_body());
+        if (!in_world_) {
+          in_world_ = true;
+          scene_->addRigidBody(rbody_->bt_rigid_body());
         }
-      } else if (enabled()) {
-        set_enabled(false);
-        scene_->world()->removeCollisionObject(rbody_->bt_rigid_body());
+      } else if (in_world_) {
+        in_world_ = false;
+        scene_->removeRigidBody(rbody_->bt_rigid_body());
       }
     }
 
@@ -385,20 +400,17 @@ class BulletForest : public engine::GameObject {
       auto shadow = scene_->shadow();
       const auto& cam = *scene_->camera();
       auto campos = cam.transform()->pos();
-      if (shadow->getDepth() < shadow->getMaxDepth() &&
+      if (shadow->hasFreeSlot() &&
           glm::length(glm::vec3(model_matrix_[3]) - campos) < 150) {
         shadow_uMCP_ = shadow->modelCamProjMat(
             tree_info_->bsphere_, model_matrix_, glm::mat4{});
         gl::TemporaryDisable cullface{gl::kCullFace};
         tree_info_->mesh_.render();
-        shadow->push();
       }
     }
 
     virtual void render() override {
-      auto cam = scene_->camera();
-      const auto& cam_mx = cam->cameraMatrix();
-      const auto& frustum = cam->frustum();
+      const auto& frustum = scene_->camera()->frustum();
 
       // Check for visibility
       if (!bbox_.collidesWithFrustum(frustum)) { return; }
@@ -406,14 +418,13 @@ class BulletForest : public engine::GameObject {
       gl::TemporarySet capabilities{{{gl::kBlend, true},
                                    {gl::kCullFace, false}}};
 
-      uModelCameraMatrix_.set(cam_mx * model_matrix_);
+      uModelMatrix_.set(model_matrix_);
       uNormalMatrix_.set(glm::inverse(glm::mat3(model_matrix_)));
       tree_info_->mesh_.render();
     }
   };
 
   engine::ShaderProgram prog_, shadow_prog_;
-  gl::LazyUniform<glm::mat4> uProjectionMatrix_;
   std::array<std::unique_ptr<TreeInfo>, 3> tree_infos_;
 
  public:
@@ -422,8 +433,7 @@ class BulletForest : public engine::GameObject {
       , prog_(scene_->shader_manager()->get("tree.vert"),
               scene_->shader_manager()->get("tree.frag"))
       , shadow_prog_(scene_->shader_manager()->get("tree_shadow.vert"),
-                   scene_->shader_manager()->get("tree_shadow.frag"))
-      , uProjectionMatrix_(prog_, "uProjectionMatrix") {
+                   scene_->shader_manager()->get("tree_shadow.frag")) {
     gl::Use(prog_);
     gl::UniformSampler(prog_, "uDiffuseTexture").set(0);
 
@@ -475,6 +485,12 @@ class BulletForest : public engine::GameObject {
     }
   }
 
+  virtual void contextChanged() override {
+    for (auto& tree_info : tree_infos_) {
+      tree_info->mesh_.recreateVertexArrays();
+    }
+  }
+
   virtual void shadowRender() override {
     gl::Use(shadow_prog_);
   }
@@ -482,7 +498,6 @@ class BulletForest : public engine::GameObject {
   virtual void render() override {
     gl::Use(prog_);
     prog_.update();
-    uProjectionMatrix_ = scene_->camera()->projectionMatrix();
 
     gl::BlendFunc(gl::kSrcAlpha, gl::kOneMinusSrcAlpha);
 
@@ -508,15 +523,16 @@ class BulletHeightFieldScene : public engine::Scene {
   }
 
   GameObject* dynamic_objects = nullptr;
+  // The colliding pairs of the current frame, reused to avoid allocations.
+  std::vector<std::pair<GameObject*, GameObject*>> collisions_;
 
  public:
   BulletHeightFieldScene() {
-#if !ENGINE_NO_FULLSCREEN
-    glfwSetInputMode(window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-#endif
-
-    LoadingScreen().render();
-    glfwSwapBuffers(window());
+    // On a loader thread, the engine draws the loading screen.
+    if (glfwGetCurrentContext() == window()) {
+      LoadingScreen().render();
+      glfwSwapBuffers(window());
+    }
 
     collision_config_ = engine::make_unique<btDefaultCollisionConfiguration>();
     dispatcher_ =
@@ -567,28 +583,47 @@ class BulletHeightFieldScene : public engine::Scene {
     addComponent<FpsDisplay>();
   }
 
+  // The manifolds are written by the physics thread, so the colliding pairs
+  // are collected while holding the world's lock, but the objects are only
+  // notified after it is released.
   void findCollisions() {
-    int num_manifolds = world_->getDispatcher()->getNumManifolds();
-    for (int i = 0; i < num_manifolds; ++i) {
-      btPersistentManifold* contact_manifold =
-         world_->getDispatcher()->getManifoldByIndexInternal(i);
-      const btCollisionObject* obA = contact_manifold->getBody0();
-      const btCollisionObject* obB = contact_manifold->getBody1();
-
-      int num_contacts = contact_manifold->getNumContacts();
-      for (int j = 0; j < num_contacts; ++j) {
-        btManifoldPoint& pt = contact_manifold->getContactPoint(j);
-        if (pt.getDistance() < 1e-3f) {
-          // const btVector3& ptA = pt.getPositionWorldOnA();
-          // const btVector3& ptB = pt.getPositionWorldOnB();
-          // const btVector3& normalOnB = pt.m_normalWorldOnB;
-          auto go1 = (engine::GameObject*)obA->getUserPointer();
-          auto go2 = (engine::GameObject*)obB->getUserPointer();
-          if (go1) { go1->collisionAll(go2); }
-          if (go2) { go2->collisionAll(go1); }
+    collisions_.clear();
+    {
+      std::lock_guard<std::recursive_mutex> lock(world_mutex());
+      int num_manifolds = world_->getDispatcher()->getNumManifolds();
+      for (int i = 0; i < num_manifolds; ++i) {
+        btPersistentManifold* contact_manifold =
+           world_->getDispatcher()->getManifoldByIndexInternal(i);
+        const btCollisionObject* obA = contact_manifold->getBody0();
+        const btCollisionObject* obB = contact_manifold->getBody1();
+
+        int num_contacts = contact_manifold->getNumContacts();
+        for (int j = 0; j < num_contacts; ++j) {
+          btManifoldPoint& pt = contact_manifold->getContactPoint(j);
+          if (pt.getDistance() < 1e-3f) {
+            // const btVector3& ptA = pt.getPositionWorldOnA();
+            // const btVector3& ptB = pt.getPositionWorldOnB();
+            // const btVector3& normalOnB = pt.m_normalWorldOnB;
+            collisions_.push_back(std::make_pair(
+                (engine::GameObject*)obA->getUserPointer(),
+                (engine::GameObject*)obB->getUserPointer()));
+          }
         }
       }
     }
+
+    for (const auto& collision : collisions_) {
+      auto go1 = collision.first;
+      auto go2 = collision.second;
+      if (go1) { go1->collisionAll(go2); }
+      if (go2) { go2->collisionAll(go1); }
+    }
+  }
+
+  virtual void activate() override {
+#if !ENGINE_NO_FULLSCREEN
+    glfwSetInputMode(window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+#endif
   }
 
   virtual void update() override {
@@ -596,16 +631,12 @@ class BulletHeightFieldScene : public engine::Scene {
     findCollisions();
   }
 
-  virtual void updatePhysics() override {
-    world_->stepSimulation(game_time().dt, 4);
-  }
-
   virtual void keyAction(int key, int scancode, int action, int mods) override {
     if (action == GLFW_PRESS) {
       if (key == GLFW_KEY_SPACE) {
         dropCubes();
       } else if (key == GLFW_KEY_HOME) {
-        engine::GameEngine::LoadScene<MainScene>();
+        engine::GameEngine::LoadSceneAsync<MainScene>();
       } else if (key == GLFW_KEY_DELETE) {
         dynamic_objects->ClearComponents ();
       }
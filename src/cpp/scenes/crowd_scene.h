@@ -0,0 +1,223 @@
+// Copyright (c) 2014, Tamas Csala
+
+#ifndef LOD_SCENES_CROWD_SCENE_H_
+#define LOD_SCENES_CROWD_SCENE_H_
+
+#include <string>
+#include <vector>
+#include <cassert>
+#include "../engine/oglwrap_config.h"
+#include <GLFW/glfw3.h>
+
+#include "../engine/misc.h"
+#include "../engine/scene.h"
+#include "../engine/camera.h"
+#include "../engine/game_engine.h"
+#include "../engine/game_object.h"
+#include "../engine/job_system.h"
+#include "../engine/shader_manager.h"
+#include "../engine/debug/debug_shape.h"
+#include "../engine/gui/label.h"
+#include "../engine/mesh/animation.h"
+#include "../engine/mesh/animated_mesh_renderer.h"
+#include "../engine/mesh/skinned_instances.h"
+
+#include "../skybox.h"
+#include "../after_effects.h"
+#include "../fps_display.h"
+#include "./main_scene.h"
+
+// A crowd of Ayumis sharing a single mesh. Every character has its own
+// animation state, the visible ones' bone palettes are packed into one
+// storage buffer, and they are drawn with a single instanced draw call per
+// entry of the mesh. The mesh is shared and immutable, so the poses are
+// evaluated in parallel, and the render thread only uploads them.
+class Crowd : public engine::GameObject {
+ public:
+  Crowd(GameObject* parent, int rows, int columns, float spacing)
+      : GameObject(parent)
+      , mesh_("src/resources/models/ayumi/ayumi.dae",
+              aiProcessPreset_TargetRealtime_Quality | aiProcess_FlipUVs)
+      , prog_(loadVertexShader(scene_->shader_manager()),
+              scene_->shader_manager()->get("ayumi.frag"))
+      , instances_(mesh_.getNumBones(), mesh_.getBoneEncoding()) {
+    gl::Use(prog_);
+
+    mesh_.setupPositions(prog_ | "aPosition");
+    mesh_.setupTexCoords(prog_ | "aTexCoord");
+    mesh_.setupNormals(prog_ | "aNormal");
+    gl::LazyVertexAttrib boneIDs(prog_, "aBoneIDs", false);
+    gl::LazyVertexAttrib weights(prog_, "aWeights", false);
+    mesh_.setupBones(boneIDs, weights, false);
+
+    mesh_.setupDiffuseTextures(1);
+    mesh_.setupSpecularTextures(2);
+    gl::UniformSampler(prog_, "uDiffuseTexture").set(1);
+    gl::UniformSampler(prog_, "uSpecularTexture").set(2);
+
+    prog_.validate();
+
+    using engine::AnimFlag;
+    const char* anim_names[] = {"Stand", "Walk", "Run"};
+    mesh_.addAnimation("src/resources/models/ayumi/ayumi_idle.dae",
+                       anim_names[0], AnimFlag::Repeat);
+    mesh_.addAnimation("src/resources/models/ayumi/ayumi_walk.dae",
+                       anim_names[1], AnimFlag::Repeat);
+    mesh_.addAnimation("src/resources/models/ayumi/ayumi_run.dae",
+                       anim_names[2], AnimFlag::Repeat);
+
+    // The poses differ from the bind pose, so the bounding boxes are twice
+    // as large as the mesh's.
+    engine::BoundingBox bbox = mesh_.boundingBox(mesh_.worldTransform());
+    glm::vec3 center = bbox.center(), extent = bbox.extent();
+    bbox = engine::BoundingBox{center - extent, center + extent};
+
+    for (int row = 0; row < rows; ++row) {
+      for (int column = 0; column < columns; ++column) {
+        glm::vec3 pos = spacing * glm::vec3(column - columns / 2, 0,
+                                            row - rows / 2);
+        float rotation = 2*M_PI * rand() / RAND_MAX;
+        glm::mat4 matrix = glm::rotate(glm::mat4(), rotation,
+                                       glm::vec3(0, 1, 0));
+        matrix[3] = glm::vec4(pos, 1);
+
+        Member member{engine::Animation{mesh_.getAnimData()},
+                      matrix * mesh_.worldTransform(),
+                      engine::BoundingBox{bbox.mins() + pos,
+                                          bbox.maxes() + pos}};
+        member.anim.setDefaultAnimation(anim_names[rand() % 3]);
+        // Starting the animations at different times desynchronizes them.
+        member.anim.forceAnimToDefault(-10.0f * rand() / RAND_MAX);
+        members_.push_back(std::move(member));
+      }
+    }
+  }
+
+  size_t visible_count() const { return instances_.size(); }
+
+ private:
+  struct Member {
+    engine::Animation anim;
+    glm::mat4 model_matrix;
+    engine::BoundingBox bbox;
+  };
+
+  engine::AnimatedMeshRenderer mesh_;
+  engine::ShaderProgram prog_;
+  std::vector<Member> members_;
+  std::vector<Member*> visible_members_;
+  engine::SkinnedInstances instances_;
+
+  engine::ShaderFile* loadVertexShader(engine::ShaderManager* manager) {
+    gl::ShaderSource palette_src("engine/bone_palette.vert");
+    palette_src.insertMacroValue("BONE_ATTRIB_NUM", mesh_.getBoneAttribNum());
+    palette_src.insertMacroValue("BONE_ENCODING",
+                                 int(mesh_.getBoneEncoding()));
+    manager->publish("engine/bone_palette.vert", palette_src);
+
+    gl::ShaderSource vs_src("ayumi_crowd.vert");
+    int bone_size = engine::BoneEncodingSize(mesh_.getBoneEncoding());
+    vs_src.insertMacroValue("BONE_NUM", mesh_.getNumBones());
+    vs_src.insertMacroValue("BONE_SIZE", bone_size);
+    return manager->publish("ayumi_crowd.vert", vs_src);
+  }
+
+  virtual void contextChanged() override {
+    mesh_.recreateVertexArrays();
+  }
+
+  // Only the visible characters are animated.
+  virtual void update() override {
+    float time = scene_->game_time().current;
+    const auto& frustum = scene_->camera()->frustum();
+
+    visible_members_.clear();
+    for (Member& member : members_) {
+      if (member.bbox.collidesWithFrustum(frustum)) {
+        visible_members_.push_back(&member);
+      }
+    }
+
+    // Every member writes only its own Animation and instance. A pinned bone
+    // would be written by all of them.
+    assert(!mesh_.hasPinnedBones());
+    instances_.resize(visible_members_.size());
+    engine::JobSystem::Default().parallelFor(0, visible_members_.size(),
+        [this, time](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        Member* member = visible_members_[i];
+        mesh_.updateBoneInfo(member->anim, time);
+        instances_.set(i, member->model_matrix,
+                       member->anim.getBoneTransforms());
+      }
+    });
+  }
+
+  virtual void render() override {
+    if (instances_.size() == 0) { return; }
+
+    gl::Use(prog_);
+    prog_.update();
+    instances_.upload();
+
+    gl::FrontFace(gl::kCcw);
+    gl::TemporaryEnable cullface{gl::kCullFace};
+
+    mesh_.render(instances_.size());
+  }
+};
+
+class CrowdScene : public engine::Scene {
+ public:
+  CrowdScene() {
+    auto skybox = addComponent<Skybox>();
+
+    auto ground = addComponent<engine::debug::Cube>(glm::vec3(0.3, 0.4, 0.2));
+    ground->transform()->set_local_pos(glm::vec3(0, -0.5f, 0));
+    ground->transform()->set_local_scale(glm::vec3(400, 1, 400));
+
+    crowd_ = addComponent<Crowd>(20, 20, 4.0f);
+
+    addComponent<AfterEffects>(skybox);
+
+    auto cam = addComponent<engine::FreeFlyCamera>(
+        M_PI/3, 1, 500, glm::vec3(0, 15, 60), glm::vec3(), 15, 10);
+    set_camera(cam);
+
+    label_ = addComponent<engine::gui::Label>(L"", glm::vec2(0, -0.9));
+    label_->set_vertical_alignment(
+        engine::gui::Font::VerticalAlignment::kCenter);
+    label_->set_font_size(20);
+
+    auto label2 = addComponent<engine::gui::Label>(
+        L"You can load the main scene by pressing the home button.",
+        glm::vec2(0, -0.95));
+    label2->set_vertical_alignment(
+        engine::gui::Font::VerticalAlignment::kCenter);
+    label2->set_font_size(14);
+
+    addComponent<FpsDisplay>();
+  }
+
+  virtual void activate() override {
+    glfwSetInputMode(window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+  }
+
+  virtual void update() override {
+    Scene::update();
+    label_->set_text(L"Visible characters: " +
+                     std::to_wstring(crowd_->visible_count()));
+  }
+
+  virtual void keyAction(int key, int scancode, int action, int mods) override {
+    if (action == GLFW_PRESS && key == GLFW_KEY_HOME) {
+      engine::GameEngine::LoadSceneAsync<MainScene>();
+    }
+  }
+
+ private:
+  Crowd* crowd_ = nullptr;
+  engine::gui::Label* label_ = nullptr;
+};
+
+#endif
@@ -2,12 +2,15 @@
 
 #include "./main_scene.h"
 
+#include <memory>
 #include <iostream>
 #include <string>
 
 #include "../engine/rigid_body.h"
 #include "../engine/game_engine.h"
 #include "../engine/shader_manager.h"
+#include "../engine/debug/memory_overlay.h"
+#include "../engine/debug/profiler_overlay.h"
 
 #include "../charmove.h"
 #include "../skybox.h"
@@ -32,33 +35,46 @@ static void PrintDebugTime() {
   last_debug_time = curr_time;
 }
 
+// Reports the progress of the loading. The loading screen is only redrawn
+// here, if the scene is created with the window's context, on a loader
+// thread the engine animates it (see GameEngine::set_loading_screen).
+static void ShowProgress(LoadingScreen* loading_screen, GLFWwindow* window,
+                         float progress) {
+  engine::GameEngine::set_loading_progress(progress);
+  if (loading_screen) {
+    loading_screen->render(progress);
+    glfwSwapBuffers(window);
+  }
+}
+
 MainScene::MainScene() {
   GLFWwindow* window = this->window();
 
-  // Disable cursor
-#if !ENGINE_NO_FULLSCREEN
-  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-#endif
-
   // The scene builds quite slow, put some picture for the user.
   last_debug_time = glfwGetTime();
   PrintDebugText("Drawing the loading screen");
-    LoadingScreen().render();
-    glfwSwapBuffers(window);
+    std::unique_ptr<LoadingScreen> loading_screen;
+    if (glfwGetCurrentContext() == window) {
+      loading_screen = engine::make_unique<LoadingScreen>();
+    }
+    ShowProgress(loading_screen.get(), window, 0.0f);
   PrintDebugTime();
 
   PrintDebugText("Initializing the skybox");
     Skybox *skybox = addComponent<Skybox>();
   PrintDebugTime();
+  ShowProgress(loading_screen.get(), window, 0.05f);
 
   PrintDebugText("Initializing the shadow maps");
     Shadow *shadow = addComponent<Shadow>(skybox, 2048, 4, 4);
     set_shadow(shadow);
   PrintDebugTime();
+  ShowProgress(loading_screen.get(), window, 0.1f);
 
   PrintDebugText("Initializing the terrain");
     Terrain *terrain = addComponent<Terrain>();
   PrintDebugTime();
+  ShowProgress(loading_screen.get(), window, 0.45f);
   const engine::HeightMapInterface& height_map = terrain->height_map();
 
   PrintDebugText("Initializing Ayumi");
@@ -69,6 +85,7 @@ MainScene::MainScene() {
     ayumi->charmove(charmove);
     charmove->setAnimation(&ayumi->getAnimation());
   PrintDebugTime();
+  ShowProgress(loading_screen.get(), window, 0.65f);
 
   PrintDebugText("Initializing the camera");
     GameObject* cam_offset_go = ayumi->addComponent<GameObject>();
@@ -88,17 +105,30 @@ MainScene::MainScene() {
     set_camera(cam);
     charmove->setCamera(cam);
   PrintDebugTime();
+  ShowProgress(loading_screen.get(), window, 0.7f);
 
   PrintDebugText("Initializing the trees");
     addComponent<Tree>(height_map);
   PrintDebugTime();
+  ShowProgress(loading_screen.get(), window, 0.9f);
 
   PrintDebugText("Initializing the resources for the after effects");
     AfterEffects *after_effects = addComponent<AfterEffects>(skybox);
     shadow->set_default_fbo(after_effects->fbo());
   PrintDebugTime();
+  ShowProgress(loading_screen.get(), window, 0.95f);
 
   PrintDebugText("Initializing the FPS display");
     addComponent<FpsDisplay>();
+    addComponent<engine::debug::ProfilerOverlay>();
+    addComponent<engine::debug::MemoryOverlay>();
   PrintDebugTime();
+  ShowProgress(loading_screen.get(), window, 1.0f);
+}
+
+void MainScene::activate() {
+  // Disable cursor
+#if !ENGINE_NO_FULLSCREEN
+  glfwSetInputMode(window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+#endif
 }
@@ -10,6 +10,7 @@ class MainScene : public engine::Scene {
  public:
   MainScene();
   virtual float gravity() const override { return 18.0f; }
+  virtual void activate() override;
 };
 
 #endif
@@ -1,8 +1,10 @@
 // Copyright (c) 2014, Tamas Csala
 
 #include <vector>
+#include <algorithm>
 #include "./shadow.h"
 #include "./skybox.h"
+#include "engine/context_objects.h"
 #include "oglwrap/context.h"
 #include "oglwrap/smart_enums.h"
 
@@ -14,10 +16,11 @@ Shadow::Shadow(GameObject* parent, Skybox* skybox, int shadow_map_size,
     , size_(shadow_map_size)
     , xsize_(atlas_x_size)
     , ysize_(atlas_y_size)
-    , curr_depth_(0)
     , max_depth_(xsize_*ysize_)
+    , next_slot_(0)
     , cp_matrices_(max_depth_)
-    , skybox_(skybox)  {
+    , skybox_(skybox)
+    , memory_(engine::MemoryStats::kGpu, "shadow maps", "atlas") {
   gl::Bind(tex_);
   tex_.upload(gl::kDepthComponent, size_*xsize_, size_*ysize_,
               gl::kDepthComponent, gl::kFloat, nullptr);
@@ -27,9 +30,13 @@ Shadow::Shadow(GameObject* parent, Skybox* skybox, int shadow_map_size,
   tex_.wrapS(gl::kClampToBorder);
   tex_.wrapT(gl::kClampToBorder);
   tex_.borderColor(glm::vec4(1.0f));
+  memory_.set_bytes(engine::MemoryStats::BoundTextureBytes());
   gl::Unbind(tex_);
 
-  // Setup the FBO
+  setupFramebuffer();
+}
+
+void Shadow::setupFramebuffer() {
   gl::Bind(fbo_);
   fbo_.attachTexture(gl::kDepthAttachment, tex_, 0);
   // No color output in the bound framebuffer, only depth.
@@ -38,6 +45,11 @@ Shadow::Shadow(GameObject* parent, Skybox* skybox, int shadow_map_size,
   gl::Unbind(fbo_);
 }
 
+void Shadow::contextChanged() {
+  engine::ContextObjects::Recreate(&fbo_);
+  setupFramebuffer();
+}
+
 void Shadow::screenResized(size_t width, size_t height) {
   w_ = width;
   h_ = height;
@@ -58,6 +70,24 @@ glm::mat4 Shadow::camMat(glm::vec3 lightSrcPos,
 glm::mat4 Shadow::modelCamProjMat(glm::vec4 targetBSphere,
                                   glm::mat4 modelMatrix,
                                   glm::mat4 worldTransform) {
+  glm::mat4 mcp;
+  int slot = reserveSlot(targetBSphere, modelMatrix, worldTransform, &mcp);
+  if (slot >= 0) {
+    setViewPort(slot);
+  }
+  return mcp;
+}
+
+void Shadow::resetSlots() {
+  next_slot_ = 0;
+  light_pos_ = skybox_->getLightSourcePos();
+}
+
+int Shadow::reserveSlot(glm::vec4 targetBSphere, glm::mat4 modelMatrix,
+                        glm::mat4 worldTransform, glm::mat4* mcp) {
+  size_t slot = next_slot_++;
+  if (slot >= max_depth_) { return -1; }
+
   // [-1, 1] -> [0, 1] convert
   glm::mat4 biasMatrix(
     0.5, 0.0, 0.0, 0.0,
@@ -70,12 +100,13 @@ glm::mat4 Shadow::modelCamProjMat(glm::vec4 targetBSphere,
     glm::vec4(glm::vec3(modelMatrix * glm::vec4(glm::vec3(targetBSphere), 1)),
               targetBSphere.w);
 
-  glm::mat4 pc = projMatrix * camMat(skybox_->getLightSourcePos(),
-                                     offseted_targetBSphere);
+  glm::mat4 pc = projMatrix * camMat(light_pos_, offseted_targetBSphere);
 
-  cp_matrices_[curr_depth_] = biasMatrix * pc;
+  // Every thread writes a different element.
+  cp_matrices_[slot] = biasMatrix * pc;
+  *mcp = pc * modelMatrix * worldTransform;
 
-  return static_cast<glm::mat4>(pc * modelMatrix * worldTransform);
+  return static_cast<int>(slot);
 }
 
 const std::vector<glm::mat4>& Shadow::shadowCPs() const {
@@ -88,29 +119,18 @@ const gl::Texture2D& Shadow::shadowTex() const {
 
 void Shadow::begin() {
   gl::Bind(fbo_);
-  curr_depth_ = 0;
 
   // Clear the shadowmap atlas
   gl::Clear().Depth();
-
-  // Setup the 0th shadowmap
-  gl::Viewport(0, 0, size_, size_);
 }
 
-void Shadow::setViewPort() {
-  size_t x = curr_depth_ / xsize_, y = curr_depth_ % xsize_;
+void Shadow::setViewPort(size_t slot) {
+  size_t x = slot / xsize_, y = slot % xsize_;
   gl::Viewport(x*size_, y*size_, size_, size_);
 }
 
-void Shadow::push() {
-  if (curr_depth_ < max_depth_) {
-    ++curr_depth_;
-    setViewPort();
-  }
-}
-
 size_t Shadow::getDepth() const {
-  return curr_depth_;
+  return std::min<size_t>(next_slot_, max_depth_);
 }
 
 size_t Shadow::getMaxDepth() const {
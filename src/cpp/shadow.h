@@ -3,12 +3,14 @@
 #ifndef LOD_SHADOW_H_
 #define LOD_SHADOW_H_
 
+#include <atomic>
 #include <vector>
 #include "engine/oglwrap_config.h"
 #include "oglwrap/shader.h"
 #include "oglwrap/uniform.h"
 #include "oglwrap/framebuffer.h"
 #include "engine/game_object.h"
+#include "engine/memory_stats.h"
 
 class Skybox;
 
@@ -17,21 +19,36 @@ class Shadow : public engine::GameObject {
   Shadow(GameObject* parent, Skybox* skybox, int shadow_map_size,
          int atlas_x_size, int atlas_y_size);
   virtual void screenResized(size_t width, size_t height) override;
+  virtual void contextChanged() override;
   glm::mat4 projMat(float size) const;
   glm::mat4 camMat(glm::vec3 lightSrcPos, glm::vec4 targetBSphere) const;
+
+  // Reserves the next slot of the atlas for an object, and sets the viewport
+  // to it. Returns the model-camera-projection matrix of the object. Check
+  // hasFreeSlot() before calling it.
   glm::mat4 modelCamProjMat(glm::vec4 targetBSphere,
                             glm::mat4 modelMatrix,
                             glm::mat4 worldTransform = glm::mat4());
 
+  // Frees every slot of the atlas. Called before the draws of a frame are
+  // collected.
+  void resetSlots();
+
+  // Reserves a slot, like modelCamProjMat, but it doesn't use OpenGL, so it
+  // can be called from collectDraws() on any thread. Returns -1 if the atlas
+  // is full.
+  int reserveSlot(glm::vec4 targetBSphere, glm::mat4 modelMatrix,
+                  glm::mat4 worldTransform, glm::mat4* mcp);
+  bool hasFreeSlot() const { return next_slot_ < max_depth_; }
+
   const std::vector<glm::mat4>& shadowCPs() const;
   const gl::Texture2D& shadowTex() const;
   glm::ivec2 getAtlasDimensions() const {
     return glm::ivec2(xsize_, ysize_);
   }
 
-  void setViewPort();
+  void setViewPort(size_t slot);
   void begin();
-  void push();
   size_t getDepth() const;
   size_t getMaxDepth() const;
   void set_default_fbo(gl::Framebuffer *default_fbo) {
@@ -44,10 +61,16 @@ class Shadow : public engine::GameObject {
   gl::Framebuffer fbo_, *default_fbo_;
 
   size_t w_, h_, size_;
-  size_t xsize_, ysize_, curr_depth_, max_depth_;
+  size_t xsize_, ysize_, max_depth_;
+  std::atomic<size_t> next_slot_;
   std::vector<glm::mat4> cp_matrices_;
+  // The light's direction, cached for the frame by resetSlots().
+  glm::vec3 light_pos_;
 
   Skybox* skybox_;
+  engine::MemoryStats::Allocation memory_;
+
+  void setupFramebuffer();
 };
 
 #endif  // LOD_SHADOW_H_
@@ -1,6 +1,7 @@
 // Copyright (c) 2014, Tamas Csala
 
 #include "./skybox.h"
+#include "engine/context_objects.h"
 #include "oglwrap/smart_enums.h"
 
 const float day_duration = 256.0f, day_start = 0.0f;
@@ -10,14 +11,7 @@ Skybox::Skybox(engine::GameObject* parent)
     , time_(day_start)
     , cube_({gl::CubeShape::kPosition})
     , prog_(scene_->shader_manager()->get("skybox.vert"),
-            scene_->shader_manager()->get("skybox.frag"))
-    , uProjectionMatrix_(prog_, "uProjectionMatrix")
-    , uCameraMatrix_(prog_, "uCameraMatrix") {
-  engine::ShaderFile *sky_fs = scene_->shader_manager()->get("sky.frag");
-  sky_fs->set_update_func([this](const gl::Program& prog) {
-    gl::Uniform<glm::vec3>(prog, "uSunPos") = getSunPos();
-  });
-
+            scene_->shader_manager()->get("skybox.frag")) {
   gl::Use(prog_);
   prog_.validate();
   (prog_ | "aPosition").bindLocation(cube_.kPosition);
@@ -25,9 +19,9 @@ Skybox::Skybox(engine::GameObject* parent)
 
 glm::vec3 Skybox::getSunPos() const {
   return glm::vec3(0.f, 1.f, 0.f) *
-          static_cast<float>(sin(time_ * 2 * M_PI / day_duration)) +
+          static_cast<float>(sin(time_.get() * 2 * M_PI / day_duration)) +
          glm::vec3(0.f, 0.f, -1.f) *
-          static_cast<float>(cos(time_ * 2 * M_PI / day_duration));
+          static_cast<float>(cos(time_.get() * 2 * M_PI / day_duration));
 }
 
 glm::vec3 Skybox::getLightSourcePos() const {
@@ -36,16 +30,22 @@ glm::vec3 Skybox::getLightSourcePos() const {
 }
 
 void Skybox::update() {
-  time_ = scene_->environment_time().current + day_start;
+  time_.get() = scene_->environment_time().current + day_start;
 }
 
-void Skybox::render() {
-  auto cam = scene_->camera();
+// Every program that includes sky.frag reads the sun from the frame uniforms.
+void Skybox::prepareRender() {
+  scene_->frame_uniforms()->data().sun_pos = getSunPos();
+}
 
+void Skybox::contextChanged() {
+  engine::ContextObjects::Recreate(
+      &cube_, gl::CubeShape({gl::CubeShape::kPosition}));
+}
+
+void Skybox::render() {
   gl::Use(prog_);
   prog_.update();
-  uCameraMatrix_ = glm::mat3(cam->cameraMatrix());
-  uProjectionMatrix_ = cam->projectionMatrix();
 
   gl::TemporaryDisable depth_test{gl::kDepthTest};
 
@@ -11,6 +11,7 @@
 
 #include "engine/scene.h"
 #include "engine/game_object.h"
+#include "engine/frame_buffered.h"
 
 class Skybox : public engine::GameObject {
  public:
@@ -22,15 +23,18 @@ class Skybox : public engine::GameObject {
 
   virtual void render() override;
   virtual void update() override;
+  virtual void contextChanged() override;
+  virtual void prepareRender() override;
+  virtual unsigned updatePolicy() const override {
+    return kUpdateThreadSafe | kUpdateReadsScene;
+  }
 
  private:
-  float time_;
+  // Written in every update, and read by the render functions.
+  engine::FrameBuffered<float> time_;
   gl::CubeShape cube_;
 
   engine::ShaderProgram prog_;
-
-  gl::LazyUniform<glm::mat4> uProjectionMatrix_;
-  gl::LazyUniform<glm::mat3> uCameraMatrix_;
 };
 
 
@@ -11,12 +11,9 @@ Terrain::Terrain(engine::GameObject* parent)
     , mesh_(scene_->shader_manager(), height_map_)
     , prog_(scene_->shader_manager()->get("terrain.vert"),
             scene_->shader_manager()->get("terrain.frag"))
-    , uProjectionMatrix_(prog_, "uProjectionMatrix")
-    , uCameraMatrix_(prog_, "uCameraMatrix")
     , uModelMatrix_(prog_, "uModelMatrix")
-    , uShadowCP_(prog_, "uShadowCP")
-    , uNumUsedShadowMaps_(prog_, "uNumUsedShadowMaps")
-    , uShadowAtlasSize_(prog_, "uShadowAtlasSize") {
+    , render_state_(&prog_, engine::RenderQueue::kCullFace)
+    , textures_memory_(engine::MemoryStats::kGpu, "terrain", "textures") {
   gl::Use(prog_);
   mesh_.setup(prog_, 1);
   gl::UniformSampler(prog_, "uGrassMap0").set(2);
@@ -32,6 +29,8 @@ Terrain::Terrain(engine::GameObject* parent)
     grassMaps_[i].magFilter(gl::kLinear);
     grassMaps_[i].wrapS(gl::kRepeat);
     grassMaps_[i].wrapT(gl::kRepeat);
+    textures_memory_.add(engine::MemoryStats::BoundTextureBytes(
+        GL_TEXTURE_2D, true));
   }
 
   gl::UniformSampler(prog_, "uGrassNormalMap").set(4);
@@ -44,6 +43,8 @@ Terrain::Terrain(engine::GameObject* parent)
     grassNormalMap_.magFilter(gl::kLinear);
     grassNormalMap_.wrapS(gl::kRepeat);
     grassNormalMap_.wrapT(gl::kRepeat);
+    textures_memory_.add(engine::MemoryStats::BoundTextureBytes(
+        GL_TEXTURE_2D, true));
   }
 
   gl::UniformSampler(prog_, "uShadowMap").set(5);
@@ -51,22 +52,32 @@ Terrain::Terrain(engine::GameObject* parent)
   prog_.validate();
 }
 
-void Terrain::render() {
-  const engine::Camera& cam = *scene_->camera();
+void Terrain::contextChanged() {
+  mesh_.recreateVertexArray();
+}
+
+void Terrain::collectDraws(engine::RenderQueue* queue) {
+  if (queue->pass() != engine::RenderQueue::kMainPass) { return; }
+
+  mesh_.select(scene_->frame_uniforms()->data().camera_pos,
+               scene_->camera()->frustum());
+  queue->push(engine::RenderQueue::kOpaque, 0,
+              engine::RenderQueue::Command{
+                &render_state_, engine::RenderQueue::Material{
+                  nullptr, 0, nullptr, nullptr},
+                &Terrain::Draw, this, nullptr, 0, glm::mat4(), glm::vec4(),
+                nullptr});
+}
+
+void Terrain::Draw(const engine::RenderQueue::Command& command,
+                   const engine::Camera&) {
+  static_cast<Terrain*>(command.object)->draw();
+}
+
+void Terrain::draw() {
   const Shadow *shadow = scene_->shadow();
 
-  gl::Use(prog_);
-  prog_.update();
-  uCameraMatrix_ = cam.cameraMatrix();
-  uProjectionMatrix_ = cam.projectionMatrix();
   uModelMatrix_ = transform()->matrix();
-  if (shadow) {
-    for (size_t i = 0; i < shadow->getDepth(); ++i) {
-      uShadowCP_[i] = shadow->shadowCPs()[i];
-    }
-    uNumUsedShadowMaps_ = shadow->getDepth();
-    uShadowAtlasSize_ = shadow->getAtlasDimensions();
-  }
 
   gl::BindToTexUnit(grassMaps_[0], 2);
   gl::BindToTexUnit(grassMaps_[1], 3);
@@ -75,7 +86,7 @@ void Terrain::render() {
     gl::BindToTexUnit(shadow->shadowTex(), 5);
   }
 
-  mesh_.render(cam);
+  mesh_.renderSelected();
 
   if (shadow) {
     gl::UnbindFromTexUnit(shadow->shadowTex(), 5);
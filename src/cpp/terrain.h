@@ -10,6 +10,8 @@
 #include "engine/height_map.h"
 #include "engine/game_object.h"
 #include "engine/shader_manager.h"
+#include "engine/render_queue.h"
+#include "engine/memory_stats.h"
 #include "engine/cdlod/terrain_mesh.h"
 
 class Terrain : public engine::GameObject {
@@ -25,12 +27,17 @@ class Terrain : public engine::GameObject {
   engine::ShaderProgram prog_;  // has to be inited after mesh_
 
   gl::Texture2D grassMaps_[2], grassNormalMap_;
-  gl::LazyUniform<glm::mat4> uProjectionMatrix_, uCameraMatrix_,
-                             uModelMatrix_, uShadowCP_;
-  gl::LazyUniform<int> uNumUsedShadowMaps_;
-  gl::LazyUniform<glm::ivec2> uShadowAtlasSize_;
-
-  virtual void render() override;
+  // The camera and the shadow data come from the scene's frame uniforms.
+  gl::LazyUniform<glm::mat4> uModelMatrix_;
+  engine::RenderQueue::State render_state_;
+  engine::MemoryStats::Allocation textures_memory_;
+
+  // Selects the visible nodes on a worker thread, and queues a single draw.
+  virtual void collectDraws(engine::RenderQueue* queue) override;
+  virtual void contextChanged() override;
+  static void Draw(const engine::RenderQueue::Command& command,
+                   const engine::Camera& camera);
+  void draw();
 };
 
 #endif  // LOD_TERRAIN_H_
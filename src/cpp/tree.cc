@@ -1,7 +1,10 @@
 // Copyright (c) 2014, Tamas Csala
 
+#include <algorithm>
+
 #include "./tree.h"
 #include "engine/scene.h"
+#include "engine/job_system.h"
 #include "oglwrap/debug/insertion.h"
 
 Tree::Tree(GameObject *parent, const engine::HeightMapInterface& height_map)
@@ -10,10 +13,11 @@ Tree::Tree(GameObject *parent, const engine::HeightMapInterface& height_map)
             scene_->shader_manager()->get("tree.frag"))
     , shadow_prog_(scene_->shader_manager()->get("tree_shadow.vert"),
                    scene_->shader_manager()->get("tree_shadow.frag"))
-    , uProjectionMatrix_(prog_, "uProjectionMatrix")
-    , uModelCameraMatrix_(prog_, "uModelCameraMatrix")
+    , uModelMatrix_(prog_, "uModelMatrix")
     , uNormalMatrix_(prog_, "uNormalMatrix")
-    , shadow_uMCP_(shadow_prog_, "uMCP") {
+    , shadow_uMCP_(shadow_prog_, "uMCP")
+    , render_state_(&prog_, engine::RenderQueue::kBlend)
+    , shadow_state_(&shadow_prog_, 0) {
   gl::Use(shadow_prog_);
   gl::UniformSampler(shadow_prog_, "uDiffuseTexture").set(0);
   shadow_prog_.validate();
@@ -69,55 +73,134 @@ Tree::Tree(GameObject *parent, const engine::HeightMapInterface& height_map)
       glm::vec4 bsphere = meshes_[type]->bSphere();
       bsphere.w *= 1.2;  // removes peter panning (but decreases quality)
 
-      trees_.push_back(TreeInfo{type, matrix, bsphere, bbox});
+      glm::mat3 normal_mat = glm::inverse(glm::mat3(matrix));
+
+      trees_.push_back(TreeInfo{type, matrix, normal_mat, bsphere, bbox});
     }
   }
 }
 
-void Tree::shadowRender() {
-  gl::Use(shadow_prog_);
+void Tree::contextChanged() {
+  for (auto& mesh : meshes_) {
+    mesh->recreateVertexArrays();
+  }
+}
 
-  auto shadow = scene_->shadow();
-  gl::TemporaryDisable cullface{gl::kCullFace};
+void Tree::collectDraws(engine::RenderQueue* queue) {
+  if (queue->pass() == engine::RenderQueue::kShadowPass) {
+    collectShadowDraws(queue);
+  } else {
+    collectMainDraws(queue);
+  }
+}
 
-  const auto& cam = *scene_->camera();
-  auto campos = cam.transform()->pos();
-  for (size_t i = 0; i < trees_.size() &&
-      shadow->getDepth() < shadow->getMaxDepth(); i++) {
-    if (glm::length(glm::vec3(trees_[i].mat[3]) - campos) < 150) {
-      shadow_uMCP_ = shadow->modelCamProjMat(
-          trees_[i].bsphere, trees_[i].mat, glm::mat4{});
-      meshes_[trees_[i].type]->render();
-      shadow->push();
+void Tree::collectShadowDraws(engine::RenderQueue* queue) {
+  auto shadow = scene_->shadow();
+  // The per frame data is read here, as the jobs might run on any slot.
+  glm::vec3 campos = scene_->frame_uniforms()->data().camera_pos;
+
+  engine::JobSystem& jobs = engine::JobSystem::Default();
+  size_t job_count = std::max<size_t>(
+      1, std::min(trees_.size(), jobs.concurrency()));
+  shadow_candidates_.resize(job_count);
+  jobs.parallelFor(0, job_count,
+      [this, campos, job_count](size_t begin, size_t end) {
+    for (size_t job = begin; job < end; ++job) {
+      std::vector<ShadowCandidate>& candidates = shadow_candidates_[job];
+      candidates.clear();
+      size_t first = job * trees_.size() / job_count;
+      size_t last = (job + 1) * trees_.size() / job_count;
+      for (size_t i = first; i < last; ++i) {
+        const TreeInfo& tree = trees_[i];
+        float distance = glm::length(glm::vec3(tree.mat[3]) - campos);
+        if (distance < 150) {
+          candidates.push_back(ShadowCandidate{&tree, distance});
+        }
+      }
+    }
+  }, 1);
+
+  for (const auto& candidates : shadow_candidates_) {
+    for (const ShadowCandidate& candidate : candidates) {
+      const TreeInfo& tree = *candidate.tree;
+      glm::mat4 mcp;
+      int slot = shadow->reserveSlot(tree.bsphere, tree.mat, glm::mat4{},
+                                     &mcp);
+      if (slot < 0) { return; }
+
+      engine::MeshRenderer* mesh = meshes_[tree.type].get();
+      for (size_t entry = 0; entry < mesh->entry_count(); ++entry) {
+        queue->push(engine::RenderQueue::kOpaque, candidate.distance,
+                    engine::RenderQueue::Command{
+                      &shadow_state_, mesh->queueMaterial(entry),
+                      &Tree::DrawShadowEntry, this, mesh,
+                      static_cast<unsigned>(entry), mcp,
+                      glm::vec4(slot, 0, 0, 0), &tree});
+      }
     }
   }
 }
 
-void Tree::render() {
-  gl::Use(prog_);
-  prog_.update();
-
+void Tree::collectMainDraws(engine::RenderQueue* queue) {
   const auto& cam = *scene_->camera();
-  uProjectionMatrix_ = cam.projectionMatrix();
-
-  gl::TemporarySet capabilities{{{gl::kBlend, true},
-                                 {gl::kCullFace, false}}};
-  gl::BlendFunc(gl::kSrcAlpha, gl::kOneMinusSrcAlpha);
-
-  auto campos = cam.transform()->pos();
-  auto cam_mx = cam.cameraMatrix();
-  auto frustum = cam.frustum();
-  for (size_t i = 0; i < trees_.size(); i++) {
-    // Check for visibility
-    if (!trees_[i].bbox.collidesWithFrustum(frustum) ||
-      glm::length(glm::vec3(trees_[i].mat[3]) - campos) > 1500) {
-      continue;
+  // The per frame data is read here, as the jobs might run on any slot.
+  glm::vec3 campos = scene_->frame_uniforms()->data().camera_pos;
+  const auto& frustum = cam.frustum();
+
+  engine::JobSystem& jobs = engine::JobSystem::Default();
+  size_t job_count = std::max<size_t>(
+      1, std::min(trees_.size(), jobs.concurrency()));
+  if (main_lists_.size() < job_count) {
+    main_lists_.resize(job_count, engine::RenderQueue{queue->pass()});
+  }
+  jobs.parallelFor(0, job_count,
+      [this, campos, &frustum, job_count](size_t begin, size_t end) {
+    for (size_t job = begin; job < end; ++job) {
+      engine::RenderQueue* list = &main_lists_[job];
+      size_t first = job * trees_.size() / job_count;
+      size_t last = (job + 1) * trees_.size() / job_count;
+      for (size_t i = first; i < last; ++i) {
+        const TreeInfo& tree = trees_[i];
+        // Check for visibility
+        float distance = glm::length(glm::vec3(tree.mat[3]) - campos);
+        if (distance > 1500 || !tree.bbox.collidesWithFrustum(frustum)) {
+          continue;
+        }
+
+        // Every entry is queued separately, so the entries of the different
+        // trees that share a material are drawn after each other.
+        engine::MeshRenderer* mesh = meshes_[tree.type].get();
+        for (size_t entry = 0; entry < mesh->entry_count(); ++entry) {
+          list->push(engine::RenderQueue::kOpaque, distance,
+                     engine::RenderQueue::Command{
+                       &render_state_, mesh->queueMaterial(entry),
+                       &Tree::DrawEntry, this, mesh,
+                       static_cast<unsigned>(entry), tree.mat, glm::vec4(),
+                       &tree});
+        }
+      }
     }
+  }, 1);
 
-    auto& mesh = meshes_[trees_[i].type];
-    glm::mat4 model_mx = trees_[i].mat;
-    uModelCameraMatrix_.set(cam_mx * model_mx);
-    uNormalMatrix_.set(glm::inverse(glm::mat3(model_mx)));
-    mesh->render();
+  // In the jobs' order, so the result doesn't depend on the scheduling.
+  for (size_t job = 0; job < job_count; ++job) {
+    queue->append(&main_lists_[job]);
   }
 }
+
+void Tree::DrawEntry(const engine::RenderQueue::Command& command,
+                     const engine::Camera&) {
+  Tree* tree = static_cast<Tree*>(command.object);
+  const TreeInfo* info = static_cast<const TreeInfo*>(command.data);
+  tree->uModelMatrix_.set(command.model_matrix);
+  tree->uNormalMatrix_.set(info->normal_mat);
+  static_cast<engine::MeshRenderer*>(command.mesh)->renderEntry(command.part);
+}
+
+void Tree::DrawShadowEntry(const engine::RenderQueue::Command& command,
+                           const engine::Camera&) {
+  Tree* tree = static_cast<Tree*>(command.object);
+  tree->scene_->shadow()->setViewPort(static_cast<size_t>(command.param.x));
+  tree->shadow_uMCP_.set(command.model_matrix);
+  static_cast<engine::MeshRenderer*>(command.mesh)->renderEntry(command.part);
+}
@@ -10,6 +10,7 @@
 #include "engine/scene.h"
 #include "engine/game_object.h"
 #include "engine/shader_manager.h"
+#include "engine/render_queue.h"
 #include "engine/mesh/mesh_renderer.h"
 #include "engine/height_map_interface.h"
 
@@ -17,8 +18,8 @@ class Tree : public engine::GameObject {
  public:
   Tree(GameObject *parent, const engine::HeightMapInterface& height_map);
   virtual ~Tree() {}
-  virtual void shadowRender() override;
-  virtual void render() override;
+  virtual void collectDraws(engine::RenderQueue* queue) override;
+  virtual void contextChanged() override;
 
  private:
   // It should be std::array<engine::MeshRenderer, 3>, but calling its ctor
@@ -26,18 +27,41 @@ class Tree : public engine::GameObject {
   std::array<std::unique_ptr<engine::MeshRenderer>, 3> meshes_;
   engine::ShaderProgram prog_, shadow_prog_;
 
-  gl::LazyUniform<glm::mat4> uProjectionMatrix_, uModelCameraMatrix_;
+  gl::LazyUniform<glm::mat4> uModelMatrix_;
   gl::LazyUniform<glm::mat3> uNormalMatrix_;
   gl::LazyUniform<glm::mat4> shadow_uMCP_;
+  // The blending only smooths the leaves' edges, so the trees are drawn in
+  // the opaque layer, sorted by material instead of back to front.
+  engine::RenderQueue::State render_state_, shadow_state_;
+
+  static void DrawEntry(const engine::RenderQueue::Command& command,
+                        const engine::Camera& camera);
+  static void DrawShadowEntry(const engine::RenderQueue::Command& command,
+                              const engine::Camera& camera);
 
   struct TreeInfo {
     int type;
     glm::mat4 mat;
+    glm::mat3 normal_mat;
     glm::vec4 bsphere;
     engine::BoundingBox bbox;
   };
 
+  void collectShadowDraws(engine::RenderQueue* queue);
+  void collectMainDraws(engine::RenderQueue* queue);
+
   std::vector<TreeInfo> trees_;
+
+  // The trees are culled on the worker threads, every job works on a
+  // contiguous range of them, and writes its own list. The shadow pass only
+  // collects the trees in range, as the shadow slots are reserved in the
+  // trees' order, so that the same trees get the limited slots every time.
+  struct ShadowCandidate {
+    const TreeInfo* tree;
+    float distance;
+  };
+  std::vector<std::vector<ShadowCandidate>> shadow_candidates_;
+  std::vector<engine::RenderQueue> main_lists_;
 };
 
 #endif  // LOD_TREE_H_
@@ -2,6 +2,7 @@
 
 #version 430
 
+#include "engine/frame_data.vert"
 #include "sky.frag"
 #include "hemisphere_lighting.frag"
 
@@ -9,7 +10,6 @@ in vec3 w_vNormal, c_vNormal;
 in vec3 w_vPos, c_vPos;
 in vec2 vTexCoord;
 
-uniform mat4 uCameraMatrix;
 uniform sampler2D uDiffuseTexture, uSpecularTexture;
 
 out vec4 fragColor;
@@ -0,0 +1,53 @@
+// Copyright (c) 2014, Tamas Csala
+
+#version 430
+
+#include "engine/frame_data.vert"
+#include "engine/bone_palette.vert"
+
+// External macros
+#define BONE_NUM
+// The number of vec4s per bone (see engine::BoneEncodingSize).
+#define BONE_SIZE
+
+// The model matrix, then BONE_NUM * BONE_SIZE vec4s for every instance,
+// written once per frame by engine::SkinnedInstances.
+#define INSTANCE_SIZE (4 + BONE_NUM * BONE_SIZE)
+layout(std430, binding = 2) readonly buffer EngineSkinnedInstances {
+  vec4 uInstances[];
+};
+
+// The same attributes as in ayumi.vert, so the crowd can share the
+// AnimatedMeshRenderer setup code.
+in vec4 aPosition;
+
+in vec2 aTexCoord;
+in vec3 aNormal;
+
+out vec3 w_vNormal, c_vNormal;
+out vec3 w_vPos, c_vPos;
+out vec2 vTexCoord;
+
+vec4 getBoneData(int index) {
+  return uInstances[gl_InstanceID * INSTANCE_SIZE + 4 + index];
+}
+
+void main() {
+  int instance = gl_InstanceID * INSTANCE_SIZE;
+  mat4 ModelMatrix = mat4(uInstances[instance], uInstances[instance + 1],
+                          uInstances[instance + 2], uInstances[instance + 3]);
+  mat4 BoneMatrix = getBoneMatrix();
+
+  vec3 w_normal = mat3(ModelMatrix) * (mat3(BoneMatrix) * aNormal);
+  w_vNormal = w_normal;
+  c_vNormal = mat3(uCameraMatrix) * w_normal;
+  vTexCoord = aTexCoord;
+
+  vec4 w_pos = ModelMatrix * (BoneMatrix * aPosition);
+  vec4 c_pos = uCameraMatrix * w_pos;
+
+  c_vPos = vec3(c_pos);
+  w_vPos = vec3(w_pos);
+
+  gl_Position = uProjectionMatrix * c_pos;
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2014, Tamas Csala
+
+#version 430
+
+// The skinning of the AnimatedMeshRenderer's vertices. The bones' attributes
+// are declared here, the shaders, that include it, only call getBoneMatrix().
+
+// External macros
+#define BONE_ATTRIB_NUM
+#define BONE_ENCODING
+
+// The values of BONE_ENCODING (see engine::BoneEncoding).
+#define ENCODING_MAT4 0
+#define ENCODING_MAT3X4 1
+#define ENCODING_DUAL_QUATERNION 2
+
+#if BONE_ENCODING == ENCODING_DUAL_QUATERNION
+  #define BONE_SIZE 2
+#elif BONE_ENCODING == ENCODING_MAT3X4
+  #define BONE_SIZE 3
+#else
+  #define BONE_SIZE 4
+#endif
+
+#if BONE_ATTRIB_NUM > 0
+in vec4 aBoneIDs0;
+in vec4 aWeights0;
+#endif
+#if BONE_ATTRIB_NUM > 1
+in vec4 aBoneIDs1;
+in vec4 aWeights1;
+#endif
+#if BONE_ATTRIB_NUM > 2
+in vec4 aBoneIDs2;
+in vec4 aWeights2;
+#endif
+#if BONE_ATTRIB_NUM > 3
+in vec4 aBoneIDs3;
+in vec4 aWeights3;
+#endif
+#if BONE_ATTRIB_NUM > 4
+in vec4 aBoneIDs4;
+in vec4 aWeights4;
+#endif
+#if BONE_ATTRIB_NUM > 5
+in vec4 aBoneIDs5;
+in vec4 aWeights5;
+#endif
+#if BONE_ATTRIB_NUM > 6
+in vec4 aBoneIDs6;
+in vec4 aWeights6;
+#endif
+#if BONE_ATTRIB_NUM > 7
+in vec4 aBoneIDs7;
+in vec4 aWeights7;
+#endif
+
+// Returns the index-th vec4 of the encoded bones, BONE_SIZE vec4s per bone.
+// It is defined by the including shader, as that knows where they are.
+vec4 getBoneData(int index);
+
+// The weighted sum of the encoded bones.
+vec4 BoneSum[BONE_SIZE];
+
+void addBone(float id, float weight) {
+  int first = int(id) * BONE_SIZE;
+  #if BONE_ENCODING == ENCODING_DUAL_QUATERNION
+    // q and -q are the same rotation, but they mustn't cancel out each other.
+    if (dot(BoneSum[0], getBoneData(first)) < 0) {
+      weight = -weight;
+    }
+  #endif
+  for (int i = 0; i < BONE_SIZE; i++) {
+    BoneSum[i] += getBoneData(first + i) * weight;
+  }
+}
+
+mat4 getBoneMatrix() {
+  for (int i = 0; i < BONE_SIZE; i++) {
+    BoneSum[i] = vec4(0);
+  }
+  #if BONE_ATTRIB_NUM > 0
+    for (int j = 0; j < 4; j++)
+      addBone(aBoneIDs0[j], aWeights0[j]);
+  #endif
+  #if BONE_ATTRIB_NUM > 1
+    for (int j = 0; j < 4; j++)
+      addBone(aBoneIDs1[j], aWeights1[j]);
+  #endif
+  #if BONE_ATTRIB_NUM > 2
+    for (int j = 0; j < 4; j++)
+      addBone(aBoneIDs2[j], aWeights2[j]);
+  #endif
+  #if BONE_ATTRIB_NUM > 3
+    for (int j = 0; j < 4; j++)
+      addBone(aBoneIDs3[j], aWeights3[j]);
+  #endif
+  #if BONE_ATTRIB_NUM > 4
+    for (int j = 0; j < 4; j++)
+      addBone(aBoneIDs4[j], aWeights4[j]);
+  #endif
+  #if BONE_ATTRIB_NUM > 5
+    for (int j = 0; j < 4; j++)
+      addBone(aBoneIDs5[j], aWeights5[j]);
+  #endif
+  #if BONE_ATTRIB_NUM > 6
+    for (int j = 0; j < 4; j++)
+      addBone(aBoneIDs6[j], aWeights6[j]);
+  #endif
+  #if BONE_ATTRIB_NUM > 7
+    for (int j = 0; j < 4; j++)
+      addBone(aBoneIDs7[j], aWeights7[j]);
+  #endif
+  #if BONE_ENCODING == ENCODING_DUAL_QUATERNION
+    float len = length(BoneSum[0]);
+    vec4 r = BoneSum[0] / len, d = BoneSum[1] / len;
+    vec3 t = 2 * (r.w * d.xyz - d.w * r.xyz + cross(r.xyz, d.xyz));
+    float x = r.x, y = r.y, z = r.z, w = r.w;
+    return mat4(
+      1 - 2*(y*y + z*z), 2*(x*y + w*z), 2*(x*z - w*y), 0,
+      2*(x*y - w*z), 1 - 2*(x*x + z*z), 2*(y*z + w*x), 0,
+      2*(x*z + w*y), 2*(y*z - w*x), 1 - 2*(x*x + y*y), 0,
+      t, 1);
+  #elif BONE_ENCODING == ENCODING_MAT3X4
+    return transpose(mat4(BoneSum[0], BoneSum[1], BoneSum[2],
+                          vec4(0, 0, 0, 1)));
+  #else
+    return mat4(BoneSum[0], BoneSum[1], BoneSum[2], BoneSum[3]);
+  #endif
+}
+
+#export mat4 getBoneMatrix();
@@ -2,6 +2,8 @@
 
 #version 430
 
+#include "engine/frame_data.vert"
+
 #export vec3 CDLODTerrain_worldPos();
 #export vec2 CDLODTerrain_texCoord(vec3 pos);
 #export vec3 CDLODTerrain_normal(vec3 pos);
@@ -24,7 +26,6 @@ int CDLODTerrain_uLevel = int(CDLODTerrain_uRenderData.w);
 
 uniform sampler2D CDLODTerrain_uHeightMap;
 uniform vec2 CDLODTerrain_uTexSize;
-uniform vec3 CDLODTerrain_uCamPos;
 
 float CDLODTerrain_fetchHeight(vec2 tex_coord) {
   return texture2D(CDLODTerrain_uHeightMap,
@@ -45,7 +46,7 @@ vec3 CDLODTerrain_worldPos() {
   vec2 pos = CDLODTerrain_uOffset + CDLODTerrain_uScale * CDLODTerrain_aPosition;
 
   float max_dist = CDLODTerrain_morph_end_fudge * pow(2, CDLODTerrain_uLevel+1) * 128;
-  float dist = length(CDLODTerrain_uCamPos - vec3(pos.x, CDLODTerrain_fetchHeight(pos), pos.y));
+  float dist = length(uCameraPos - vec3(pos.x, CDLODTerrain_fetchHeight(pos), pos.y));
 
   float morph = clamp((dist - CDLODTerrain_morph_start*max_dist) /
       ((1-CDLODTerrain_morph_start) * max_dist), 0, 1);
@@ -0,0 +1,7 @@
+// Copyright (c) 2014, Tamas Csala
+
+#version 430
+
+// The data that is the same for every program during a frame, uploaded once
+// per frame by engine::FrameUniforms. The export must stay on a single line.
+#export layout(std140, binding = 0) uniform EngineFrameData { mat4 uCameraMatrix; mat4 uProjectionMatrix; mat4 uShadowCP[16]; vec3 uCameraPos; float uTime; vec3 uSunPos; int uNumUsedShadowMaps; ivec2 uShadowAtlasSize; };
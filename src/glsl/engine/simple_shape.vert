@@ -2,12 +2,12 @@
 
 #version 430
 
+#include "engine/frame_data.vert"
+
 in vec4 aPosition;
 in vec3 aNormal;
 
-uniform mat4 uProjectionMatrix = mat4(1.0),
-             uCameraMatrix = mat4(1.0),
-             uModelMatrix = mat4(1.0);
+uniform mat4 uModelMatrix = mat4(1.0);
 
 out vec3 w_vNormal;
 
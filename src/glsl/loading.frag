@@ -5,9 +5,24 @@
 in vec2 vTexCoord;
 
 uniform sampler2D uTex;
+uniform float uProgress;
+uniform float uTime;
 
 out vec4 fragColor;
 
 void main() {
   fragColor = vec4(texture2D(uTex, vTexCoord).rgb, 1.0);
+
+  // The progress bar, at the bottom of the screen.
+  vec2 bar_min = vec2(0.1, 0.95), bar_max = vec2(0.9, 0.97);
+  if (all(greaterThan(vTexCoord, bar_min)) &&
+      all(lessThan(vTexCoord, bar_max))) {
+    float x = (vTexCoord.s - bar_min.s) / (bar_max.s - bar_min.s);
+    // A highlight sweeps through the filled part, so that the bar keeps
+    // moving while a step of the loading takes long.
+    float sweep = fract(0.5 * uTime) * uProgress;
+    float highlight = 0.1 * smoothstep(0.05, 0.0, abs(x - sweep));
+    vec3 bar_color = x < uProgress ? vec3(0.9 + highlight) : vec3(0.2);
+    fragColor.rgb = mix(fragColor.rgb, bar_color, 0.8);
+  }
 }
@@ -4,6 +4,8 @@
 
 #version 430
 
+#include "engine/frame_data.vert"
+
 #export vec3 SkyColor(vec3 look_dir);
 #export vec3 SunPos();
 #export vec3 MoonPos();
@@ -19,7 +21,6 @@ const float kAtmThickness = 50000;
 const vec3 kAirColor = vec3(0.32, 0.36, 0.45);
 const vec3 kLightColor = vec3(1.0, 1.0, 1.0);
 
-uniform vec3 uSunPos;
 vec3 sun_pos = normalize(uSunPos);
 vec3 moon_pos = -sun_pos;
 
@@ -2,14 +2,13 @@
 
 #version 430
 
-in vec3 aPosition;
+#include "engine/frame_data.vert"
 
-uniform mat4 uProjectionMatrix;
-uniform mat3 uCameraMatrix;
+in vec3 aPosition;
 
 out vec3 vTexCoord;
 
 void main(void) {
-  gl_Position = uProjectionMatrix * vec4(uCameraMatrix * vec3(10 * aPosition), 1.0);
+  gl_Position = uProjectionMatrix * vec4(mat3(uCameraMatrix) * vec3(10 * aPosition), 1.0);
   vTexCoord = aPosition;
 }
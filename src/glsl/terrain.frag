@@ -2,28 +2,20 @@
 
 #version 430
 
+#include "engine/frame_data.vert"
 #include "sky.frag"
 #include "fog.frag"
 #include "hemisphere_lighting.frag"
 
-// This might be overwritten by the c++ code.
-#define SHADOW_MAP_NUM 16
-
 in vec3  w_vNormal;
 in vec3  c_vPos, w_vPos;
 in vec2  vTexCoord;
 in float vInvalid;
 in mat3  vNormalMatrix;
 
-uniform mat4 uCameraMatrix;
 uniform sampler2D uGrassMap0, uGrassMap1, uGrassNormalMap;
 uniform sampler2D uShadowMap;
 
-uniform mat4 uShadowCP[SHADOW_MAP_NUM];
-uniform int uNumUsedShadowMaps;
-uniform ivec2 uShadowAtlasSize;
-
-
 out vec4 fragColor;
 
 // -------======{[ Shadow ]}======-------
@@ -47,7 +39,7 @@ bool isValid(vec2 tc) {
 
 float Visibility() {
   float visibility = 1.0;
-  int num_shadow_casters = min(uNumUsedShadowMaps, SHADOW_MAP_NUM);
+  int num_shadow_casters = min(uNumUsedShadowMaps, uShadowCP.length());
   float length_from_camera = length(c_vPos);
   float modifier = max((150 - length_from_camera) / 150, 0);
   modifier *= kMaxShadow;
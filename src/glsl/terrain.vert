@@ -2,9 +2,10 @@
 
 #version 430
 
+#include "engine/frame_data.vert"
 #include "engine/cdlod_terrain.vert"
 
-uniform mat4 uProjectionMatrix, uCameraMatrix, uModelMatrix;
+uniform mat4 uModelMatrix;
 uniform vec2 CDLODTerrain_uTexSize;
 
 out vec3  w_vNormal;
@@ -2,11 +2,13 @@
 
 #version 430
 
+#include "engine/frame_data.vert"
+
 in vec4 aPosition;
 in vec2 aTexCoord;
 in vec3 aNormal;
 
-uniform mat4 uModelCameraMatrix, uProjectionMatrix;
+uniform mat4 uModelMatrix;
 uniform mat3 uNormalMatrix;
 
 out vec3 c_vPos;
@@ -17,7 +19,7 @@ void main() {
   w_vNormal = aNormal * uNormalMatrix;
   vTexCoord = aTexCoord;
 
-  vec4 c_pos = uModelCameraMatrix * aPosition;
+  vec4 c_pos = uCameraMatrix * (uModelMatrix * aPosition);
   c_vPos = vec3(c_pos);
 
   gl_Position = uProjectionMatrix * c_pos;